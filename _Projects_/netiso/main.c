@@ -46,6 +46,7 @@ SYS_MODULE_STOP(netiso_stop);
 #define STOP_THREAD_NAME "sm_nets"
 
 #define MIN(a, b)	((a) <= (b) ? (a) : (b))
+#define MAX(a, b)	((a) >= (b) ? (a) : (b))
 #define ABS(a)		(((a) < 0) ? -(a) : (a))
 
 #define CD_CACHE_SIZE			(48)
@@ -286,8 +287,237 @@ static int64_t open_remote_file(char *path)
 	return res.file_size;
 }
 
+#define NETISO_V2_WINDOW	8		// tagged reads in flight
+#define NETISO_V2_CHUNK		0x10000	// size of each tagged read
+
+static u8 netiso_window = 0; // tagged reads in flight negotiated with the server (0 = protocol v1)
+static u8 *netiso_zbuf = NULL; // LZ4 input of the compressed transfer mode (NULL = raw transfers)
+
+// protocol v2: returns the tagged reads in flight accepted by the server (0 = the server only speaks v1)
+// servers without v2 close the connection on the unknown command, so the caller must reconnect if 0 is returned
+static u8 negotiate_remote_v2(u8 window, u8 *flags)
+{
+	netiso_negotiate_v2_cmd cmd;
+	netiso_negotiate_v2_result res;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.opcode = NETISO_CMD_NEGOTIATE_V2;
+	cmd.version = NETISO_PROTOCOL_V2;
+	cmd.window = window;
+	cmd.flags = *flags;
+
+	if(send(g_socket, &cmd, sizeof(cmd), 0) != sizeof(cmd)) return 0;
+
+	if(recv(g_socket, &res, sizeof(res), MSG_WAITALL) != sizeof(res)) return 0;
+
+	if((res.version < NETISO_PROTOCOL_V2) || (res.max_read < NETISO_V2_CHUNK)) return 0;
+
+	*flags &= res.flags;
+
+	return (u8)MIN(res.window, window);
+}
+
+// LZ4 block format decoder: the block must expand to exactly dst_size bytes
+static int lz4_decompress_block(const u8 *src, u32 src_size, u8 *dst, u32 dst_size)
+{
+	const u8 *ip = src, *ip_end = src + src_size;
+	u8 *op = dst, *op_end = dst + dst_size;
+
+	while(ip < ip_end)
+	{
+		u8 token = *ip++, b;
+		u32 len = token >> 4;
+
+		if(len == 15) do {if(ip >= ip_end) return FAILED; b = *ip++; len += b;} while(b == 255);
+
+		if((len > (u32)(ip_end - ip)) || (len > (u32)(op_end - op))) return FAILED;
+
+		memcpy(op, ip, len); op += len, ip += len;
+
+		if(ip >= ip_end) break; // the last sequence has only literals
+
+		if(ip_end - ip < 2) return FAILED;
+
+		u32 offset = ip[0] | (ip[1] << 8); ip += 2;
+		if(!offset || (offset > (u32)(op - dst))) return FAILED;
+
+		len = (token & 15) + 4;
+		if((token & 15) == 15) do {if(ip >= ip_end) return FAILED; b = *ip++; len += b;} while(b == 255);
+
+		if(len > (u32)(op_end - op)) return FAILED;
+
+		// byte copy: the match can overlap the output (runs)
+		for(const u8 *match = op - offset; len; len--) *op++ = *match++;
+	}
+
+	return (op == op_end) ? CELL_OK : FAILED;
+}
+
+// receive file data: raw, or in blocks of NETISO_BLOCK_SIZE in the compressed transfer mode
+static int recv_remote_data(u8 *buf, u32 size)
+{
+	if(!netiso_zbuf)
+		return (recv(g_socket, buf, size, MSG_WAITALL) == (int)size) ? CELL_OK : FAILED;
+
+	netiso_block_header header;
+
+	for(u32 pos = 0, len; pos < size; pos += len)
+	{
+		len = MIN(NETISO_BLOCK_SIZE, size - pos);
+
+		if(recv(g_socket, &header, sizeof(header), MSG_WAITALL) != sizeof(header)) return FAILED;
+
+		if(header.type == NETISO_BLOCK_ZERO)
+		{
+			memset(buf + pos, 0, len);
+		}
+		else if(header.type == NETISO_BLOCK_LZ4)
+		{
+			if((header.size >= len) || (recv(g_socket, netiso_zbuf, header.size, MSG_WAITALL) != (int)header.size)) return FAILED;
+			if(lz4_decompress_block(netiso_zbuf, header.size, buf + pos, len)) return FAILED;
+		}
+		else
+		{
+			if((header.size != len) || (recv(g_socket, buf + pos, len, MSG_WAITALL) != (int)len)) return FAILED;
+		}
+	}
+
+	return 0;
+}
+
+// protocol v2: split a read in tagged requests, keep up to netiso_window of them in flight
+// and place each result by its tag (the server can complete them in any order)
+static int read_remote_file_tagged(u64 offset, u8 *buf, u32 size)
+{
+	netiso_read_file_tagged_cmd cmd;
+	netiso_read_file_tagged_result res;
+
+	u32 nreads = (size + NETISO_V2_CHUNK - 1) / NETISO_V2_CHUNK, sent = 0, done = 0;
+
+	if(nreads > 0xFFFF) return FAILED;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.opcode = NETISO_CMD_READ_FILE_TAGGED;
+
+	while(done < nreads)
+	{
+		// fill the window
+		for(; (sent < nreads) && (sent - done < netiso_window); sent++)
+		{
+			u32 pos = sent * NETISO_V2_CHUNK;
+
+			cmd.tag = (u16)sent;
+			cmd.num_bytes = MIN(NETISO_V2_CHUNK, size - pos);
+			cmd.offset = offset + pos;
+
+			if(send(g_socket, &cmd, sizeof(cmd), 0) != sizeof(cmd)) return FAILED;
+		}
+
+		// each result completes one request
+		if(recv(g_socket, &res, sizeof(res), MSG_WAITALL) != sizeof(res)) return FAILED;
+
+		if(res.tag >= nreads) return FAILED;
+
+		u32 pos = res.tag * NETISO_V2_CHUNK, len = MIN(NETISO_V2_CHUNK, size - pos);
+
+		if(res.bytes_read != (int32_t)len) return FAILED; // critical read: short reads are errors
+
+		if(recv_remote_data(buf + pos, len)) return FAILED;
+
+		done++;
+	}
+
+	return 0;
+}
+
+// sector cache for CMD_READ_ISO: LRU segments filled on misses (request + readahead window)
+// and by one async readahead that is sent after a sequential read and received before the next command
+#define NET_CACHE_SEGS		4
+#define NET_SEG_SIZE		(128 * 1024)
+#define NET_RA_MIN			(32 * 1024)	// first readahead window of a sequential stream (doubles up to NET_SEG_SIZE)
+
+typedef struct
+{
+	u64 offset;
+	u32 len;   // 0 = empty
+	u32 stamp; // last use (LRU)
+} t_net_segment;
+
+static u8 *net_cache = NULL;
+static t_net_segment net_seg[NET_CACHE_SEGS];
+static u32 net_stamp = 0;
+static u64 net_last_end = 0;  // end of the previous read (sequential stream detector)
+static u32 net_ra_window = 0; // readahead window (0 = random access)
+static s8  net_ra_seg = NONE; // segment waiting for the async readahead
+static u32 net_ra_len = 0;
+
+static void net_cache_reset(void)
+{
+	memset(net_seg, 0, sizeof(net_seg));
+	net_stamp = net_ra_window = net_ra_len = 0;
+	net_last_end = 0;
+	net_ra_seg = NONE;
+}
+
+static int net_cache_lookup(u64 offset)
+{
+	for(u8 i = 0; i < NET_CACHE_SEGS; i++)
+		if(net_seg[i].len && (offset >= net_seg[i].offset) && (offset < net_seg[i].offset + net_seg[i].len)) return i;
+
+	return NONE;
+}
+
+// least recently used segment, keeping the ones that start in [keep_from, keep_to)
+static u8 net_cache_victim(u64 keep_from, u64 keep_to)
+{
+	u8 victim = 0; u32 oldest = 0xFFFFFFFF;
+
+	for(u8 i = 0; i < NET_CACHE_SEGS; i++)
+	{
+		if(i == net_ra_seg) continue;
+		if(!net_seg[i].len) return i;
+		if((net_seg[i].offset >= keep_from) && (net_seg[i].offset < keep_to)) continue;
+		if(net_seg[i].stamp < oldest) {oldest = net_seg[i].stamp; victim = i;}
+	}
+
+	return victim;
+}
+
+static void net_readahead_start(u8 i, u64 offset, u32 size)
+{
+	netiso_read_file_critical_cmd cmd;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.opcode = NETISO_CMD_READ_FILE_CRITICAL;
+	cmd.num_bytes = size;
+	cmd.offset = offset;
+
+	net_seg[i].len = 0, net_seg[i].offset = offset;
+
+	if(send(g_socket, &cmd, sizeof(cmd), 0) == sizeof(cmd)) {net_ra_seg = i, net_ra_len = size;}
+}
+
+// receive the pending readahead: must be called before any other command is sent to the server
+static int net_readahead_finish(void)
+{
+	if(net_ra_seg < 0) return 0;
+
+	t_net_segment *seg = &net_seg[(u8)net_ra_seg]; net_ra_seg = NONE;
+
+	if(recv_remote_data(net_cache + ((u8)(seg - net_seg) * NET_SEG_SIZE), net_ra_len))
+		return FAILED;
+
+	seg->len = net_ra_len, seg->stamp = ++net_stamp;
+	return 0;
+}
+
 static int read_remote_file_critical(u64 offset, void *buf, u32 size)
 {
+	if(net_readahead_finish()) return FAILED;
+
+	if(netiso_window && (size > NETISO_V2_CHUNK))
+		return read_remote_file_tagged(offset, (u8*)buf, size);
+
 	netiso_read_file_critical_cmd cmd;
 
 	memset(&cmd, 0, sizeof(cmd));
@@ -301,7 +531,7 @@ static int read_remote_file_critical(u64 offset, void *buf, u32 size)
 		return FAILED;
 	}
 
-	if(recv(g_socket, buf, size, MSG_WAITALL) != (int)size)
+	if(recv_remote_data(buf, size))
 	{
 		//DPRINTF("recv failed (recv file)  (errno=%d)!\n", sys_net_errno);
 		return FAILED;
@@ -334,8 +564,65 @@ static int process_read_iso_cmd(u8 *buf, u64 offset, u32 size)
 	return read_remote_file_critical(offset, buf, size);
 }
 
+static int process_read_iso_cached(u8 *buf, u64 offset, u32 size)
+{
+	// sequential stream: grow the readahead window; random access: no readahead
+	if(offset == net_last_end)
+		net_ra_window = net_ra_window ? MIN(net_ra_window * 2, NET_SEG_SIZE) : NET_RA_MIN;
+	else
+		net_ra_window = 0;
+
+	net_last_end = offset + size;
+
+	while(size)
+	{
+		int i = net_cache_lookup(offset);
+
+		if((i < 0) && (net_ra_seg >= 0) && (offset >= net_seg[(u8)net_ra_seg].offset) && (offset < net_seg[(u8)net_ra_seg].offset + net_ra_len))
+		{
+			if(net_readahead_finish()) return FAILED;
+			continue;
+		}
+
+		if(i < 0)
+		{
+			// large reads and the reads of the end of the disc bypass the cache
+			if((size > NET_SEG_SIZE) || (offset + size > discsize)) return process_read_iso_cmd(buf, offset, size);
+
+			// miss: fill a segment with the request and the readahead window (not beyond the end of the disc)
+			i = net_cache_victim(0, 0);
+			u32 len = (u32)MIN(MIN(MAX(size, net_ra_window), NET_SEG_SIZE), discsize - offset);
+
+			net_seg[i].len = 0;
+			if(process_read_iso_cmd(net_cache + (i * NET_SEG_SIZE), offset, len)) return FAILED;
+			net_seg[i].offset = offset, net_seg[i].len = len;
+		}
+
+		t_net_segment *seg = &net_seg[i]; seg->stamp = ++net_stamp;
+
+		u32 pos = (u32)(offset - seg->offset), n = MIN(size, seg->len - pos);
+		memcpy(buf, net_cache + (i * NET_SEG_SIZE) + pos, n);
+
+		buf += n, offset += n, size -= n;
+	}
+
+	// keep the next window of a sequential stream on its way while the data is consumed
+	if(net_ra_window && (net_ra_seg < 0))
+	{
+		u64 ahead = net_last_end; int i;
+		while((i = net_cache_lookup(ahead)) >= 0) ahead = net_seg[i].offset + net_seg[i].len;
+
+		if((ahead < discsize) && (ahead - net_last_end < net_ra_window))
+			net_readahead_start(net_cache_victim(net_last_end, ahead), ahead, (u32)MIN(net_ra_window, discsize - ahead));
+	}
+
+	return 0;
+}
+
 static int process_read_cd_2048_cmd(u8 *buf, u32 start_sector, u32 sector_count)
 {
+	if(net_readahead_finish()) return FAILED;
+
 	netiso_read_cd_2048_critical_cmd cmd;
 
 	memset(&cmd, 0, sizeof(cmd));
@@ -473,6 +760,25 @@ static void netiso_thread(u64 arg)
 		sys_ppu_thread_exit(0);
 	}
 
+	// protocol v2: tagged reads in flight & compressed transfer mode
+	sys_addr_t zbuf; u8 flags = 0;
+	if(sys_memory_allocate(NETISO_BLOCK_SIZE, SYS_MEMORY_PAGE_SIZE_64K, &zbuf) == CELL_OK) {netiso_zbuf = (u8 *)zbuf; flags = NETISO_FLAG_COMPRESS;}
+
+	netiso_window = negotiate_remote_v2(NETISO_V2_WINDOW, &flags);
+
+	if(netiso_zbuf && !(netiso_window && (flags & NETISO_FLAG_COMPRESS)))
+	{
+		sys_memory_free((sys_addr_t)netiso_zbuf); netiso_zbuf = NULL; // raw transfers
+	}
+
+	if(!netiso_window)
+	{
+		// older ps3netsrv closes the connection on unknown commands: reconnect with protocol v1
+		socketclose(g_socket);
+		g_socket = connect_to_server(args->server, args->port);
+		if(g_socket < 0) sys_ppu_thread_exit(0);
+	}
+
 	int64_t size = open_remote_file(args->path);
 	if(size < 0)
 	{
@@ -547,6 +853,10 @@ static void netiso_thread(u64 arg)
 		numtracks = 0;
 		tracks = NULL;
 		is_cd2352 = 0;
+
+		sys_addr_t addr;
+		net_cache_reset();
+		if(sys_memory_allocate(NET_CACHE_SEGS * NET_SEG_SIZE, SYS_MEMORY_PAGE_SIZE_64K, &addr) == CELL_OK) net_cache = (u8 *)addr; // no cache if there is no memory
 	}
 
 	ret = sys_storage_ext_mount_discfile_proxy(result_port, command_queue, emu_mode, discsize, 256*1024, numtracks|cd_sec_size_param, tracks);
@@ -584,6 +894,10 @@ static void netiso_thread(u64 arg)
 				{
 					ret = process_read_cd_2048_cmd(buf, offset/2048, size/2048);
 				}
+				else if(net_cache)
+				{
+					ret = process_read_iso_cached(buf, offset, size);
+				}
 				else
 				{
 					ret = process_read_iso_cmd(buf, offset, size);
@@ -620,6 +934,17 @@ static void netiso_thread(u64 arg)
 		sys_memory_free((sys_addr_t)cd_cache);
 	}
 
+	if(net_cache)
+	{
+		sys_memory_free((sys_addr_t)net_cache); net_cache = NULL;
+	}
+	net_ra_seg = NONE;
+
+	if(netiso_zbuf)
+	{
+		sys_memory_free((sys_addr_t)netiso_zbuf); netiso_zbuf = NULL;
+	}
+
 	if(g_socket >= 0)
 	{
 		shutdown(g_socket, SHUT_RDWR);
@@ -20,6 +20,12 @@ enum NETISO_CMD
 	
 	/* Replace this with any custom command */
 	NETISO_CMD_CUSTOM_0 = 0x2412,	
+
+	/* Protocol v2: negotiates tagged reads. Servers without v2 close the connection on it (the client reconnects and uses v1) */
+	NETISO_CMD_NEGOTIATE_V2,
+	/* Protocol v2: reads the active ro file. Offsets and sizes in bytes. Up to the negotiated window of reads can be in flight.
+	   Each result carries the tag of its request and results can arrive in any order */
+	NETISO_CMD_READ_FILE_TAGGED,
 };
 
 typedef struct _netiso_cmd
@@ -58,6 +64,60 @@ typedef struct _netiso_read_cd_2048_critical_cmd
 	uint32_t pad2;
 } __attribute__((packed)) netiso_read_cd_2048_critical_cmd;
 
+#define NETISO_PROTOCOL_V2	2
+
+/* Compressed transfer mode: the data of READ_FILE_CRITICAL, READ_FILE and READ_FILE_TAGGED is sent in blocks of
+   NETISO_BLOCK_SIZE bytes (the last one can be shorter), each one preceded by a netiso_block_header */
+#define NETISO_FLAG_COMPRESS	1
+#define NETISO_BLOCK_SIZE		65536
+
+enum NETISO_BLOCK_TYPE
+{
+	NETISO_BLOCK_RAW,	/* size bytes of data */
+	NETISO_BLOCK_ZERO,	/* all zero, no data */
+	NETISO_BLOCK_LZ4	/* size bytes of LZ4 block format (always smaller than the block) */
+};
+
+typedef struct _netiso_block_header
+{
+	uint8_t type;
+	uint8_t pad[3];
+	uint32_t size; // bytes of data that follow
+} __attribute__((packed)) netiso_block_header;
+
+typedef struct _netiso_negotiate_v2_cmd
+{
+	uint16_t opcode;
+	uint16_t version; // highest protocol version of the client
+	uint16_t window;  // tagged reads in flight wanted by the client
+	uint8_t flags;   // NETISO_FLAG_* wanted by the client
+	uint8_t pad[9];
+} __attribute__((packed)) netiso_negotiate_v2_cmd;
+
+typedef struct _netiso_negotiate_v2_result
+{
+	uint16_t version;  // protocol version of the server
+	uint16_t window;   // tagged reads in flight accepted by the server
+	uint32_t max_read; // max bytes of one tagged read
+	uint8_t flags;    // NETISO_FLAG_* accepted by the server
+	uint8_t pad[3];
+} __attribute__((packed)) netiso_negotiate_v2_result;
+
+typedef struct _netiso_read_file_tagged_cmd
+{
+	uint16_t opcode;
+	uint16_t tag;
+	uint32_t num_bytes;
+	uint64_t offset;
+} __attribute__((packed)) netiso_read_file_tagged_cmd;
+
+typedef struct _netiso_read_file_tagged_result
+{
+	uint16_t tag;
+	uint16_t pad;
+	int32_t bytes_read; // -1 on error. The data read (if any) follows
+} __attribute__((packed)) netiso_read_file_tagged_result;
+
 #ifdef __BIG_ENDIAN__
 
 static inline uint16_t BE16(uint16_t x) 
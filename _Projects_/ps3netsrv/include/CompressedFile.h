@@ -0,0 +1,66 @@
+#ifndef __COMPRESSEDFILE_H__
+#define __COMPRESSEDFILE_H__
+
+// Block-indexed compressed images served as raw ISOs:
+// CSO (deflate) and ZSO (LZ4) with a header + offset index, DAX (zlib) with offset & length tables
+
+#include "AbstractFile.h"
+
+enum CompressedFormat
+{
+	kFormatNone,
+	kFormatCSO,
+	kFormatZSO,
+	kFormatDAX
+};
+
+class CompressedFile : public AbstractFile
+{
+ private:
+	static const int kCacheSlots = 32; // decompressed blocks kept in the LRU cache
+
+	struct CacheSlot
+	{
+		int64_t block;	// -1 = empty
+		uint32_t size;	// decompressed bytes
+		uint32_t stamp;	// last use
+	};
+
+	file_t fd;
+	CompressedFormat format;
+
+	uint64_t total_bytes;
+	uint32_t block_size;
+	uint32_t num_blocks;
+	uint8_t align;
+
+	uint32_t *index;	// CSO/ZSO: num_blocks + 1 entries (bit 31 = stored). DAX: num_blocks offsets
+	uint16_t *lengths;	// DAX: compressed size of each block
+	uint8_t *stored;	// DAX: blocks in non-compressed areas
+
+	uint8_t *zbuf;		// compressed block
+	uint8_t *cache;		// kCacheSlots * block_size
+	CacheSlot slots[kCacheSlots];
+	uint32_t stamp;
+
+	int64_t position;
+
+	int load_index(void);
+	int read_block(uint32_t block, uint8_t *buf, uint32_t *size);
+	uint8_t *get_block(uint32_t block, uint32_t *size);
+
+ public:
+	CompressedFile();
+	virtual ~CompressedFile();
+
+	static CompressedFormat detect_format(const char *path);
+
+	virtual int open(const char *path, int flags);
+	virtual int close(void);
+	virtual ssize_t read(void *buf, size_t nbyte);
+	virtual ssize_t write(void *buf, size_t nbyte);
+	virtual int64_t seek(int64_t offset, int whence);
+	virtual int fstat(file_stat_t *fs);
+};
+
+#endif
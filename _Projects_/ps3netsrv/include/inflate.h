@@ -0,0 +1,17 @@
+#ifndef __INFLATE_H__
+#define __INFLATE_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int inflate_raw(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INFLATE_H__ */
@@ -0,0 +1,19 @@
+#ifndef __LZ4BLOCK_H__
+#define __LZ4BLOCK_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int is_zero_block(const uint8_t *buf, size_t size);
+int lz4_compress_block(const uint8_t *src, int src_size, uint8_t *dst, int max_size);
+int lz4_decompress_block(const uint8_t *src, int src_size, uint8_t *dst, int max_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LZ4BLOCK_H__ */
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "common.h"
+#include "compat.h"
+#include "CompressedFile.h"
+#include "inflate.h"
+#include "lz4block.h"
+
+static const int FAILED		= -1;
+static const int SUCCEEDED	=  0;
+static const int NONE		= -1;
+
+#define MIN(a, b)	((a) <= (b) ? (a) : (b))
+
+#define CISO_MAGIC			0x4F534943 // "CISO"
+#define ZISO_MAGIC			0x4F53495A // "ZISO"
+#define DAX_MAGIC			0x00584144 // "DAX\0"
+
+#define CISO_HEADER_SIZE	0x18
+#define DAX_HEADER_SIZE		0x20
+#define DAX_FRAME_SIZE		0x2000
+
+#define MAX_BLOCK_SIZE		0x100000
+
+// the image formats are little endian
+static uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t le64(const uint8_t *p)
+{
+	return le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+static bool has_extension(const char *path, const char *ext)
+{
+	size_t plen = strlen(path), elen = strlen(ext);
+	if(plen <= elen) return false;
+
+	for(size_t i = 0; i < elen; i++)
+		if(tolower((unsigned char)path[plen - elen + i]) != ext[i]) return false;
+
+	return true;
+}
+
+CompressedFile::CompressedFile()
+{
+	fd = INVALID_FD;
+	format = kFormatNone;
+	index = NULL;
+	lengths = NULL;
+	stored = NULL;
+	zbuf = NULL;
+	cache = NULL;
+	total_bytes = block_size = num_blocks = align = 0;
+	position = 0;
+}
+
+CompressedFile::~CompressedFile()
+{
+	DPRINTF("CompressedFile destructor.\n");
+
+	if (FD_OK(fd))
+		this->close();
+}
+
+// selected by extension, the magic is checked by open()
+CompressedFormat CompressedFile::detect_format(const char *path)
+{
+	if(has_extension(path, ".cso")) return kFormatCSO;
+	if(has_extension(path, ".zso")) return kFormatZSO;
+	if(has_extension(path, ".dax")) return kFormatDAX;
+
+	return kFormatNone;
+}
+
+int CompressedFile::load_index(void)
+{
+	uint8_t header[DAX_HEADER_SIZE];
+	file_stat_t st;
+
+	if((fstat_file(fd, &st) < 0) || (read_file(fd, header, sizeof(header)) != sizeof(header)))
+		return FAILED;
+
+	uint32_t magic = le32(header);
+
+	if(((magic == CISO_MAGIC) || (magic == ZISO_MAGIC)) && (header[0x14] <= 1))
+	{
+		// CSO / ZSO: header, then (num_blocks + 1) offsets >> align. Bit 31 = stored block
+		format = (magic == CISO_MAGIC) ? kFormatCSO : kFormatZSO;
+		total_bytes = le64(header + 8);
+		block_size = le32(header + 0x10);
+		align = header[0x15];
+
+		if((block_size < 0x800) || (block_size > MAX_BLOCK_SIZE) || (block_size & (block_size - 1)) || (align > 31))
+			return FAILED;
+
+		num_blocks = (uint32_t)((total_bytes + block_size - 1) / block_size);
+
+		if(((uint64_t)num_blocks + 1) * sizeof(uint32_t) > st.file_size) return FAILED; // truncated or not an image
+
+		index = new uint32_t[num_blocks + 1];
+
+		if(seek_file(fd, CISO_HEADER_SIZE, SEEK_SET) < 0) return FAILED;
+
+		size_t size = (num_blocks + 1) * sizeof(uint32_t);
+		if(read_file(fd, index, size) != (ssize_t)size) return FAILED;
+
+		for(uint32_t i = 0; i <= num_blocks; i++) index[i] = le32((uint8_t *)&index[i]);
+	}
+	else if(magic == DAX_MAGIC)
+	{
+		// DAX: header, frame offsets, frame lengths, then (version 1) non-compressed areas
+		format = kFormatDAX;
+		total_bytes = le32(header + 4);
+		block_size = DAX_FRAME_SIZE;
+
+		uint32_t version = le32(header + 8), nc_areas = le32(header + 12);
+
+		num_blocks = (uint32_t)((total_bytes + block_size - 1) / block_size);
+
+		if((uint64_t)num_blocks * (sizeof(uint32_t) + sizeof(uint16_t)) > st.file_size) return FAILED; // truncated or not an image
+
+		index = new uint32_t[num_blocks];
+		lengths = new uint16_t[num_blocks];
+		stored = new uint8_t[num_blocks];
+		memset(stored, 0, num_blocks);
+
+		if(read_file(fd, index, num_blocks * sizeof(uint32_t)) != (ssize_t)(num_blocks * sizeof(uint32_t))) return FAILED;
+		if(read_file(fd, lengths, num_blocks * sizeof(uint16_t)) != (ssize_t)(num_blocks * sizeof(uint16_t))) return FAILED;
+
+		for(uint32_t i = 0; i < num_blocks; i++)
+		{
+			uint8_t *p = (uint8_t *)&lengths[i];
+			index[i] = le32((uint8_t *)&index[i]);
+			lengths[i] = p[0] | (p[1] << 8);
+		}
+
+		for(uint32_t n = 0; (version >= 1) && (n < nc_areas); n++)
+		{
+			uint8_t area[8];
+			if(read_file(fd, area, sizeof(area)) != sizeof(area)) return FAILED;
+
+			for(uint32_t i = le32(area), last = i + le32(area + 4); (i < last) && (i < num_blocks); i++) stored[i] = 1;
+		}
+	}
+	else
+		return FAILED;
+
+	return SUCCEEDED;
+}
+
+int CompressedFile::open(const char *path, int flags)
+{
+	if(!path)
+	{
+		printf("compressed file error: no path\n");
+		return FAILED;
+	}
+
+	if (FD_OK(fd))
+		this->close();
+
+	if(flags != O_RDONLY)
+		return FAILED;
+
+	fd = open_file(path, flags);
+	if (!FD_OK(fd))
+	{
+		printf("compressed file error: opening \"%s\"\n", path);
+		return FAILED;
+	}
+
+	if(load_index() != SUCCEEDED)
+	{
+		printf("compressed file error: invalid header or index \"%s\"\n", path);
+		this->close();
+		return FAILED;
+	}
+
+	zbuf = new uint8_t[block_size * 2]; // compressed blocks can be larger than the block (alignment, incompressible data)
+	cache = new uint8_t[kCacheSlots * block_size];
+
+	for(int i = 0; i < kCacheSlots; i++) {slots[i].block = NONE; slots[i].size = slots[i].stamp = 0;}
+	stamp = 0;
+	position = 0;
+
+	return SUCCEEDED;
+}
+
+int CompressedFile::close(void)
+{
+	int ret = (FD_OK(fd)) ? close_file(fd) : FAILED;
+
+	fd = INVALID_FD;
+
+	delete[] index;   index = NULL;
+	delete[] lengths; lengths = NULL;
+	delete[] stored;  stored = NULL;
+	delete[] zbuf;    zbuf = NULL;
+	delete[] cache;   cache = NULL;
+
+	format = kFormatNone;
+	total_bytes = num_blocks = 0;
+
+	return ret;
+}
+
+// decompress one block, size = bytes of the block in the image
+int CompressedFile::read_block(uint32_t block, uint8_t *buf, uint32_t *size)
+{
+	uint64_t offset;
+	uint32_t zsize;
+	bool is_stored;
+
+	*size = (uint32_t)MIN((uint64_t)block_size, total_bytes - ((uint64_t)block * block_size));
+
+	if(format == kFormatDAX)
+	{
+		offset = index[block];
+		zsize = lengths[block];
+		is_stored = stored[block];
+		if(is_stored) zsize = *size; else if(zsize > block_size * 2) return FAILED;
+	}
+	else
+	{
+		offset = (uint64_t)(index[block] & 0x7FFFFFFF) << align;
+		uint64_t next = (uint64_t)(index[block + 1] & 0x7FFFFFFF) << align;
+
+		if(next < offset) return FAILED;
+
+		is_stored = (index[block] & 0x80000000);
+		zsize = (uint32_t)MIN(next - offset, (uint64_t)block_size * 2);
+		if(is_stored) zsize = *size;
+	}
+
+	if(seek_file(fd, offset, SEEK_SET) < 0)
+		return FAILED;
+
+	if(is_stored)
+		return (read_file(fd, buf, zsize) == (ssize_t)zsize) ? SUCCEEDED : FAILED;
+
+	ssize_t ret = read_file(fd, zbuf, zsize);
+	if(ret <= 0) return FAILED;
+
+	int len;
+	if(format == kFormatZSO)
+		len = lz4_decompress_block(zbuf, (int)ret, buf, *size);
+	else if(format == kFormatDAX)
+		len = (ret > 2) ? inflate_raw(zbuf + 2, ret - 2, buf, *size) : FAILED; // skip zlib header
+	else
+		len = inflate_raw(zbuf, ret, buf, *size);
+
+	return (len == (int)*size) ? SUCCEEDED : FAILED;
+}
+
+uint8_t *CompressedFile::get_block(uint32_t block, uint32_t *size)
+{
+	int victim = 0;
+
+	for(int i = 0; i < kCacheSlots; i++)
+	{
+		if(slots[i].block == block)
+		{
+			slots[i].stamp = ++stamp;
+			*size = slots[i].size;
+			return cache + (i * block_size);
+		}
+
+		if(slots[i].stamp < slots[victim].stamp) victim = i;
+	}
+
+	uint8_t *buf = cache + (victim * block_size);
+
+	slots[victim].block = NONE;
+	if(read_block(block, buf, size) != SUCCEEDED)
+	{
+		printf("compressed file error: block %u is corrupted\n", block);
+		return NULL;
+	}
+
+	slots[victim].block = block;
+	slots[victim].size = *size;
+	slots[victim].stamp = ++stamp;
+
+	return buf;
+}
+
+ssize_t CompressedFile::read(void *buf, size_t nbyte)
+{
+	if(!FD_OK(fd) || !buf)
+		return FAILED;
+
+	if((position < 0) || ((uint64_t)position >= total_bytes))
+		return 0;
+
+	nbyte = (size_t)MIN((uint64_t)nbyte, total_bytes - position);
+
+	uint8_t *out = (uint8_t *)buf;
+	size_t remaining = nbyte;
+
+	while(remaining > 0)
+	{
+		uint32_t block = (uint32_t)(position / block_size), pos = (uint32_t)(position % block_size), size;
+
+		uint8_t *data = get_block(block, &size);
+		if(!data) return FAILED;
+
+		uint32_t len = (uint32_t)MIN((size_t)(size - pos), remaining);
+		memcpy(out, data + pos, len);
+
+		out += len, position += len, remaining -= len;
+	}
+
+	return nbyte;
+}
+
+ssize_t CompressedFile::write(void *buf, size_t nbyte)
+{
+	(void) buf;
+	(void) nbyte;
+	printf("compressed file error: write error\n");
+	return FAILED;
+}
+
+int64_t CompressedFile::seek(int64_t offset, int whence)
+{
+	if (!FD_OK(fd))
+		return FAILED;
+
+	if (whence == SEEK_SET)
+	{
+		position = offset;
+	}
+	else if (whence == SEEK_CUR)
+	{
+		position += offset;
+	}
+	else if (whence == SEEK_END)
+	{
+		position = total_bytes + offset;
+	}
+
+	return position;
+}
+
+int CompressedFile::fstat(file_stat_t *fs)
+{
+	if (!FD_OK(fd) || !fs)
+		return FAILED;
+
+	if(fstat_file(fd, fs) < 0)
+		return FAILED;
+
+	fs->file_size = total_bytes; // size of the raw image
+
+	return SUCCEEDED;
+}
@@ -338,10 +338,10 @@ static int parse_param_sfo(file_t fd, const char *field, char *field_value, int
 
 	if (FD_OK(fd))
 	{
-		unsigned len, pos, str;
 		unsigned char *mem = NULL;
 
-		len = seek_file(fd, 0, SEEK_END);
+		unsigned len = seek_file(fd, 0, SEEK_END);
+		if (len > 0x10000) len = 0x10000; // PARAM.SFO is a few KB
 
 		mem = (unsigned char *) malloc(len + 16);
 		if (!mem)
@@ -356,32 +356,34 @@ static int parse_param_sfo(file_t fd, const char *field, char *field_value, int
 		read_file(fd, mem, len);
 		close_file(fd);
 
-		str = (mem[0x8] + (mem[0x9] << 8));
-		pos = (mem[0xc] + (mem[0xd] << 8));
-
-		int indx = 0;
-
-		while (str < len)
+		if ((len >= 0x14) && (mem[1] == 'P') && (mem[2] == 'S') && (mem[3] == 'F'))
 		{
-			if (mem[str] == 0)
-				break;
+			unsigned key_table  = mem[0x08] + (mem[0x09] << 8);
+			unsigned data_table = mem[0x0c] + (mem[0x0d] << 8);
+			unsigned entries    = mem[0x10] + (mem[0x11] << 8);
+			unsigned field_size = strlen(field) + 1;
 
-			if (!strcmp((char *) &mem[str], field))
+			// single pass over the index table: the key & data offsets of each entry are read from it
+			for (unsigned n = 0, indx = 0x14; (n < entries) && (indx + 0x10 <= len); n++, indx += 0x10)
 			{
+				unsigned str = key_table  + mem[indx + 0x0] + (mem[indx + 0x1] << 8);
+				unsigned pos = data_table + mem[indx + 0xc] + (mem[indx + 0xd] << 8);
+				unsigned siz = mem[indx + 0x8] + (mem[indx + 0x9] << 8);
+
+				if ((str + field_size > len) || memcmp(&mem[str], field, field_size))
+					continue;
+
 				if (pos >= len) break;
+				if (pos + siz > len) siz = len - pos;
+				if (siz > (unsigned)field_len) siz = field_len;
 
-				strncpy(field_value, (char *) &mem[pos], field_len);
+				strncpy(field_value, (char *) &mem[pos], siz);
 				free(mem);
 				return SUCCEEDED;
 			}
-			while (mem[str])
-				str++;
-			str++;
-			pos += (mem[0x1c + indx] + (mem[0x1d + indx] << 8));
-			indx += 16;
 		}
-		if (mem)
-			free(mem);
+
+		free(mem);
 	}
 
 	printf("viso error: failed to parse PARAM.SFO\n");
@@ -0,0 +1,235 @@
+#include <string.h>
+
+#include "inflate.h"
+
+// raw deflate (RFC 1951) decoder for the blocks of compressed images
+// canonical Huffman tables are decoded one bit at a time (blocks are small, the index lookup dominates)
+
+#define MAX_BITS	15
+
+typedef struct
+{
+	const uint8_t *src;
+	size_t src_size, src_pos;
+	uint32_t bits;
+	int nbits;
+	uint8_t *dst;
+	size_t dst_size, dst_pos;
+} inflate_state;
+
+typedef struct
+{
+	uint16_t count[MAX_BITS + 1];	// codes of each length
+	uint16_t symbol[288];			// symbols ordered by code
+} huffman;
+
+static const uint16_t length_base[29]  = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const uint8_t  length_extra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint16_t dist_base[30]  = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const uint8_t  dist_extra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+static int get_bits(inflate_state *s, int count)
+{
+	while(s->nbits < count)
+	{
+		if(s->src_pos >= s->src_size) return -1;
+		s->bits |= (uint32_t)s->src[s->src_pos++] << s->nbits;
+		s->nbits += 8;
+	}
+
+	int value = (int)(s->bits & ((1U << count) - 1));
+	s->bits >>= count, s->nbits -= count;
+	return value;
+}
+
+static void build_huffman(huffman *h, const uint8_t *lengths, int n)
+{
+	uint16_t offsets[MAX_BITS + 1];
+
+	memset(h->count, 0, sizeof(h->count));
+	for(int i = 0; i < n; i++) h->count[lengths[i]]++;
+	h->count[0] = 0;
+
+	offsets[1] = 0;
+	for(int len = 1; len < MAX_BITS; len++) offsets[len + 1] = offsets[len] + h->count[len];
+
+	for(int i = 0; i < n; i++)
+		if(lengths[i]) h->symbol[offsets[lengths[i]]++] = (uint16_t)i;
+}
+
+static int decode_symbol(inflate_state *s, const huffman *h)
+{
+	int code = 0, first = 0, index = 0;
+
+	for(int len = 1; len <= MAX_BITS; len++)
+	{
+		int bit = get_bits(s, 1);
+		if(bit < 0) return -1;
+
+		code |= bit;
+		int count = h->count[len];
+		if(code - first < count) return h->symbol[index + (code - first)];
+
+		index += count, first += count;
+		first <<= 1, code <<= 1;
+	}
+
+	return -1;
+}
+
+static int inflate_codes(inflate_state *s, const huffman *lencode, const huffman *distcode)
+{
+	for(;;)
+	{
+		int symbol = decode_symbol(s, lencode);
+		if(symbol < 0) return -1;
+
+		if(symbol < 256)
+		{
+			if(s->dst_pos >= s->dst_size) return -1;
+			s->dst[s->dst_pos++] = (uint8_t)symbol;
+		}
+		else if(symbol == 256)
+		{
+			return 0;
+		}
+		else
+		{
+			symbol -= 257;
+			if(symbol >= 29) return -1;
+
+			int extra = get_bits(s, length_extra[symbol]); if(extra < 0) return -1;
+			size_t len = length_base[symbol] + extra;
+
+			symbol = decode_symbol(s, distcode);
+			if((symbol < 0) || (symbol >= 30)) return -1;
+
+			extra = get_bits(s, dist_extra[symbol]); if(extra < 0) return -1;
+			size_t dist = dist_base[symbol] + extra;
+
+			if((dist > s->dst_pos) || (len > s->dst_size - s->dst_pos)) return -1;
+
+			for(; len; len--, s->dst_pos++) s->dst[s->dst_pos] = s->dst[s->dst_pos - dist];
+		}
+	}
+}
+
+static int inflate_stored(inflate_state *s)
+{
+	s->bits = 0, s->nbits = 0; // skip to byte boundary
+
+	if(s->src_pos + 4 > s->src_size) return -1;
+
+	size_t len = s->src[s->src_pos] | (s->src[s->src_pos + 1] << 8);
+	size_t nlen = s->src[s->src_pos + 2] | (s->src[s->src_pos + 3] << 8);
+	s->src_pos += 4;
+
+	if((len != (~nlen & 0xFFFF)) || (len > s->src_size - s->src_pos) || (len > s->dst_size - s->dst_pos)) return -1;
+
+	memcpy(s->dst + s->dst_pos, s->src + s->src_pos, len);
+	s->src_pos += len, s->dst_pos += len;
+	return 0;
+}
+
+static int inflate_fixed(inflate_state *s)
+{
+	huffman lencode, distcode;
+	uint8_t lengths[288];
+
+	int n = 0;
+	for(; n < 144; n++) lengths[n] = 8;
+	for(; n < 256; n++) lengths[n] = 9;
+	for(; n < 280; n++) lengths[n] = 7;
+	for(; n < 288; n++) lengths[n] = 8;
+	build_huffman(&lencode, lengths, 288);
+
+	for(n = 0; n < 30; n++) lengths[n] = 5;
+	build_huffman(&distcode, lengths, 30);
+
+	return inflate_codes(s, &lencode, &distcode);
+}
+
+static int inflate_dynamic(inflate_state *s)
+{
+	static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+	huffman lencode, distcode;
+	uint8_t lengths[320];
+
+	int nlen = get_bits(s, 5), ndist = get_bits(s, 5), ncode = get_bits(s, 4);
+	if((nlen < 0) || (ndist < 0) || (ncode < 0)) return -1;
+	nlen += 257, ndist += 1, ncode += 4;
+	if((nlen > 286) || (ndist > 30)) return -1;
+
+	memset(lengths, 0, 19);
+	for(int i = 0; i < ncode; i++)
+	{
+		int len = get_bits(s, 3); if(len < 0) return -1;
+		lengths[order[i]] = (uint8_t)len;
+	}
+	build_huffman(&lencode, lengths, 19);
+
+	for(int i = 0; i < nlen + ndist; )
+	{
+		int symbol = decode_symbol(s, &lencode);
+		if(symbol < 0) return -1;
+
+		if(symbol < 16)
+		{
+			lengths[i++] = (uint8_t)symbol;
+			continue;
+		}
+
+		int len = 0, repeat;
+		if(symbol == 16)
+		{
+			if(!i) return -1;
+			len = lengths[i - 1];
+			repeat = get_bits(s, 2); if(repeat < 0) return -1; repeat += 3;
+		}
+		else if(symbol == 17)
+		{
+			repeat = get_bits(s, 3); if(repeat < 0) return -1; repeat += 3;
+		}
+		else
+		{
+			repeat = get_bits(s, 7); if(repeat < 0) return -1; repeat += 11;
+		}
+
+		if(i + repeat > nlen + ndist) return -1;
+		while(repeat--) lengths[i++] = (uint8_t)len;
+	}
+
+	build_huffman(&lencode, lengths, nlen);
+	build_huffman(&distcode, lengths + nlen, ndist);
+
+	return inflate_codes(s, &lencode, &distcode);
+}
+
+// returns the bytes written to dst, or -1 on corrupted data
+int inflate_raw(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size)
+{
+	inflate_state s;
+	memset(&s, 0, sizeof(s));
+	s.src = src, s.src_size = src_size;
+	s.dst = dst, s.dst_size = dst_size;
+
+	int last;
+	do
+	{
+		last = get_bits(&s, 1);
+		int type = get_bits(&s, 2), ret;
+
+		if((last < 0) || (type < 0)) return -1;
+
+		if(type == 0) ret = inflate_stored(&s); else
+		if(type == 1) ret = inflate_fixed(&s);  else
+		if(type == 2) ret = inflate_dynamic(&s);
+		else ret = -1;
+
+		if(ret) return -1;
+	}
+	while(!last);
+
+	return (int)s.dst_pos;
+}
@@ -0,0 +1,144 @@
+#include <string.h>
+
+#include "lz4block.h"
+
+// LZ4 block format encoder (greedy, single probe hash) used by the compressed transfer mode
+// and decoder for the blocks of ZSO images
+
+#define LZ4_HASH_BITS		12
+#define LZ4_MIN_MATCH		4
+#define LZ4_LAST_LITERALS	5	// the last 5 bytes are always literals
+#define LZ4_MF_LIMIT		12	// the last match must start at least 12 bytes before the end
+#define LZ4_MAX_OFFSET		65535
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t value;
+	memcpy(&value, p, 4);
+	return value;
+}
+
+static uint32_t hash32(uint32_t value)
+{
+	return (value * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t *write_length(uint8_t *op, size_t len)
+{
+	for(; len >= 255; len -= 255) *op++ = 255;
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+int is_zero_block(const uint8_t *buf, size_t size)
+{
+	for(; size >= 8; buf += 8, size -= 8)
+		if(read32(buf) | read32(buf + 4)) return 0;
+
+	while(size--)
+		if(*buf++) return 0;
+
+	return 1;
+}
+
+// returns the size of the compressed block, or 0 if it does not fit in max_size bytes
+int lz4_compress_block(const uint8_t *src, int src_size, uint8_t *dst, int max_size)
+{
+	int32_t table[1 << LZ4_HASH_BITS];
+	memset(table, 0xFF, sizeof(table));
+
+	const uint8_t *ip = src, *anchor = src, *end = src + src_size;
+	const uint8_t *mf_limit = end - LZ4_MF_LIMIT, *match_limit = end - LZ4_LAST_LITERALS;
+	uint8_t *op = dst, *op_end = dst + max_size;
+
+	if(src_size > LZ4_MF_LIMIT)
+	{
+		while(ip < mf_limit)
+		{
+			uint32_t sequence = read32(ip), h = hash32(sequence);
+			int32_t ref = table[h]; table[h] = (int32_t)(ip - src);
+
+			if((ref < 0) || ((ip - src) - ref > LZ4_MAX_OFFSET) || (read32(src + ref) != sequence))
+			{
+				ip++;
+				continue;
+			}
+
+			const uint8_t *match = src + ref;
+
+			// extend the match backwards over pending literals, then forwards
+			while((ip > anchor) && (match > src) && (ip[-1] == match[-1])) {ip--, match--;}
+
+			const uint8_t *p = ip + LZ4_MIN_MATCH, *q = match + LZ4_MIN_MATCH;
+			while((p < match_limit) && (*p == *q)) {p++, q++;}
+
+			size_t literals = ip - anchor, match_len = (p - ip) - LZ4_MIN_MATCH;
+
+			if(op + 1 + (literals / 255) + 1 + literals + 2 + (match_len / 255) + 1 > op_end) return 0;
+
+			uint8_t *token = op++;
+
+			if(literals >= 15) {*token = 15 << 4; op = write_length(op, literals - 15);}
+			else *token = (uint8_t)(literals << 4);
+
+			memcpy(op, anchor, literals); op += literals;
+
+			uint16_t offset = (uint16_t)(ip - match);
+			*op++ = offset & 0xFF;
+			*op++ = offset >> 8;
+
+			if(match_len >= 15) {*token |= 15; op = write_length(op, match_len - 15);}
+			else *token |= (uint8_t)match_len;
+
+			anchor = ip = p;
+		}
+	}
+
+	// last literals
+	size_t literals = end - anchor;
+
+	if(op + 1 + (literals / 255) + 1 + literals > op_end) return 0;
+
+	if(literals >= 15) {*op++ = 15 << 4; op = write_length(op, literals - 15);}
+	else *op++ = (uint8_t)(literals << 4);
+
+	memcpy(op, anchor, literals); op += literals;
+
+	return (int)(op - dst);
+}
+
+// returns the bytes written to dst (up to max_size), or -1 on corrupted data
+// decoding stops when dst is full, so padding after the block is ignored
+int lz4_decompress_block(const uint8_t *src, int src_size, uint8_t *dst, int max_size)
+{
+	const uint8_t *ip = src, *ip_end = src + src_size;
+	uint8_t *op = dst, *op_end = dst + max_size;
+
+	while((ip < ip_end) && (op < op_end))
+	{
+		uint8_t token = *ip++, b;
+		size_t len = token >> 4;
+
+		if(len == 15) do {if(ip >= ip_end) return -1; b = *ip++; len += b;} while(b == 255);
+
+		if((len > (size_t)(ip_end - ip)) || (len > (size_t)(op_end - op))) return -1;
+
+		memcpy(op, ip, len); op += len, ip += len;
+
+		if((ip >= ip_end) || (op >= op_end)) break; // the last sequence has only literals
+
+		if(ip_end - ip < 2) return -1;
+
+		size_t offset = ip[0] | (ip[1] << 8); ip += 2;
+		if(!offset || (offset > (size_t)(op - dst))) return -1;
+
+		len = (token & 15) + LZ4_MIN_MATCH;
+		if((token & 15) == 15) do {if(ip >= ip_end) return -1; b = *ip++; len += b;} while(b == 255);
+
+		if(len > (size_t)(op_end - op)) return -1;
+
+		for(const uint8_t *match = op - offset; len; len--) *op++ = *match++;
+	}
+
+	return (int)(op - dst);
+}
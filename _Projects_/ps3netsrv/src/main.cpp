@@ -10,6 +10,7 @@
 
 #ifndef WIN32
 #include <ifaddrs.h>
+#include <sys/select.h>
 #endif
 
 static const int FAILED		= -1;
@@ -23,10 +24,18 @@ static const int NONE		= -1;
 
 #include "File.h"
 #include "VIsoFile.h"
+#include "CompressedFile.h"
+#include "lz4block.h"
 
 #define BUFFER_SIZE  (4 * 1048576)
 #define MAX_CLIENTS  5
 
+#define MAX_TAGGED_READS 16 // max reads in flight per client (protocol v2)
+
+#if (BUFFER_SIZE % NETISO_BLOCK_SIZE)
+#error BUFFER_SIZE must be a multiple of NETISO_BLOCK_SIZE
+#endif
+
 #define MAX_ENTRIES  4096
 #define MAX_PATH_LEN 510
 #define MAX_FILE_LEN 255
@@ -59,6 +68,11 @@ typedef struct _client_t
 	thread_t thread;
 	uint16_t CD_SECTOR_SIZE;
 	int subdirs;
+	uint16_t window; // tagged reads in flight negotiated with protocol v2 (0 = v1 client)
+	int has_pending;
+	netiso_cmd pending_cmd; // command received while collecting tagged reads
+	uint8_t *zbuf; // LZ4 output of the compressed transfer mode (NULL = raw transfers)
+	uint64_t raw_bytes, sent_bytes;
 } client_t;
 
 static client_t clients[MAX_CLIENTS];
@@ -110,6 +124,17 @@ static int initialize_socket(uint16_t port)
 	return s;
 }
 
+static int data_available(int s)
+{
+	fd_set fds;
+	struct timeval tv = {0, 0};
+
+	FD_ZERO(&fds);
+	FD_SET(s, &fds);
+
+	return (select(s + 1, &fds, NULL, NULL, &tv) > 0);
+}
+
 #ifndef WIN32
 static int recv_all(int s, void *buf, int size)
 {
@@ -226,6 +251,14 @@ static void finalize_client(client_t *client)
 		free(client->buf);
 	}
 
+	if(client->zbuf)
+	{
+		if(client->raw_bytes)
+			DPRINTF("Compressed transfers: %llu -> %llu bytes (%i%%)\n", (long long unsigned int)client->raw_bytes, (long long unsigned int)client->sent_bytes, (int)(client->sent_bytes * 100 / client->raw_bytes));
+
+		free(client->zbuf);
+	}
+
 	client->ro_file = NULL;
 	client->wo_file = NULL;
 	client->dir = NULL;
@@ -508,7 +541,10 @@ static int process_open_cmd(client_t *client, netiso_open_cmd *cmd)
 
 	if(viso == VISO_NONE)
 	{
-		client->ro_file = new File();
+		if(CompressedFile::detect_format(filepath) != kFormatNone)
+			client->ro_file = new CompressedFile(); // CSO / ZSO / DAX served as raw iso
+		else
+			client->ro_file = new File();
 	}
 	else
 	{
@@ -592,6 +628,55 @@ send_result:
 	return ret;
 }
 
+// sends file data: raw, or in blocks if the client negotiated the compressed transfer mode
+// all-zero blocks are sent as markers, other blocks as LZ4 if that saves at least 1/16 of the block
+static int send_file_data(client_t *client, uint8_t *buf, uint32_t size)
+{
+	if(!client->zbuf)
+	{
+		int send_ret = send(client->s, (char *)buf, size, 0);
+		return ((send_ret < 0) || (static_cast<unsigned int>(send_ret) != size)) ? FAILED : SUCCEEDED;
+	}
+
+	for (uint32_t pos = 0; pos < size; pos += NETISO_BLOCK_SIZE)
+	{
+		uint32_t len = MIN(NETISO_BLOCK_SIZE, size - pos);
+		uint8_t *data = buf + pos;
+		netiso_block_header header;
+
+		memset(&header, 0, sizeof(header));
+
+		int zlen = 0;
+		if(is_zero_block(data, len))
+		{
+			header.type = NETISO_BLOCK_ZERO;
+		}
+		else if((zlen = lz4_compress_block(data, len, client->zbuf, len - (len / 16))) > 0)
+		{
+			header.type = NETISO_BLOCK_LZ4;
+			header.size = BE32(zlen);
+			data = client->zbuf;
+		}
+		else
+		{
+			header.type = NETISO_BLOCK_RAW;
+			header.size = BE32(len);
+			zlen = len;
+		}
+
+		if(send(client->s, (char *)&header, sizeof(header), 0) != sizeof(header))
+			return FAILED;
+
+		if((zlen > 0) && (send(client->s, (char *)data, zlen, 0) != zlen))
+			return FAILED;
+
+		client->raw_bytes += len;
+		client->sent_bytes += sizeof(header) + zlen;
+	}
+
+	return SUCCEEDED;
+}
+
 static int process_read_file_critical(client_t *client, netiso_read_file_critical_cmd *cmd)
 {
 	if ((!client->ro_file) || (!client->buf))
@@ -629,8 +714,7 @@ static int process_read_file_critical(client_t *client, netiso_read_file_critica
 			return FAILED;
 		}
 
-		int send_ret = send(client->s, (char *)client->buf, read_size, 0);
-		if ((send_ret < 0) || (static_cast<unsigned int>(send_ret) != read_size))
+		if(send_file_data(client, client->buf, read_size) != SUCCEEDED)
 		{
 			printf("ERROR: send failed on read file critical command!\n");
 			return FAILED;
@@ -722,7 +806,7 @@ send_result_read_file:
 		return FAILED;
 	}
 
-	if((bytes_read > 0) && (send(client->s, (char *)client->buf, bytes_read, 0) != bytes_read))
+	if((bytes_read > 0) && (send_file_data(client, client->buf, bytes_read) != SUCCEEDED))
 	{
 		printf("ERROR: send failed on read file!\n");
 		return FAILED;
@@ -731,6 +815,120 @@ send_result_read_file:
 	return SUCCEEDED;
 }
 
+static int process_negotiate_v2_cmd(client_t *client, netiso_negotiate_v2_cmd *cmd)
+{
+	netiso_negotiate_v2_result result;
+
+	uint16_t window = BE16(cmd->window);
+
+	client->window = (window < 1) ? 1 : MIN(window, MAX_TAGGED_READS);
+
+	if((cmd->flags & NETISO_FLAG_COMPRESS) && !client->zbuf)
+	{
+		client->zbuf = (uint8_t *)malloc(NETISO_BLOCK_SIZE); // raw transfers if there is no memory
+	}
+
+	DPRINTF("Protocol v2: %i reads in flight%s\n", client->window, client->zbuf ? ", compressed" : "");
+
+	memset(&result, 0, sizeof(result));
+	result.version = BE16(NETISO_PROTOCOL_V2);
+	result.window = BE16(client->window);
+	result.max_read = BE32(BUFFER_SIZE);
+	result.flags = client->zbuf ? NETISO_FLAG_COMPRESS : 0;
+
+	if(send(client->s, (char *)&result, sizeof(result), 0) != sizeof(result))
+	{
+		printf("ERROR: send failed on negotiate v2\n");
+		return FAILED;
+	}
+
+	return SUCCEEDED;
+}
+
+static int compare_tagged_reads(const void *a, const void *b)
+{
+	uint64_t offset_a = BE64(((const netiso_read_file_tagged_cmd *)a)->offset);
+	uint64_t offset_b = BE64(((const netiso_read_file_tagged_cmd *)b)->offset);
+
+	return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+static int send_tagged_read(client_t *client, netiso_read_file_tagged_cmd *cmd)
+{
+	int32_t bytes_read = NONE;
+	netiso_read_file_tagged_result result;
+
+	uint32_t read_size = BE32(cmd->num_bytes);
+	uint64_t offset = BE64(cmd->offset);
+
+	if((read_size <= BUFFER_SIZE) && (client->ro_file->seek(offset, SEEK_SET) >= 0))
+	{
+		bytes_read = client->ro_file->read(client->buf, read_size);
+		if(bytes_read < 0)
+		{
+			bytes_read = NONE;
+		}
+	}
+
+	result.tag = cmd->tag;
+	result.pad = 0;
+	result.bytes_read = (int32_t)BE32(bytes_read);
+
+	if(send(client->s, (char *)&result, sizeof(result), 0) != sizeof(result))
+	{
+		printf("ERROR: send failed on send result (read file tagged)\n");
+		return FAILED;
+	}
+
+	if((bytes_read > 0) && (send_file_data(client, client->buf, bytes_read) != SUCCEEDED))
+	{
+		printf("ERROR: send failed on read file tagged!\n");
+		return FAILED;
+	}
+
+	return SUCCEEDED;
+}
+
+static int process_read_file_tagged_cmd(client_t *client, netiso_read_file_tagged_cmd *cmd)
+{
+	if ((!client->ro_file) || (!client->buf) || (!client->window))
+		return FAILED;
+
+	netiso_read_file_tagged_cmd reads[MAX_TAGGED_READS];
+	int count = 0;
+
+	memcpy(&reads[count++], cmd, sizeof(netiso_cmd));
+
+	// collect the reads already in flight, up to the negotiated window
+	while((count < client->window) && data_available(client->s))
+	{
+		netiso_cmd next;
+		if(recv_all(client->s, (void *)&next, sizeof(next)) != sizeof(next))
+			return FAILED;
+
+		if(BE16(next.opcode) != NETISO_CMD_READ_FILE_TAGGED)
+		{
+			client->pending_cmd = next;
+			client->has_pending = 1;
+			break;
+		}
+
+		memcpy(&reads[count++], &next, sizeof(netiso_cmd));
+	}
+
+	// results can be sent in any order: serve them by offset to keep the reads sequential
+	if(count > 1)
+		qsort(reads, count, sizeof(netiso_read_file_tagged_cmd), compare_tagged_reads);
+
+	for (int i = 0; i < count; i++)
+	{
+		if(send_tagged_read(client, &reads[i]) != SUCCEEDED)
+			return FAILED;
+	}
+
+	return SUCCEEDED;
+}
+
 static int process_create_cmd(client_t *client, netiso_create_cmd *cmd)
 {
 	netiso_create_result result;
@@ -1576,7 +1774,15 @@ void *client_thread(void *arg)
 	for(;;)
 	{
 		netiso_cmd cmd;
-		int ret = recv_all(client->s, (void *)&cmd, sizeof(cmd));
+		int ret = sizeof(cmd);
+
+		if(client->has_pending)
+		{
+			cmd = client->pending_cmd;
+			client->has_pending = 0;
+		}
+		else
+			ret = recv_all(client->s, (void *)&cmd, sizeof(cmd));
 
 		if(ret != sizeof(cmd))
 		{
@@ -1645,6 +1851,14 @@ void *client_thread(void *arg)
 				ret = process_rmdir_cmd(client, (netiso_rmdir_cmd *)&cmd);
 			break;
 
+			case NETISO_CMD_NEGOTIATE_V2:
+				ret = process_negotiate_v2_cmd(client, (netiso_negotiate_v2_cmd *)&cmd);
+			break;
+
+			case NETISO_CMD_READ_FILE_TAGGED:
+				ret = process_read_file_tagged_cmd(client, (netiso_read_file_tagged_cmd *)&cmd);
+			break;
+
 			default:
 				printf("ERROR: Unknown command received: %04X\n", BE16(cmd.opcode));
 				ret = FAILED;
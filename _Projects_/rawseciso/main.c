@@ -37,6 +37,7 @@ SYS_MODULE_STOP(rawseciso_stop);
 #endif
 
 #define MIN(a, b)		((a) <= (b) ? (a) : (b))
+#define MAX(a, b)		((a) >= (b) ? (a) : (b))
 #define ABS(a)			(((a) < 0) ? -(a) : (a))
 
 #define CD_CACHE_SIZE			(48) // sectors 48*2448 = 115KB (up to 52 sectors fit in 128KB)
@@ -69,7 +70,6 @@ enum EMU_TYPE
 #define OK	  0
 #define FAILED -1
 
-#define LAST_SECTOR				1
 #define READ_SECTOR				0xFFFFFFFF
 
 #define NONE -1
@@ -310,254 +310,342 @@ static void memcpy64(void *dst, void *src, int n)
 	}
 }
 
-static void get_next_read(u64 discoffset, u64 bufsize, u64 *offset, u64 *readsize, int *idx, u64 sec_size)
+// extent map: disc offset where each section starts (prefix sums), built on the first read of a set of sections
+// and searched with the last hit (sequential reads) or a binary search instead of walking all the sections
+#define EXTENT_MAP_MIN		16	// fewer sections are walked
+
+static u64 *extent_start = NULL;	// num_sections + 1 entries
+static u32 extent_max = 0;			// entries allocated
+static u32 *extent_sections = NULL;	// sections of the map
+static u64 extent_sec_size = 0;
+static u32 extent_last = 0;
+
+static u64 section_bytes(u32 i, u64 sec_size)
+{
+	if((i == 0) && (IS_FAKE_ISO))
+		return (((u64)sections_size[i]) * CD_SECTOR_SIZE_2048);
+	else
+		return (((u64)sections_size[i]) * sec_size);
+}
+
+static int build_extent_map(u64 sec_size)
 {
+	extent_sections = NULL;
+
+	if(num_sections < EXTENT_MAP_MIN) return 0;
+
+	if(num_sections >= extent_max)
+	{
+		if(extent_start) sys_memory_free((sys_addr_t)extent_start);
+		extent_start = NULL; extent_max = 0;
+
+		u32 size = ((num_sections + 1) * sizeof(u64) + _64KB_ - 1) & ~(_64KB_ - 1);
+		sys_addr_t addr;
+		if(sys_memory_allocate(size, SYS_MEMORY_PAGE_SIZE_64K, &addr) == CELL_OK) extent_start = (u64 *)addr;
+		if(!extent_start) return 0;
+
+		extent_max = size / sizeof(u64);
+	}
+
 	u64 base = 0;
+	for(u32 i = 0; i < num_sections; i++)
+	{
+		extent_start[i] = base; base += section_bytes(i, sec_size);
+	}
+	extent_start[num_sections] = base;
+
+	extent_sections = sections, extent_sec_size = sec_size, extent_last = 0;
+	return 1;
+}
+
+static void get_next_read(u64 discoffset, u64 bufsize, u64 *offset, u64 *readsize, int *idx, u64 sec_size)
+{
+	u64 base = 0, last = 0;
 	*idx = NONE;
 	*readsize = bufsize;
 	*offset = 0;
 
-	for(u32 i = 0; i < num_sections; i++)
+	if(((extent_sections == sections) && (extent_sec_size == sec_size)) || build_extent_map(sec_size))
 	{
-		u64 last;
-		u64 sz;
+		if(discoffset >= extent_start[num_sections]) goto out_of_range;
 
-		if((i == 0) && (IS_FAKE_ISO))
-			sz = (((u64)sections_size[i]) * CD_SECTOR_SIZE_2048);
-		else
-			sz = (((u64)sections_size[i]) * sec_size);
+		u32 i = extent_last;
+
+		if((discoffset < extent_start[i]) || (discoffset >= extent_start[i + 1]))
+		{
+			// find the last section that starts at or before discoffset
+			u32 lo = 0, hi = num_sections;
+
+			if((discoffset >= extent_start[i + 1]) && (discoffset < extent_start[i + 2])) lo = i + 1, hi = i + 2; // next section
+
+			while(hi - lo > 1)
+			{
+				u32 mid = (lo + hi) / 2;
+				if(extent_start[mid] <= discoffset) lo = mid; else hi = mid;
+			}
 
-		last = base + sz;
+			i = extent_last = lo;
+		}
 
-		if(discoffset >= base && discoffset < last)
+		base = extent_start[i], last = extent_start[i + 1];
+		*idx = i;
+	}
+	else
+	{
+		for(u32 i = 0; i < num_sections; i++)
 		{
-			u64 maxfileread = last-discoffset;
+			last = base + section_bytes(i, sec_size);
 
-			if(bufsize > maxfileread)
-				*readsize = maxfileread;
-			else
-				*readsize = bufsize;
+			if(discoffset >= base && discoffset < last)
+			{
+				*idx = i;
+				break;
+			}
 
-			*idx = i;
-			*offset = discoffset-base;
-			return;
+			base = last;
 		}
+	}
 
-		base += sz;
+	if(*idx != NONE)
+	{
+		u64 maxfileread = last-discoffset;
+
+		if(bufsize > maxfileread)
+			*readsize = maxfileread;
+		else
+			*readsize = bufsize;
+
+		*offset = discoffset-base;
+		return;
 	}
 
+out_of_range:
 	// We can be here on video blu-ray
 	DPRINTF("Offset or size out of range  %lx%08lx   %lx!!!!!!!!\n", discoffset>>32, discoffset, bufsize);
 }
 
-u8 last_sect_buf[4096] __attribute__((aligned(16)));
-u32 last_sect = READ_SECTOR;
+// set-associative cache of device sectors for partial sectors & short reads (ISO, PSX & multi PSX paths)
+// lines of whole device sectors are stored [way][set], so the following lines of a way are contiguous
+// and sequential misses prefetch them with a single sys_storage_read
+#define SECT_CACHE_WAYS		4
+#define SECT_CACHE_LINE		_8KB_
+#define SECT_CACHE_PREFETCH	8		// lines loaded by a sequential miss
+#define SECT_CACHE_LINES	32		// _256KB_ / SECT_CACHE_LINE
+
+static u8 sect_cache_buf[4096] __attribute__((aligned(16))); // single line if nothing can be allocated
+static u8 *sect_cache = NULL;
+static u32 sect_cache_mem = 0;		// bytes allocated (0 = sect_cache_buf)
+static u32 sect_tag[SECT_CACHE_LINES];	// line number + 1 (0 = empty)
+static u32 sect_stamp[SECT_CACHE_LINES];
+static u32 sect_clock, sect_ways, sect_sets, sect_line_sectors, sect_line_bytes;
+static u32 sect_next_line;			// line after the last miss
+static u32 sect_hits = 0, sect_misses = 0, sect_prefetched = 0;
+
+static void sect_cache_reset(void)
+{
+	memset(sect_tag, 0, sizeof(sect_tag));
+	memset(sect_stamp, 0, sizeof(sect_stamp));
+	sect_clock = 0, sect_next_line = READ_SECTOR;
+}
 
-static int process_read_iso_cmd(u8 *buf, u64 offset, u64 size)
+// sized by the free memory: 256KB, 128KB, 64KB or the static line
+static void sect_cache_init(void)
 {
-	u64 remaining;
-	int x;
+	sys_memory_info_t mem_info;
+	if(sys_memory_get_user_memory_size(&mem_info) != CELL_OK) mem_info.available_user_memory = 0;
 
-	//DPRINTF("read iso: %p %lx %lx\n", buf, offset, size);
-	remaining = size;
+	u32 avail = mem_info.available_user_memory;
+	u32 size = (avail >= 0x300000) ? _256KB_ : (avail >= 0x200000) ? _128KB_ : (avail >= 0x100000) ? _64KB_ : 0;
+	u32 line = SECT_CACHE_LINE;
 
-	while(remaining)
+	sect_cache_mem = 0;
+	if(size)
 	{
-		u64 pos, readsize;
-		int idx;
-		int ret;
-		u32 sector;
-		u32 r;
+		sys_addr_t addr;
+		if(sys_memory_allocate(size, SYS_MEMORY_PAGE_SIZE_64K, &addr) == CELL_OK) {sect_cache = (u8 *)addr; sect_cache_mem = size;}
+	}
+	if(!sect_cache_mem) {sect_cache = sect_cache_buf; size = line = sizeof(sect_cache_buf);}
 
-		if(!ntfs_running) return FAILED;
+	sect_line_sectors = MAX(1, line / (u32)sec_size);
+	sect_line_bytes = sect_line_sectors * (u32)sec_size;
 
-		get_next_read(offset, remaining, &pos, &readsize, &idx, sec_size);
+	u32 lines = MIN(size / sect_line_bytes, SECT_CACHE_LINES);
+	sect_ways = MAX(1, MIN(SECT_CACHE_WAYS, lines));
+	sect_sets = MAX(1, lines / sect_ways);
 
-		if((idx == NONE) || (sections[idx] == 0xFFFFFFFF))
-		{
-			memset(buf, 0, readsize);
-			buf += readsize;
-			offset += readsize;
-			remaining -= readsize;
-			continue;
-		}
+	sect_hits = sect_misses = sect_prefetched = 0;
+	sect_cache_reset();
+}
 
-		if(pos % sec_size)
-		{
-			sector = sections[idx] + (pos / sec_size);
-			for(x = 0; x < 16; x++)
-			{
-				r = 0;
-				if(last_sect == sector)
-				{
-					ret = OK; r = LAST_SECTOR;
-				}
-				else
-					ret = sys_storage_read(handle, 0, sector, 1, last_sect_buf, &r, 0);
+static void sect_cache_free(void)
+{
+	DPRINTF("sector cache: %u hits, %u misses, %u lines prefetched\n", sect_hits, sect_misses, sect_prefetched);
 
-				if((ret == OK) && (r == LAST_SECTOR))
-					last_sect = sector;
-				else
-					last_sect = READ_SECTOR;
+	if(sect_cache_mem) sys_memory_free((sys_addr_t)sect_cache);
+	sect_cache = NULL, sect_cache_mem = 0;
+}
 
-				if((ret != OK) || (r != LAST_SECTOR))
-				{
-					if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
+static int read_device_sectors(u32 sector, u32 n, u8 *buf)
+{
+	int ret;
+	u32 r;
 
-					if((ret == (int) 0x80010002) || (ret == (int) 0x8001002D))
-					{
-						if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
+	for(int x = 0; x < 16; x++)
+	{
+		r = 0;
+		ret = sys_storage_read(handle, 0, sector, n, buf, &r, 0);
 
-						while(ntfs_running)
-						{
-							if(sys_storage_get_device_info(usb_device, &disc_info) == OK)
-							{
-								ret = sys_storage_open(usb_device, 0, &handle, 0);
-								if(ret == OK) break;
+		if((ret == OK) && (r == n)) return OK;
 
-								handle = SYS_DEVICE_HANDLE_NONE; sysUsleep(500000);
-							}
-							else sysUsleep(7000000);
-						}
-						x= -1; continue;
-					}
+		if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
 
+		if((ret == (int) 0x80010002) || (ret == (int) 0x8001002D))
+		{
+			if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
 
-					if(x == 15 || !ntfs_running)
-					{
-						DPRINTF("sys_storage_read failed: %x 1 -> %x\n", sector, ret);
-						return FAILED;
-					}
-					else sysUsleep(100000);
+			while(ntfs_running)
+			{
+				if(sys_storage_get_device_info(usb_device, &disc_info) == OK)
+				{
+					ret = sys_storage_open(usb_device, 0, &handle, 0);
+					if(ret == OK) break;
+
+					handle = SYS_DEVICE_HANDLE_NONE; sysUsleep(500000);
 				}
-				else break;
+				else sysUsleep(7000000);
 			}
 
-			u64 csize = sec_size - (pos % sec_size);
+			sect_cache_reset(); // the device was reconnected
+			x = -1; continue;
+		}
+
+		if(x == 15 || !ntfs_running)
+		{
+			DPRINTF("sys_storage_read failed: %x %x -> %x\n", sector, n, ret);
+			return FAILED;
+		}
+		else sysUsleep(100000);
+	}
+
+	return FAILED;
+}
 
-			if(csize > readsize) csize = readsize;
+// returns the cached line that holds the sector, NULL on read error (*err = error code)
+static u8 *sect_cache_line(u32 sector, int *err)
+{
+	u32 line = sector / sect_line_sectors, set = line % sect_sets, victim = 0, i;
 
-			memcpy64(buf, last_sect_buf + (pos % sec_size), csize);
-			buf += csize;
-			offset += csize;
-			pos += csize;
-			remaining -= csize;
-			readsize -= csize;
+	for(u32 way = 0; way < sect_ways; way++)
+	{
+		i = (way * sect_sets) + set;
+		if(sect_tag[i] == line + 1)
+		{
+			sect_stamp[i] = ++sect_clock; sect_hits++;
+			return sect_cache + (i * sect_line_bytes);
 		}
+		if(sect_stamp[i] < sect_stamp[(victim * sect_sets) + set]) victim = way;
+	}
+
+	sect_misses++;
+
+	// a sequential miss also loads the next lines of the victim way (up to the last set)
+	u32 count = (line == sect_next_line) ? MIN(SECT_CACHE_PREFETCH, sect_sets - set) : 1;
+	u32 first = line * sect_line_sectors, n = count * sect_line_sectors;
+
+	if(disc_info.sector_count)
+	{
+		// a line past the last sector of the device can't be read
+		if(first >= disc_info.sector_count) {*err = FAILED; sect_next_line = READ_SECTOR; return NULL;}
+		if((u64)first + n > disc_info.sector_count) n = (u32)(disc_info.sector_count - first);
+	}
+	count = (n + sect_line_sectors - 1) / sect_line_sectors;
 
-		if(readsize)
+	// drop copies of the loaded lines held by other ways & the lines being replaced
+	for(u32 l = 0; l < count; l++)
+		for(u32 way = 0; way < sect_ways; way++)
 		{
-			u32 n = readsize / sec_size;
+			i = (way * sect_sets) + set + l;
+			if((way == victim) || (sect_tag[i] == line + l + 1)) sect_tag[i] = 0;
+		}
 
-			if(n)
-			{
-				sector = sections[idx] + (pos / sec_size);
-				for(x = 0; x < 16; x++)
-				{
-					r = 0;
-					ret = sys_storage_read(handle, 0, sector, n, buf, &r, 0);
+	i = (victim * sect_sets) + set;
 
-					if((ret == OK) && (r == n))
-						last_sect = sector + n - 1;
-					else
-						last_sect = READ_SECTOR;
+	*err = read_device_sectors(first, n, sect_cache + (i * sect_line_bytes));
+	if(*err) {sect_next_line = READ_SECTOR; return NULL;}
 
-					if((ret != OK) || (r != n))
-					{
-						if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
+	for(u32 l = 0; l < count; l++) {sect_tag[i + l] = line + l + 1; sect_stamp[i + l] = ++sect_clock;}
 
-						if((ret == (int) 0x80010002) || (ret == (int) 0x8001002D))
-						{
-							if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
+	sect_prefetched += count - 1;
+	sect_next_line = line + count;
 
-							while(ntfs_running)
-							{
-								if(sys_storage_get_device_info(usb_device, &disc_info) == OK)
-								{
-									ret = sys_storage_open(usb_device, 0, &handle, 0);
-									if(ret == OK) break;
-
-									handle = SYS_DEVICE_HANDLE_NONE; sysUsleep(500000);
-								}
-								else sysUsleep(7000000);
-							}
-							x= -1; continue;
-						}
+	return sect_cache + (i * sect_line_bytes);
+}
 
-						if(x == 15 || !ntfs_running)
-						{
-							DPRINTF("sys_storage_read failed: %x %x -> %x\n", sector, n, ret);
-							return FAILED;
-						}
-						else sysUsleep(100000);
-					}
-					else break;
-				}
+static int process_read_iso_cmd(u8 *buf, u64 offset, u64 size)
+{
+	u64 remaining;
+	int ret;
 
-				u64 s = n * sec_size;
+	//DPRINTF("read iso: %p %lx %lx\n", buf, offset, size);
+	remaining = size;
 
-				buf += s;
-				offset += s;
-				pos += s;
-				remaining -= s;
-				readsize -= s;
-			}
+	if(!sect_cache) sect_cache_init();
 
-			if(readsize)
-			{
-				sector = sections[idx] + pos / sec_size;
-				for(x = 0; x < 16; x++)
-				{
-					r = 0;
-					if(last_sect == sector)
-					{
-						ret = OK; r = LAST_SECTOR;
-					}
-					else
-						ret = sys_storage_read(handle, 0, sector, 1, last_sect_buf, &r, 0);
+	while(remaining)
+	{
+		u64 pos, readsize;
+		int idx;
 
-					if((ret == OK) && (r == LAST_SECTOR))
-						last_sect = sector;
-					else
-						last_sect = READ_SECTOR;
+		if(!ntfs_running) return FAILED;
 
-					if((ret != OK) || (r != LAST_SECTOR))
-					{
-						if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
+		get_next_read(offset, remaining, &pos, &readsize, &idx, sec_size);
 
-						if((ret == (int) 0x80010002) || (ret == (int) 0x8001002D))
-						{
-							if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
+		if((idx == NONE) || (sections[idx] == 0xFFFFFFFF))
+		{
+			memset(buf, 0, readsize);
+			buf += readsize;
+			offset += readsize;
+			remaining -= readsize;
+			continue;
+		}
 
-							while(ntfs_running)
-							{
-								if(sys_storage_get_device_info(usb_device, &disc_info) == OK)
-								{
-									ret = sys_storage_open(usb_device, 0, &handle, 0);
-									if(ret == OK) break;
-
-									handle = SYS_DEVICE_HANDLE_NONE; sysUsleep(500000);
-								}
-								else sysUsleep(3000000);
-							}
-							x= -1; continue;
-						}
+		// fragments that are contiguous on the device are read with one request
+		for(u32 i = idx; (readsize < remaining) && (i + 1 < num_sections) && !((i == 0) && (IS_FAKE_ISO)) && (sections[i] + sections_size[i] == sections[i + 1]); i++)
+		{
+			readsize = MIN(remaining, readsize + ((u64)sections_size[i + 1] * sec_size));
+		}
 
-						if(x == 15 || !ntfs_running)
-						{
-							DPRINTF("sys_storage_read failed: %x 1 -> %x\n", sector, ret);
-							return FAILED;
-						}
-						else sysUsleep(100000);
-					}
-					else break;
-				}
+		while(readsize)
+		{
+			u32 sector = sections[idx] + (pos / sec_size);
+			u64 csize;
 
-				memcpy64(buf, last_sect_buf, readsize);
-				buf += readsize;
-				offset += readsize;
-				remaining -= readsize;
+			if((pos % sec_size) || (readsize < sect_line_bytes))
+			{
+				// partial sectors & short reads are served by the sector cache
+				u8 *line = sect_cache_line(sector, &ret);
+				if(!line) return ret;
+
+				u32 line_pos = ((sector % sect_line_sectors) * (u32)sec_size) + (u32)(pos % sec_size);
+
+				csize = MIN(readsize, sect_line_bytes - line_pos);
+				memcpy64(buf, line + line_pos, csize);
+			}
+			else
+			{
+				u32 n = readsize / sec_size;
+
+				ret = read_device_sectors(sector, n, buf);
+				if(ret) return ret;
+
+				csize = n * sec_size;
 			}
+
+			buf += csize;
+			offset += csize;
+			pos += csize;
+			remaining -= csize;
+			readsize -= csize;
 		}
 	}
 
@@ -780,6 +868,13 @@ static int process_read_cd_2048_cmd(u8 *buf, u32 start_sector, u32 sector_count)
 
 static int process_read_cd_2352_cmd(u8 *buf, u32 sector, u32 remaining)
 {
+	// short reads go to the sector cache (keeps interleaved streams apart),
+	// longer reads keep the 48-sector readahead window
+	if(sect_cache_mem && (remaining * CD_SECTOR_SIZE_2352 < SECT_CACHE_LINE))
+	{
+		return process_read_iso_cmd(buf, sector * CD_SECTOR_SIZE_2352, remaining * CD_SECTOR_SIZE_2352);
+	}
+
 	if(remaining <= CD_CACHE_SIZE)
 	{
 		int dif = (int)cached_cd_sector - sector;
@@ -1388,6 +1483,14 @@ static void rawseciso_thread(u64 arg)
 		sys_memory_free((sys_addr_t)cd_cache);
 	}
 
+	sect_cache_free();
+
+	if(extent_start)
+	{
+		sys_memory_free((sys_addr_t)extent_start);
+	}
+	extent_start = NULL, extent_sections = NULL, extent_max = 0;
+
 	if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle);
 
 	if(discfd != NONE) cellFsClose(discfd);
@@ -14,20 +14,6 @@
 
 const char argb_magic[] = "ARGB";
 
-enum argb_flags {
-	ARGB_FLAG_TRANSPARENCY = 0x1 // image has A values less than 0xFF
-};
-
-// 128 byte header, big-endian values
-typedef struct {
-	char magic[4];        // ASCII "ARGB"
-	uint32_t nx;
-	uint32_t ny;
-	uint32_t flags;       // Used for indicating existing transparent pixels
-	uint8_t padding[112]; // Padding to 128 byte cache line boundary on PS3
-	// uncompressed pixel data following as ARGB (uint32_t)
-} argb_h_t;
-
 /***********************************************************************
 * load argb file
 * file_path = path to argb file e.g. "/dev_hdd0/test.argb"
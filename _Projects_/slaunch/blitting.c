@@ -2,8 +2,10 @@
 #include "include/argb_dec.h"
 #include "include/png_dec.h"
 #include "include/jpg_dec.h"
+#include "include/thumb_cache.h"
 #include "include/misc.h"
 #include "include/mem.h"
+#include "../../blitter.h"
 
 #define FAILED -1
 
@@ -28,6 +30,11 @@ static uint32_t offset_720p(uint32_t x, uint32_t y) {return OFFSET_720p(x, y);}
 static uint32_t offset_576p(uint32_t x, uint32_t y) {return OFFSET_576p(x, y);}
 static uint32_t offset_480p(uint32_t x, uint32_t y) {return OFFSET_480p(x, y);}
 
+// 1080p framebuffer rows are contiguous: whole rows are blitted at once
+#define IS_1080			(fn_offset == offset_1080)
+#define FB_ROW(x, y)	((uint32_t*)OFFSET(x, y))
+#define PAIRS(x, xe)	(((xe) - (x) + 1) & ~1)	// pixels written by the 64-bit loops from x to xe
+
 /***********************************************************************
 * get font object
 ***********************************************************************/
@@ -354,6 +361,8 @@ void dim_bg(float ds, float de)
 		}
 		sys_timer_usleep(250);
 	}
+
+	ctx.damage_count = DAMAGE_FULL;
 }
 
 /***********************************************************************
@@ -364,6 +373,15 @@ void dump_bg(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 	uint32_t i, k, kk, m, CANVAS_WW = w/2;
 	uint64_t *bg = (uint64_t*)ctx.canvas;
 
+	ctx.damage_count = DAMAGE_FULL; // the canvas is used as backup
+
+	if(IS_1080)
+	{
+		for(i = 0; i < h; i++, y++)
+			blit_copy(ctx.canvas + (i * (CANVAS_WW<<1)), FB_ROW(x, y), CANVAS_WW<<1);
+		return;
+	}
+
 	for(i = 0; i < h; i++, y++)
 		for(m = i * CANVAS_WW, k = 0, kk = x; k < CANVAS_WW; k++, kk+=2)
 			bg[m++] = *(uint64_t*)(OFFSET(kk, y));
@@ -395,6 +413,7 @@ void init_graphic()
 	if(disp_h == 576)	fn_offset = offset_576p; else
 						fn_offset = offset_480p;
 
+	ctx.damage_count = DAMAGE_FULL;
 	flip_frame();
 
 	//getDisplayPitch(&pitch, &unk1);	   // framebuffer pitch size
@@ -407,17 +426,20 @@ void init_graphic()
 *
 * int32_t idx	  = index of img, max 11 (0 - 10)
 * const char *path = path to img file
+* uint8_t warm	  = only store the cover in the thumbnail cache
 ***********************************************************************/
-int32_t load_img_bitmap(int32_t idx, char *path, const char *default_img)
+static int32_t decode_img(int32_t idx, char *path, const char *default_img, uint8_t warm)
 {
 	if(!path || *path != '/') return FAILED;
 
 	if(idx > IMG_MAX) return FAILED;
 	uint32_t *buf=ctx.canvas;
-	if(idx) buf=ctx.imgs;
+	if(idx) buf=ctx.imgs; else ctx.damage_count = DAMAGE_FULL; // new background
 
 	if(!buf) return FAILED;
 
+	uint8_t mode = idx ? ((disp_h < 720) ? 1 : gpp) : 0; // covers are cached per grid (background isn't)
+
 	bool use_default = (*default_img == '/');
 
 	char *ext = strchr(path, '.');
@@ -430,6 +452,9 @@ int32_t load_img_bitmap(int32_t idx, char *path, const char *default_img)
 		use_default = false;
 	}
 
+	// decoded & scaled by a previous page
+	if(mode && !thumb_load(path, mode, &ctx.img[idx], warm ? NULL : buf)) return 0;
+
 retry:
 
 	if(strstr(ext, ".png") || strstr(ext, ".PNG"))
@@ -449,6 +474,8 @@ retry:
 
 blank_image:
 
+		mode = 0; // not cached
+
 		if(gpp == 10)
 		{
 			ctx.img[idx].w=260;
@@ -463,7 +490,7 @@ blank_image:
 		memset32(buf, 0x80808080, ctx.img[idx].w * ctx.img[idx].h);
 	}
 
-	if(disp_h<720) return 0;
+	if(disp_h<720) goto cache;
 
 	if(gpp==10 && ctx.img[idx].w<=(MAX_W/2) && ctx.img[idx].h<=(MAX_H/2))
 	{
@@ -514,59 +541,141 @@ downscale:
 		if(ctx.img[idx].w>168 || ctx.img[idx].h>168) goto downscale;
 	}
 
+cache:
+	if(mode) thumb_save(path, mode, &ctx.img[idx]);
+
 	return 0;
 }
 
+int32_t load_img_bitmap(int32_t idx, char *path, const char *default_img)
+{
+	return decode_img(idx, path, default_img, 0);
+}
+
 /***********************************************************************
-* alpha blending (ARGB)
-*
-* uint32_t bg = background color
-* uint32_t fg = foreground color
+* decode & scale a cover into the thumbnail cache without drawing it
+* (borrows the last image slot, ctx.imgs is free once a page is drawn)
 ***********************************************************************/
-static uint32_t mix_color(uint32_t bg, uint32_t fg)
+void cache_img_bitmap(char *path, const char *default_img)
 {
-  uint32_t a = fg >>24;
+	Buffer slot = ctx.img[IMG_MAX - 1];
+	decode_img(IMG_MAX - 1, path, default_img, 1);
+	ctx.img[IMG_MAX - 1] = slot;
+}
 
-  if(a == 0) return bg; // fg is transparent
+/*
+******** 1920 0x2000 (8192) / 4 = 2048 pitch
+** ** ** 1280 0x1400 (5120) / 4 = 1280
+*  *  *   720 0x0C00 (3072) / 4 =  768
+*/
 
-  uint32_t aa = a ^ 0xFF;
+/***********************************************************************
+* damage tracking: the framebuffer areas that differ from the canvas
+* (drawn by set_texture, set_textbox, set_backdrop, print_text...)
+***********************************************************************/
+void merge_rect(Rect *r, const Rect *add)
+{
+	if((add->x2 <= add->x) || (add->y2 <= add->y)) return;
+	if((r->x2 <= r->x) || (r->y2 <= r->y)) {*r = *add; return;}
 
-  uint32_t rb = (((fg & 0x00FF00FF) * a) + ((bg & 0x00FF00FF) * aa)) & 0xFF00FF00;
-  uint32_t g  = (((fg & 0x0000FF00) * a) + ((bg & 0x0000FF00) * aa)) & 0x00FF0000;
-  fg = a + ((bg >>24) * aa >>8);
+	if(add->x  < r->x ) r->x  = add->x;
+	if(add->y  < r->y ) r->y  = add->y;
+	if(add->x2 > r->x2) r->x2 = add->x2;
+	if(add->y2 > r->y2) r->y2 = add->y2;
+}
+
+void add_damage(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+	Rect r; uint8_t i;
+
+	if(ctx.damage_count >= DAMAGE_FULL) return;
+
+	if((x >= CANVAS_W) || (y >= CANVAS_H) || !w || !h) return;
+
+	// the pixels are flipped in pairs
+	r.x  = x & ~1, r.y = y;
+	r.x2 = (w >= CANVAS_W - x) ? CANVAS_W : ((x + w + 2) & ~1);
+	r.y2 = (h >= CANVAS_H - y) ? CANVAS_H : (y + h);
+	if(r.x2 > CANVAS_W) r.x2 = CANVAS_W;
 
-  return (fg <<24) | ((rb | g) >>8);
+	// join an overlapping or adjacent rectangle (a tile, its backdrop & its frame become one)
+	for(i = 0; i < ctx.damage_count; i++)
+	{
+		Rect *d = &ctx.damage[i];
+		if((r.x <= d->x2) && (d->x <= r.x2) && (r.y <= d->y2) && (d->y <= r.y2)) {merge_rect(d, &r); return;}
+	}
+
+	if(ctx.damage_count < DAMAGE_MAX)
+		ctx.damage[ctx.damage_count++] = r;
+	else
+		ctx.damage_count = DAMAGE_FULL;
 }
 
-static inline uint64_t mix_color64(uint64_t bg, uint64_t fg)
+void reset_text_damage(void)
 {
-  return ((uint64_t)(mix_color(bg, fg>>32))<<32 | mix_color(bg, fg));
+	ctx.text.x = ctx.text.y = ctx.text.x2 = ctx.text.y2 = 0;
 }
 
-/*
-******** 1920 0x2000 (8192) / 4 = 2048 pitch
-** ** ** 1280 0x1400 (5120) / 4 = 1280
-*  *  *   720 0x0C00 (3072) / 4 =  768
-*/
+static void flip_rect(const Rect *r)
+{
+	uint64_t *canvas = (uint64_t *)ctx.canvas;
+	uint32_t i, k;
+
+	for(i = r->y; i < r->y2; i++)
+		if(IS_1080)
+			blit_copy(FB_ROW(r->x, i), ctx.canvas + (i * CANVAS_W) + r->x, r->x2 - r->x);
+		else
+			for(k = r->x; k < r->x2; k+=2)
+				*(uint64_t*)(OFFSET(k, i)) = canvas[(i * CANVAS_W + k)>>1];
+}
 
 /***********************************************************************
 * flip finished frame into paused ps3-framebuffer
+* only the damaged areas are restored from the canvas
 ***********************************************************************/
 void flip_frame(void)
 {
-	uint64_t *canvas = (uint64_t *)ctx.canvas;
-	uint32_t i, k, m, CANVAS_WW = CANVAS_W/2;
+	const Rect full = {0, 0, CANVAS_W, CANVAS_H};
 
-	for(i = 0; i < CANVAS_H; i++)
-		for(m = i * CANVAS_WW, k = 0; k < CANVAS_W; k+=2)
-			*(uint64_t*)(OFFSET(k, i)) =
-				 canvas[m++];
+	if(ctx.damage_count >= DAMAGE_FULL)
+		flip_rect(&full);
+	else
+		for(uint8_t i = 0; i < ctx.damage_count; i++) flip_rect(&ctx.damage[i]);
+
+	ctx.damage_count = 0;
+}
+
+// copy the area r of a texture (text_width pixels per row) into the framebuffer at x, y
+void set_texture_rect(uint32_t *texture, uint32_t text_width, uint32_t x, uint32_t y, const Rect *r)
+{
+	uint32_t i, k, kx = r->x & ~1, w = ((r->x2 + 1) & ~1) - kx;
+
+	if((r->x2 <= r->x) || (r->y2 <= r->y)) return;
+
+	for(i = r->y; i < r->y2; i++)
+		if(IS_1080)
+			blit_copy(FB_ROW(x + kx, y + i), texture + (i * text_width) + kx, w);
+		else
+			for(k = 0; k < w; k+=2)
+				*(uint64_t*)(OFFSET(x + kx + k, y + i)) = *(uint64_t*)(texture + (i * text_width) + kx + k);
+
+	add_damage(x + kx, y + r->y, w, r->y2 - r->y);
 }
 
 void set_texture_direct(uint32_t *texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
 	uint32_t i, k, m, _width = width>>1, ww = width + x;
 	uint64_t *canvas = (uint64_t*)texture;
+
+	add_damage(x, y, width, height);
+
+	if(IS_1080)
+	{
+		for(i = 0; i < height; i++, y++)
+			blit_copy(FB_ROW(x, y), texture + (i * (_width<<1)), PAIRS(x, ww));
+		return;
+	}
+
 	for(i = 0; i < height; i++, y++)
 		for(m = i * _width, k = x; k < ww; k+=2)
 			*(uint64_t*)(OFFSET(k, y)) =
@@ -575,7 +684,20 @@ void set_texture_direct(uint32_t *texture, uint32_t x, uint32_t y, uint32_t widt
 
 void set_texture(uint8_t idx, uint32_t x, uint32_t y)
 {
-	if (!(ctx.img[idx].w&3) && !ctx.img[idx].b) { // Use VMX SIMD
+	add_damage(x, y, ctx.img[idx].w, ctx.img[idx].h);
+
+	if(IS_1080)
+	{
+		uint32_t i, w = PAIRS(x, ctx.img[idx].w + x), pitch = ctx.img[idx].w & ~1;
+		uint32_t *canvas = ctx.img[idx].addr;
+
+		for(i = 0; i < ctx.img[idx].h; i++, y++, canvas += pitch)
+			if(ctx.img[idx].b)	// png - blend with 18% gray background
+				blit_blend_over(FB_ROW(x, y), 0x80303030, canvas, w);
+			else
+				blit_copy(FB_ROW(x, y), canvas, w);
+	}
+	else if (!(ctx.img[idx].w&3) && !ctx.img[idx].b) { // Use VMX SIMD
 		uint32_t i, k, kk, m, _width = ctx.img[idx].w>>2;
 		vec_uint4 *canvas = (vec_uint4*)ctx.img[idx].addr;
 
@@ -595,59 +717,62 @@ void set_texture(uint8_t idx, uint32_t x, uint32_t y)
 		else				// png - blend with 18% gray background
 			for(i = 0; i < ctx.img[idx].h; i++, y++)
 				for(m = i * _width, k = x; k < ww; k+=2, m++)
-					*(uint64_t*)(OFFSET(k, y)) = mix_color64(0x80303030, canvas[m]);
+					*(uint64_t*)(OFFSET(k, y)) = ((uint64_t)blit_mix(0x80303030, canvas[m]>>32)<<32 | blit_mix(0x80303030, canvas[m]));
 	}
 }
 
-#define DIM_PIXEL(p)	new_pixel = canvas[p]; \
-						pixel = (uint8_t*)&new_pixel; \
-						pixel[1] -= (pixel[1]>>2); \
-						pixel[2] -= (pixel[2]>>2); \
-						pixel[3] -= (pixel[3]>>2); \
-						pixel[5] -= (pixel[5]>>2); \
-						pixel[6] -= (pixel[6]>>2); \
-						pixel[7] -= (pixel[7]>>2); \
-						new_pixel = *((uint64_t*)pixel);
+// copy (or dim to 75%) the canvas pixel pairs k to ke of the row y into the framebuffer from x
+static void set_backdrop_row(uint32_t x, uint32_t y, uint32_t k, uint32_t ke, uint8_t dim)
+{
+	uint64_t *canvas = (uint64_t*)ctx.canvas, pixel;
+
+	if(k >= ke) return;
+
+	if(IS_1080)
+	{
+		if(dim)
+			blit_dim(FB_ROW(x, y), ctx.canvas + (y * CANVAS_W) + (k<<1), (ke - k)<<1);
+		else
+			blit_copy(FB_ROW(x, y), ctx.canvas + (y * CANVAS_W) + (k<<1), (ke - k)<<1);
+		return;
+	}
+
+	for(k += y * (CANVAS_W/2), ke += y * (CANVAS_W/2); k < ke; k++, x+=2)
+	{
+		pixel = canvas[k];
+		if(dim) pixel = ((uint64_t)blit_dim_pixel(pixel>>32)<<32) | blit_dim_pixel(pixel);
+		*(uint64_t*)(OFFSET(x, y)) = pixel;
+	}
+}
 
 void set_backdrop(uint8_t idx, uint8_t restore)
 {
-	uint32_t i, k, kk, m, CANVAS_WW = CANVAS_W/2;
-	uint64_t *canvas = (uint64_t*)ctx.canvas;
-	uint64_t new_pixel; uint8_t *pixel;
-	uint32_t ww = (ctx.img[idx].x+ctx.img[idx].w)/2;
-	uint32_t hh = (ctx.img[idx].y+ctx.img[idx].h);
+	uint32_t i, x = ctx.img[idx].x, y = ctx.img[idx].y, w = ctx.img[idx].w;
+	uint32_t ww = (x+w)/2;
+	uint32_t hh = (y+ctx.img[idx].h);
 
-	for(i = (ctx.img[idx].y+16); i < (hh+16) ; i++)
-		for(m = i * CANVAS_WW, k = ww, kk=ww<<1; k < ww + 8; k++, kk+=2)
-		{
-			DIM_PIXEL(k + m); //75%
-			*(uint64_t*)(OFFSET(kk, i)) = new_pixel;
-		}
+	add_damage(x + w, y + 16, 16, ctx.img[idx].h);	// shadow
+	add_damage(x + 16, hh, w, 16);
+
+	for(i = (y+16); i < (hh+16) ; i++)
+		set_backdrop_row(ww<<1, i, ww, ww + 8, 1); //75%
 
 	for(i = hh; i < (hh+16) ; i++)
-		for(m = i * CANVAS_WW, kk = (ctx.img[idx].x+16), k = kk>>1; k < ww; k++, kk+=2)
-		{
-			DIM_PIXEL(k + m); //75%
-			*(uint64_t*)(OFFSET(kk, i)) = new_pixel;
-		}
+		set_backdrop_row(x+16, i, (x+16)>>1, ww, 1); //75%
 
 	if(restore)
 	{
-		for(i = (ctx.img[idx].y-16); i < (hh+32) ; i++)
-			for(m = i * CANVAS_WW, kk = (ctx.img[idx].x-16), k = kk>>1; k < (ctx.img[idx].x)/2; k++, kk+=2)
-				*(uint64_t*)(OFFSET(kk, i)) = canvas[k + m];
+		for(i = (y-16); i < (hh+32) ; i++)
+			set_backdrop_row(x-16, i, (x-16)>>1, x/2, 0);
 
-		for(i = (ctx.img[idx].y-16); i < (ctx.img[idx].y) ; i++)
-			for(m = i * CANVAS_WW, kk = (ctx.img[idx].x), k = kk>>1; k < (ctx.img[idx].x+ctx.img[idx].w+16)/2; k++, kk+=2)
-				*(uint64_t*)(OFFSET(kk, i)) = canvas[k + m];
+		for(i = (y-16); i < y ; i++)
+			set_backdrop_row(x, i, x>>1, (x+w+16)/2, 0);
 
-		for(i = (ctx.img[idx].y); i < (ctx.img[idx].y+16) ; i++)
-			for(m = i * CANVAS_WW, kk = (ctx.img[idx].x+ctx.img[idx].w), k = kk>>1; k < (ctx.img[idx].x+ctx.img[idx].w+16)/2; k++, kk+=2)
-				*(uint64_t*)(OFFSET(kk, i)) = canvas[k + m];
+		for(i = y; i < (y+16) ; i++)
+			set_backdrop_row(x+w, i, (x+w)>>1, (x+w+16)/2, 0);
 
 		for(i = hh; i < (hh+16) ; i++)
-			for(m = i * CANVAS_WW, kk = (ctx.img[idx].x), k = kk>>1; k < (ctx.img[idx].x+16)/2; k++, kk+=2)
-				*(uint64_t*)(OFFSET(kk, i)) = canvas[k + m];
+			set_backdrop_row(x, i, x>>1, (x+16)/2, 0);
 	}
 }
 
@@ -655,6 +780,16 @@ void set_backdrop(uint8_t idx, uint8_t restore)
 void set_textbox(uint64_t color, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
 	uint32_t i, k, _width = width + x;
+
+	add_damage(x, y, width, height);
+
+	if(IS_1080)
+	{
+		for(i = 0, x &= 0xffe; i < height; i++, y++)
+			blit_fill64((uint64_t*)FB_ROW(x, y), color, PAIRS(x, _width)>>1);
+		return;
+	}
+
 	for(i = 0; i < height; i++, y++)
 		for(k = (x&0xffe); k < _width; k+=2)
 			*(uint64_t*)(OFFSET(k, y)) = color;
@@ -710,6 +845,8 @@ int32_t print_text(uint32_t *texture, uint32_t text_width, uint32_t x, uint32_t
 {
 	uint32_t *canvas = texture;
 	uint32_t i, k, m, len = 0;
+	int32_t n;
+	Rect drawn = {0, 0, 0, 0};									  // damage of the glyphs & shadows
 	uint32_t code = 0;											  // char unicode
 	uint32_t t_x = x, t_y = y;									   // temp x/y
 	uint32_t o_x = x, o_y = y + bitmap->horizontal_layout.baseLineY; // origin x/y
@@ -758,25 +895,39 @@ int32_t print_text(uint32_t *texture, uint32_t text_width, uint32_t x, uint32_t
 			t_x = o_x + glyph->metrics.Horizontal.bearingX;
 			t_y = o_y - glyph->metrics.Horizontal.bearingY;
 
-			// draw bitmap
-			for(i = 0; i < glyph->h; i++)
+			// visible columns of the glyph (t_x can be left of the texture)
+			k = ((int32_t)t_x < 0) ? -t_x : 0;
+			n = ((int32_t)(text_width - t_x) < glyph->w) ? (int32_t)(text_width - t_x) : glyph->w;
+
+			// draw bitmap: shadow into the next row, then blend the glyph row
+			for(i = 0; (i < glyph->h) && ((int32_t)k < n); i++)
 			  if(t_y + i < CANVAS_H)
-				  for(m = (t_y + i) * text_width, k = 0; k < glyph->w; k++)
-					if((glyph->image[i * glyph->w + k]) && (t_x + k < text_width))
-					{
-						pixel = m + t_x + k;
-						canvas[pixel + text_width + 1] = color;
-						canvas[pixel] =
-						mix_color(canvas[pixel],
-								 ((uint32_t)glyph->image[i * glyph->w + k] <<24) |
-								 (ctx.fg_color & 0x00FFFFFF));
-					}
+			  {
+				  uint8_t *image = glyph->image + (i * glyph->w);
+				  m = (t_y + i) * text_width + t_x;
+
+				  for(pixel = k; (int32_t)pixel < n; pixel++)
+					if(image[pixel]) canvas[m + pixel + text_width + 1] = color;
+
+				  blit_glyph(canvas + (m + k), image + k, ctx.fg_color, n - k);
+			  }
+
+			if(((int32_t)k < n) && (t_y < CANVAS_H))
+			{
+				Rect g = {t_x + k, t_y, t_x + n + 1, t_y + glyph->h + 1};
+				if(g.x2 > text_width) g.x2 = text_width;
+				if(g.y2 > CANVAS_H) g.y2 = CANVAS_H;
+				merge_rect(&drawn, &g);
+			}
 
 			// get origin-x for next char
 			o_x += glyph->metrics.Horizontal.advance + bitmap->distance;
 		}
 	}
 
+	merge_rect(&ctx.text, &drawn);
+	if(texture == ctx.canvas) add_damage(drawn.x, drawn.y, drawn.x2 - drawn.x, drawn.y2 - drawn.y);
+
 	return o_x;
 }
 
@@ -790,27 +941,29 @@ int32_t print_text(uint32_t *texture, uint32_t text_width, uint32_t x, uint32_t
 * int32_t w		=  width of png part to blit
 * int32_t h		=  height of png part to blit
 ***********************************************************************/
-/*
 int32_t draw_png(int32_t idx, int32_t c_x, int32_t c_y, int32_t p_x, int32_t p_y, int32_t w, int32_t h)
 {
 	uint32_t i, k, m, hh = h, ww = w;
 
+	if((c_x < 0) || (c_y < 0) || (c_x >= CANVAS_W) || (c_y >= CANVAS_H)) return (c_x + w);
+
 	const uint32_t CANVAS_WW = CANVAS_W - c_x, CANVAS_HH = CANVAS_H - c_y;
 
 	if(ww > CANVAS_WW) ww = CANVAS_WW;
 	if(hh > CANVAS_HH) hh = CANVAS_HH;
 
+	add_damage(c_x, c_y, ww, hh); // the canvas differs from the framebuffer
+
 	uint32_t offset = p_x + p_y * ctx.img[idx].w;
 
 	for(i = 0; i < hh; i++)
 		for(m = (c_y + i) * CANVAS_W + c_x, k = 0; k < ww; k++)
 			ctx.canvas[m + k] =
-				mix_color(ctx.canvas[m + k],
+				blit_mix(ctx.canvas[m + k],
 				ctx.img[idx].addr[offset + (k + i * ctx.img[idx].w)]);
 
 	return (c_x + w);
 }
-*/
 
 // some primitives...
 /***********************************************************************
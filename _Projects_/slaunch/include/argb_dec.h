@@ -3,6 +3,25 @@
 
 #include "blitting.h"
 
+enum argb_flags {
+	ARGB_FLAG_TRANSPARENCY = 0x1 // image has A values less than 0xFF
+};
+
+// 128 byte header, big-endian values
+typedef struct {
+	char magic[4];        // ASCII "ARGB"
+	uint32_t nx;
+	uint32_t ny;
+	uint32_t flags;       // Used for indicating existing transparent pixels
+	uint32_t src_key;     // thumbnail cache: 2nd hash of the source path (0 in files made by png2argb)
+	uint32_t src_size;    // thumbnail cache: size of the source image
+	uint64_t src_mtime;   // thumbnail cache: mtime of the source image
+	uint8_t padding[96];  // Padding to 128 byte cache line boundary on PS3
+	// uncompressed pixel data following as ARGB (uint32_t)
+} argb_h_t;
+
+extern const char argb_magic[];
+
 Buffer load_argb(const char *file_path, void* buf_addr);
 
 #endif // _ARGB_DEC_H_
@@ -35,6 +35,9 @@
 #define MAX_H			336
 #define MAX_WH4			(MAX_W * MAX_H * 4)
 
+#define DAMAGE_MAX		64				// dirty rectangles tracked between 2 flips
+#define DAMAGE_FULL		(DAMAGE_MAX + 1)	// the whole canvas must be flipped
+
 #define CENTER_TEXT  0
 
 
@@ -58,6 +61,11 @@
 extern int32_t LINE_HEIGHT;
 
 // graphic buffers
+// dirty rectangle (x2/y2 excluded, empty if x2 <= x)
+typedef struct _Rect {
+	uint16_t x, y, x2, y2;
+} Rect;
+
 typedef struct _Buffer {
 	uint32_t *addr;                // buffer address
 	uint32_t  w;                   // buffer width
@@ -96,6 +104,9 @@ typedef struct _DrawCtx {
 	CellFont font;
 	CellFontRenderer renderer;
 	Buffer   img[IMG_MAX];        // bitmaps
+	Rect     damage[DAMAGE_MAX];  // framebuffer areas changed since the last flip
+	uint8_t  damage_count;        // DAMAGE_FULL = whole canvas
+	Rect     text;                // texture area drawn by print_text since the last reset_text_damage()
 	uint32_t bg_color;            // background color
 	uint32_t fg_color;            // foreground color
 } DrawCtx;
@@ -105,7 +116,11 @@ DrawCtx ctx;                      // drawing context
 void font_finalize(void);
 void init_graphic(void);
 int32_t load_img_bitmap(int32_t idx, char *path, const char *default_img);
+void cache_img_bitmap(char *path, const char *default_img);
 void flip_frame(void);
+void add_damage(uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+void merge_rect(Rect *r, const Rect *add);
+void reset_text_damage(void);
 void dim_bg(float ds, float de);
 void dim_img(float dim);
 void dump_bg(uint32_t x, uint32_t y, uint32_t w, uint32_t h);
@@ -116,6 +131,7 @@ void draw_background(void);
 int32_t print_text(uint32_t *texture, uint32_t text_width, uint32_t x, uint32_t y, const char *str);
 int32_t draw_png(int32_t idx, int32_t c_x, int32_t c_y, int32_t p_x, int32_t p_y, int32_t w, int32_t h);
 void set_texture_direct(uint32_t *texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+void set_texture_rect(uint32_t *texture, uint32_t text_width, uint32_t x, uint32_t y, const Rect *r);
 void set_texture(uint8_t idx, uint32_t x, uint32_t y);
 void set_backdrop(uint8_t idx, uint8_t restore);
 void set_frame(uint8_t idx, uint64_t color);
@@ -0,0 +1,14 @@
+#ifndef _THUMB_CACHE_H_
+#define _THUMB_CACHE_H_
+
+#include "blitting.h"
+
+#define THUMBS_DIR			"/dev_hdd0/tmp/wmtmp/thumbs"	// decoded & scaled covers (ARGB)
+#define THUMBS_MAX_SIZE		MB(64)							// the least recently used are deleted above this size
+
+int32_t thumb_load(const char *path, uint8_t mode, Buffer *img, uint32_t *buf);
+void thumb_save(const char *path, uint8_t mode, const Buffer *img);
+uint8_t thumb_trim_pending(void);
+void thumb_trim(void *scratch, uint32_t size);
+
+#endif // _THUMB_CACHE_H_
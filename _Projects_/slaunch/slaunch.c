@@ -4,6 +4,9 @@
 #include "include/misc.h"
 #include "include/mem.h"
 #include "include/blitting.h"
+#include "include/thumb_cache.h"
+
+#include "../../slaunch_idx.h"
 
 SYS_MODULE_INFO(sLaunch, 0, 1, 1);
 SYS_MODULE_START(slaunch_start);
@@ -106,6 +109,7 @@ typedef struct // 1MB for 2000+1 titles
 } __attribute__((packed)) _slaunch;
 
 static _slaunch *slaunch = NULL;
+static uint16_t slist_order[MAX_GAMES];
 
 #define GRAY_TEXT   0xff808080
 #define LIGHT_TEXT  0xffa0a0a0
@@ -158,6 +162,9 @@ static void slaunch_thread(uint64_t arg);
 
 static uint8_t draw_side_menu(void);
 static void draw_selection(uint16_t game_idx);
+
+static Rect menu_text; // text of the menu strip in the framebuffer
+
 static void reload_data(uint32_t curpad);
 
 #define HDD0  1
@@ -173,6 +180,8 @@ static uint8_t cpu_rsx = 0;
 
 static uint32_t frame = 0;
 
+static uint16_t warm_game = 0, warm_end = 0; // covers of the next page to cache while the pad is idle
+
 static void load_background(void)
 {
 	char path[64];
@@ -197,6 +206,10 @@ static void load_background(void)
 	}
 
 	load_img_bitmap(0, path, "\0");
+
+	// the whole menu strip is flipped with the new background
+	memcpy((uint8_t *)ctx.menu, (uint8_t *)(ctx.canvas)+INFOBAR_Y*CANVAS_W*4, CANVAS_W*INFOBAR_H*4);
+	menu_text.x = menu_text.y = 0, menu_text.x2 = CANVAS_W, menu_text.y2 = INFOBAR_H;
 }
 
 static void draw_page(uint16_t game_idx, uint8_t key_repeat)
@@ -214,6 +227,7 @@ static void draw_page(uint16_t game_idx, uint8_t key_repeat)
 	// draw background and menu strip
 	flip_frame();
 	memcpy((uint8_t *)ctx.menu, (uint8_t *)(ctx.canvas)+INFOBAR_Y*CANVAS_W*4, CANVAS_W*INFOBAR_H*4);
+	menu_text.x2 = 0; // the strip was restored
 
 	set_textbox(LIGHT_GRAY, 0, INFOBAR_Y - 10, CANVAS_W, 1);
 	set_textbox(GRAY,       0, INFOBAR_Y - 9,  CANVAS_W, 1);
@@ -279,12 +293,19 @@ static void draw_page(uint16_t game_idx, uint8_t key_repeat)
 
 		if(key_repeat) break;
 	}
+
+	// queue the next page (or the first after the last)
+	warm_game = (j + gpp < games) ? (j + gpp) : 0;
+	warm_end  = (warm_game + gpp < games) ? (warm_game + gpp) : games;
+	if(warm_game == j) warm_end = 0;
 }
 
 static void draw_selection(uint16_t game_idx)
 {
 	char one_of[32], mode[8];
 
+	reset_text_damage();
+
 	if(games)
 	{
 		char *path = slaunch[game_idx].name + slaunch[game_idx].path_pos;
@@ -341,9 +362,17 @@ static void draw_selection(uint16_t game_idx)
 		print_text(ctx.menu, CANVAS_W, CANVAS_W - ((disp_h==720) ? 450 : 300), 64, s_temp);
 	}
 
-	// set frame buffer for menu strip
-	set_texture_direct(ctx.menu, 0, INFOBAR_Y, CANVAS_W, INFOBAR_H);
-	memcpy((uint8_t *)ctx.menu, (uint8_t *)(ctx.canvas)+INFOBAR_Y*CANVAS_W*4, CANVAS_W*INFOBAR_H*4);
+	// set frame buffer for menu strip: the new text & the area of the previous text
+	if(ctx.text.y2 > INFOBAR_H) ctx.text.y2 = INFOBAR_H;
+
+	Rect r = menu_text; merge_rect(&r, &ctx.text);
+	set_texture_rect(ctx.menu, CANVAS_W, 0, INFOBAR_Y, &r);
+
+	// clear the text of the menu strip
+	for(uint32_t i = ctx.text.y; (i < ctx.text.y2) && (ctx.text.x < ctx.text.x2); i++)
+		memcpy(ctx.menu + (i * CANVAS_W) + ctx.text.x, ctx.canvas + ((INFOBAR_Y + i) * CANVAS_W) + ctx.text.x, (ctx.text.x2 - ctx.text.x) * 4);
+
+	menu_text = ctx.text;
 }
 
 static uint8_t cur_mode;
@@ -579,10 +608,41 @@ static void save_config(void)
 	}
 }
 
+// load the titles in the order of slist.idx (title order or the range of gmode in the type order)
+// returns NONE if the index is missing or outdated
+static int load_indexed(int fd, uint64_t size)
+{
+	_slaunch_idx idx; uint64_t bytes; int fdi, count = NONE;
+
+	if(cellFsOpen(WMTMP "/" SLIST ".idx", CELL_FS_O_RDONLY, &fdi, NULL, 0) != CELL_FS_SUCCEEDED) return NONE;
+
+	if((cellFsRead(fdi, (void *)&idx, sizeof(_slaunch_idx), &bytes) == CELL_FS_SUCCEEDED) && (bytes == sizeof(_slaunch_idx)) &&
+		(idx.magic == SLIDX_MAGIC) && (idx.version == SLIDX_VERSION) && (idx.record_size == sizeof(_slaunch)) && (idx.count == size / sizeof(_slaunch)))
+	{
+		uint32_t first = 0, last = idx.count; uint8_t order = SLIDX_TITLE;
+
+		if(gmode && (gmode < SLIDX_TYPES)) {first = idx.type_first[gmode], last = idx.type_first[gmode + 1], order = SLIDX_TYPE;}
+
+		count = (last - first); if(count >= MAX_GAMES) count = MAX_GAMES - 1;
+
+		if(cellFsReadWithOffset(fdi, slidx_order_offset(idx.count, order) + (first * sizeof(uint16_t)), (void *)slist_order, count * sizeof(uint16_t), &bytes) != CELL_FS_SUCCEEDED) count = NONE;
+
+		for(int n = 0; n < count; n++)
+		{
+			if(cellFsReadWithOffset(fd, slist_order[n] * sizeof(_slaunch), (void *)&slaunch[n], sizeof(_slaunch), &bytes) != CELL_FS_SUCCEEDED) {count = NONE; break;}
+		}
+	}
+
+	cellFsClose(fdi);
+	return count;
+}
+
 static void load_data(void)
 {
 	int fd;
 
+	warm_end = 0; // the queue refers to the old list
+
 	//if(get_vsh_plugin_slot_by_name("WWWD") >= 7) {games=fav_mode=0, gmode = TYPE_FAV; return;}
 
 	char filename[64];
@@ -605,14 +665,18 @@ reload:
 		// load game list in MC memory
 		slaunch = (_slaunch*)mem_alloc((games+1)*sizeof(_slaunch));
 
-		cellFsRead(fd, (void *)slaunch, sizeof(_slaunch)*games, NULL);
+		int indexed = fav_mode ? NONE : load_indexed(fd, size); // already sorted & filtered by type
+
+		if(indexed < 0) cellFsRead(fd, (void *)slaunch, sizeof(_slaunch)*games, NULL);
 		cellFsClose(fd);
 
 		//if(!fav_mode)
 		{
-			uint16_t ngames = games; char *path;
+			uint16_t ngames = (indexed < 0) ? games : indexed; char *path;
 
-			if(gmode)		// filter games by type
+			if(gmode && !ngames) {if(++gmode >= TYPE_FAV) gmode = TYPE_ALL; goto reload;}
+
+			if(gmode && (indexed < 0))		// filter games by type
 			{
 				ngames = 0;
 
@@ -657,7 +721,7 @@ reload:
 			games = ngames;
 
 			// sort game list
-			if(games > 1)
+			if((games > 1) && (indexed < 0))
 			{
 				_slaunch swap; uint8_t sorted = 1; ngames = (games - 1);
 				for(uint16_t n = 0; n<ngames; n++)
@@ -688,6 +752,7 @@ reload:
 						cellFsOpen(filename, CELL_FS_O_CREAT | CELL_FS_O_TRUNC | CELL_FS_O_WRONLY, &fd, NULL, 0);
 						cellFsWrite(fd, (void *)slaunch, sizeof(_slaunch)*games, NULL);
 						cellFsClose(fd);
+						if(!fav_mode) cellFsUnlink(WMTMP "/" SLIST ".idx"); // the record numbers changed
 					}
 				}
 			}
@@ -1086,6 +1151,15 @@ static void slaunch_thread(uint64_t arg)
 
 					// update temperature
 					if(++frame > 400) {frame = 0, cpu_rsx ^= 1; draw_selection(cur_game);}
+
+					// cache the covers of the next page, 1 per idle cycle
+					if(warm_game < warm_end)
+					{
+						cache_img_bitmap(slaunch[warm_game].name + slaunch[warm_game].icon_pos, wm_icons[slaunch[warm_game].type]);
+						warm_game++;
+					}
+					else if(thumb_trim_pending())
+						thumb_trim(ctx.imgs, MAX_WH4);
 				}
 			}
 		}
@@ -0,0 +1,226 @@
+/*
+ *  Thumbnail cache of the covers shown by sLaunch
+ *
+ *  The covers are decoded (PNG/JPG) and scaled once for the grid of the
+ *  current mode and stored in THUMBS_DIR as uncompressed ARGB (argb_dec.c).
+ *  The next time the page is shown they are read back without decoding.
+ *
+ *  <hash of path><mode>.argb     mode: 1 = SD, 10 / 40 = covers per page (HD)
+ *
+ *  The header identifies the source image (2nd hash of the path, size & mtime),
+ *  a changed cover is decoded again. The mtime of a thumbnail is renewed when
+ *  it is used: the least recently used are deleted above THUMBS_MAX_SIZE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cell/rtc.h>
+
+#include "include/thumb_cache.h"
+#include "include/argb_dec.h"
+#include "include/misc.h"
+#include "include/mem.h"
+
+#define FAILED -1
+
+#define THUMB_NAME_LEN		16			// "%08x%02x.argb"
+#define THUMB_PATH_LEN		(sizeof(THUMBS_DIR) + THUMB_NAME_LEN)
+#define THUMB_TOUCH_SECS	3600		// renew the mtime of a used thumbnail at most every hour
+
+typedef struct {
+	uint32_t mtime;
+	uint32_t size;
+	char name[THUMB_NAME_LEN];
+} thumb_entry;
+
+static uint8_t thumbs_dir = 0;			// 0 = not checked, 1 = ready, 2 = not available
+static int64_t thumbs_size = -1;		// bytes in THUMBS_DIR (-1 = not counted)
+
+static uint32_t thumb_hash(const char *path, uint32_t h, uint32_t prime)
+{
+	while(*path) h = (h ^ (uint8_t)*path++) * prime;
+	return h;
+}
+
+static uint32_t thumb_key(const char *path)
+{
+	return thumb_hash(path, 0x9747B28C, 0x5BD1E995) | 1; // never 0 (files made by png2argb)
+}
+
+static void thumb_path(char *thumb, const char *path, uint8_t mode)
+{
+	sprintf(thumb, THUMBS_DIR "/%08x%02x.argb", thumb_hash(path, 0x811C9DC5, 0x01000193), mode);
+}
+
+static time_t thumb_now(void)
+{
+	CellRtcTick tick; cellRtcGetCurrentTick(&tick);
+	return (time_t)((tick.tick / 1000000ULL) - 62135596800ULL); // seconds since 0001 -> since 1970
+}
+
+/***********************************************************************
+* load the thumbnail of an image
+* path = source image (png, jpg, argb)
+* mode = grid of the page (the size of the thumbnail)
+* buf  = pixel buffer or NULL to check only that the thumbnail is valid
+* returns 0 if the thumbnail was loaded (or is valid)
+***********************************************************************/
+int32_t thumb_load(const char *path, uint8_t mode, Buffer *img, uint32_t *buf)
+{
+	struct CellFsStat s;
+	char thumb[THUMB_PATH_LEN];
+	argb_h_t argb_h;
+	uint64_t read = 0;
+	int fd;
+
+	if(!path || *path != '/' || (cellFsStat(path, &s) != CELL_FS_SUCCEEDED)) return FAILED;
+
+	thumb_path(thumb, path, mode);
+
+	if(cellFsOpen(thumb, CELL_FS_O_RDONLY, &fd, NULL, 0) != CELL_FS_SUCCEEDED) return FAILED;
+
+	int32_t ret = FAILED;
+
+	if((cellFsRead(fd, (void *)&argb_h, sizeof(argb_h_t), &read) == CELL_FS_SUCCEEDED) && (read == sizeof(argb_h_t)) &&
+		!memcmp(argb_h.magic, argb_magic, 4) && (argb_h.src_key == thumb_key(path)) &&
+		(argb_h.src_size == (uint32_t)s.st_size) && (argb_h.src_mtime == (uint64_t)s.st_mtime) &&
+		argb_h.nx && argb_h.ny && ((argb_h.nx * argb_h.ny * 4) <= MAX_WH4))
+	{
+		uint32_t size = argb_h.nx * argb_h.ny * 4;
+
+		if(!buf)
+			ret = 0;
+		else if((cellFsRead(fd, (void *)buf, size, &read) == CELL_FS_SUCCEEDED) && (read == size))
+		{
+			img->addr = buf;
+			img->w = argb_h.nx;
+			img->h = argb_h.ny;
+			img->x = img->y = 0;
+			img->b = argb_h.flags & ARGB_FLAG_TRANSPARENCY;
+
+			// least recently used order
+			time_t now = thumb_now();
+			if((cellFsFstat(fd, &s) == CELL_FS_SUCCEEDED) && ((now - s.st_mtime) > THUMB_TOUCH_SECS))
+			{
+				CellFsUtimbuf times;
+				times.actime = times.modtime = now;
+				cellFsUtime(thumb, &times);
+			}
+			ret = 0;
+		}
+	}
+
+	cellFsClose(fd);
+	return ret;
+}
+
+/***********************************************************************
+* store an image decoded & scaled for a grid
+***********************************************************************/
+void thumb_save(const char *path, uint8_t mode, const Buffer *img)
+{
+	struct CellFsStat s;
+	char thumb[THUMB_PATH_LEN];
+	argb_h_t argb_h;
+	uint64_t written = 0;
+	int fd;
+
+	if(!path || *path != '/' || !img->w || !img->h) return;
+
+	if(!thumbs_dir) thumbs_dir = (not_exists(THUMBS_DIR) && (cellFsMkdir(THUMBS_DIR, 0777) != CELL_FS_SUCCEEDED)) ? 2 : 1;
+	if(thumbs_dir != 1) return;
+
+	if(!strncmp(path, THUMBS_DIR, sizeof(THUMBS_DIR) - 1) || (cellFsStat(path, &s) != CELL_FS_SUCCEEDED)) return;
+
+	memset(&argb_h, 0, sizeof(argb_h_t));
+	memcpy(argb_h.magic, argb_magic, 4);
+	argb_h.nx = img->w;
+	argb_h.ny = img->h;
+	argb_h.flags = img->b ? ARGB_FLAG_TRANSPARENCY : 0;
+	argb_h.src_key = thumb_key(path);
+	argb_h.src_size = (uint32_t)s.st_size;
+	argb_h.src_mtime = (uint64_t)s.st_mtime;
+
+	uint32_t size = img->w * img->h * 4;
+
+	thumb_path(thumb, path, mode);
+
+	if(cellFsOpen(thumb, CELL_FS_O_CREAT | CELL_FS_O_TRUNC | CELL_FS_O_WRONLY, &fd, NULL, 0) != CELL_FS_SUCCEEDED) return;
+
+	bool ok = (cellFsWrite(fd, (void *)&argb_h, sizeof(argb_h_t), &written) == CELL_FS_SUCCEEDED) && (written == sizeof(argb_h_t)) &&
+			  (cellFsWrite(fd, (void *)img->addr, size, &written) == CELL_FS_SUCCEEDED) && (written == size);
+
+	cellFsClose(fd);
+
+	if(!ok) {cellFsUnlink(thumb); return;} // e.g. disk full
+
+	if(thumbs_size >= 0) thumbs_size += sizeof(argb_h_t) + size;
+}
+
+/***********************************************************************
+* the cache grew in this session and may be over its size
+***********************************************************************/
+uint8_t thumb_trim_pending(void)
+{
+	return (thumbs_dir == 1) && ((thumbs_size < 0) || (thumbs_size > THUMBS_MAX_SIZE));
+}
+
+/***********************************************************************
+* delete the least recently used thumbnails above THUMBS_MAX_SIZE
+* (down to 3/4 of the size, so it isn't done for every new cover)
+* scratch = work buffer for the list of thumbnails
+***********************************************************************/
+void thumb_trim(void *scratch, uint32_t size)
+{
+	thumb_entry *list = (thumb_entry *)scratch;
+	uint32_t max = size / sizeof(thumb_entry), count = 0;
+	char thumb[THUMB_PATH_LEN];
+	struct CellFsStat s;
+	CellFsDirent dir;
+	uint64_t read;
+	int64_t total = 0;
+	int fd;
+
+	if(!list || (cellFsOpendir(THUMBS_DIR, &fd) != CELL_FS_SUCCEEDED)) return;
+
+	while((cellFsReaddir(fd, &dir, &read) == CELL_FS_SUCCEEDED) && read)
+	{
+		if((dir.d_namlen != THUMB_NAME_LEN - 1) || strcmp(dir.d_name + 10, ".argb")) continue;
+
+		sprintf(thumb, THUMBS_DIR "/%s", dir.d_name);
+		if(cellFsStat(thumb, &s) != CELL_FS_SUCCEEDED) continue;
+
+		total += s.st_size;
+
+		if(count < max)
+		{
+			list[count].mtime = (uint32_t)s.st_mtime;
+			list[count].size  = (uint32_t)s.st_size;
+			strcpy(list[count].name, dir.d_name);
+			count++;
+		}
+	}
+	cellFsClosedir(fd);
+
+	if(total > THUMBS_MAX_SIZE)
+	{
+		// shell sort by mtime (oldest first)
+		static const uint32_t gaps[] = {701, 301, 132, 57, 23, 10, 4, 1};
+
+		for(uint8_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++)
+			for(uint32_t gap = gaps[g], i = gap; i < count; i++)
+			{
+				thumb_entry entry = list[i]; uint32_t j = i;
+				for(; (j >= gap) && (list[j - gap].mtime > entry.mtime); j -= gap) list[j] = list[j - gap];
+				list[j] = entry;
+			}
+
+		for(uint32_t n = 0; (n < count) && (total > (THUMBS_MAX_SIZE / 4 * 3)); n++)
+		{
+			sprintf(thumb, THUMBS_DIR "/%s", list[n].name);
+			if(cellFsUnlink(thumb) == CELL_FS_SUCCEEDED) total -= list[n].size;
+		}
+	}
+
+	thumbs_size = total;
+}
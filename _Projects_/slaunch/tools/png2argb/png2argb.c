@@ -7,6 +7,11 @@
  *
  *  Usage:
  *  png2argb <png input file> [<argb output file>]
+ *  png2argb -b [options] <png file | directory | @list file>...
+ *
+ *  Batch mode converts the PNG files on a pool of worker threads,
+ *  optionally scaled down to fit in a size (area average, premultiplied),
+ *  and skips the ARGB files that are newer than their PNG.
  */
 
 #include <stdio.h>
@@ -14,6 +19,18 @@
 #include <stdint.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "common.h"
 
@@ -21,6 +38,8 @@
 
 #define CHECK_OW 0
 
+#define MAX_THREADS 64
+
 typedef struct {
 	uint8_t r;
 	uint8_t g;
@@ -51,130 +70,334 @@ typedef struct argb {
 
 const char argb_magic[] = "ARGB";
 
-int main(int argc, char *argv[]) {
+// conversion options
+typedef struct {
+	uint32_t max_w;       // fit in max_w x max_h (0 = keep the size)
+	uint32_t max_h;
+	int premultiply;      // write premultiplied alpha (slaunch blends straight alpha)
+	int force;            // convert even if the ARGB file is up to date
+	int quiet;
+	const char *out_dir;  // NULL = next to the PNG
+} opts_t;
+
+/***********************************************************************
+* RGBA -> ARGB swizzle (+ premultiply), 4 pixels per SIMD step
+* returns ARGB_FLAG_TRANSPARENCY if a pixel has A < 0xFF
+***********************************************************************/
+static inline uint8_t mul_div255(uint32_t c, uint32_t a)
+{
+	uint32_t x = c * a + 128;
+	return (uint8_t)((x + (x >> 8)) >> 8); // round(c * a / 255)
+}
+
+static uint32_t swizzle_argb(argb_px_t *dst, const png_px_t *src, uint64_t n, int premultiply)
+{
+	uint64_t i = 0;
+	uint32_t flags = 0;
+
+#if defined(__SSSE3__)
+	const __m128i to_argb = _mm_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+	const __m128i alpha   = _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+	const __m128i a_mask  = _mm_set1_epi32(0xFF000000);	// A of the RGBA pixels (little endian lanes)
+	const __m128i zero    = _mm_setzero_si128(), r128 = _mm_set1_epi16(128);
+	__m128i opaque = _mm_set1_epi8(-1);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)&src[i]);
+
+		opaque = _mm_and_si128(opaque, _mm_or_si128(v, _mm_xor_si128(a_mask, _mm_set1_epi8(-1))));
+
+		if (premultiply) {
+			__m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+			__m128i alo = _mm_shuffle_epi8(v, alpha), ahi = _mm_shuffle_epi8(_mm_srli_si128(v, 8), alpha);
+
+			lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), r128);
+			hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), r128);
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+			// A * A / 255 != A: keep the original A
+			v = _mm_or_si128(_mm_and_si128(v, a_mask), _mm_andnot_si128(a_mask, _mm_packus_epi16(lo, hi)));
+		}
+
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_shuffle_epi8(v, to_argb));
+	}
+
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(opaque, _mm_set1_epi8(-1))) != 0xFFFF) {
+		flags |= ARGB_FLAG_TRANSPARENCY;
+	}
+#endif
+
+	for (; i < n; i++) {
+		uint8_t a = src[i].a;
+
+		if (a < 0xFF) {
+			flags |= ARGB_FLAG_TRANSPARENCY;
+		}
+
+		dst[i].a = a;
+		dst[i].r = premultiply ? mul_div255(src[i].r, a) : src[i].r;
+		dst[i].g = premultiply ? mul_div255(src[i].g, a) : src[i].g;
+		dst[i].b = premultiply ? mul_div255(src[i].b, a) : src[i].b;
+	}
+
+	return flags;
+}
+
+/***********************************************************************
+* area average downscale
+* The pixels are weighted by the part of their area covered by the
+* output pixel (2 separable passes). The colors are premultiplied by A
+* while they are averaged, so transparent pixels don't bleed their color.
+***********************************************************************/
+#if defined(__SSE2__)
+typedef __m128 px4_t; // R G B A
+
+static inline px4_t px4_zero(void) {return _mm_setzero_ps();}
+static inline px4_t px4_madd(px4_t acc, px4_t p, float w) {return _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(w)));}
+static inline void px4_store(float *f, px4_t p) {_mm_storeu_ps(f, p);}
+
+static inline px4_t px4_load(const png_px_t *px) // premultiplied
+{
+	int32_t v; memcpy(&v, px, 4);
+	__m128i i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), _mm_setzero_si128()), _mm_setzero_si128());
+	__m128 f = _mm_cvtepi32_ps(i);
+	__m128 a = _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm_mul_ps(a, _mm_set_ps(0.f, 1.f / 255.f, 1.f / 255.f, 1.f / 255.f));
+	a = _mm_add_ps(a, _mm_set_ps(1.f, 0.f, 0.f, 0.f));
+	return _mm_mul_ps(f, a);
+}
+#else
+typedef struct {float v[4];} px4_t;
+
+static inline px4_t px4_zero(void) {px4_t p = {{0, 0, 0, 0}}; return p;}
+static inline px4_t px4_madd(px4_t acc, px4_t p, float w) {for (int c = 0; c < 4; c++) acc.v[c] += p.v[c] * w; return acc;}
+static inline void px4_store(float *f, px4_t p) {memcpy(f, p.v, sizeof(p.v));}
+
+static inline px4_t px4_load(const png_px_t *px)
+{
+	float a = px->a / 255.f;
+	px4_t p = {{px->r * a, px->g * a, px->b * a, px->a}};
+	return p;
+}
+#endif
+
+typedef struct {
+	uint32_t first;   // first source pixel
+	uint32_t count;   // source pixels
+	float *w;         // their weights (sum = 1)
+} contrib_t;
+
+// weights of the source pixels of each output pixel
+static contrib_t *area_weights(uint32_t src, uint32_t dst, float *w)
+{
+	contrib_t *c = malloc(dst * sizeof(contrib_t));
+	if (!c) return NULL;
+
+	double scale = (double)src / dst;
+
+	for (uint32_t d = 0; d < dst; d++) {
+		double x0 = d * scale, x1 = x0 + scale;
+		uint32_t first = (uint32_t)x0, last = (uint32_t)ceil(x1);
+
+		if (last > src) last = src;
+
+		c[d].first = first;
+		c[d].count = last - first;
+		c[d].w = w;
+
+		for (uint32_t s = first; s < last; s++) {
+			double l = (s > x0) ? s : x0, r = (s + 1 < x1) ? (s + 1) : x1;
+			*w++ = (float)((r - l) / scale);
+		}
+	}
+
+	return c;
+}
+
+static int area_resize(argb_px_t *dst, uint32_t dw, uint32_t dh, const png_px_t *src, uint32_t sw, uint32_t sh, int premultiply, uint32_t *flags)
+{
+	int ret = -1;
+	float *wx = malloc((sw + dw) * sizeof(float)), *wy = malloc((sh + dh) * sizeof(float));
+	contrib_t *cx = wx ? area_weights(sw, dw, wx) : NULL;
+	contrib_t *cy = wy ? area_weights(sh, dh, wy) : NULL;
+	px4_t *rows = malloc((size_t)sh * dw * sizeof(px4_t)); // horizontal pass
+
+	if (!cx || !cy || !rows) goto done;
+
+	for (uint32_t y = 0; y < sh; y++) {
+		const png_px_t *line = src + (size_t)y * sw;
+		px4_t *out = rows + (size_t)y * dw;
+
+		for (uint32_t x = 0; x < dw; x++) {
+			px4_t acc = px4_zero();
+			for (uint32_t k = 0; k < cx[x].count; k++) {
+				acc = px4_madd(acc, px4_load(&line[cx[x].first + k]), cx[x].w[k]);
+			}
+			out[x] = acc;
+		}
+	}
+
+	*flags = 0;
+
+	for (uint32_t y = 0; y < dh; y++) {
+		for (uint32_t x = 0; x < dw; x++) {
+			px4_t acc = px4_zero();
+			const px4_t *col = rows + (size_t)cy[y].first * dw + x;
+
+			for (uint32_t k = 0; k < cy[y].count; k++, col += dw) {
+				acc = px4_madd(acc, *col, cy[y].w[k]);
+			}
+
+			float f[4]; px4_store(f, acc);
+
+			float a = f[3] < 0.f ? 0.f : (f[3] > 255.f ? 255.f : f[3]);
+			float m = premultiply ? 1.f : (a > 0.f ? 255.f / a : 0.f);
+
+			argb_px_t *px = &dst[(size_t)y * dw + x];
+			px->a = (uint8_t)(a + .5f);
+			px->r = (uint8_t)fminf(f[0] * m + .5f, 255.f);
+			px->g = (uint8_t)fminf(f[1] * m + .5f, 255.f);
+			px->b = (uint8_t)fminf(f[2] * m + .5f, 255.f);
+
+			if (px->a < 0xFF) {
+				*flags |= ARGB_FLAG_TRANSPARENCY;
+			}
+		}
+	}
+
+	ret = 0;
+
+done:
+	free(rows); free(cx); free(cy); free(wx); free(wy);
+	return ret;
+}
+
+/***********************************************************************
+* convert a PNG file
+* returns 0 on success, the errors are printed
+***********************************************************************/
+static int convert_png(const char *file_png, const char *file_argb, const opts_t *opts, uint64_t *png_bytes)
+{
 	int ret = 0;
 
 	FILE *fp_png;
 	spng_ctx *lsp_ctx = NULL;
 	png_px_t *png_px = NULL;
+	uint8_t *png_data = NULL;
+	long png_size;
 
 	uint64_t n;
 	size_t png_px_size;
 
 	argb_t argb = {0};
-	char file_argb[4096] = {0};
 	FILE *fp_argb;
 
-	if (argc < 2 || argc > 3) {
- 		printf("Copyright (C) 2022 Darjan Krijan <krijan@dkmechatronics.eu>\n\n");
-
-		printf("png2argb converts a PNG to a simple uncompressed ARGB image format for slaunch.\n");
-		printf("Provided under [GPLv3].\n");
-		printf("Uses libspng [BSD 2-Clause License] for simplicity and performance reasons.\n");
-		printf("libspng uses zlib [zlib License] for decompression in this case.\n\n");
-
-		if (argc < 2) {
-			printf("No input file provided!\n");
-			printf("Usage: %s <png input file> [<argb output file>]\n", argv[0]);
-			printf("Not providing an output file will produce an argb image next to the PNG image.\n", argv[0]);
-		} else if (argc > 3) {
-			printf("Too many input arguments!\n");
-			printf("Usage: %s <png input file> [<argb output file>]\n", argv[0]);
-			printf("Not providing an output file will produce an argb image next to the PNG image.\n", argv[0]);
-		}
-
+	if (!(fp_png = fopen(file_png, "rb"))) {
+		printf("Error opening input PNG file '%s'\n", file_png);
 		return EXIT_FAILURE;
 	}
 
-	if (!(fp_png = fopen(argv[1], "rb"))) {
-		printf("Error opening input PNG file '%s'\n", argv[1]);
+	// the whole file is decoded from memory
+	fseek(fp_png, 0, SEEK_END);
+	png_size = ftell(fp_png);
+	fseek(fp_png, 0, SEEK_SET);
+
+	if ((png_size <= 0) || !(png_data = malloc(png_size)) || (fread(png_data, 1, png_size, fp_png) != (size_t)png_size)) {
+		printf("Error reading input PNG file '%s'\n", file_png);
+		fclose(fp_png); free(png_data);
 		return EXIT_FAILURE;
 	}
+	fclose(fp_png);
+
+	if (png_bytes) *png_bytes = png_size;
 
 	if (!(lsp_ctx = spng_ctx_new(0))) {
 		printf("spng_ctx_new() failed\n");
+		free(png_data);
 		return EXIT_FAILURE;
 	}
 
-	spng_set_png_file(lsp_ctx, fp_png);
+	spng_set_png_buffer(lsp_ctx, png_data, png_size);
 
 	struct spng_ihdr ihdr;
 	if (ret = spng_get_ihdr(lsp_ctx, &ihdr)) {
 		printf("spng_get_ihdr() error: %s\n", spng_strerror(ret));
-		return EXIT_FAILURE;
-	}
-
-	if (ihdr.width%4) {
-		printf("Image '%s' doesn't have a width multiple of 4, aborting.\n", argv[1]);
-		return EXIT_FAILURE;
-	} else if (ihdr.height%4) {
-		printf("Image '%s' doesn't have a height multiple of 4, aborting.\n", argv[1]);
-		return EXIT_FAILURE;
+		goto fail;
 	}
 
 	argb.nx = ihdr.width;
 	argb.ny = ihdr.height;
+
+	// fit in max_w x max_h keeping the aspect ratio (never upscaled)
+	if (opts->max_w && opts->max_h) {
+		double scale = fmin((double)opts->max_w / ihdr.width, (double)opts->max_h / ihdr.height);
+		if (scale > 1.) scale = 1.;
+
+		argb.nx = (uint32_t)(ihdr.width  * scale) & ~3;
+		argb.ny = (uint32_t)(ihdr.height * scale) & ~3;
+
+		if (!argb.nx || !argb.ny) {
+			printf("Image '%s' is too small for a size multiple of 4, aborting.\n", file_png);
+			goto fail;
+		}
+	}
+
+	if (argb.nx%4) {
+		printf("Image '%s' doesn't have a width multiple of 4, aborting.\n", file_png);
+		goto fail;
+	} else if (argb.ny%4) {
+		printf("Image '%s' doesn't have a height multiple of 4, aborting.\n", file_png);
+		goto fail;
+	}
+
 	n  = (uint64_t)argb.nx*(uint64_t)argb.ny;
 
 	if (ret = spng_decoded_image_size(lsp_ctx, SPNG_FMT_RGBA8, &png_px_size)) {
 		fprintf(stderr, "spng_decoded_image_size() error: %s\n", spng_strerror(ret));
-		spng_ctx_free(lsp_ctx);
-
-		return EXIT_FAILURE;
+		goto fail;
 	}
 
 	if (!(png_px = malloc(png_px_size))) {
-		fprintf(stderr, "Error: malloc returned NULL with size %lu\n", png_px_size);
-		spng_ctx_free(lsp_ctx);
-
-		return EXIT_FAILURE;
+		fprintf(stderr, "Error: malloc returned NULL with size %zu\n", png_px_size);
+		goto fail;
 	}
 
 	if (ret = spng_decode_image(lsp_ctx, png_px, png_px_size, SPNG_FMT_RGBA8, 0)) {
 		printf("spng_decode_image() error: %s\n", spng_strerror(ret));
-		free(png_px);
-		spng_ctx_free(lsp_ctx);
-
-		return EXIT_FAILURE;
+		goto fail;
 	}
 
-	spng_ctx_free(lsp_ctx);
-	fclose(fp_png);
+	spng_ctx_free(lsp_ctx); lsp_ctx = NULL;
+	free(png_data); png_data = NULL;
 
-	if (argc == 3) {
-		strcpy(file_argb, argv[2]);
-	} else { // in same directory as png
-		strcpy(file_argb, argv[1]);
-		strcpy(&file_argb[strlen(file_argb) - 4], ".argb");
+	if (!(argb.px = malloc(n*sizeof(argb_px_t)))) {
+		fprintf(stderr, "Error: malloc returned NULL with size %" PRIu64 "\n", n*sizeof(argb_px_t));
+		goto fail;
 	}
 
+	if ((argb.nx == ihdr.width) && (argb.ny == ihdr.height)) {
+		argb.flags = swizzle_argb(argb.px, png_px, n, opts->premultiply);
+	} else if (area_resize(argb.px, argb.nx, argb.ny, png_px, ihdr.width, ihdr.height, opts->premultiply, &argb.flags)) {
+		fprintf(stderr, "Error: out of memory scaling '%s'\n", file_png);
+		goto fail;
+	}
+
+	free(png_px); png_px = NULL;
+
 #if CHECK_OW == 1
 	if (fp_argb = fopen(file_argb, "r")) {
 		printf("Output file '%s' exists, aborting.\n", file_argb);
 		fclose(fp_argb);
-		return EXIT_FAILURE;
+		goto fail;
 	}
 #endif
 
 	if (!(fp_argb = fopen(file_argb, "wb"))) {
 		printf("Can't open output file '%s'\n", file_argb);
-		return EXIT_FAILURE;
-	}
-
-	argb.px = malloc(n*sizeof(argb_px_t));
-
-	for (uint64_t i = 0; i < n; i++) {
-		argb.px[i].a = png_px[i].a;
-		if (argb.px[i].a < 0xFF) {
-			argb.flags |= ARGB_FLAG_TRANSPARENCY;
-		}
-		argb.px[i].r = png_px[i].r;
-		argb.px[i].g = png_px[i].g;
-		argb.px[i].b = png_px[i].b;
+		goto fail;
 	}
 
-	free(png_px);
-
 	memcpy(argb.magic, argb_magic, strlen(argb_magic));
 
 #if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
@@ -183,11 +406,278 @@ int main(int argc, char *argv[]) {
 	argb.flags = BE32(argb.flags);
 #endif
 
-	fwrite(&argb, sizeof(uint8_t), 128, fp_argb);
-	fwrite(argb.px, sizeof(argb_px_t), n, fp_argb);
+	int ok = (fwrite(&argb, sizeof(uint8_t), 128, fp_argb) == 128) &&
+			 (fwrite(argb.px, sizeof(argb_px_t), n, fp_argb) == n);
+
+	if ((fclose(fp_argb) != 0) || !ok) {
+		printf("Error writing output file '%s'\n", file_argb);
+		remove(file_argb);
+		goto fail;
+	}
 
-	fclose(fp_argb);
 	free(argb.px);
 
 	return EXIT_SUCCESS;
+
+fail:
+	if (lsp_ctx) spng_ctx_free(lsp_ctx);
+	free(png_data);
+	free(png_px);
+	free(argb.px);
+
+	return EXIT_FAILURE;
+}
+
+/***********************************************************************
+* batch mode
+***********************************************************************/
+typedef struct {
+	char **png;           // input files
+	uint32_t count;
+	uint32_t size;
+
+	const opts_t *opts;
+	uint32_t next;        // next job (atomic)
+
+	uint32_t converted;   // results (atomic)
+	uint32_t skipped;
+	uint32_t failed;
+	uint64_t png_bytes;
+} batch_t;
+
+static int is_png(const char *name)
+{
+	size_t len = strlen(name);
+	return (len > 4) && (!strcmp(name + len - 4, ".png") || !strcmp(name + len - 4, ".PNG"));
+}
+
+static int add_job(batch_t *batch, const char *file_png)
+{
+	if (batch->count == batch->size) {
+		uint32_t size = batch->size ? batch->size * 2 : 1024;
+		char **png = realloc(batch->png, size * sizeof(char*));
+		if (!png) return -1;
+		batch->png = png, batch->size = size;
+	}
+
+	if (!(batch->png[batch->count] = strdup(file_png))) return -1;
+	batch->count++;
+	return 0;
+}
+
+// a PNG file, the PNG files of a directory or the files listed in @<list file>
+static int add_input(batch_t *batch, const char *input)
+{
+	struct stat st;
+	char path[4096];
+
+	if (*input == '@') {
+		FILE *fp = fopen(input + 1, "r");
+		if (!fp) {printf("Can't open list file '%s'\n", input + 1); return -1;}
+
+		while (fgets(path, sizeof(path), fp)) {
+			path[strcspn(path, "\r\n")] = 0;
+			if (*path && add_job(batch, path)) {fclose(fp); return -1;}
+		}
+
+		fclose(fp);
+		return 0;
+	}
+
+	if (stat(input, &st)) {printf("Can't find '%s'\n", input); return -1;}
+
+	if (!S_ISDIR(st.st_mode)) return add_job(batch, input);
+
+	DIR *dir = opendir(input);
+	if (!dir) {printf("Can't open directory '%s'\n", input); return -1;}
+
+	for (struct dirent *entry; (entry = readdir(dir)); ) {
+		if (!is_png(entry->d_name)) continue;
+
+		snprintf(path, sizeof(path), "%s/%s", input, entry->d_name);
+		if (add_job(batch, path)) {closedir(dir); return -1;}
+	}
+
+	closedir(dir);
+	return 0;
+}
+
+static void argb_name(char *file_argb, size_t size, const char *file_png, const char *out_dir)
+{
+	if (out_dir) {
+		const char *name = strrchr(file_png, '/');
+		snprintf(file_argb, size, "%s/%s", out_dir, name ? name + 1 : file_png);
+	} else {
+		snprintf(file_argb, size, "%s", file_png);
+	}
+
+	char *ext = strrchr(file_argb, '.');
+	if (ext && (strlen(ext) == 4)) *ext = 0;
+	strncat(file_argb, ".argb", size - strlen(file_argb) - 1);
+}
+
+static int is_up_to_date(const char *file_png, const char *file_argb)
+{
+	struct stat png, argb;
+	return !stat(file_argb, &argb) && !stat(file_png, &png) && (argb.st_size > 128) && (argb.st_mtime >= png.st_mtime);
+}
+
+static void *batch_worker(void *arg)
+{
+	batch_t *batch = arg;
+	char file_argb[4096];
+
+	for (;;) {
+		uint32_t job = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+		if (job >= batch->count) break;
+
+		const char *file_png = batch->png[job];
+		uint64_t png_bytes = 0;
+
+		argb_name(file_argb, sizeof(file_argb), file_png, batch->opts->out_dir);
+
+		if (!batch->opts->force && is_up_to_date(file_png, file_argb)) {
+			__atomic_fetch_add(&batch->skipped, 1, __ATOMIC_RELAXED);
+		} else if (convert_png(file_png, file_argb, batch->opts, &png_bytes) == EXIT_SUCCESS) {
+			__atomic_fetch_add(&batch->converted, 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&batch->png_bytes, png_bytes, __ATOMIC_RELAXED);
+			if (!batch->opts->quiet) printf("%s -> %s\n", file_png, file_argb);
+		} else {
+			__atomic_fetch_add(&batch->failed, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s <png input file> [<argb output file>]\n", name);
+	printf("Not providing an output file will produce an argb image next to the PNG image.\n\n");
+
+	printf("Batch mode: %s -b [options] <png file | directory | @list file>...\n", name);
+	printf("  -o <dir>   write the argb images to <dir> (default: next to the PNG images)\n");
+	printf("  -s <W>x<H> scale down to fit in WxH, e.g. 320x320 (size multiple of 4)\n");
+	printf("  -j <n>     worker threads (default: number of CPUs)\n");
+	printf("  -p         premultiplied alpha (slaunch expects straight alpha)\n");
+	printf("  -f         convert even if the argb image is newer than the PNG\n");
+	printf("  -q         only print errors and the summary\n");
+}
+
+static int batch_main(int argc, char *argv[])
+{
+	opts_t opts = {0};
+	batch_t batch = {0};
+#ifdef _SC_NPROCESSORS_ONLN
+	int threads = (int)sysconf(_SC_NPROCESSORS_ONLN), i;
+#else
+	int threads = 4, i;
+#endif
+
+	for (i = 2; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+		char opt = argv[i][1];
+
+		if ((opt == 'o' || opt == 's' || opt == 'j') && (i + 1 >= argc)) {
+			printf("Missing value of -%c\n", opt);
+			return EXIT_FAILURE;
+		}
+
+		if (opt == 'o') opts.out_dir = argv[++i];
+		else if (opt == 's') {
+			if (sscanf(argv[++i], "%ux%u", &opts.max_w, &opts.max_h) != 2 || opts.max_w < 4 || opts.max_h < 4) {
+				printf("Invalid size '%s'\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (opt == 'j') threads = atoi(argv[++i]);
+		else if (opt == 'p') opts.premultiply = 1;
+		else if (opt == 'f') opts.force = 1;
+		else if (opt == 'q') opts.quiet = 1;
+		else {
+			printf("Unknown option '%s'\n", argv[i]);
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (i >= argc) {
+		printf("No input files provided!\n");
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (; i < argc; i++) {
+		if (add_input(&batch, argv[i])) return EXIT_FAILURE;
+	}
+
+	if (threads < 1) threads = 1;
+	if (threads > MAX_THREADS) threads = MAX_THREADS;
+	if ((uint32_t)threads > batch.count) threads = batch.count ? batch.count : 1;
+
+	batch.opts = &opts;
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	pthread_t tid[MAX_THREADS];
+	int started = 0;
+
+	for (; started < threads - 1; started++) {
+		if (pthread_create(&tid[started], NULL, batch_worker, &batch)) break;
+	}
+
+	batch_worker(&batch); // the main thread works too
+
+	for (int t = 0; t < started; t++) pthread_join(tid[t], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	printf("%u converted, %u up to date, %u failed in %.3fs with %d threads",
+		   batch.converted, batch.skipped, batch.failed, secs, started + 1);
+	if (batch.converted && secs > 0) {
+		printf(" (%.1f images/s, %.1f MB/s of PNG)", batch.converted / secs, batch.png_bytes / secs / 1048576.);
+	}
+	printf("\n");
+
+	for (uint32_t n = 0; n < batch.count; n++) free(batch.png[n]);
+	free(batch.png);
+
+	return batch.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+	char file_argb[4096] = {0};
+	opts_t opts = {0};
+
+	if (argc >= 2 && !strcmp(argv[1], "-b")) {
+		return batch_main(argc, argv);
+	}
+
+	if (argc < 2 || argc > 3) {
+ 		printf("Copyright (C) 2022 Darjan Krijan <krijan@dkmechatronics.eu>\n\n");
+
+		printf("png2argb converts a PNG to a simple uncompressed ARGB image format for slaunch.\n");
+		printf("Provided under [GPLv3].\n");
+		printf("Uses libspng [BSD 2-Clause License] for simplicity and performance reasons.\n");
+		printf("libspng uses zlib [zlib License] for decompression in this case.\n\n");
+
+		if (argc < 2) {
+			printf("No input file provided!\n");
+		} else if (argc > 3) {
+			printf("Too many input arguments!\n");
+		}
+
+		usage(argv[0]);
+
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 3) {
+		snprintf(file_argb, sizeof(file_argb), "%s", argv[2]);
+	} else { // in same directory as png
+		argb_name(file_argb, sizeof(file_argb), argv[1], NULL);
+	}
+
+	return convert_png(argv[1], file_argb, &opts, NULL);
 }
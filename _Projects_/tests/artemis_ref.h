@@ -0,0 +1,403 @@
+// Interpreter of the Artemis codelists as it was before the codes were compiled (ParseLine & ConvertCodes
+// of include/ps3mapi/artemis.h), kept verbatim as the reference of test_artemis; the helpers are shared
+// with artemis.h, only the entry points are renamed & the stack buffers that overflow are marked "test:"
+
+static u8 isConstantWrite = 0;
+
+// Compares the bytes at source to buf (equal to)
+static int CompareMemoryBuffered(char *source, int sourceOff, char *buf, int bufLen)
+{
+	for (int i = 0; i < bufLen; i++)
+	{
+		if (buf[i] != source[sourceOff + i])
+			return 0;
+	}
+
+	return 1;
+}
+
+// Artemis PS3 Engine
+static int RefParseLine(process_id_t pid, char *lines, int start, int *skip, int doForceWrite)
+{
+	if (pid == NULL)
+		return userCodesLen;
+
+	int lineLen;
+	for (lineLen = start; lineLen < userCodesLen; lineLen++)
+	{
+		if (lines[lineLen] == '\n' || lines[lineLen] == '\r')
+			break;
+	}
+	lineLen -= start; if(lineLen <= 0) return start;
+
+	const int lineEnd = (start + lineLen);
+
+	if (skip[0] <= 0)
+	{
+		skip[0] = 0;
+
+		int arg2Len = 0, arg1Off = 0, arg0, arg0_2 = 0;
+		int arg3Off = lineEnd, arg4Off = arg3Off + 1, arg4Len = arg4Off;
+
+		//Parse first line
+		while (lines[lineEnd - arg2Len] != ' ')
+			arg2Len++;
+		while (lines[start + arg1Off] != ' ')
+			arg1Off++;
+
+		if (arg2Len < 0)
+			return userCodesLen;
+
+		char addrBuf[16]; _memset(addrBuf, 16); // test: 4 bytes in the plugin, ReadHex() writes 8 & the 2nd line may be longer
+
+		ReadHexPartial(lines, start + 1, (arg1Off - 1), addrBuf, (arg1Off - 1)/2);
+		arg0 = (int)(INT32(addrBuf));
+
+		ReadHex(lines, start + arg1Off + 1, 8, addrBuf, 4);
+		u64 addr = (u64)(INT32(addrBuf));
+		if (ptrAddr)
+		{
+			addr = ptrAddr;
+			ptrAddr = 0;
+		}
+
+		char buf0[MAX(arg2Len, 4)]; _memset(buf0, arg2Len); // test: arg2Len bytes in the plugin, WriteMem() logs 4 bytes
+		const int buf0size = arg2Len - 1;
+		const int buf0Len  = arg2Len / 2;
+
+		if (arg0 < 0)
+			arg0 = 0;
+		char buf1[MAX(arg0, 4)]; _memset(buf1, arg0); // test: arg0 bytes in the plugin (0, or less than read by OR/AND/XOR)
+
+		//Check if theres a second line
+		if ((lineEnd + 1) < userCodesLen)
+		{
+			//Parse second line vars (for codes that need the second line
+			//Get next code arguments
+			while (arg3Off < userCodesLen && lines[arg3Off] != ' ')
+				arg3Off++;
+			arg4Off = arg3Off + 1;
+			while (arg4Off < userCodesLen && lines[arg4Off] != ' ')
+				arg4Off++;
+			arg4Len = arg4Off + 1;
+			while (arg4Len < userCodesLen && lines[arg4Len] != '\r' && lines[arg4Len] != '\n')
+				arg4Len++;
+			arg4Len -= arg4Off;
+		}
+		else
+			arg4Len = 0;
+
+		char buf0_2[MAX(arg4Len, arg4Off - arg3Off)/2 + 4]; // test: arg4Len/2 in the plugin, the 2nd line of any code is read
+		char buf1_2[MAX(arg4Len, arg4Off - arg3Off)/2 + 4]; // test: (arg4Off - arg3Off)/2 in the plugin
+
+		if (arg4Len)
+		{
+			//Get args for second line
+			ReadHexPartial(lines, lineEnd + 2, (arg3Off) - (lineEnd + 2), addrBuf, ((arg3Off) - (lineEnd + 2))/2);
+			arg0_2 = (uint)(INT32(addrBuf));
+
+			//Get address for second line
+			ReadHexPartial(lines, arg3Off + 1, arg4Off - arg3Off - 1, buf0_2, (arg4Off - arg3Off - 1)/2);
+
+			//Get value for second line
+			ReadHexPartial(lines, arg4Off + 1, arg4Len - 1, buf1_2, (arg4Len - 1)/2);
+		}
+
+		int startPos = lineEnd - arg2Len + 1;
+
+		lines[lineEnd] = '\0';
+		add_log(lines + start); // write line to log file
+		lines[lineEnd] = '\n';
+
+		char cType = lines[start];
+		switch (cType)
+		{
+			case '0': ; //Write bytes (1=OR,2=AND,3=XOR,rest=write)
+				ReadHex(lines, startPos, buf0size, buf0, 4);
+
+				//Get source bytes
+				if(arg0) get_process_mem(pid, addr, buf1, buf0Len);
+
+				switch (arg0)
+				{
+					case 1: //OR
+						for (int cnt0 = 0; cnt0 < buf0Len; cnt0++)
+							buf0[cnt0] |= buf1[cnt0];
+						break;
+					case 2: //AND
+						for (int cnt0 = 0; cnt0 < buf0Len; cnt0++)
+							buf0[cnt0] &= buf1[cnt0];
+						break;
+					case 3: //XOR
+						for (int cnt0 = 0; cnt0 < buf0Len; cnt0++)
+							buf0[cnt0] ^= buf1[cnt0];
+						break;
+				}
+
+				//Write bytes to dest
+				WriteMem(pid, addr, buf0, buf0Len);
+				break;
+			case '1': //Write text
+				//Get total text write size
+				arg1Off++;
+				while (lines[start + arg1Off] != ' ')
+					arg1Off++;
+
+				arg2Len = lineLen - arg1Off;
+				memcpy64(buf0, lines + startPos, buf0size);
+				buf0[buf0size] = '\0';
+				WriteMem(pid, addr, buf0, buf0size);
+				break;
+			case '2': //Write float
+				strncpy(buf0, lines + startPos, buf0size);
+				float buf2Flt = (float)tofloat(buf0);
+				WriteMem(pid, addr, (char*)&buf2Flt, buf0size);
+				break;
+			case '4': ; //Write condensed
+				//Get count
+				uint count = (uint)(INT32(buf1_2));
+
+				//Get increment
+				u64 inc = (u64)(INT32(buf0_2));
+
+				//Get write
+				ReadHex(lines, startPos, buf0size, buf0, buf0Len);
+
+				for (uint cnt4 = 0; cnt4 < count; cnt4++)
+				{
+					WriteMem(pid, addr + (u64)(cnt4 * inc), buf0, buf0Len);
+					if (arg0_2)
+						*(uint*)buf0 += (arg0_2 << ((buf0Len % 4) * 8));
+				}
+
+				skip[0]++;
+				break;
+			case '6': //Write pointer
+
+				//Get offset
+				ReadHexPartial(lines, startPos, buf0size, buf0, buf0Len);
+				u64 offset = (u64)(INT32(buf0));
+
+				//Get address at pointer
+				get_process_mem(pid, addr, buf0, 4);
+				ptrAddr = (u64)(INT32(buf0));
+
+				ptrAddr += offset;
+
+				break;
+			case 'A': //Copy paste
+
+				switch (arg0)
+				{
+					case 1:
+						//Get count
+						ReadHexPartial(lines, startPos, buf0size, buf0, buf0Len);
+						uint count = (uint)(INT32(buf0));
+
+						if(count > _64KB_) {typeA_Size = 0; break;} // disable paste if copy is too large
+
+						if(!typeA_Copy)
+							typeA_Copy = sys_mem_allocate(_64KB_);
+
+						if(typeA_Copy)
+						{
+							typeA_Size = count;
+							get_process_mem(pid, addr, (char *)typeA_Copy, 4);
+						}
+						else
+						{
+							typeA_Size = 0;
+							typeA_Copy = NULL;
+						}
+						break;
+					case 2:
+						if (!typeA_Copy || typeA_Size <= 0)
+							break;
+
+						WriteMem(pid, addr, (char *)typeA_Copy, typeA_Size);
+						break;
+				}
+
+				break;
+			case 'B': //Find Replace
+				//Only work when doForceWrite is true (1) which means everytime the user activates Artemis from the in game XMB
+				//Don't want to waste time constantly searching
+
+				if (!doForceWrite)
+					break;
+
+				//Get end addr
+				ReadHex(lines, startPos, buf0size, addrBuf, 4);
+				u64 endAddr = (u64)(INT32(addrBuf));
+
+				//new (COP) length
+				uint binc = arg4Len/2;
+
+				//original (OGP) length
+				uint cmpSize = (arg4Off - arg3Off)/2;
+
+				//Flip addresses
+				u64 temp = 0;
+				if (endAddr < addr) { temp = addr; addr = endAddr; endAddr = temp; }
+
+				const size_t scanInc = _64KB_;
+				sys_addr_t sysmem = sys_mem_allocate(scanInc);
+
+				if(sysmem)
+				{
+					for (u64 curAddr = addr; curAddr < endAddr; curAddr += (scanInc - cmpSize))
+					{
+						if (get_process_mem(pid, curAddr, (char *)sysmem, scanInc) >= 0)
+						{
+							//So we stop it each loop before (scanInc - cmpSize) in the instance that
+							//the result is the last 2 bytes, for instance, and the compare is actually 4 bytes (so it won't result even though it should)
+							//This fixes that
+							for (u64 boff = 0; boff < (scanInc - cmpSize); boff++)
+							{
+								//Break if count reached
+								if (arg0 > 0 && temp >= (u64)arg0)
+									break;
+								if ((curAddr + boff) >= endAddr)
+									break;
+
+								if (CompareMemoryBuffered((char *)sysmem, boff, buf0_2, cmpSize))
+								{
+									//printf ("Instance found at 0x%08x, writing 0x%i (%d)\n", curAddr + boff, *(uint*)buf1_2, binc);
+									WriteMem(pid, curAddr + boff, buf1_2, binc);
+									//Just skip in case the replacement has, within itself, the ogp
+									//We subtract one because it gets added back at the top of the loop
+									boff += binc - 1;
+									temp++;
+								}
+							}
+						}
+					}
+					sys_memory_free(sysmem);
+				}
+
+				skip[0]++;
+				break;
+			case 'D': //Write conditional
+				ReadHex(lines, startPos, buf0size, buf0, 4);
+				int DisCond = CompareMemory(pid, addr, buf0, buf0Len);
+
+				if (!DisCond)
+				{
+					skip[0] += arg0;
+				}
+
+				break;
+			case 'E': //Write conditional (bitwise)
+				ReadHex(lines, startPos, buf0size, buf0, 4);
+				int EisCond = CompareMemoryAnd(pid, addr, buf0, buf0Len);
+
+				if (!EisCond)
+				{
+					skip[0] += arg0;
+				}
+
+				break;
+			case 'F': //Copy bytes
+
+				//Get destination
+				ReadHex(lines, startPos, buf0size, buf0, 4);
+				u64 dest = (u64)(INT32(buf0));
+
+				//Get source bytes
+				get_process_mem(pid, addr, buf1, arg0);
+				//Write bytes to dest
+				WriteMem(pid, dest, buf1, arg0);
+
+				break;
+
+		}
+	}
+	else
+		skip[0]--;
+
+	return lineEnd;
+}
+
+// Loops through each line of the code list, interprets the codes & writes to process id
+static void RefConvertCodes(process_id_t pid, char *userCodes)
+{
+	char lineBuf[100];
+
+	int lineNum = 0, codeNum = 0, lineCharInd = 0;
+	int skip[1]; skip[0] = 0;
+
+	if(file_size(ARTEMIS_CODES_LOG) >= _2MB_)
+		create_file(ARTEMIS_CODES_LOG); // truncate log file larger than 2MB
+
+	for (int i = 0; i < userCodesLen; i++)
+	{
+		if (userCodes[i] != '#')
+		{
+			if (userCodes[i] == '\n')
+			{
+				lineNum++;
+				lineCharInd = -1;
+			}
+			else
+			{
+				if (lineCharInd == 0)
+				{
+					int n;
+					for (n = i; n < userCodesLen; n++)
+					{
+						if (userCodes[n] == '\n' || userCodes[n] == '\r')
+							break;
+					}
+					n -= i; // line length
+					if(n > 100) n = sizeof(lineBuf);
+					memcpy64(lineBuf, userCodes + i, n);
+					lineBuf[n] = 0;
+				}
+
+				switch (lineNum)
+				{
+					case 1: //cWrite
+						if (*lineBuf == 0)
+							lineNum--;
+						else
+						{
+							if (lineCharInd == 0)
+								isConstantWrite = (userCodes[i] == '1' || userCodes[i] == 'T');
+
+							if (!isConstantWrite && !doForceWrite) //skip this code if not constant or force write
+							{
+								while ((i < userCodesLen) && (userCodes[i] != '#'))
+									i++;
+								i--;
+							}
+						}
+						break;
+					case 0: //Name
+						break;
+
+					default: //codes
+
+						if (lineNum > 1 && isCodeLineValid(lineBuf))
+						{
+							if(!(isConstantWrite || doForceWrite))
+								skip[0]++;
+							i = RefParseLine(pid, userCodes, i, skip, doForceWrite);
+						}
+						break;
+				}
+			}
+			lineCharInd++;
+		}
+		else // skip # line
+		{
+			lineNum = -1;
+			isConstantWrite = 0;
+			skip[0] = 0;
+			codeNum++;
+			lineCharInd = 0;
+
+			while ((i < userCodesLen) && (userCodes[i] == '\n'))
+				i++;
+		}
+	}
+}
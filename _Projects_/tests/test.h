@@ -0,0 +1,18 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+// minimal host test helpers: CHECK counts the failures, test_result() prints the summary
+
+#include <stdio.h>
+
+static int test_checks = 0, test_failures = 0;
+
+#define CHECK(cond) do { test_checks++; if(!(cond)) { test_failures++; printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); } } while(0)
+
+static int test_result(const char *name)
+{
+	printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+	return test_failures ? 1 : 0;
+}
+
+#endif // __TEST_H__
@@ -0,0 +1,344 @@
+// Artemis codelists (include/ps3mapi/artemis.h): the compiled codes (CompileCodes & RunCodes) against the
+// interpreter they replaced (artemis_ref.h) on random codelists; both run on a copy of the same process
+// memory & must leave the same memory and the same log
+// The codes are generated within the limits of the interpreter (e.g. patterns of find/replace of 4 or 8 bytes)
+// The 2nd lines of the codes 4 & B start with 5 (not a code type): they are run as a code of their own when
+// a conditional skips the 1st line, a 4 or a B with the values of the next line could run for minutes
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8; typedef uint16_t u16; typedef uint32_t u32; typedef unsigned long long u64; typedef int32_t s32;
+typedef volatile u8 vu8; typedef uintptr_t sys_addr_t;
+
+#undef  NULL
+#define NULL	0	// the plugin code also uses NULL as a null PID & address
+
+#define ARTEMIS_PRX
+
+#define MAX(a, b)			((a) >= (b) ? (a) : (b))
+#define MIN(a, b)			((a) <= (b) ? (a) : (b))
+#define BETWEEN(a, b, c)	( ((a) <= (b)) && ((b) <= (c)) )
+#define ISDIGIT(a)			( ('0' <= (a)) && ((a) <= '9') )
+#define ISSPACE(a)			( ( 0  <= (a)) && ((a) <= ' ') )
+#define LCASE(a)			((a) | 0x20)
+#define ISHEX(a)			(ISDIGIT(a) || BETWEEN('a', LCASE(a), 'f'))
+#define INT32(a)			be32(a)	// the PPU is big endian
+#define _4KB_	4096
+#define _64KB_	65536
+#define _1MB_	0x100000
+#define _2MB_	0x200000
+
+static u32 be32(const void *p) {const u8 *b = p; return ((u32)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];}
+
+static u8 h2b(const char hex)
+{
+	u8 c = LCASE(hex);
+	if(BETWEEN('0', c, '9')) c -= '0'; else if(BETWEEN('a', c, 'f')) c -= 'W';
+	return c;
+}
+
+static void _memset(void *m, size_t n) {memset(m, 0, n);}
+static void memcpy64(void *dst, const void *src, int n) {if(dst && src && n) memcpy(dst, src, n);}
+
+// log (add_log)
+#define ARTEMIS_CODES_LOG	"artemis.log"
+#define ARTEMIS_CODES_FILE	"artemis.ncl"
+#define ARTEMIS_CODES_L2	"artemis_l2.ncl"
+#define ARTEMIS_CODES_R2	"artemis_r2.ncl"
+#define SAVE_ALL			0
+#define APPEND_TEXT			1
+
+#define LOG_SIZE	(8 * _1MB_)
+static char *log_text; static u32 log_len;
+
+static int save_file(const char *file, const char *text, int mode)
+{
+	(void)file; if(mode == SAVE_ALL) log_len = 0;
+
+	// WriteMem logs the first 4 bytes of the data whatever its size: only the bytes written are kept
+	// & the writes of 0 bytes (a copy of 0 bytes is not logged by the compiled codes) are dropped
+	u64 addr; u32 value; int size; char line[100];
+	if(sscanf(text, "Write at 0x%llx => %x (%i bytes)", &addr, &value, &size) == 3)
+	{
+		if(size <= 0) return 0;
+		if(size < 4) value >>= (4 - size) * 8;
+		sprintf(line, "Write at 0x%llx => %x (%i bytes)", addr, value, size); text = line;
+	}
+
+	u32 len = strlen(text);
+	if(log_len + len + 1 < LOG_SIZE) {memcpy(log_text + log_len, text, len); log_len += len; log_text[log_len++] = '\n', log_text[log_len] = 0;}
+	return 0;
+}
+
+// process memory (ps3mapi_get_process_mem & ps3mapi_set_process_mem): bytes out of the memory read as 0
+#define MEM_BASE	0x10000
+#define MEM_SIZE	0x30000
+static u8 *mem;
+
+static int process_mem(const char *func, u64 addr, char *buf, int size)
+{
+	const bool set = strstr(func, "set") != NULL;
+	const u64 end = addr + size, from = MAX(addr, MEM_BASE), to = MIN(end, MEM_BASE + MEM_SIZE);
+
+	if(!set) memset(buf, 0, size);
+	if(from < to)
+	{
+		if(set) memcpy(mem + (from - MEM_BASE), buf + (from - addr), to - from);
+		else    memcpy(buf + (from - addr), mem + (from - MEM_BASE), to - from);
+	}
+	return BETWEEN(MEM_BASE, addr, MEM_BASE + MEM_SIZE - 1) ? 0 : -1;
+}
+
+#define system_call_6(...)			(void)0
+#define return_to_user_prog(type)	return process_mem(__func__, addr, buf, size)
+
+// the rest of the plugin used by artemis.h (thread, pad & files)
+typedef struct {int len; u16 button[8];} CellPadData;
+typedef struct {u8 port_status[8];} CellPadInfo2;
+static struct {u8 artemis;} config, *webman_config = &config;
+static int working = 1, thread_id_art;
+#define IS_INGAME		1
+#define THREAD_PRIO_ARTEMIS				0
+#define THREAD_STACK_SIZE_ARTEMIS		0
+#define SYS_PPU_THREAD_CREATE_JOINABLE	0
+#define sys_ppu_thread_create(id, ...)	(void)(id)
+#define sys_ppu_thread_sleep(s)			(void)0
+#define sys_ppu_thread_yield()			(void)0
+#define sys_ppu_thread_exit(r)			(void)0
+#define sys_timer_usleep(us)			(void)0
+#define cellPadGetInfo2(info)			memset(info, 0, sizeof(CellPadInfo2))
+#define cellPadGetData(port, data)		(memset(data, 0, sizeof(CellPadData)), 0)
+#define cellFsUnlink(path)				(void)0
+#define show_msg(msg)					(void)0
+#define show_error(msg)					(void)0
+#define create_file(path)				(void)0
+#define force_copy(from, to)			(void)0
+#define not_exists(path)				1
+static int GetGameProcessID(void) {return 0;}
+static size_t file_size(const char *path) {(void)path; return 0;}
+static size_t read_file(const char *file, char *data, size_t size, s32 offset) {(void)file, (void)data, (void)size, (void)offset; return 0;}
+static sys_addr_t sys_mem_allocate(u32 size) {return (sys_addr_t)calloc(1, size);}
+static void sys_memory_free(sys_addr_t addr) {free((void *)addr);}
+
+#include "../../include/ps3mapi/artemis.h"
+#include "artemis_ref.h"
+#include "test.h"
+
+/***********************************************************************
+* random codelists
+***********************************************************************/
+static char *text; static u32 text_len;
+static const char *eol;
+
+static void add(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void add(const char *fmt, ...)
+{
+	va_list args; va_start(args, fmt);
+	text_len += vsprintf(text + text_len, fmt, args);
+	va_end(args);
+}
+
+static u8 *mem_ref, *mem_prog;
+
+static u32 rnd_addr(u32 room)
+{
+	switch(rand() % 16)
+	{
+		case 0: return 0;
+		case 1: return rand() % 0x100000;
+		default: return MEM_BASE + rand() % (MEM_SIZE - room);
+	}
+}
+
+// hex of the bytes at addr (the current memory) or random bytes
+static void add_hex(u32 addr, u8 bytes)
+{
+	for(u8 i = 0; i < bytes; i++)
+	{
+		u32 a = addr + i;
+		add("%02X", (addr && BETWEEN(MEM_BASE, a, MEM_BASE + MEM_SIZE - 1)) ? mem_ref[a - MEM_BASE] : rand() & 0xFF);
+	}
+}
+
+// sub-type / count of the code type & its value as read by the interpreter
+static int add_prefix(const char *digits)
+{
+	char prefix[4]; u8 n = rand() % 3, i;
+	for(i = 0; i < n; i++) prefix[i] = digits[rand() % strlen(digits)];
+	prefix[i] = 0; add("%s", prefix);
+
+	if(!n) return 0;
+	char buf[4]; ReadHexPartial(prefix, 0, n, buf, n / 2);
+	return (int)INT32(buf);
+}
+
+static void add_code_line(void)
+{
+	const char *types = "00001246ABDDEEF";
+	static char type;
+
+	// no B after a pointer: the interpreter counted the swapped start address as replacements (pointer > end)
+	for(char last = type; (type = types[rand() % strlen(types)]) == 'B' && last == '6'; ) ;
+	u32 addr; u8 bytes;
+
+	add("%c", type);
+
+	switch(type)
+	{
+		case '0':
+			add_prefix("0123"); bytes = 1 + rand() % 4;
+			addr = rnd_addr(4); add(" %08X ", addr); add_hex(0, bytes);
+			break;
+		case '1':
+			add(" %08X ", rnd_addr(16));
+			for(u8 i = 1 + rand() % 12; i; i--) add("%c", "abcXYZ019_"[rand() % 10]);
+			break;
+		case '2':
+			add(" %08X %u", rnd_addr(4), rand() % 10000);
+			break;
+		case '4':
+			add(" %08X ", rnd_addr(0x400)); add_hex(0, (rand() & 1) ? 4 : 2);
+			add("%s5%06X %08X %08X", eol, rand() % 3, 1 + rand() % 0x40, rand() % 0x20); // value inc, address inc, count
+			break;
+		case '6':
+			add(" %08X %08X", MEM_BASE + (rand() % (MEM_SIZE / 0x100)) * 0x100, rand() % 0x80);
+			break;
+		case 'A':
+			add_prefix("0123");
+			add(" %08X %08X", rnd_addr(0x100), rand() % 0x100);
+			break;
+		case 'B':
+		{
+			add_prefix("0123");
+			u32 start = MEM_BASE + rand() % MEM_SIZE, end = start + rand() % (MEM_SIZE - (start - MEM_BASE));
+			bytes = (rand() & 1) ? 4 : 8;
+			add(" %08X %08X%s5 ", start, end, eol);
+			if(!(rand() % 4))
+				add("%0*u %0*u", bytes * 2, 0, bytes * 2, 0); // zeros replaced by zeros: the next search starts after the replacement
+			else
+				{add_hex((rand() % 3) ? start + rand() % (end - start + 1) : 0, bytes); add(" "); add_hex(0, bytes);}
+			break;
+		}
+		case 'D':
+		case 'E':
+			add_prefix("0123");
+			addr = rnd_addr(4); bytes = 1 + rand() % 4;
+			add(" %08X ", addr); add_hex((rand() % 3) ? addr : 0, bytes);
+			break;
+		case 'F':
+			add_prefix("0123F");
+			add(" %08X %08X", rnd_addr(0x100), rnd_addr(0x100));
+			break;
+	}
+	add("%s", eol);
+}
+
+static void build_codelist(void)
+{
+	text_len = 0; eol = (rand() % 4) ? "\n" : "\r\n";
+
+	for(u8 codes = 1 + rand() % 6; codes; codes--)
+	{
+		add("Code %i%s", rand(), eol);
+		if(!(rand() % 8)) add("%s", eol);
+		add("%c%s", "0011TF"[rand() % 6], eol);
+
+		for(u8 lines = 1 + rand() % 5; lines; lines--)
+			if(rand() % 16) add_code_line(); else add("%s%s", (rand() & 1) ? "0 1234" : "not a code", eol);
+
+		if(codes > 1 || (rand() & 1)) add("#%s", eol);
+	}
+
+	text[text_len++] = '\n'; text[text_len] = '\0'; // as appended by art_process
+}
+
+// the memory of a run is a random window of a larger random block, pointers included
+static u8 *block;
+
+static void init_block(void)
+{
+	for(u32 i = 0; i < 2 * MEM_SIZE; i++) block[i] = (rand() & 1) ? "\x00\x11\x22\xFF"[rand() % 4] : rand();
+	for(u32 i = 0; i < 2 * MEM_SIZE; i += 0x40) // pointers of the codes 6
+	{
+		u32 ptr = MEM_BASE + rand() % (MEM_SIZE - 0x100);
+		block[i] = ptr >> 24, block[i + 1] = ptr >> 16, block[i + 2] = ptr >> 8, block[i + 3] = ptr;
+	}
+	for(u32 i = 0; i < 2 * MEM_SIZE; i += 0x1000) memset(block + i + 0x20, 0, rand() % 0x20); // runs of zeros
+}
+
+static void init_memory(void)
+{
+	memcpy(mem_ref, block + (rand() % (MEM_SIZE / 0x40)) * 0x40, MEM_SIZE);
+	memcpy(mem_prog, mem_ref, MEM_SIZE);
+}
+
+static void reset_state(void)
+{
+	ptrAddr = 0; typeA_Size = 0;
+	if(typeA_Copy) {sys_memory_free(typeA_Copy); typeA_Copy = NULL;}
+}
+
+#define RUNS	1000
+#define PASSES	3		// the 1st pass is a force write (START), then constant writes
+
+int main(void)
+{
+	char *codes = calloc(1, _64KB_ + _4KB_); // extra room: the hex values are read past the end of their line
+	char *log_ref = malloc(LOG_SIZE), *log_prog = malloc(LOG_SIZE);
+	u32 log_ref_len = 0, writes = 0;
+	text = calloc(1, _64KB_ + _4KB_);
+	mem_ref = malloc(MEM_SIZE), mem_prog = malloc(MEM_SIZE), block = malloc(2 * MEM_SIZE);
+
+	srand(41); init_block();
+
+	for(u32 run = 0; run < RUNS; run++)
+	{
+		build_codelist(); init_memory();
+		userCodesLen = text_len;
+
+		// interpreter
+		mem = mem_ref; log_text = log_ref; log_len = 0; reset_state();
+		for(u8 pass = 0; pass < PASSES; pass++)
+		{
+			memcpy(codes, text, text_len + 1);
+			doForceWrite = (pass == 0);
+			isConstantWrite = 0; // else it is left by the last code of the previous pass if the list does not end with #
+			RefConvertCodes(1, codes);
+		}
+		log_ref_len = log_len;
+
+		// compiled codes
+		mem = mem_prog; log_text = log_prog; log_len = 0; reset_state();
+		memcpy(codes, text, text_len + 1); userCodes = codes;
+
+		userProgLen = CompileCodes(userCodes, NULL);
+		u8 *prog = malloc(userProgLen);
+		int progLen = CompileCodes(userCodes, prog);
+		CHECK(progLen == userProgLen);
+
+		for(u8 pass = 0; pass < PASSES; pass++)
+		{
+			doForceWrite = (pass == 0);
+			RunCodes(1, prog);
+		}
+		free(prog);
+
+		const bool same_mem = !memcmp(mem_ref, mem_prog, MEM_SIZE);
+		const bool same_log = (log_len == log_ref_len) && !memcmp(log_ref, log_prog, log_len);
+		CHECK(same_mem); CHECK(same_log);
+		if(!same_mem || !same_log) {printf("  codelist of run %u:\n%s\n", run, text); break;}
+
+		for(char *w = log_prog; (w = strstr(w, "Write at")) && (w < log_prog + log_len); w++) writes++;
+	}
+
+	reset_state(); userCodes = NULL;
+	printf("  %u codelists, %u writes\n", RUNS, writes);
+
+	free(codes); free(text); free(log_ref); free(log_prog); free(mem_ref); free(mem_prog); free(block);
+	return test_result("artemis");
+}
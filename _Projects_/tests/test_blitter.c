@@ -0,0 +1,126 @@
+// ARGB row primitives (blitter.h) against per-pixel references, at every 4-byte alignment & row length
+// The host builds the scalar path (the VMX path needs a PPU); the whole buffer is compared, so a write
+// before or after the row is caught
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../blitter.h"
+#include "test.h"
+
+#define PIXELS	64
+#define MAX_N	40
+
+// channel = (fg * a + bg * (255 - a)) >> 8, alpha = a + (bg alpha * (255 - a)) >> 8, transparent fg keeps bg
+static uint32_t ref_mix(uint32_t bg, uint32_t fg)
+{
+	uint32_t a = fg >> 24, ret;
+	if(!a) return bg;
+
+	ret = (a + (((bg >> 24) * (255 - a)) >> 8)) << 24;
+	for(int s = 0; s < 24; s += 8)
+		ret |= ((((fg >> s) & 0xFF) * a + ((bg >> s) & 0xFF) * (255 - a)) >> 8) << s;
+	return ret;
+}
+
+// 75% of R, G & B: c - c/4
+static uint32_t ref_dim(uint32_t p)
+{
+	uint32_t ret = p & 0xFF000000;
+	for(int s = 0; s < 24; s += 8) {uint32_t c = (p >> s) & 0xFF; ret |= (c - c / 4) << s;}
+	return ret;
+}
+
+static uint32_t rnd_pixel(void)
+{
+	uint32_t p = ((uint32_t)rand() << 16) ^ rand();
+	switch(rand() % 4) {case 0: return p & 0x00FFFFFF; case 1: return p | 0xFF000000; default: return p;} // transparent, opaque
+}
+
+static uint32_t dst[PIXELS] __attribute__((aligned(16))), expect[PIXELS], src[PIXELS] __attribute__((aligned(16))), fg[PIXELS] __attribute__((aligned(16)));
+static uint8_t alpha[PIXELS];
+
+static void fill_random(void)
+{
+	for(int i = 0; i < PIXELS; i++)
+	{
+		dst[i] = rnd_pixel(), src[i] = rnd_pixel(), fg[i] = rnd_pixel();
+		alpha[i] = (rand() % 3) ? 0 : rand(); // blank runs
+	}
+	memcpy(expect, dst, sizeof(dst));
+}
+
+int main(void)
+{
+	int mix_errors = 0, row_errors = 0;
+
+	// blit_mix: every alpha, fg & bg of a channel (in R, G & B at once), then random pixels
+	for(uint32_t a = 0; a < 256; a++)
+		for(uint32_t f = 0; f < 256; f++)
+			for(uint32_t b = 0; b < 256; b += 3)
+			{
+				uint32_t bg = (b << 24) | (b << 16) | (b << 8) | b, px = (a << 24) | (f << 16) | (f << 8) | f;
+				if(blit_mix(bg, px) != ref_mix(bg, px)) mix_errors++;
+			}
+	for(int i = 0; i < 1000000; i++)
+	{
+		uint32_t bg = rnd_pixel(), px = rnd_pixel();
+		if(blit_mix(bg, px) != ref_mix(bg, px)) mix_errors++;
+		if(blit_dim_pixel(px) != ref_dim(px)) mix_errors++;
+	}
+	CHECK(mix_errors == 0);
+
+	srand(39);
+
+	// rows at every pixel offset of a 16-byte block (dst & src), of 0 to MAX_N pixels
+	for(int od = 0; od < 4; od++)
+	for(int os = 0; os < 4; os++)
+	for(uint32_t n = 0; n <= MAX_N; n++)
+	{
+		uint32_t *d = dst + od, *e = expect + od, *s = src + os, *f = fg + os, color = rnd_pixel();
+		const uint8_t *al = alpha + os;
+
+		fill_random(); blit_copy(d, s, n);
+		for(uint32_t i = 0; i < n; i++) e[i] = s[i];
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_blend(d, s, f, n);
+		for(uint32_t i = 0; i < n; i++) e[i] = ref_mix(s[i], f[i]);
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_blend(d, d, f, n); // in place
+		for(uint32_t i = 0; i < n; i++) e[i] = ref_mix(e[i], f[i]);
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_blend_color(d, s, color, n);
+		for(uint32_t i = 0; i < n; i++) e[i] = ref_mix(s[i], color);
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_blend_over(d, color, f, n);
+		for(uint32_t i = 0; i < n; i++) e[i] = ref_mix(color, f[i]);
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_dim(d, s, n);
+		for(uint32_t i = 0; i < n; i++) e[i] = ref_dim(s[i]);
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_dim(d, d, n); // in place
+		for(uint32_t i = 0; i < n; i++) e[i] = ref_dim(e[i]);
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		fill_random(); blit_glyph(d, al, color, n);
+		for(uint32_t i = 0; i < n; i++) if(al[i]) e[i] = ref_mix(e[i], ((uint32_t)al[i] << 24) | (color & 0x00FFFFFF));
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+
+		// pairs of pixels: the 1st pixel of the pair is the 1st in memory
+		uint64_t pair; uint32_t px[2] = {color, rnd_pixel()}; memcpy(&pair, px, 8);
+		fill_random(); blit_fill64((uint64_t *)d, pair, n / 2);
+		for(uint32_t i = 0; i < (n & ~1); i++) e[i] = px[i & 1];
+		row_errors += !!memcmp(dst, expect, sizeof(dst));
+	}
+	CHECK(row_errors == 0);
+
+	printf("  blit_mix %d errors, rows %d errors\n", mix_errors, row_errors);
+	return test_result("blitter");
+}
@@ -0,0 +1,197 @@
+// ps3netsrv LZ4 blocks (src/lz4block.c) & CSO/ZSO/DAX images read as raw ISOs (src/CompressedFile.cpp)
+// the images are built here with lz4_compress_block & zlib, every read is compared with the raw data
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "CompressedFile.h"
+#include "lz4block.h"
+#include "test.h"
+
+#define RAW_SIZE	(150 * 1024 + 1234)		// last block is partial
+
+static uint8_t raw[RAW_SIZE];
+
+static void put32(uint8_t *p, uint32_t v) {for(int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (i * 8));}
+
+static void fill_raw(void)
+{
+	const char *text = "PLAYSTATION3 webMAN MOD netiso block ";
+	for(uint32_t i = 0; i < RAW_SIZE; i++)
+	{
+		uint32_t area = (i / 5000) % 3;
+		raw[i] = (area == 0) ? (uint8_t)text[i % 37] : (area == 1) ? (uint8_t)rand() : 0;
+	}
+}
+
+static bool write_image(const char *path, const uint8_t *data, size_t size)
+{
+	FILE *f = fopen(path, "wb");
+	if(!f) return false;
+	bool ok = (fwrite(data, 1, size, f) == size);
+	fclose(f);
+	return ok;
+}
+
+// CSO (raw deflate) or ZSO (LZ4) with blocks of block_size, offsets >> align
+static size_t build_ciso(uint8_t *img, bool zso, uint32_t block_size, uint8_t align)
+{
+	uint32_t blocks = (RAW_SIZE + block_size - 1) / block_size;
+	size_t pos = 0x18 + (blocks + 1) * 4;
+
+	memset(img, 0, 0x18);
+	memcpy(img, zso ? "ZISO" : "CISO", 4); put32(img + 4, 0x18);
+	put32(img + 8, RAW_SIZE); put32(img + 0x10, block_size); img[0x14] = 1; img[0x15] = align;
+
+	for(uint32_t b = 0; b <= blocks; b++)
+	{
+		pos = (pos + (1 << align) - 1) & ~(size_t)((1 << align) - 1);
+		uint32_t entry = (uint32_t)(pos >> align);
+		if(b == blocks) {put32(img + 0x18 + b * 4, entry); break;}
+
+		uint32_t size = (b == blocks - 1) ? (RAW_SIZE - b * block_size) : block_size; int zsize = 0;
+		const uint8_t *src = raw + b * block_size;
+
+		if(zso)
+			zsize = lz4_compress_block(src, size, img + pos, size - 1);
+		else
+		{
+			z_stream z; memset(&z, 0, sizeof(z));
+			deflateInit2(&z, 9, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+			z.next_in = (Bytef*)src, z.avail_in = size, z.next_out = img + pos, z.avail_out = size - 1;
+			if(deflate(&z, Z_FINISH) == Z_STREAM_END) zsize = (int)z.total_out;
+			deflateEnd(&z);
+		}
+
+		if(zsize <= 0) {memcpy(img + pos, src, size); zsize = size; entry |= 0x80000000;} // stored
+		put32(img + 0x18 + b * 4, entry);
+		pos += zsize;
+	}
+	return pos;
+}
+
+// DAX: zlib frames of 0x2000, the frames of [stored_first, +stored_count) are not compressed
+static size_t build_dax(uint8_t *img, uint32_t stored_first, uint32_t stored_count)
+{
+	const uint32_t frame = 0x2000, frames = (RAW_SIZE + frame - 1) / frame;
+	size_t pos = 0x20 + frames * 6 + 8;
+
+	memset(img, 0, 0x20);
+	memcpy(img, "DAX", 4); put32(img + 4, RAW_SIZE); put32(img + 8, 1); put32(img + 12, 1);
+
+	uint8_t *lengths = img + 0x20 + frames * 4, *area = lengths + frames * 2;
+	put32(area, stored_first); put32(area + 4, stored_count);
+
+	for(uint32_t b = 0; b < frames; b++)
+	{
+		uint32_t size = (b == frames - 1) ? (RAW_SIZE - b * frame) : frame;
+		uLongf zsize = compressBound(size);
+
+		if((b >= stored_first) && (b < stored_first + stored_count))
+			{memcpy(img + pos, raw + b * frame, size); zsize = 0;}
+		else
+			compress2(img + pos, &zsize, raw + b * frame, size, 9);
+
+		put32(img + 0x20 + b * 4, (uint32_t)pos);
+		lengths[b * 2] = (uint8_t)zsize, lengths[b * 2 + 1] = (uint8_t)(zsize >> 8);
+		pos += zsize ? zsize : size;
+	}
+	return pos;
+}
+
+// random reads & a full sequential read compared with the raw data
+static bool check_reads(CompressedFile &file)
+{
+	static uint8_t buf[RAW_SIZE + 100];
+	file_stat_t st;
+
+	if((file.fstat(&st) != 0) || (st.file_size != RAW_SIZE)) return false;
+
+	if((file.seek(0, SEEK_SET) != 0) || (file.read(buf, sizeof(buf)) != RAW_SIZE) || memcmp(buf, raw, RAW_SIZE)) return false;
+
+	for(int n = 0; n < 500; n++)
+	{
+		uint32_t offset = rand() % RAW_SIZE, size = 1 + rand() % 20000;
+		ssize_t expected = (offset + size > RAW_SIZE) ? (RAW_SIZE - offset) : size;
+
+		if(file.seek(offset, SEEK_SET) != offset) return false;
+		if((file.read(buf, size) != expected) || memcmp(buf, raw + offset, expected)) return false;
+	}
+
+	file.seek(-10, SEEK_END);
+	if((file.read(buf, 100) != 10) || memcmp(buf, raw + RAW_SIZE - 10, 10)) return false;
+	return (file.read(buf, 100) == 0); // end of the image
+}
+
+int main(void)
+{
+	static uint8_t img[RAW_SIZE * 2], out[RAW_SIZE];
+	char path[] = "/tmp/test_compressed_XXXXXX"; int tmp = mkstemp(path); close(tmp);
+	srand(99);
+	fill_raw();
+
+	// LZ4 blocks: round trip, bounds, corrupted data
+	for(uint32_t size = 1; size <= 70000; size = size * 3 + 7)
+	{
+		const uint8_t *src = raw + (rand() % (RAW_SIZE - size));
+		int zsize = lz4_compress_block(src, size, img, sizeof(img));
+		CHECK(zsize > 0);
+		CHECK(lz4_decompress_block(img, zsize, out, size) == (int)size && !memcmp(out, src, size));
+		if(size > 16) CHECK(lz4_decompress_block(img, zsize, out, size - 1) == -1); // output too small
+
+		for(int n = 0; n < 20; n++) // corrupted input never writes out of bounds (ASan)
+		{
+			img[rand() % zsize] ^= (uint8_t)(1 + rand() % 255);
+			lz4_decompress_block(img, zsize, out, size);
+		}
+	}
+	CHECK(lz4_compress_block(raw + 5000, 5000, img, 100) == 0); // random data does not fit
+	CHECK(is_zero_block(raw + 10000, 5000) && !is_zero_block(raw + 9999, 5001) && is_zero_block(raw, 0));
+
+	// images
+	struct {const char *name; size_t size;} images[5];
+	CompressedFile file;
+
+	images[0].name = "CSO 2KB";		 images[0].size = build_ciso(img, false, 0x800, 0);
+	write_image(path, img, images[0].size);
+	CHECK(file.open(path, O_RDONLY) == 0 && check_reads(file)); file.close();
+
+	images[1].name = "ZSO 2KB";		 images[1].size = build_ciso(img, true, 0x800, 0);
+	write_image(path, img, images[1].size);
+	CHECK(file.open(path, O_RDONLY) == 0 && check_reads(file)); file.close();
+
+	images[2].name = "ZSO 16KB a2";	 images[2].size = build_ciso(img, true, 0x4000, 2);
+	write_image(path, img, images[2].size);
+	CHECK(file.open(path, O_RDONLY) == 0 && check_reads(file)); file.close();
+
+	images[3].name = "DAX";			 images[3].size = build_dax(img, 3, 4);
+	write_image(path, img, images[3].size);
+	CHECK(file.open(path, O_RDONLY) == 0 && check_reads(file)); file.close();
+
+	for(int i = 0; i < 4; i++) printf("  %-12s %6zu bytes (raw %u)\n", images[i].name, images[i].size, RAW_SIZE);
+
+	// corrupted block: the read fails, the other blocks are still read
+	images[4].size = build_ciso(img, false, 0x800, 0);
+	uint32_t first = img[0x18] | (img[0x19] << 8);
+	memset(img + first, 0xFF, 16);
+	write_image(path, img, images[4].size);
+	CHECK(file.open(path, O_RDONLY) == 0);
+	CHECK(file.read(out, 100) == -1);
+	file.seek(0x800, SEEK_SET);
+	CHECK(file.read(out, 100) == 100 && !memcmp(out, raw + 0x800, 100));
+	file.close();
+
+	// truncated index & not an image
+	write_image(path, img, 0x30);
+	CHECK(file.open(path, O_RDONLY) != 0);
+	memset(img, 0, 64); write_image(path, img, 64);
+	CHECK(file.open(path, O_RDONLY) != 0);
+	CHECK(CompressedFile::detect_format("/a/b/GAME.ZsO") == kFormatZSO);
+	CHECK(CompressedFile::detect_format("/a/b/GAME.iso") == kFormatNone);
+
+	unlink(path);
+	return test_result("compressed_file");
+}
@@ -0,0 +1,97 @@
+// cue sheet parser (include/mount/cue_sheet.h)
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../../include/mount/cue_sheet.h"
+#include "test.h"
+
+static cue_track t[99];
+static uint8_t files;
+
+static uint8_t parse(const char *sheet, uint8_t max_tracks)
+{
+	memset(t, 0xEE, sizeof(t));
+	return cue_parse(sheet, strlen(sheet), t, max_tracks, &files);
+}
+
+static int file_is(const char *sheet, uint8_t n, const char *name)
+{
+	uint32_t len; const char *p = cue_file_name(sheet, strlen(sheet), n, &len);
+	if(!name) return (p == NULL);
+	return p && (len == strlen(name)) && !memcmp(p, name, len);
+}
+
+#define MSF(m, s, f)	((((m) * 60 + (s)) * 75) + (f))
+
+int main(void)
+{
+	// single bin with CRLF, INDEX 00 pregap ignored
+	const char *single =	"FILE \"Game.bin\" BINARY\r\n"
+							"  TRACK 01 MODE2/2352\r\n"
+							"    INDEX 01 00:00:00\r\n"
+							"  TRACK 02 AUDIO\r\n"
+							"    INDEX 00 30:00:00\r\n"
+							"    INDEX 01 30:02:00\r\n";
+	CHECK(parse(single, 99) == 2);
+	CHECK(files == 1);
+	CHECK(t[0].lba == 0 && !t[0].audio && t[0].file == 0);
+	CHECK(t[1].lba == MSF(30, 2, 0) && t[1].audio);
+	CHECK(file_is(single, 0, "Game.bin"));
+	CHECK(file_is(single, 1, NULL));
+
+	// multi bin: path stripped, lower case keywords, LBAs relative to each FILE
+	const char *multi =		"FILE \"C:\\dump\\Game (Track 1).bin\" BINARY\n"
+							" TRACK 01 MODE2/2352\n"
+							"  INDEX 01 00:00:00\n"
+							"FILE \"Game (Track 2).bin\" BINARY\n"
+							" TRACK 02 AUDIO\n"
+							"  INDEX 00 00:00:00\n"
+							"  INDEX 01 00:02:00\n"
+							"file Game3.bin binary\n"
+							" track 03 audio\n"
+							"  index 01 00:02:00\n";
+	const uint32_t sectors[3] = {1000, 500, 200};
+	CHECK(parse(multi, 99) == 3);
+	CHECK(files == 3);
+	CHECK(t[1].file == 1 && t[2].file == 2);
+	cue_resolve(t, 3, sectors);
+	CHECK(t[0].lba == 0);
+	CHECK(t[1].lba == 1000 + CUE_PREGAP && t[1].audio);
+	CHECK(t[2].lba == 1500 + CUE_PREGAP && t[2].audio);
+	CHECK(file_is(multi, 0, "Game (Track 1).bin"));
+	CHECK(file_is(multi, 1, "Game (Track 2).bin"));
+	CHECK(file_is(multi, 2, "Game3.bin"));
+
+	// .ccd: MODE=0 is audio, INDEX 1=<lba>
+	const char *ccd =		"[TRACK 1]\nMODE=2\nINDEX 1=0\n"
+							"[TRACK 2]\nMODE=0\nINDEX 0=1000\nINDEX 1=1150\n";
+	CHECK(parse(ccd, 99) == 2);
+	CHECK(files == 0);
+	CHECK(t[0].lba == 0 && !t[0].audio);
+	CHECK(t[1].lba == 1150 && t[1].audio);
+
+	// single file where INDEX 01 is lower than the previous track: it is a track length
+	const char *lengths =	"FILE \"a.bin\" BINARY\n"
+							"TRACK 01 MODE2/2352\nINDEX 01 00:10:00\n"
+							"TRACK 02 AUDIO\nINDEX 01 00:05:00\n";
+	CHECK(parse(lengths, 99) == 2);
+	CHECK(t[0].lba == 0);
+	CHECK(t[1].lba == MSF(0, 10, 0) + CUE_PREGAP);
+
+	// the table is never overrun
+	CHECK(parse(multi, 2) == 2);
+	CHECK(t[2].lba == 0xEEEEEEEE);
+
+	// text ends at NUL within size
+	const char nul[] = "TRACK 01 MODE1/2048\nINDEX 01 00:00:00\n\0TRACK 02 AUDIO\nINDEX 01 01:00:00\n";
+	CHECK(cue_parse(nul, sizeof(nul) - 1, t, 99, &files) == 1);
+
+	// not a cue sheet
+	CHECK(parse("hello\nINDEX 01 xx\nINDEX 01 1:2\nTRACK\n", 99) == 0);
+	CHECK(parse("", 99) == 0);
+	CHECK(cue_msf("12:34:56", "12:34:56" + 8) == MSF(12, 34, 56));
+	CHECK(cue_msf("12:34", "12:34" + 5) == -1);
+
+	return test_result("cue_sheet");
+}
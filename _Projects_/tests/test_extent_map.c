@@ -0,0 +1,83 @@
+// extent map of the raw ISO sections (include/mount/extent_map.h)
+// random section sizes (empty sections included) are searched in random & sequential order
+// and compared with the walk of the sections that rawseciso.h uses for the small maps
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../../include/mount/extent_map.h"
+#include "test.h"
+
+#define MAX_SECTIONS	3000
+
+static uint64_t size[MAX_SECTIONS], start[MAX_SECTIONS + 1];
+
+// section that holds offset (count if past the end)
+static uint32_t walk(uint32_t count, uint64_t offset)
+{
+	uint64_t base = 0;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if((offset >= base) && (offset < base + size[i])) return i;
+		base += size[i];
+	}
+	return count;
+}
+
+static uint64_t random_offset(uint64_t end) {return (((uint64_t)rand() << 31) ^ rand()) % (end + 100);}
+
+int main(void)
+{
+	t_extent_map map = {start, 0, 0};
+	uint32_t errors = 0;
+
+	// no section: every offset is past the end
+	start[0] = 0;
+	CHECK(extent_find(&map, 0) == 0 && extent_find(&map, 12345) == 0);
+
+	srand(35);
+	for(uint32_t run = 0; run < 300; run++)
+	{
+		uint32_t count = 1 + rand() % ((run & 1) ? MAX_SECTIONS : 20);
+		uint8_t empty = rand() % 4; // 1 of 4 maps has many empty sections
+
+		for(uint32_t i = 0; i < count; i++)
+		{
+			size[i] = (rand() % 5) ? 1 + rand() % 100000 : (rand() % 2) ? 2048 : 0;
+			if(empty == 0 && (rand() % 3) == 0) size[i] = 0;
+			if(run % 7 == 0) size[i] *= 0x100000; // > 4GB discs
+		}
+
+		start[0] = 0;
+		for(uint32_t i = 0; i < count; i++) start[i + 1] = start[i] + size[i];
+
+		map.count = count, map.last = 0;
+		uint64_t end = start[count];
+
+		// random offsets
+		for(uint32_t n = 0; n < 300; n++)
+		{
+			uint64_t offset = random_offset(end);
+			if(extent_find(&map, offset) != walk(count, offset)) errors++;
+		}
+
+		// sequential reads of random lengths, through the end of the disc
+		for(uint64_t offset = 0; offset <= end; offset += 1 + (random_offset(end) >> (4 + rand() % 16)))
+		{
+			uint32_t i = extent_find(&map, offset);
+			if((i != walk(count, offset)) || ((i < count) && !size[i])) errors++;
+		}
+
+		// the first & last byte of each section
+		for(uint32_t i = 0; i < count; i++)
+			if(size[i] && ((extent_find(&map, start[i]) != i) || (extent_find(&map, start[i + 1] - 1) != i))) errors++;
+
+		// past the end: the last hit is kept
+		uint32_t last = map.last;
+		CHECK(extent_find(&map, end) == count && extent_find(&map, end + 1) == count && extent_find(&map, UINT64_MAX) == count);
+		CHECK(map.last == last && map.last < count);
+	}
+	CHECK(errors == 0);
+
+	return test_result("extent_map");
+}
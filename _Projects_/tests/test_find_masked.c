@@ -0,0 +1,72 @@
+// chunked memory search (find_masked of include/init/compare.h) against a brute force search
+// the buffers are allocated with the exact size find_masked may read (mem + last + len)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8; typedef uint32_t u32; typedef int32_t s32; typedef uint64_t u64;
+#define NONE	-1
+#define PS3MAPI
+
+#include "../../include/init/compare.h"
+#include "test.h"
+
+static s32 reference(const char *mem, u32 pos, u32 last, u8 step, const char *find, u8 len, const char *mask)
+{
+	for(; pos <= last; pos += step)
+	{
+		u8 i = 0;
+		while((i < len) && ((mask[i] == '?') || (mem[pos + i] == find[i]))) i++;
+		if(i == len) return (s32)pos;
+	}
+	return NONE;
+}
+
+int main(void)
+{
+	u32 runs = 0, found = 0; int ok = 1;
+
+	srand(7);
+
+	for(u32 run = 0; run < 20000; run++)
+	{
+		u32 last = rand() % 300; u8 len = 1 + rand() % 12, step = (rand() & 1) ? 1 : 4;
+		u32 size = last + len, misalign = rand() % 8;
+
+		char *block = malloc(size + misalign), *mem = block + misalign; // mem starts at any alignment
+		for(u32 i = 0; i < size; i++) mem[i] = "ab?c"[rand() % 4]; // small alphabet: hits & near hits
+
+		char find[16], mask[16];
+		for(u8 i = 0; i < len; i++)
+		{
+			find[i] = "abc"[rand() % 3];
+			mask[i] = (rand() % 5) ? find[i] : '?';
+		}
+		if(run % 97 == 0) memset(mask, '?', len); // only wildcards
+
+		u32 pos = (last && (rand() & 1)) ? rand() % last : 0;
+
+		s32 a = find_masked(mem, pos, last, step, find, len, mask);
+		s32 b = reference(mem, pos, last, step, find, len, mask);
+
+		if(a != b) {ok = 0; printf("  mismatch: run %u pos %u last %u step %u len %u -> %d, expected %d\n", run, pos, last, step, len, a, b);}
+		runs++; found += (b != NONE);
+
+		free(block);
+	}
+	CHECK(ok);
+	printf("  %u searches, %u found\n", runs, found);
+
+	// long buffer without the byte: the 8-byte skip path
+	static char zero[4096 + 8];
+	CHECK(find_masked(zero, 0, 4096, 1, "\x01", 1, "\x01") == NONE);
+	zero[4001] = 1;
+	CHECK(find_masked(zero, 0, 4096, 1, "\x01", 1, "\x01") == 4001);
+	CHECK(find_masked(zero, 0, 4096, 4, "\x01", 1, "\x01") == NONE);
+	CHECK(find_masked(zero, 1, 4096, 4, "\x01", 1, "\x01") == 4001);
+	CHECK(find_masked(zero, 4002, 4096, 1, "\x01", 1, "\x01") == NONE);
+
+	return test_result("find_masked");
+}
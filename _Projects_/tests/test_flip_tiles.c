@@ -0,0 +1,78 @@
+// VSH Menu partial flip (vsh_menu/include/flip_tiles.h)
+// the framebuffer must equal the frame after each flip, the bytes written are reported
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../blitter.h"
+#include "../vsh_menu/include/flip_tiles.h"
+#include "test.h"
+
+#define W		720
+#define H		400
+#define TILE	80
+#define PITCH	1280
+
+static uint32_t fb[PITCH * H], frame[2][W * H], bg[W * H];
+
+static int fb_equals(const uint32_t *cur)
+{
+	for(uint32_t i = 0; i < H; i++)
+		if(memcmp(fb + (i * PITCH), cur + (i * W), W * 4)) return 0;
+	return 1;
+}
+
+static void fill(uint32_t *buf, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
+{
+	for(uint32_t i = y; i < y + h; i++)
+		for(uint32_t k = x; k < x + w; k++) buf[(i * W) + k] = color;
+}
+
+// draws a menu with the selection bar on line sel
+static void draw_menu(uint32_t *buf, int sel)
+{
+	memcpy(buf, bg, sizeof(bg));
+	for(int n = 0; n < 10; n++) fill(buf, 40, 60 + (n * 30), 300, 20, 0xFFC0C0C0);
+	if(sel >= 0) fill(buf, 30, 55 + (sel * 30), 660, 30, 0x80FFFFFF);
+}
+
+int main(void)
+{
+	uint32_t bytes, full = W * H * 4; int f = 0;
+
+	for(uint32_t n = 0; n < W * H; n++) bg[n] = 0xFF000000 | (n * 2654435761u >> 8);
+
+	draw_menu(frame[f], 0);
+	bytes = flip_tiles(fb, PITCH, frame[f], NULL, W, H, TILE);
+	CHECK(bytes == full);
+	CHECK(fb_equals(frame[f]));
+	printf("  first frame:       %7u bytes (full %u)\n", bytes, full);
+
+	f ^= 1; draw_menu(frame[f], 0);
+	bytes = flip_tiles(fb, PITCH, frame[f], frame[f ^ 1], W, H, TILE);
+	CHECK(bytes == 0);
+	CHECK(fb_equals(frame[f]));
+	printf("  same frame:        %7u bytes\n", bytes);
+
+	f ^= 1; draw_menu(frame[f], 1);
+	bytes = flip_tiles(fb, PITCH, frame[f], frame[f ^ 1], W, H, TILE);
+	CHECK(bytes && (bytes <= 65 * W * 4)); // the rows of the old & the new selection
+	CHECK(fb_equals(frame[f]));
+	printf("  selection moved:   %7u bytes (%u%%)\n", bytes, bytes * 100 / full);
+
+	// one pixel: one tile of one row, whatever its value (no hash to collide)
+	f ^= 1; draw_menu(frame[f], 1); frame[f][(200 * W) + 719] ^= 1;
+	bytes = flip_tiles(fb, PITCH, frame[f], frame[f ^ 1], W, H, TILE);
+	CHECK(bytes == TILE * 4);
+	CHECK(fb_equals(frame[f]));
+	printf("  one pixel changed: %7u bytes\n", bytes);
+
+	// width not multiple of the tile width: the last tile is partial
+	memset(fb, 0, sizeof(fb));
+	bytes = flip_tiles(fb, PITCH, frame[f], NULL, W, H, 96);
+	CHECK(bytes == full);
+	CHECK(fb_equals(frame[f]));
+
+	return test_result("flip_tiles");
+}
@@ -0,0 +1,117 @@
+// conditional & partial GET fields (include/www/http_range.h)
+// dates in the 3 formats of RFC 7231 are checked against gmtime() over 400 years, the byte-range sets
+// against the cases of RFC 7233 (ignored = 0: whole file, unsatisfiable = -1: 416)
+
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../include/www/http_range.h"
+#include "test.h"
+
+typedef struct {const char *range; uint64_t size; int count; uint64_t from[MAX_HTTP_RANGES], to[MAX_HTTP_RANGES];} range_case;
+
+static const range_case ranges[] =
+{
+	{"bytes=0-499",				10000, 1, {0}, {499}},
+	{"bytes=500-999",			10000, 1, {500}, {999}},
+	{"bytes=-500",				10000, 1, {9500}, {9999}},
+	{"bytes=9500-",				10000, 1, {9500}, {9999}},
+	{"bytes=0-0,-1",			10000, 2, {0, 9999}, {0, 9999}},
+	{"bytes=500-600, 601-999",	10000, 2, {500, 601}, {600, 999}},
+	{"bytes=0-99999",			10000, 1, {0}, {9999}},			// last byte clipped to the file
+	{"bytes=-20000",			10000, 1, {0}, {9999}},			// suffix longer than the file
+	{"bytes=5-5",				10000, 1, {5}, {5}},
+	{"bytes=0-1,2-3,4-5,6-7",	10000, 4, {0, 2, 4, 6}, {1, 3, 5, 7}},
+	{"bytes=10000-",			10000, -1},						// starts past the end: 416
+	{"bytes=10000-20000",		10000, -1},
+	{"bytes=-0",				10000, -1},						// empty suffix
+	{"bytes=20000-,0-1",		10000, 1, {0}, {1}},			// the satisfiable ranges are kept
+	{"bytes=500-100",			10000, 0},						// last byte before the first: invalid, ignored
+	{"bytes=0-1,500-100",		10000, 0},
+	{"bytes=20000-10000",		10000, 0},
+	{"bytes=0-1,2-3,4-5,6-7,8-9", 10000, 0},					// too many ranges
+	{"bytes=",					10000, 0},						// no range
+	{"bytes= , ",				10000, 0},
+	{"bytes=-",					10000, 0},
+	{"bytes=a-b",				10000, 0},
+	{"bytes=1-2x",				10000, 0},
+	{"bytes=1",					10000, 0},
+	{"items=0-1",				10000, 0},
+	{"bytes=0-1",				0, 0},							// empty file
+	{"bytes=99999999999999999999-",	10000, 0},					// overflow
+	{"bytes=0-99999999999999999999",	10000, 0},
+	{"bytes=18446744073709551615-",	10000, 0},					// 20 digits
+	{"bytes=9999999999999999999-",	10000, -1},					// 19 digits
+};
+
+#define RANGE_CASES	(sizeof(ranges) / sizeof(range_case))
+
+int main(void)
+{
+	uint64_t from[MAX_HTTP_RANGES], to[MAX_HTTP_RANGES];
+
+	// byte-range sets
+	for(uint32_t n = 0; n < RANGE_CASES; n++)
+	{
+		const range_case *c = &ranges[n];
+		int count = parse_http_range(c->range, c->size, from, to);
+
+		if(count != c->count) printf("  %s: %i ranges (expected %i)\n", c->range, count, c->count);
+		CHECK(count == c->count);
+
+		for(int i = 0; i < count; i++) CHECK((from[i] == c->from[i]) && (to[i] == c->to[i]));
+	}
+
+	// every range is inside the file
+	srand(27);
+	for(uint32_t run = 0; run < 100000; run++)
+	{
+		char range[64]; uint64_t size = 1 + rand() % 1000, a = rand() % 1200, b = rand() % 1200; int kind = rand() % 3, expected;
+		switch(kind)
+		{
+			case 0:  sprintf(range, "bytes=%llu-%llu", (unsigned long long)a, (unsigned long long)b); expected = (b < a) ? 0 : (a >= size) ? -1 : 1; break;
+			case 1:  sprintf(range, "bytes=%llu-", (unsigned long long)a); expected = (a >= size) ? -1 : 1; break;
+			default: sprintf(range, "bytes=-%llu", (unsigned long long)b); expected = b ? 1 : -1; break;
+		}
+
+		int count = parse_http_range(range, size, from, to);
+		CHECK(count == expected);
+		if(count == 1) CHECK((from[0] <= to[0]) && (to[0] < size));
+	}
+
+	// dates: the 3 formats of the same time
+	CHECK(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT") == 784111777);
+	CHECK(parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT") == 784111777);
+	CHECK(parse_http_date("Sun Nov  6 08:49:37 1994") == 784111777);
+	CHECK(parse_http_date("Thu, 01 Jan 1970 00:00:00 GMT") == 0);
+	CHECK(parse_http_date("Sat, 29 Feb 2020 23:59:59 GMT") == 1583020799);
+	CHECK(parse_http_date("Fri, 31 Dec 1999 23:59:60 GMT") == 946684800); // leap second
+
+	// not dates
+	const char *invalid[] = {"", "GMT", "Sun, 06 Nov 1994", "Sun, 06 Xyz 1994 08:49:37 GMT", "Sun, 32 Nov 1994 08:49:37 GMT",
+							 "Sun, 06 Nov 1969 08:49:37 GMT", "Sun, 06 Nov 1994 24:00:00 GMT", "Sun, 06 Nov 1994 08:60:00 GMT",
+							 "Sun, 06 Nov 1994 08:49:61 GMT", "Sun, 00 Nov 1994 08:49:37 GMT", "Sun, 06 Nov 99999999999 08:49:37 GMT",
+							 "Sun, 06 Nov 1994 08:999999999999:37 GMT", "\"5f1a-2000\""};
+	for(uint8_t n = 0; n < sizeof(invalid) / sizeof(char *); n++) CHECK(parse_http_date(invalid[n]) == 0);
+
+	// random times of 1970-2369 in the 3 formats (RFC 850 only for 1970-2069: 2 digit years)
+	int date_errors = 0;
+	for(uint32_t run = 0; run < 200000; run++)
+	{
+		time_t t = (time_t)(((uint64_t)rand() << 16 ^ rand()) % (400ULL * 365 * 86400));
+		struct tm tm; gmtime_r(&t, &tm); char date[64];
+
+		strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm); if(parse_http_date(date) != (uint64_t)t) date_errors++;
+		strftime(date, sizeof(date), "%a %b %e %H:%M:%S %Y", &tm);      if(parse_http_date(date) != (uint64_t)t) date_errors++;
+		if(tm.tm_year < 170)
+		{
+			strftime(date, sizeof(date), "%A, %d-%b-%y %H:%M:%S GMT", &tm); if(parse_http_date(date) != (uint64_t)t) date_errors++;
+		}
+	}
+	CHECK(date_errors == 0);
+
+	return test_result("http_range");
+}
@@ -0,0 +1,171 @@
+// ISO9660 / Joliet reader (include/file/iso9660.h) on images built in memory
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../../include/file/iso9660.h"
+#include "test.h"
+
+#define SECTORS		64
+#define FILLERS		60		// entries that push the Joliet root into a 2nd sector
+
+static uint8_t image[SECTORS * ISO9660_SECTOR];
+static uint32_t reads;
+
+static int read_image(void *handle, uint64_t offset, void *buf, uint32_t size)
+{
+	(void)handle; reads++;
+	if(offset >= sizeof(image)) return 0;
+	if(size > sizeof(image) - offset) size = sizeof(image) - offset;
+	memcpy(buf, image + offset, size);
+	return size;
+}
+
+static void both32(uint8_t *p, uint32_t v)
+{
+	for(int i = 0; i < 4; i++) {p[i] = (uint8_t)(v >> (i * 8)); p[7 - i] = (uint8_t)(v >> (i * 8));}
+}
+
+// directory record, returns its length
+static uint8_t record(uint8_t *p, uint32_t lba, uint32_t size, uint8_t flags, const uint8_t *name, uint8_t name_len)
+{
+	uint8_t len = 33 + name_len + !(name_len & 1);
+	memset(p, 0, len);
+	p[0] = len; both32(p + 2, lba); both32(p + 10, size);
+	p[25] = flags; p[28] = p[31] = 1; p[32] = name_len;
+	memcpy(p + 33, name, name_len);
+	return len;
+}
+
+static uint8_t record_str(uint8_t *p, uint32_t lba, uint32_t size, uint8_t flags, const char *name)
+{
+	return record(p, lba, size, flags, (const uint8_t*)name, (uint8_t)strlen(name));
+}
+
+// UCS-2 big endian name
+static uint8_t record_ucs2(uint8_t *p, uint32_t lba, uint32_t size, uint8_t flags, const uint16_t *name, uint8_t chars)
+{
+	uint8_t buf[128];
+	for(uint8_t i = 0; i < chars; i++) {buf[i * 2] = name[i] >> 8; buf[i * 2 + 1] = name[i] & 0xFF;}
+	return record(p, lba, size, flags, buf, chars * 2);
+}
+
+static uint8_t *sector(uint32_t lba) {return image + (lba * ISO9660_SECTOR);}
+
+// dot entries of the directory at lba
+static uint32_t dots(uint32_t lba, uint32_t size)
+{
+	const uint8_t dot = 0, dotdot = 1;
+	uint32_t pos = record(sector(lba), lba, size, 2, &dot, 1);
+	return pos + record(sector(lba) + pos, 20, ISO9660_SECTOR, 2, &dotdot, 1);
+}
+
+static void build_image(int joliet)
+{
+	memset(image, 0, sizeof(image));
+
+	// volume descriptors
+	uint8_t *pvd = sector(16);
+	pvd[0] = 1; memcpy(pvd + 1, "CD001", 5); pvd[6] = 1; both32(pvd + 80, SECTORS);
+	record(pvd + 156, 20, ISO9660_SECTOR, 2, (const uint8_t*)"", 1);
+
+	uint8_t *svd = sector(17);
+	svd[0] = joliet ? 2 : 3; memcpy(svd + 1, "CD001", 5); svd[6] = 1; memcpy(svd + 88, "%/E", 3);
+	record(svd + 156, 24, 2 * ISO9660_SECTOR, 2, (const uint8_t*)"", 1);
+
+	sector(18)[0] = 0xFF; memcpy(sector(18) + 1, "CD001", 5);
+
+	// primary tree: / (20) & /PS3_GAME (22)
+	uint32_t pos = dots(20, ISO9660_SECTOR);
+	pos += record_str(sector(20) + pos, 22, ISO9660_SECTOR, 2, "PS3_GAME");
+	pos += record_str(sector(20) + pos, 30, 100, 0, "README.;1");
+	pos = dots(22, ISO9660_SECTOR);
+	pos += record_str(sector(22) + pos, 34, 8, 0, "PARAM.SFO;1");
+
+	// Joliet tree: / (24-25) & /PS3_GAME (26)
+	pos = dots(24, 2 * ISO9660_SECTOR);
+	for(uint16_t n = 0; n < FILLERS; n++)
+	{
+		uint16_t name[4] = {'F', '0' + n / 10, '0' + n % 10, 0};
+		if(pos + 48 > ISO9660_SECTOR) break; // records do not cross sectors
+		pos += record_ucs2(sector(24) + pos, 40, 0, 0, name, 3);
+	}
+	pos = ISO9660_SECTOR; // the rest of sector 24 is padding
+	const uint16_t ps3_game[] = {'P','S','3','_','G','A','M','E'}, big[] = {'b','i','g','.','b','i','n'}, uni[] = {0x00DC, 'n', 0x20AC, '.', 't', 'x', 't'};
+	pos += record_ucs2(sector(24) + pos, 26, ISO9660_SECTOR, 2, ps3_game, 8);
+	pos += record_ucs2(sector(24) + pos, 32, ISO9660_SECTOR, 0x80, big, 7);	// multi-extent
+	pos += record_ucs2(sector(24) + pos, 33, 1000, 0, big, 7);
+	pos += record_ucs2(sector(24) + pos, 30, 100, 0, uni, 7);
+	pos = dots(26, ISO9660_SECTOR);
+	const uint16_t sfo[] = {'P','A','R','A','M','.','S','F','O'};
+	pos += record_ucs2(sector(26) + pos, 34, 8, 0, sfo, 9);
+
+	memcpy(sector(34), "SFOdata!", 8);
+}
+
+int main(void)
+{
+	uint8_t cache[4 * ISO9660_SECTOR]; char buf[16];
+	iso9660_reader iso; iso9660_entry entry; iso9660_dir dir;
+
+	// Joliet image
+	build_image(1);
+	CHECK(iso9660_open(&iso, read_image, NULL, cache, sizeof(cache)) == 0);
+	CHECK(iso.joliet == 1);
+	CHECK(iso.volume_sectors == SECTORS);
+	CHECK(iso.root.lba == 24);
+
+	CHECK(iso9660_find(&iso, "/ps3_game/param.sfo", &entry));
+	CHECK(entry.lba == 34 && entry.size == 8 && !entry.is_dir);
+	CHECK(iso9660_read_file(&iso, &entry, 0, buf, sizeof(buf)) == 8 && !memcmp(buf, "SFOdata!", 8));
+	CHECK(iso9660_read_file(&iso, &entry, 3, buf, 2) == 2 && !memcmp(buf, "da", 2));
+	CHECK(iso9660_read_file(&iso, &entry, 8, buf, 2) == 0);
+
+	CHECK(iso9660_find(&iso, "big.bin", &entry));
+	CHECK(entry.lba == 32 && entry.size == ISO9660_SECTOR + 1000);
+
+	CHECK(iso9660_find(&iso, "/\xC3\x9Cn\xE2\x82\xAC.txt", &entry)); // UTF-8 of the UCS-2 name
+	CHECK(iso9660_find(&iso, "/PS3_GAME", &entry) && entry.is_dir);
+	CHECK(!iso9660_find(&iso, "/PS3_GAME/PARAM.SF", &entry));
+	CHECK(!iso9660_find(&iso, "/PS3_GAME/PARAM.SFO/X", &entry));
+	CHECK(!iso9660_find(&iso, "/nothing", &entry));
+
+	// the entries of the 2 sectors of the root, multi-extent counted once
+	uint32_t count = 0;
+	CHECK(iso9660_opendir(&iso.root, &dir) == 0);
+	while(iso9660_readdir(&iso, &dir, &entry)) count++;
+	CHECK(count > 3);
+	CHECK(iso9660_opendir(&entry, &dir) == -1);
+
+	uint32_t cold = reads;
+	CHECK(iso9660_find(&iso, "/PS3_GAME/PARAM.SFO", &entry));
+	CHECK(reads == cold); // the directory blocks are cached
+	printf("  Joliet: %u root entries, cache %u hits / %u misses\n", count, iso.hits, iso.misses);
+
+	// single block cache
+	CHECK(iso9660_open(&iso, read_image, NULL, cache, ISO9660_SECTOR) == 0);
+	CHECK(iso9660_find(&iso, "/PS3_GAME/PARAM.SFO", &entry) && entry.lba == 34);
+	CHECK(iso9660_open(&iso, read_image, NULL, cache, ISO9660_SECTOR - 1) == -1);
+
+	// primary tree only: ";1" & the dot of the names without extension are stripped
+	build_image(0);
+	CHECK(iso9660_open(&iso, read_image, NULL, cache, sizeof(cache)) == 0);
+	CHECK(iso.joliet == 0 && iso.root.lba == 20);
+	CHECK(iso9660_find(&iso, "/README", &entry) && entry.size == 100);
+	CHECK(iso9660_find(&iso, "/ps3_game/PARAM.SFO", &entry) && entry.lba == 34);
+
+	// sectors beyond the volume & broken records
+	CHECK(iso9660_block(&iso, SECTORS) == NULL);
+	sector(22)[0] = 0; // zero length record: the rest of the sector is padding
+	iso9660_open(&iso, read_image, NULL, cache, sizeof(cache));
+	CHECK(!iso9660_find(&iso, "/PS3_GAME/PARAM.SFO", &entry));
+	sector(22)[0] = 34, sector(22)[68 + 32] = 250; // name longer than its record
+	iso9660_open(&iso, read_image, NULL, cache, sizeof(cache));
+	CHECK(!iso9660_find(&iso, "/PS3_GAME/PARAM.SFO", &entry));
+
+	// not an ISO9660 image
+	memset(image, 0, sizeof(image));
+	CHECK(iso9660_open(&iso, read_image, NULL, cache, sizeof(cache)) == -1);
+
+	return test_result("iso9660");
+}
@@ -0,0 +1,119 @@
+// memory search sessions core (include/ps3mapi/mem_scan.h)
+// the bitmaps of memscan_page are checked against a brute force scan of the same page
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/ps3mapi/mem_scan.h"
+#include "test.h"
+
+#define PAGE	4096
+
+static uint8_t cur[PAGE], prev[PAGE], bits[PAGE / 8], ref[PAGE / 8];
+
+static void store(uint8_t *p, uint64_t v, uint8_t size)
+{
+	for(int8_t i = size - 1; i >= 0; i--, v >>= 8) p[i] = (uint8_t)v;
+}
+
+// brute force: candidates of ref (all if first) that match op
+static uint32_t reference(const uint8_t *c, const uint8_t *p, uint8_t type, uint8_t align, uint8_t op, uint64_t value, int first)
+{
+	uint8_t vsize = memscan_size[type];
+	uint32_t positions = memscan_positions(PAGE, type, align), count = 0;
+	uint64_t mask = (vsize == 8) ? ~0ULL : ((1ULL << (vsize * 8)) - 1);
+
+	if(first) {memset(ref, 0, sizeof(ref)); if(op >= MEMSCAN_CHANGED) op = MEMSCAN_ANY;}
+
+	for(uint32_t n = 0; n < positions; n++)
+	{
+		if(!first && !(ref[n >> 3] & (1 << (n & 7)))) continue;
+
+		uint64_t cv = memscan_load(c + (n * align), vsize), pv = p ? memscan_load(p + (n * align), vsize) : 0;
+		int keep = (op == MEMSCAN_ANY) || memscan_match(type, op, cv, pv, value & mask, mask);
+
+		if(keep) {ref[n >> 3] |= 1 << (n & 7); count++;} else ref[n >> 3] &= ~(1 << (n & 7));
+	}
+	return count;
+}
+
+static int same_bits(uint8_t type, uint8_t align)
+{
+	uint32_t positions = memscan_positions(PAGE, type, align);
+	for(uint32_t n = 0; n < positions; n++)
+		if(((bits[n >> 3] ^ ref[n >> 3]) >> (n & 7)) & 1) return 0;
+	return 1;
+}
+
+int main(void)
+{
+	srand(1234);
+
+	// signed compare: -2 < 1 as s32, 0xFFFFFFFE > 1 as u32
+	store(cur, (uint32_t)-2, 4);
+	CHECK( memscan_match(MEMSCAN_S32, MEMSCAN_LT, memscan_load(cur, 4), 0, 1, 0xFFFFFFFF));
+	CHECK(!memscan_match(MEMSCAN_U32, MEMSCAN_LT, memscan_load(cur, 4), 0, 1, 0xFFFFFFFF));
+	CHECK( memscan_match(MEMSCAN_S8,  MEMSCAN_DEC, 0xFF, 0x01, 0, 0xFF));
+	CHECK( memscan_match(MEMSCAN_S16, MEMSCAN_GT,  0x7FFF, 0, 0x8000, 0xFFFF));
+	CHECK( memscan_signed(0x80, 1) == -128);
+	CHECK( memscan_signed(0x7FFFFFFFFFFFFFFFULL, 8) == 0x7FFFFFFFFFFFFFFFLL);
+
+	// float compare
+	union {uint32_t u; float f;} a, b, c; a.f = 1.5f; b.f = -2.0f; c.f = 3.5f;
+	CHECK( memscan_match(MEMSCAN_FLOAT, MEMSCAN_GT, a.u, 0, b.u, 0xFFFFFFFF));
+	CHECK( memscan_match(MEMSCAN_FLOAT, MEMSCAN_INC_BY, a.u, b.u, c.u, 0xFFFFFFFF)); // 1.5 == -2.0 + 3.5
+	CHECK(!memscan_match(MEMSCAN_FLOAT, MEMSCAN_DEC_BY, a.u, b.u, c.u, 0xFFFFFFFF));
+
+	// sessions: new scan, then narrowing scans after random changes of the memory
+	const uint8_t ops[] = {MEMSCAN_CHANGED, MEMSCAN_UNCHANGED, MEMSCAN_INC, MEMSCAN_DEC, MEMSCAN_INC_BY, MEMSCAN_DEC_BY, MEMSCAN_EQ, MEMSCAN_NE, MEMSCAN_GT, MEMSCAN_LT};
+
+	for(uint8_t type = MEMSCAN_U8; type <= MEMSCAN_S64; type++)
+	{
+		if(type == MEMSCAN_FLOAT) continue; // float: NaN != NaN, covered by the compares above
+
+		uint8_t vsize = memscan_size[type];
+
+		for(uint8_t align = 1; align <= 8; align <<= 1)
+		{
+			if(align > vsize) continue;
+
+			for(uint32_t i = 0; i < PAGE; i++) cur[i] = (uint8_t)(rand() & 3); // small values: many hits
+
+			uint32_t count = memscan_page(cur, NULL, bits, PAGE, type, align, MEMSCAN_EQ, 0);
+			CHECK(count == reference(cur, NULL, type, align, MEMSCAN_EQ, 0, 1));
+			CHECK(same_bits(type, align));
+
+			for(uint8_t s = 0; s < sizeof(ops); s++)
+			{
+				memcpy(prev, cur, PAGE);
+				if(s & 1) for(uint32_t i = 0; i < 64; i++) cur[rand() % PAGE] += (uint8_t)(rand() % 3) - 1;
+
+				uint64_t value = (s & 2) ? 1 : (uint64_t)-1; // -1 = negative (signed types) or max value (unsigned types)
+
+				count = memscan_page(cur, prev, bits, PAGE, type, align, ops[s], value);
+				CHECK(count == reference(cur, prev, type, align, ops[s], value, 0));
+				CHECK(same_bits(type, align));
+			}
+
+			// memscan_next walks the same positions
+			uint32_t positions = memscan_positions(PAGE, type, align), walked = 0; int ok = 1;
+			for(int32_t n = memscan_next(bits, positions, 0); n >= 0; n = memscan_next(bits, positions, n + 1), walked++)
+				if(!(ref[n >> 3] & (1 << (n & 7)))) ok = 0;
+			CHECK(ok && (walked == count));
+		}
+	}
+
+	// unchanged page: only "unchanged" keeps the candidates
+	memset(cur, 7, PAGE); memcpy(prev, cur, PAGE);
+	CHECK(memscan_page(cur, NULL, bits, PAGE, MEMSCAN_U32, 4, MEMSCAN_ANY, 0) == PAGE / 4);
+	CHECK(memscan_page(cur, prev, bits, PAGE, MEMSCAN_U32, 4, MEMSCAN_UNCHANGED, 0) == PAGE / 4);
+	CHECK(memscan_page(cur, prev, bits, PAGE, MEMSCAN_U32, 4, MEMSCAN_INC_BY, 0) == PAGE / 4);
+	CHECK(memscan_page(cur, prev, bits, PAGE, MEMSCAN_U32, 4, MEMSCAN_CHANGED, 0) == 0);
+
+	// positions of a page
+	CHECK(memscan_positions(PAGE, MEMSCAN_U64, 1) == PAGE - 7);
+	CHECK(memscan_positions(4, MEMSCAN_U64, 8) == 0);
+
+	return test_result("mem_scan");
+}
@@ -0,0 +1,144 @@
+// sector cache & readahead of the netiso client (include/mount/net_cache.h)
+// the server is a disc image in memory; every read must return the bytes of the disc (zeros past its end)
+// and the commands must keep the order of the connection: no read while a readahead is pending
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/mount/net_cache.h"
+#include "test.h"
+
+#define DISC_SIZE	(5 * 1024 * 1024 + 1234)	// not a multiple of the segments
+
+static uint8_t *disc;
+
+// server: requests & bytes sent, pending readahead, failures injected
+static struct {uint32_t reads, ra_sends, ra_recvs, order_errors; uint64_t bytes; uint64_t ra_offset; uint32_t ra_size; int ra_pending; uint32_t fail_rate;} srv;
+
+static int fail(void) {return srv.fail_rate && !(rand() % srv.fail_rate);}
+
+static void copy_disc(uint8_t *buf, uint64_t offset, uint32_t size)
+{
+	memset(buf, 0, size);
+	if(offset < DISC_SIZE) memcpy(buf, disc + offset, (offset + size > DISC_SIZE) ? DISC_SIZE - offset : size);
+}
+
+static int srv_read(void *handle, uint8_t *buf, uint64_t offset, uint32_t size)
+{
+	(void)handle;
+	if(srv.ra_pending) srv.order_errors++; // the readahead data would be read as this one
+	if(fail()) return -1;
+	srv.reads++, srv.bytes += size;
+	copy_disc(buf, offset, size);
+	return 0;
+}
+
+static int srv_ra_send(void *handle, uint64_t offset, uint32_t size)
+{
+	(void)handle;
+	if(srv.ra_pending) srv.order_errors++;
+	if(fail()) return -1;
+	srv.ra_sends++, srv.bytes += size;
+	srv.ra_pending = 1, srv.ra_offset = offset, srv.ra_size = size;
+	return 0;
+}
+
+static int srv_ra_recv(void *handle, uint8_t *buf, uint32_t size)
+{
+	(void)handle;
+	if(!srv.ra_pending || (size != srv.ra_size)) srv.order_errors++;
+	srv.ra_pending = 0;
+	if(fail()) return -1;
+	srv.ra_recvs++;
+	copy_disc(buf, srv.ra_offset, size);
+	return 0;
+}
+
+static t_net_cache cache;
+static uint8_t buf[3 * NET_SEG_SIZE], ref[3 * NET_SEG_SIZE];
+
+static void setup(void)
+{
+	net_cache_reset(&cache);
+	cache.disc_size = DISC_SIZE;
+	cache.read = srv_read, cache.ra_send = srv_ra_send, cache.ra_recv = srv_ra_recv;
+	memset(&srv, 0, sizeof(srv));
+}
+
+// read & compare with the disc; a failed read drops the connection like netiso_reconnect
+static int check_read(uint64_t offset, uint32_t size)
+{
+	memset(buf, 0xAA, size);
+	if(net_cache_read(&cache, buf, offset, size)) {cache.ra_seg = -1; srv.ra_pending = 0; return 0;}
+
+	copy_disc(ref, offset, size);
+	return memcmp(buf, ref, size) ? -1 : 1;
+}
+
+int main(void)
+{
+	disc = malloc(DISC_SIZE);
+	srand(32); for(uint32_t i = 0; i < DISC_SIZE; i++) disc[i] = rand();
+	cache.mem = malloc(NET_CACHE_SEGS * NET_SEG_SIZE);
+
+	// sequential stream of 2KB to 64KB reads: the readahead keeps the next window on its way
+	setup();
+	uint32_t reads = 0, errors = 0;
+	for(uint64_t offset = 0; offset < DISC_SIZE; reads++)
+	{
+		uint32_t size = 2048 << (rand() % 6);
+		if(check_read(offset, size) < 0) errors++;
+		offset += size;
+	}
+	CHECK(errors == 0 && srv.order_errors == 0);
+	CHECK(srv.ra_sends > 0 && (srv.reads + srv.ra_sends) < reads / 2); // few requests
+	CHECK(srv.bytes < DISC_SIZE + 2 * NET_SEG_SIZE);                    // no data read twice
+	printf("  sequential: %u reads, %u requests + %u readaheads, %llu bytes\n", reads, srv.reads, srv.ra_sends, (unsigned long long)srv.bytes);
+
+	// random reads: no readahead, each miss reads the request only
+	setup(); errors = 0;
+	for(uint32_t run = 0; run < 20000; run++)
+	{
+		uint64_t offset = ((uint64_t)rand() * 7919) % (DISC_SIZE + 4096);
+		uint32_t size = 1 + rand() % ((rand() & 7) ? 65536 : sizeof(buf));
+		if(check_read(offset, size) < 0) errors++;
+	}
+	CHECK(errors == 0 && srv.order_errors == 0 && srv.ra_sends == 0);
+
+	// mixed: streams, jumps, rereads & the end of the disc
+	setup(); errors = 0;
+	uint64_t stream = 0;
+	for(uint32_t run = 0; run < 50000; run++)
+	{
+		uint32_t size = (rand() & 1) ? 2048 * (1 + rand() % 32) : 1 + rand() % 70000;
+		uint64_t offset;
+		switch(rand() % 8)
+		{
+			case 0:  offset = rand() % DISC_SIZE; break;									// jump
+			case 1:  offset = DISC_SIZE - rand() % 200000; break;							// end of the disc
+			case 2:  offset = (stream > 50000) ? stream - rand() % 50000 : 0; break;		// reread
+			default: offset = stream; break;												// stream
+		}
+		if(check_read(offset, size) < 0) errors++;
+		stream = (offset + size < DISC_SIZE) ? offset + size : 0;
+	}
+	CHECK(errors == 0 && srv.order_errors == 0);
+
+	// failures of any request: the data read after them is still the data of the disc
+	setup(); errors = 0; srv.fail_rate = 20;
+	uint32_t failed = 0; stream = 0;
+	for(uint32_t run = 0; run < 50000; run++)
+	{
+		uint32_t size = 2048 * (1 + rand() % 32);
+		uint64_t offset = (rand() % 6) ? stream : rand() % DISC_SIZE;
+		int ret = check_read(offset, size);
+		if(ret < 0) errors++; else if(!ret) failed++;
+		stream = (offset + size < DISC_SIZE) ? offset + size : 0;
+	}
+	CHECK(errors == 0 && srv.order_errors == 0 && failed > 0);
+	printf("  failures: %u reads failed, %u errors\n", failed, errors);
+
+	free(cache.mem); free(disc);
+	return test_result("net_cache");
+}
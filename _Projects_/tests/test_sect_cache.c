@@ -0,0 +1,145 @@
+// sector cache of the raw ISO reads (include/mount/sect_cache.h)
+// a device of numbered sectors is read through caches of each size used by rawseciso.h (256KB to the 4KB line);
+// every line must hold the data of its sectors, the device is read by whole lines and never past its last sector
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/mount/sect_cache.h"
+#include "test.h"
+
+static struct {uint32_t sec_size; uint64_t sector_count; uint32_t reads, errors, fail; uint8_t *mem; uint32_t size;} dev;
+
+static uint8_t sector_byte(uint32_t sector, uint32_t pos) {return (uint8_t)((sector * 2654435761u) >> 24) ^ (uint8_t)pos;}
+
+static int dev_read(void *handle, uint32_t sector, uint32_t n, uint8_t *buf)
+{
+	t_sect_cache *c = handle;
+
+	// whole lines of the device, inside the memory of the cache
+	if(!n || (sector % c->line_sectors) || (sector + (uint64_t)n > dev.sector_count)) dev.errors++;
+	if((buf < dev.mem) || (buf + (uint64_t)n * dev.sec_size > dev.mem + dev.size)) dev.errors++;
+
+	if(dev.fail) {dev.fail--; return 5;}
+	dev.reads++;
+
+	for(uint32_t s = 0; s < n; s++)
+		for(uint32_t pos = 0; pos < dev.sec_size; pos++) buf[s * dev.sec_size + pos] = sector_byte(sector + s, pos);
+	return 0;
+}
+
+// the line holds the sector & no line is cached twice
+static int check_line(t_sect_cache *c, uint32_t sector, const uint8_t *line)
+{
+	const uint8_t *data = line + (sector % c->line_sectors) * dev.sec_size;
+	for(uint32_t pos = 0; pos < dev.sec_size; pos++) if(data[pos] != sector_byte(sector, pos)) return 0;
+
+	for(uint32_t i = 0; i < c->ways * c->sets; i++)
+		for(uint32_t j = i + 1; j < c->ways * c->sets; j++) if(c->tag[i] && (c->tag[i] == c->tag[j])) return 0;
+	return 1;
+}
+
+static void setup(t_sect_cache *c, uint32_t size, uint32_t line, uint32_t sec_size, uint64_t sector_count)
+{
+	free(dev.mem);
+	dev.mem = malloc(size), dev.size = size; // exact size: ASan catches a line written past the cache
+	dev.sec_size = sec_size, dev.sector_count = sector_count, dev.reads = dev.errors = dev.fail = 0;
+
+	sect_cache_setup(c, dev.mem, size, line, sec_size);
+	c->sector_count = sector_count, c->handle = c, c->read = dev_read;
+}
+
+int main(void)
+{
+	t_sect_cache cache, *c = &cache; int err;
+	const uint32_t sizes[4] = {256 * 1024, 128 * 1024, 64 * 1024, 4096}, sec_sizes[3] = {512, 2048, 4096};
+
+	srand(36);
+	for(uint8_t s = 0; s < 4; s++)
+		for(uint8_t z = 0; z < 3; z++)
+		{
+			uint32_t size = sizes[s], line_size = (size == 4096) ? size : SECT_CACHE_LINE, sec_size = sec_sizes[z];
+			uint64_t sector_count = 20000 + rand() % 1000; // the last line is partial
+
+			// geometry of rawseciso.h
+			setup(c, size, line_size, sec_size, sector_count);
+			CHECK(c->line_bytes <= size && c->ways * c->sets * c->line_bytes <= size && c->ways * c->sets <= SECT_CACHE_LINES);
+			CHECK(c->ways >= 1 && c->ways <= SECT_CACHE_WAYS && c->line_bytes % sec_size == 0);
+
+			// sequential stream: prefetched lines, about 1 read per SECT_CACHE_PREFETCH lines when the sets allow it
+			uint32_t bad = 0, lines = (uint32_t)((sector_count + c->line_sectors - 1) / c->line_sectors);
+			for(uint32_t sector = 0; sector < sector_count; sector++)
+			{
+				uint8_t *line = sect_cache_line(c, sector, &err);
+				if(!line || err || !check_line(c, sector, line)) bad++;
+			}
+			CHECK(bad == 0 && dev.errors == 0);
+			CHECK(c->misses == dev.reads && c->hits + c->misses == sector_count);
+			if(c->sets >= SECT_CACHE_PREFETCH) CHECK(dev.reads * 4 < lines && c->prefetched > 0);
+			else if(c->sets > 1) CHECK(dev.reads < lines);
+			else CHECK(dev.reads == lines);
+
+			// random & sequential sectors mixed, with read failures
+			bad = 0; uint32_t failed = 0, sector = 0;
+			for(uint32_t run = 0; run < 20000; run++)
+			{
+				switch(rand() % 4)
+				{
+					case 0:  sector = rand() % sector_count; break;
+					case 1:  sector = (uint32_t)sector_count - 1 - rand() % 100; break;
+					default: sector = (sector + 1 + rand() % 3) % sector_count; break;
+				}
+				if(!(rand() % 50)) dev.fail = 1;
+
+				uint8_t *line = sect_cache_line(c, sector, &err);
+				if(!line) {if(err != 5) bad++; failed++; continue;}
+				if(!check_line(c, sector, line)) bad++; // *err is set by the misses only
+			}
+			CHECK(bad == 0 && failed > 0 && dev.errors == 0);
+
+			// a failed line is read again
+			setup(c, size, line_size, sec_size, sector_count);
+			dev.fail = 1;
+			CHECK(!sect_cache_line(c, 100, &err) && err == 5 && dev.reads == 0);
+			CHECK(sect_cache_line(c, 100, &err) && !err && dev.reads == 1);
+			CHECK(sect_cache_line(c, 100, &err) && dev.reads == 1);
+
+			// a line that starts past the last sector fails without a read; the last partial line is read to the end
+			uint32_t last_line = (uint32_t)((sector_count - 1) / c->line_sectors), past = (last_line + 1) * c->line_sectors;
+			uint32_t reads = dev.reads;
+			CHECK(!sect_cache_line(c, past, &err) && err && dev.reads == reads);
+			CHECK(!sect_cache_line(c, past + c->line_sectors * 100, &err) && err && dev.reads == reads);
+			CHECK(sect_cache_line(c, (uint32_t)sector_count - 1, &err) && !err && dev.reads == reads + 1 && dev.errors == 0);
+			CHECK(!sect_cache_line(c, past, &err) && err && dev.reads == reads + 1); // not sequential after a miss past the end
+
+			// LRU: the lines of a set stay cached until one more line of the set is needed
+			setup(c, size, line_size, sec_size, sector_count);
+			uint32_t set_lines[SECT_CACHE_WAYS + 1];
+			for(uint32_t w = 0; w <= c->ways; w++) set_lines[w] = (w * 3 + 1) * c->sets + 1; // same set, never sequential
+
+			for(uint32_t w = 0; w < c->ways; w++) sect_cache_line(c, set_lines[w] * c->line_sectors, &err);
+			reads = dev.reads;
+			for(uint32_t w = 0; w < c->ways; w++)
+			{
+				uint8_t *line = sect_cache_line(c, set_lines[w] * c->line_sectors + w % c->line_sectors, &err);
+				CHECK(line && check_line(c, set_lines[w] * c->line_sectors + w % c->line_sectors, line));
+			}
+			CHECK(dev.reads == reads);
+
+			sect_cache_line(c, set_lines[1 % c->ways] * c->line_sectors, &err);	// line 1 used last: line 0 is the oldest
+			sect_cache_line(c, set_lines[c->ways] * c->line_sectors, &err);		// evicts line 0
+			reads = dev.reads;
+			for(uint32_t w = 1; w <= c->ways; w++) sect_cache_line(c, set_lines[w] * c->line_sectors, &err);
+			CHECK(dev.reads == reads);
+			sect_cache_line(c, set_lines[0] * c->line_sectors, &err);
+			CHECK(dev.reads == reads + 1);
+
+			// reset drops the lines (device reconnected)
+			sect_cache_reset(c); reads = dev.reads;
+			CHECK(sect_cache_line(c, set_lines[0] * c->line_sectors, &err) && dev.reads == reads + 1);
+		}
+
+	free(dev.mem);
+	return test_result("sect_cache");
+}
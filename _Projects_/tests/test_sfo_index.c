@@ -0,0 +1,226 @@
+// PARAM.SFO index & info cache (include/mount/param_sfo.h) on PARAM.SFO built in memory
+// the file system, the mutex & the config of the plugin are stubbed; the SFO are allocated
+// with their exact size, so a read past the end of a truncated SFO is caught by ASan
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8; typedef uint16_t u16; typedef uint32_t u32; typedef uint64_t u64; typedef int32_t s32;
+
+#undef  NULL
+#define NULL	0	// the plugin code also uses NULL as the null char
+
+#define MIN(a, b)			((a) <= (b) ? (a) : (b))
+#define ISDIGIT(a)			( ('0' <= (a)) && ((a) <= '9') )
+#define _4KB_				4096
+#define HDD0_GAME_DIR		"/dev_hdd0/game/"
+#define CELL_FS_SUCCEEDED	0
+
+static void _memset(void *m, size_t n) {memset(m, 0, n);}
+static bool islike(const char *param, const char *text) {return !strncmp(param, text, strlen(text));}
+
+// plugin state
+static char TITLE_XX[12];
+static struct {u8 lang, tid;} config, *webman_config = &config;
+static int sfo_mutex, locked;
+static void mutex_lock(int mutex)   {(void)mutex; locked++;}
+static void mutex_unlock(int mutex) {(void)mutex; locked--;}
+
+// a single file of the stubbed file system
+static struct {const char *path; u8 *data; u32 size; u64 mtime;} file;
+static u32 reads;
+
+struct CellFsStat {u64 st_size, st_mtime;};
+
+static int cellFsStat(const char *path, struct CellFsStat *s)
+{
+	if(!file.data || strcmp(path, file.path)) return -1;
+	s->st_size = file.size, s->st_mtime = file.mtime;
+	return CELL_FS_SUCCEEDED;
+}
+
+static size_t read_file(const char *path, char *data, size_t size, s32 offset)
+{
+	(void)offset; reads++;
+	if(!file.data || strcmp(path, file.path)) return 0;
+	size = MIN(size, file.size); memcpy(data, file.data, size);
+	return size;
+}
+
+static bool file_exists(const char *path) {return file.data && !strcmp(path, file.path);}
+#define not_exists(path)	(!file_exists(path))
+#define check_ps3_game(path)
+static int get_game_info(void) {return 0;}
+static char _game_Title[64], _game_TitleID[10];
+
+#include "../../include/mount/param_sfo.h"
+#include "test.h"
+
+typedef struct {const char *key, *value; u32 max_len;} sfo_param;
+
+// PARAM.SFO with the params in the order given (max_len 0 = length of the value + NULL)
+static u8 *build_sfo(const sfo_param *params, u8 count, u16 *size)
+{
+	u32 keys = 0, data = 0;
+	for(u8 n = 0; n < count; n++)
+	{
+		keys += strlen(params[n].key) + 1;
+		data += params[n].max_len ? params[n].max_len : strlen(params[n].value) + 1;
+	}
+
+	u32 key_table = 0x14 + count * 0x10, data_table = (key_table + keys + 3) & ~3;
+	*size = data_table + data;
+
+	u8 *mem = calloc(1, *size);
+	memcpy(mem, "\0PSF\1\1\0\0", 8);
+	mem[0x08] = key_table, mem[0x09] = key_table >> 8;
+	mem[0x0c] = data_table, mem[0x0d] = data_table >> 8;
+	mem[0x10] = count;
+
+	for(u32 n = 0, k = 0, d = 0; n < count; n++)
+	{
+		u8 *indx = mem + 0x14 + n * 0x10;
+		u32 len = strlen(params[n].value) + 1, max_len = params[n].max_len ? params[n].max_len : len;
+		indx[0x0] = k, indx[0x1] = k >> 8; indx[0x3] = 2;
+		indx[0x4] = len; indx[0x8] = max_len, indx[0x9] = max_len >> 8;
+		indx[0xc] = d, indx[0xd] = d >> 8;
+		strcpy((char *)mem + key_table + k, params[n].key); k += strlen(params[n].key) + 1;
+		memcpy(mem + data_table + d, params[n].value, MIN(len, max_len)); d += max_len;
+	}
+	return mem;
+}
+
+static const sfo_param game[] =
+{
+	{"APP_VER", "01.02", 8},
+	{"ATTRIBUTE", "\x20\0\0", 4},
+	{"CATEGORY", "DG", 4},
+	{"PS3_SYSTEM_VER", "04.8100", 8},
+	{"TITLE", "Game", 128},
+	{"TITLE_02", "Jeu", 128},
+	{"TITLE_03", "Gioco", 128},
+	{"TITLE_ID", "BLES01234", 16},
+	{"TITLEX", "not a key", 0},
+};
+
+#define GAME_PARAMS	(sizeof(game) / sizeof(sfo_param))
+
+static void value(u8 *mem, const sfo_index *sfo, u8 key, char *buf, u16 size) {get_sfo_value(mem, sfo, key, buf, size);}
+
+int main(void)
+{
+	sfo_index sfo; char buf[128]; u16 size;
+
+	// index of the keys
+	u8 *mem = build_sfo(game, GAME_PARAMS, &size);
+
+	CHECK(index_param_sfo(mem, size, &sfo));
+	value(mem, &sfo, SFO_TITLE,    buf, sizeof(buf)); CHECK(!strcmp(buf, "Game"));
+	value(mem, &sfo, SFO_TITLE_ID, buf, sizeof(buf)); CHECK(!strcmp(buf, "BLES01234"));
+	value(mem, &sfo, SFO_APP_VER,  buf, sizeof(buf)); CHECK(!strcmp(buf, "01.02"));
+	value(mem, &sfo, SFO_CATEGORY, buf, sizeof(buf)); CHECK(!strcmp(buf, "DG"));
+	value(mem, &sfo, SFO_PS3_SYSTEM_VER, buf, sizeof(buf)); CHECK(!strcmp(buf, "04.8100"));
+	CHECK(sfo.pos[SFO_ATTRIBUTE] && mem[sfo.pos[SFO_ATTRIBUTE]] == 0x20 && sfo.siz[SFO_ATTRIBUTE] == 4);
+	CHECK(sfo.pos[SFO_TITLE_XX] == 0); // no TITLE_XX for English
+
+	strcpy(TITLE_XX, "TITLE_03");
+	CHECK(index_param_sfo(mem, size, &sfo));
+	value(mem, &sfo, SFO_TITLE_XX, buf, sizeof(buf)); CHECK(!strcmp(buf, "Gioco"));
+	value(mem, &sfo, SFO_TITLE,    buf, sizeof(buf)); CHECK(!strcmp(buf, "Game"));
+
+	// values are truncated to the buffer & to their max length
+	value(mem, &sfo, SFO_TITLE_ID, buf, 5); CHECK(!strcmp(buf, "BLES"));
+	value(mem, &sfo, SFO_TITLE_ID, buf, 1); CHECK(*buf == 0);
+	free(mem);
+
+	const sfo_param cut[] = {{"TITLE_ID", "NPUB31234", 4}, {"TITLE", "", 0}};
+	mem = build_sfo(cut, 2, &size);
+	CHECK(index_param_sfo(mem, size, &sfo));
+	value(mem, &sfo, SFO_TITLE_ID, buf, sizeof(buf)); CHECK(!strcmp(buf, "NPUB"));
+	value(mem, &sfo, SFO_TITLE,    buf, sizeof(buf)); CHECK(*buf == 0 && sfo.pos[SFO_TITLE]);
+	value(mem, &sfo, SFO_APP_VER,  buf, sizeof(buf)); CHECK(*buf == 0 && !sfo.pos[SFO_APP_VER]);
+	free(mem);
+
+	// not a PARAM.SFO
+	u8 junk[0x40] = {0};
+	CHECK(!index_param_sfo(junk, sizeof(junk), &sfo) && !sfo.pos[SFO_TITLE]);
+	mem = build_sfo(game, GAME_PARAMS, &size);
+	CHECK(!index_param_sfo(mem, 0x13, &sfo));
+
+	// truncated PARAM.SFO: the keys & values past the end are dropped, the last value is clipped
+	for(u16 cut_size = 0x14; cut_size < size; cut_size++)
+	{
+		u8 *part = malloc(cut_size); memcpy(part, mem, cut_size);
+		index_param_sfo(part, cut_size, &sfo);
+		for(u8 k = 0; k < SFO_KEYS; k++)
+		{
+			value(part, &sfo, k, buf, sizeof(buf));
+			if(sfo.pos[k]) CHECK(sfo.pos[k] + sfo.siz[k] <= cut_size);
+		}
+		free(part);
+	}
+
+	// random bytes after a valid header must not be read out of bounds
+	srand(3);
+	for(u32 run = 0; run < 2000; run++)
+	{
+		u16 rnd_size = 0x14 + rand() % 300;
+		u8 *rnd = malloc(rnd_size);
+		for(u16 i = 0; i < rnd_size; i++) rnd[i] = (rand() & 1) ? "TITLE_ID\0APCS"[rand() % 14] : rand();
+		memcpy(rnd, "\0PSF", 4);
+		rnd[0x09] = rnd[0x0d] = rnd[0x11] = 0; // tables in the SFO (mostly)
+		index_param_sfo(rnd, rnd_size, &sfo);
+		for(u8 k = 0; k < SFO_KEYS; k++) value(rnd, &sfo, k, buf, sizeof(buf));
+		free(rnd);
+	}
+
+	// info cache: a PARAM.SFO is read once per path, size, mtime & language
+	sfo_info info; char data[_4KB_];
+	*TITLE_XX = NULL;
+	file.path = "/dev_hdd0/game/BLES01234/PARAM.SFO", file.data = mem, file.size = size, file.mtime = 1000;
+
+	reads = 0;
+	CHECK(read_sfo_info(file.path, &info, data) && reads == 1);
+	CHECK(!strcmp(info.title_id, "BLES01234") && !strcmp(info.app_ver, "01.02") && !strcmp(info.category, "DG") && !strcmp(info.title, "Game"));
+	memset(&info, 0, sizeof(info));
+	CHECK(read_sfo_info(file.path, &info, data) && reads == 1 && !strcmp(info.title, "Game"));
+	CHECK(locked == 0);
+
+	file.mtime++;
+	CHECK(read_sfo_info(file.path, &info, data) && reads == 2);
+
+	config.lang = 2; strcpy(TITLE_XX, "TITLE_02");
+	CHECK(read_sfo_info(file.path, &info, data) && reads == 3 && !strcmp(info.title, "Jeu"));
+	CHECK(read_sfo_info(file.path, &info, data) && reads == 3);
+
+	sfo_cache_drop(file.path);
+	CHECK(read_sfo_info(file.path, &info, data) && reads == 4);
+
+	CHECK(!read_sfo_info("/dev_hdd0/game/BLES00000/PARAM.SFO", &info, data) && reads == 4);
+
+	// the oldest entry is replaced when the cache is full
+	char path[SFO_CACHE_SIZE + 1][48];
+	for(u8 n = 0; n <= SFO_CACHE_SIZE; n++)
+	{
+		sprintf(path[n], "/dev_hdd0/game/NPEB0000%i/PARAM.SFO", n);
+		file.path = path[n]; read_sfo_info(file.path, &info, data);
+	}
+	reads = 0;
+	file.path = path[SFO_CACHE_SIZE]; read_sfo_info(file.path, &info, data); CHECK(reads == 0);
+	file.path = path[0];              read_sfo_info(file.path, &info, data); CHECK(reads == 1);
+
+	// title with the title ID
+	config.lang = 0, config.tid = 1; *TITLE_XX = NULL;
+	char title_id[10]; strcpy(buf, file.path);
+	CHECK(getTitleID(buf, title_id, GET_TITLE_AND_ID) == false && !strcmp(title_id, "BLES01234"));
+	CHECK(!strcmp(buf, "Game [BLES01234]"));
+	CHECK(getTitleID((char *)file.path, buf, GET_VERSION) == false && !strcmp(buf, "01.02"));
+	CHECK(getTitleID((char *)file.path, buf, IS_GAME_DATA) == false);
+	CHECK(locked == 0);
+
+	free(mem);
+	return test_result("sfo_index");
+}
@@ -0,0 +1,108 @@
+// sLaunch game list index (slaunch_idx.h)
+// sort orders against their definition, type ranges, no false negatives of the search filter
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../slaunch_idx.h"
+#include "test.h"
+
+#define COUNT	3000
+
+static slidx_key keys[COUNT];
+static uint16_t orders[SLIDX_ORDERS * COUNT];
+static char titles[COUNT][64];
+
+// expected order of 2 records (a before b)
+static int before(uint8_t order, uint16_t a, uint16_t b)
+{
+	const slidx_key *ka = &keys[a], *kb = &keys[b];
+	int c = 0;
+
+	if(order == SLIDX_ID)		c = strncmp(ka->id, kb->id, 10);
+	if(order == SLIDX_TYPE)		c = ka->type - kb->type;
+	if(order == SLIDX_RECENT)	c = (ka->recent ? ka->recent : 256) - (kb->recent ? kb->recent : 256); // played first, 1 = last played
+
+	if(!c) c = strncmp(ka->title, kb->title, SLIDX_KEY_LEN);
+	return c ? (c < 0) : (a < b);
+}
+
+int main(void)
+{
+	_slaunch_idx idx;
+	const char *words[] = {"Gran", "Turismo", "Racing", "Little", "Big", "Planet", "Uncharted", "Gods", "of", "War", "Demon", "Souls", "2", "HD"};
+
+	srand(42);
+
+	for(uint32_t n = 0; n < COUNT; n++)
+	{
+		char *t = titles[n]; *t = 0;
+		for(int w = 1 + rand() % 4; w; w--) {strcat(t, words[rand() % 14]); if(w > 1) strcat(t, " ");}
+
+		for(uint8_t i = 0; i < SLIDX_KEY_LEN; i++) keys[n].title[i] = slidx_upper(t[i < strlen(t) ? i : strlen(t)]);
+		snprintf(keys[n].id, sizeof(keys[n].id), "BLES%05u", rand() % 500);
+		keys[n].type = rand() % SLIDX_TYPES;
+		keys[n].recent = (rand() % 4) ? 0 : (1 + rand() % 50);
+	}
+
+	slidx_build(&idx, keys, orders, COUNT, 0x200);
+
+	CHECK(idx.magic == SLIDX_MAGIC && idx.version == SLIDX_VERSION);
+	CHECK(idx.count == COUNT && idx.record_size == 0x200);
+
+	for(uint8_t order = 0; order < SLIDX_ORDERS; order++)
+	{
+		const uint16_t *list = orders + (order * COUNT);
+		static uint8_t seen[COUNT]; memset(seen, 0, sizeof(seen));
+
+		int sorted = 1, perm = 1;
+		for(uint32_t n = 0; n < COUNT; n++)
+		{
+			if((list[n] >= COUNT) || seen[list[n]]++) perm = 0;
+			if(n && !before(order, list[n - 1], list[n])) sorted = 0;
+		}
+		CHECK(perm);
+		CHECK(sorted);
+	}
+
+	// type ranges of the type order
+	const uint16_t *by_type = orders + (SLIDX_TYPE * COUNT);
+	CHECK(idx.type_first[0] == 0 && idx.type_first[SLIDX_TYPES] == COUNT);
+	for(uint8_t type = 0; type < SLIDX_TYPES; type++)
+		for(uint32_t n = idx.type_first[type]; n < idx.type_first[type + 1]; n++)
+			if(keys[by_type[n]].type != type) {CHECK(0); type = SLIDX_TYPES; break;}
+
+	// search filter: every substring (any case) matches its text, count the false positives of a query
+	uint32_t missed = 0, passed = 0, contain = 0;
+	slidx_sig query; memset(&query, 0, sizeof(query)); slidx_signature(&query, "planet");
+
+	for(uint32_t n = 0; n < COUNT; n++)
+	{
+		slidx_sig sig; memset(&sig, 0, sizeof(sig)); slidx_signature(&sig, titles[n]);
+
+		uint32_t len = strlen(titles[n]), from = rand() % len, sub_len = 1 + rand() % (len - from);
+		char sub[64]; memcpy(sub, titles[n] + from, sub_len); sub[sub_len] = 0;
+		for(char *c = sub; *c; c++) if(rand() & 1) *c ^= ((*c | 0x20) >= 'a' && (*c | 0x20) <= 'z') ? 0x20 : 0;
+
+		slidx_sig q; memset(&q, 0, sizeof(q)); slidx_signature(&q, sub);
+		if(!slidx_match(&sig, &q)) missed++;
+
+		if(slidx_match(&sig, &query)) passed++;
+		if(strstr(titles[n], "Planet")) contain++;
+	}
+	CHECK(missed == 0);
+	CHECK(passed >= contain);
+	printf("  filter \"planet\": %u of %u titles pass, %u contain it\n", passed, COUNT, contain);
+
+	// short queries have no bits: everything matches
+	slidx_sig empty; memset(&empty, 0, sizeof(empty)); slidx_signature(&empty, "GT");
+	CHECK(!empty.bits[0] && !empty.bits[1]);
+
+	// file layout
+	CHECK(slidx_order_offset(COUNT, 0) == sizeof(_slaunch_idx));
+	CHECK((slidx_sig_offset(7) & 7) == 0 && slidx_sig_offset(7) >= slidx_order_offset(7, SLIDX_ORDERS));
+	CHECK(slidx_size(COUNT) == slidx_sig_offset(COUNT) + COUNT * sizeof(slidx_sig));
+
+	return test_result("slaunch_idx");
+}
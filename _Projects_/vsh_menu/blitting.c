@@ -2,6 +2,8 @@
 #include "include/png_dec.h"
 #include "include/misc.h"
 #include "include/mem.h"
+#include "../../blitter.h"
+#include "include/flip_tiles.h"
 
 #include <cell/rtc.h>
 //#include "include/network.h"	// debug
@@ -11,6 +13,9 @@
 static uint32_t unk1 = 0, offset = 0, pitch = 0;
 static uint32_t h = 0, w = 0, canvas_x = 0, canvas_y = 0;
 
+// damage tracking: the tiles of ctx.canvas that differ from ctx.prev are flipped
+static uint8_t flip_all = 1;
+
 static Bitmap *bitmap = NULL;                       // font glyph cache
 
 static const CellFontLibrary* font_lib_ptr = NULL;  // font library pointer
@@ -313,14 +318,10 @@ static int32_t utf8_to_ucs4(uint8_t *utf8, uint32_t *ucs4)
 ***********************************************************************/
 static void dump_bg(void)
 {
-	uint32_t i, k, kk, m, y, CANVAS_WW = CANVAS_W/2;
-	uint64_t *bg = (uint64_t*)ctx.bg;
+	uint32_t i;
 
 	for(i = 0; i < CANVAS_H; i++)
-		for(m = i * CANVAS_WW,
-			kk = canvas_x, y = canvas_y + i,
-			k = 0; k < CANVAS_WW; k++, kk+=2)
-				bg[k + m] = *(uint64_t*)(OFFSET(kk, y));
+		blit_copy(ctx.bg + (i * CANVAS_W), (uint32_t*)(OFFSET(canvas_x, canvas_y + i)), CANVAS_W);
 }
 
 /***********************************************************************
@@ -333,6 +334,7 @@ void init_graphic()
 	// set drawing context
 	ctx.canvas     = mem_alloc(CANVAS_W * CANVAS_H * 4);  // canvas buffer
 	ctx.bg         = mem_alloc(CANVAS_W * CANVAS_H * 4);  // background buffer
+	ctx.prev       = mem_alloc(CANVAS_W * CANVAS_H * 4);  // last flipped frame
 	ctx.font_cache = mem_alloc(FONT_CACHE_MAX * 32 * 32); // glyph bitmap cache
 	ctx.bg_color   = 0xFF000000;                          // black, opaque
 	ctx.fg_color   = 0xFFFFFFFF;                          // white, opaque
@@ -354,6 +356,7 @@ void init_graphic()
 
 	// init first frame with background dump
 	memcpy32(ctx.canvas, ctx.bg, CANVAS_W * CANVAS_H);
+	flip_all = 1;
 }
 
 /***********************************************************************
@@ -373,42 +376,20 @@ int32_t load_png_bitmap(int32_t idx, const char *path)
 	return 0;
 }
 
-/***********************************************************************
-* alpha blending (ARGB)
-*
-* uint32_t bg = background color
-* uint32_t fg = foreground color
-***********************************************************************/
-static uint32_t mix_color(uint32_t bg, uint32_t fg)
-{
-	uint32_t a = fg >>24;
-
-	if(a == 0) return bg;
-
-	uint32_t aa = (255 - a);
-
-	uint32_t rb = (((fg & 0x00FF00FF) * a) + ((bg & 0x00FF00FF) * aa)) & 0xFF00FF00;
-	uint32_t g  = (((fg & 0x0000FF00) * a) + ((bg & 0x0000FF00) * aa)) & 0x00FF0000;
-	fg = a + (((bg >>24) * aa)>>8);
-
-	return (fg <<24) | ((rb | g) >>8);
-}
-
 /***********************************************************************
 * flip finished frame into paused ps3-framebuffer
+* the frame is redrawn from scratch, only the tiles that changed are flipped
 ***********************************************************************/
 void flip_frame()
 {
-	int32_t i, k, kk, m, y, CANVAS_WW = CANVAS_W/2;
-	uint64_t *canvas = (uint64_t*)ctx.canvas;
+	uint32_t *frame = ctx.canvas;
 
-	for(i = 0; i < CANVAS_H; i++)
-		for(m = i * CANVAS_WW,
-			kk = canvas_x, y = canvas_y + i,
-			k = 0; k < CANVAS_WW; k++, kk+=2)
-				*(uint64_t*)(OFFSET(kk, y)) = canvas[k + m];
+	flip_tiles((uint32_t*)(OFFSET(canvas_x, canvas_y)), pitch, ctx.canvas, flip_all ? NULL : ctx.prev, CANVAS_W, CANVAS_H, DAMAGE_TILE);
+
+	flip_all = 0;
 
-	// after flip, clear frame buffer with background
+	// keep the flipped frame for the next compare, clear the next frame with background
+	ctx.canvas = ctx.prev; ctx.prev = frame;
 	memcpy32(ctx.canvas, ctx.bg, CANVAS_W * CANVAS_H);
 }
 
@@ -462,10 +443,7 @@ void set_font(float_t font_w, float_t font_h, float_t weight, int32_t distance)
 ***********************************************************************/
 void draw_background()
 {
-	const uint32_t CANVAS_SIZE = CANVAS_W * CANVAS_H;
-
-	for(uint32_t i = 0; i < CANVAS_SIZE; i++)
-		ctx.canvas[i] = mix_color(ctx.bg[i], ctx.bg_color);
+	blit_blend_color(ctx.canvas, ctx.bg, ctx.bg_color, CANVAS_W * CANVAS_H);
 }
 
 /***********************************************************************
@@ -527,17 +505,14 @@ int32_t print_text(int32_t x, int32_t y, const char *str)
 			t_y = o_y - glyph->metrics.Horizontal.bearingY;
 
 			// draw bitmap
-			for(i = 0; i < glyph->h; i++)
+			k = (CANVAS_W - t_x < glyph->w) ? CANVAS_W - t_x : glyph->w;
+
+			for(i = 0; (i < glyph->h) && (k > 0); i++)
 			  if(t_y + i < CANVAS_H)
-				  for(k = 0; k < glyph->w; k++)
-					if((glyph->image[i * glyph->w + k]) && (t_x + k < CANVAS_W))
-					{
-						pixel = (t_y + i) * CANVAS_W + t_x + k;
-						ctx.canvas[pixel] =
-						mix_color(ctx.canvas[pixel],
-								 ((uint32_t)glyph->image[i * glyph->w + k] <<24) |
-								 (ctx.fg_color & 0x00FFFFFF));
-					}
+			  {
+				  pixel = (t_y + i) * CANVAS_W + t_x;
+				  blit_glyph(ctx.canvas + pixel, glyph->image + (i * glyph->w), ctx.fg_color, k);
+			  }
 
 			// get origin-x for next char
 			o_x += glyph->metrics.Horizontal.advance + bitmap->distance;
@@ -559,7 +534,7 @@ int32_t print_text(int32_t x, int32_t y, const char *str)
 ***********************************************************************/
 int32_t draw_png(int32_t idx, int32_t c_x, int32_t c_y, int32_t p_x, int32_t p_y, int32_t w, int32_t h)
 {
-	uint32_t i, k, m, o, hh = h, ww = w;
+	uint32_t i, m, o, hh = h, ww = w;
 
 	const uint32_t CANVAS_WW = CANVAS_W - c_x, CANVAS_HH = CANVAS_H - c_y;
 
@@ -569,12 +544,11 @@ int32_t draw_png(int32_t idx, int32_t c_x, int32_t c_y, int32_t p_x, int32_t p_y
 	uint32_t offset = p_x + p_y * ctx.png[idx].w;
 
 	for(i = 0; i < hh; i++)
-		for(m = (c_y + i) * CANVAS_W + c_x,
-			o = offset + i * ctx.png[idx].w,
-			k = 0; k < ww; k++, m++, o++)
-				ctx.canvas[m] =
-					mix_color(ctx.canvas[m],
-					ctx.png[idx].addr[o]);
+	{
+		m = (c_y + i) * CANVAS_W + c_x;
+		o = offset + i * ctx.png[idx].w;
+		blit_blend(ctx.canvas + m, ctx.canvas + m, ctx.png[idx].addr + o, ww);
+	}
 
 	return (c_x + w);
 }
@@ -639,15 +613,14 @@ void screenshot(uint8_t mode)
 	// write bmp header
 	fwrite(bmp_header, 1, sizeof(bmp_header), fd);
 
-	uint32_t c, i, k, kk, m, idx = 0;
+	uint32_t c, i, k, m, idx = 0;
 
 	uint32_t canvas_x_left = canvas_x/2, canvas_x_right = canvas_x_left + CANVAS_W/2, canvas_y_bottom = canvas_y + CANVAS_H, ww=w/2;
 
 	// dump...
 	for(c = 0, i = h; i > 0; i--, c++)
 	{
-		for(k = kk = 0; k < ww; k++, kk+=2)
-			line_frame[k] = *(uint64_t*)(OFFSET(kk, i));
+		blit_copy((uint32_t*)line_frame, (uint32_t*)(OFFSET(0, i)), ww<<1);
 
 		if((mode == 0) && (i >= canvas_y) && (i < canvas_y_bottom))
 		{
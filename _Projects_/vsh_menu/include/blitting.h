@@ -20,6 +20,7 @@
 #define BASE          0xC0000000UL     // local memory base ea
 #define CANVAS_W      720              // canvas width in pixel
 #define CANVAS_H      400              // canvas height in pixel
+#define DAMAGE_TILE   80               // width of the tiles compared between 2 flips
 
 #define PNG_MAX       4                // additional png bitmaps
 
@@ -60,6 +61,7 @@ typedef struct _Bitmap {
 typedef struct _DrawCtx {
 	uint32_t *canvas;             // addr of canvas
 	uint32_t *bg;                 // addr of background backup
+	uint32_t *prev;               // addr of the last flipped frame (swapped with canvas)
 	uint32_t *font_cache;         // addr of glyph bitmap cache buffer
 	CellFont font;
 	CellFontRenderer renderer;
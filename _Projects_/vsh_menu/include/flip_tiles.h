@@ -0,0 +1,31 @@
+#ifndef __FLIP_TILES_H__
+#define __FLIP_TILES_H__
+
+// partial flip of a frame redrawn from scratch (portable C, uses blit_copy of blitter.h)
+// the frame is compared with the previous one tile by tile, only the tiles that differ are copied
+
+#include <string.h>
+
+// fb    = framebuffer address of the first pixel, pitch = framebuffer pixels per row
+// cur   = new frame, prev = previous frame or NULL to copy all (w * h pixels)
+// tile  = width of the tiles in pixels
+// returns the bytes written to the framebuffer
+static uint32_t flip_tiles(uint32_t *fb, uint32_t pitch, const uint32_t *cur, const uint32_t *prev, uint32_t w, uint32_t h, uint32_t tile)
+{
+	uint32_t i, t, n, row, bytes = 0;
+
+	for(i = 0; i < h; i++, fb += pitch)
+		for(row = i * w, t = 0; t < w; t += tile)
+		{
+			n = (w - t < tile) ? (w - t) : tile;
+
+			if(prev && !memcmp(cur + row + t, prev + row + t, n * 4)) continue;
+
+			blit_copy(fb + t, cur + row + t, n);
+			bytes += n * 4;
+		}
+
+	return bytes;
+}
+
+#endif // __FLIP_TILES_H__
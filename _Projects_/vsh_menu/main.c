@@ -293,8 +293,8 @@ static void start_VSH_Menu(void)
 	int32_t ret, mem_size;
 
 	// create VSH Menu heap memory from memory container 1("app")
-	mem_size = (((CANVAS_W * CANVAS_H * 4 * 2) + (FONT_CACHE_MAX * 32 * 32)) + (320 * 176 * 4) + MB(4)) / MB(1);
-	ret = create_heap(mem_size);  // 6 MB
+	mem_size = (((CANVAS_W * CANVAS_H * 4 * 3) + (FONT_CACHE_MAX * 32 * 32)) + (320 * 176 * 4) + MB(4)) / MB(1);
+	ret = create_heap(mem_size);  // 7 MB
 
 	if(ret) {rsx_fifo_pause(0); return;}
 
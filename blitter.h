@@ -0,0 +1,216 @@
+#ifndef __BLITTER_H__
+#define __BLITTER_H__
+
+// ARGB row primitives shared by sLaunch & VSH Menu (blitting.c)
+// Pixels are 32-bit ARGB in native order. The rows can start at any 4-byte address:
+// the VMX path does the unaligned head & tail with the scalar code, the results are identical
+
+#include <stdint.h>
+
+typedef uint64_t blit_u64 __attribute__((aligned(4))); // 2 pixels at a 4-byte address
+
+#ifdef __ALTIVEC__
+#include <altivec.h>
+
+typedef vector unsigned char  blit_v8;
+typedef vector unsigned short blit_v16;
+typedef vector unsigned int   blit_v32;
+
+typedef union {blit_v32 v; uint32_t w[4]; uint64_t d[2];} blit_vec;
+
+#define BLIT_ALIGNED(p)	(!((uintptr_t)(p) & 15))
+#endif
+
+/***********************************************************************
+* alpha blending (ARGB)
+*
+* uint32_t bg = background color
+* uint32_t fg = foreground color
+***********************************************************************/
+static inline uint32_t blit_mix(uint32_t bg, uint32_t fg)
+{
+	uint32_t a = fg >>24;
+
+	if(a == 0) return bg; // fg is transparent
+
+	uint32_t aa = a ^ 0xFF;
+
+	uint32_t rb = (((fg & 0x00FF00FF) * a) + ((bg & 0x00FF00FF) * aa)) & 0xFF00FF00;
+	uint32_t g  = (((fg & 0x0000FF00) * a) + ((bg & 0x0000FF00) * aa)) & 0x00FF0000;
+	fg = a + ((bg >>24) * aa >>8);
+
+	return (fg <<24) | ((rb | g) >>8);
+}
+
+// 75% of R, G & B (alpha is kept). A byte never borrows from the next one
+static inline uint32_t blit_dim_pixel(uint32_t p)
+{
+	return p - ((p >>2) & 0x003F3F3F);
+}
+
+#ifdef __ALTIVEC__
+// unaligned load (never reads past the last byte of the vector)
+static inline blit_v32 blit_ld(const uint32_t *p)
+{
+	if(BLIT_ALIGNED(p)) return *(const blit_v32*)p;
+
+	blit_v8 lo = vec_ld(0, (const unsigned char*)p), hi = vec_ld(15, (const unsigned char*)p);
+	return (blit_v32)vec_perm(lo, hi, vec_lvsl(0, (const unsigned char*)p));
+}
+
+// 4 pixels at once, same math as blit_mix(): channel = (fg * a + bg * (255 - a)) >> 8
+static inline blit_v32 blit_mix_vmx(blit_v32 bg, blit_v32 fg)
+{
+	const blit_v8 alpha_splat = {0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12};
+	const blit_v8 high_bytes  = {0, 16, 2, 18, 4, 20, 6, 22, 8, 24, 10, 26, 12, 28, 14, 30};
+	const blit_v32 alpha_mask = {0xFF000000, 0xFF000000, 0xFF000000, 0xFF000000};
+
+	blit_v8 a  = vec_perm((blit_v8)fg, (blit_v8)fg, alpha_splat);
+	blit_v8 aa = vec_nor(a, a);
+	blit_v8 f  = vec_andc((blit_v8)fg, (blit_v8)alpha_mask); // alpha = a + (bg alpha * aa >> 8)
+	blit_v8 b  = (blit_v8)bg;
+
+	blit_v16 even = vec_add(vec_mule(f, a), vec_mule(b, aa)); // A & G
+	blit_v16 odd  = vec_add(vec_mulo(f, a), vec_mulo(b, aa)); // R & B
+
+	blit_v8 mix = vec_perm((blit_v8)even, (blit_v8)odd, high_bytes);
+	mix = vec_add(mix, vec_and(a, (blit_v8)alpha_mask));
+
+	return vec_sel((blit_v32)mix, bg, (vector bool int)vec_cmpeq((blit_v32)a, vec_splat_u32(0))); // fg is transparent
+}
+#endif
+
+/***********************************************************************
+* copy n pixels
+***********************************************************************/
+static inline void blit_copy(uint32_t *dst, const uint32_t *src, uint32_t n)
+{
+#ifdef __ALTIVEC__
+	for(; n && !BLIT_ALIGNED(dst); n--) *dst++ = *src++;
+
+	if(BLIT_ALIGNED(src))
+		for(; n >= 4; n -= 4, dst += 4, src += 4) *(blit_v32*)dst = *(const blit_v32*)src;
+	else
+		for(; n >= 4; n -= 4, dst += 4, src += 4) *(blit_v32*)dst = blit_ld(src);
+#endif
+	while(n--) *dst++ = *src++;
+}
+
+/***********************************************************************
+* fill n pixel pairs with a 64-bit color (2 pixels)
+* dst can be any 4-byte address: the head is written pixel by pixel
+***********************************************************************/
+static inline void blit_fill64(uint64_t *dst, uint64_t color, uint32_t pairs)
+{
+#ifdef __ALTIVEC__
+	union {uint64_t d; uint32_t w[2];} pair; pair.d = color; // w[0] = first pixel in memory
+
+	uint32_t *p = (uint32_t*)dst, n = pairs * 2; uint8_t k = 0;
+
+	for(; n && !BLIT_ALIGNED(p); n--, k ^= 1) *p++ = pair.w[k];
+
+	blit_vec c; c.w[0] = c.w[2] = pair.w[k], c.w[1] = c.w[3] = pair.w[k ^ 1];
+
+	for(; n >= 4; n -= 4, p += 4) *(blit_v32*)p = c.v;
+
+	for(; n; n--, k ^= 1) *p++ = pair.w[k];
+#else
+	blit_u64 *p = (blit_u64*)dst;
+
+	while(pairs--) *p++ = color;
+#endif
+}
+
+/***********************************************************************
+* dst = bg blended with fg (dst can be bg)
+***********************************************************************/
+static inline void blit_blend(uint32_t *dst, const uint32_t *bg, const uint32_t *fg, uint32_t n)
+{
+#ifdef __ALTIVEC__
+	for(; n && !BLIT_ALIGNED(dst); n--) *dst++ = blit_mix(*bg++, *fg++);
+
+	for(; n >= 4; n -= 4, dst += 4, bg += 4, fg += 4)
+		*(blit_v32*)dst = blit_mix_vmx(blit_ld(bg), blit_ld(fg));
+#endif
+	while(n--) *dst++ = blit_mix(*bg++, *fg++);
+}
+
+/***********************************************************************
+* dst = bg blended with a color
+***********************************************************************/
+static inline void blit_blend_color(uint32_t *dst, const uint32_t *bg, uint32_t color, uint32_t n)
+{
+#ifdef __ALTIVEC__
+	for(; n && !BLIT_ALIGNED(dst); n--) *dst++ = blit_mix(*bg++, color);
+
+	blit_vec c; c.w[0] = c.w[1] = c.w[2] = c.w[3] = color;
+
+	for(; n >= 4; n -= 4, dst += 4, bg += 4)
+		*(blit_v32*)dst = blit_mix_vmx(blit_ld(bg), c.v);
+#endif
+	while(n--) *dst++ = blit_mix(*bg++, color);
+}
+
+/***********************************************************************
+* dst = fg blended over a background color
+***********************************************************************/
+static inline void blit_blend_over(uint32_t *dst, uint32_t bg, const uint32_t *fg, uint32_t n)
+{
+#ifdef __ALTIVEC__
+	for(; n && !BLIT_ALIGNED(dst); n--) *dst++ = blit_mix(bg, *fg++);
+
+	blit_vec c; c.w[0] = c.w[1] = c.w[2] = c.w[3] = bg;
+
+	for(; n >= 4; n -= 4, dst += 4, fg += 4)
+		*(blit_v32*)dst = blit_mix_vmx(c.v, blit_ld(fg));
+#endif
+	while(n--) *dst++ = blit_mix(bg, *fg++);
+}
+
+/***********************************************************************
+* dst = src dimmed to 75%
+***********************************************************************/
+static inline void blit_dim(uint32_t *dst, const uint32_t *src, uint32_t n)
+{
+#ifdef __ALTIVEC__
+	const blit_v32 rgb_mask = {0x003F3F3F, 0x003F3F3F, 0x003F3F3F, 0x003F3F3F};
+
+	for(; n && !BLIT_ALIGNED(dst); n--) *dst++ = blit_dim_pixel(*src++);
+
+	for(; n >= 4; n -= 4, dst += 4, src += 4)
+	{
+		blit_v8 p = (blit_v8)blit_ld(src);
+		*(blit_v32*)dst = (blit_v32)vec_sub(p, vec_and(vec_sr(p, vec_splat_u8(2)), (blit_v8)rgb_mask));
+	}
+#endif
+	while(n--) *dst++ = blit_dim_pixel(*src++);
+}
+
+/***********************************************************************
+* blend a row of glyph coverage (8-bit alpha) with a color into dst
+***********************************************************************/
+static inline void blit_glyph(uint32_t *dst, const uint8_t *alpha, uint32_t color, uint32_t n)
+{
+	color &= 0x00FFFFFF;
+
+#ifdef __ALTIVEC__
+	for(; n && !BLIT_ALIGNED(dst); n--, dst++, alpha++) if(*alpha) *dst = blit_mix(*dst, ((uint32_t)*alpha <<24) | color);
+
+	blit_vec fg;
+
+	for(; n >= 4; n -= 4, dst += 4, alpha += 4)
+	{
+		if(!(alpha[0] | alpha[1] | alpha[2] | alpha[3])) continue; // blank
+
+		fg.w[0] = ((uint32_t)alpha[0] <<24) | color;
+		fg.w[1] = ((uint32_t)alpha[1] <<24) | color;
+		fg.w[2] = ((uint32_t)alpha[2] <<24) | color;
+		fg.w[3] = ((uint32_t)alpha[3] <<24) | color;
+
+		*(blit_v32*)dst = blit_mix_vmx(*(blit_v32*)dst, fg.v);
+	}
+#endif
+	for(; n; n--, dst++, alpha++) if(*alpha) *dst = blit_mix(*dst, ((uint32_t)*alpha <<24) | color);
+}
+
+#endif // __BLITTER_H__
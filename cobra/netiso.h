@@ -59,6 +59,12 @@ enum NETISO_CMD
 
 	/* Replace this with any custom command */
 	NETISO_CMD_CUSTOM_0 = 0x2412,
+
+	/* Protocol v2: negotiates tagged reads. Servers without v2 close the connection on it (the client reconnects and uses v1) */
+	NETISO_CMD_NEGOTIATE_V2,
+	/* Protocol v2: reads the active ro file. Offsets and sizes in bytes. Up to the negotiated window of reads can be in flight.
+	   Each result carries the tag of its request and results can arrive in any order */
+	NETISO_CMD_READ_FILE_TAGGED,
 };
 
 typedef struct _netiso_cmd
@@ -164,6 +170,60 @@ typedef struct _netiso_read_cd_2048_critical_cmd
 	u32 pad2;
 } __attribute__((packed)) netiso_read_cd_2048_critical_cmd;
 
+#define NETISO_PROTOCOL_V2	2
+
+/* Compressed transfer mode: the data of READ_FILE_CRITICAL, READ_FILE and READ_FILE_TAGGED is sent in blocks of
+   NETISO_BLOCK_SIZE bytes (the last one can be shorter), each one preceded by a netiso_block_header */
+#define NETISO_FLAG_COMPRESS	1
+#define NETISO_BLOCK_SIZE		65536
+
+enum NETISO_BLOCK_TYPE
+{
+	NETISO_BLOCK_RAW,	/* size bytes of data */
+	NETISO_BLOCK_ZERO,	/* all zero, no data */
+	NETISO_BLOCK_LZ4	/* size bytes of LZ4 block format (always smaller than the block) */
+};
+
+typedef struct _netiso_block_header
+{
+	u8 type;
+	u8 pad[3];
+	u32 size; // bytes of data that follow
+} __attribute__((packed)) netiso_block_header;
+
+typedef struct _netiso_negotiate_v2_cmd
+{
+	u16 opcode;
+	u16 version; // highest protocol version of the client
+	u16 window;  // tagged reads in flight wanted by the client
+	u8 flags;   // NETISO_FLAG_* wanted by the client
+	u8 pad[9];
+} __attribute__((packed)) netiso_negotiate_v2_cmd;
+
+typedef struct _netiso_negotiate_v2_result
+{
+	u16 version;  // protocol version of the server
+	u16 window;   // tagged reads in flight accepted by the server
+	u32 max_read; // max bytes of one tagged read
+	u8 flags;    // NETISO_FLAG_* accepted by the server
+	u8 pad[3];
+} __attribute__((packed)) netiso_negotiate_v2_result;
+
+typedef struct _netiso_read_file_tagged_cmd
+{
+	u16 opcode;
+	u16 tag;
+	u32 num_bytes;
+	u64 offset;
+} __attribute__((packed)) netiso_read_file_tagged_cmd;
+
+typedef struct _netiso_read_file_tagged_result
+{
+	u16 tag;
+	u16 pad;
+	s32 bytes_read; // -1 on error. The data read (if any) follows
+} __attribute__((packed)) netiso_read_file_tagged_result;
+
 #ifdef __BIG_ENDIAN__
 
 static inline u16 BE16(u16 x)
@@ -54,6 +54,7 @@
 #define MOUNT_PNG		// support fake PNG as ISO
 #define VISUALIZERS		// Rotate visualizers (earth, lines, canyon, coldboot_*.ac3)
 #define ARTEMIS_PRX
+#define GZIP_HTML		// gzip generated pages for clients that accept it & serve up-to-date <file>.gz siblings
 
 //// INTERNAL PLUGINS ////
 //#define USE_INTERNAL_NET_PLUGIN	// comment out to use netiso.sprx
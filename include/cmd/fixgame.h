@@ -1,7 +1,7 @@
 #ifdef FIX_GAME
 	if(islike(param, "/fixgame.ps3"))
 	{
-		// /fixgame.ps3<path>  fix PARAM.SFO and EBOOT.BIN / SELF / SPRX in ISO or folder
+		// /fixgame.ps3<path>  fix PARAM.SFO and EBOOT.BIN / SELF / SPRX in ISO or folder (all ISO if <path> is a PS3ISO folder)
 		// /fixgame.ps3<param_sfo>&attrib=<value>
 
 		char *game_path = param + 12, titleID[10];
@@ -1,23 +1,88 @@
 #ifdef CALC_MD5
 	if(islike(param, "/md5.ps3"))
 	{
+		// /md5.ps3<file>                 show size, MD5, SHA-1 & CRC32 (an interrupted hash resumes where it stopped)
+		// /md5.ps3<file>&dat=<dat-file>  verify file against a Redump / No-Intro DAT
+		// /md5.ps3<path>&dat=<dat-file>  verify all files in folder (report saved to HASH_VERIFY_FILE)
+
+		#define HASH_VERIFY_FILE	WMTMP "/hash_verify.txt"
+
 		char *filename = param + 8, *buffer = header;
 
+		char *dat_file = strstr(filename, "&dat=");
+		if(dat_file) {*dat_file = NULL, dat_file += 5; check_path_alias(dat_file);}
+
 		check_path_alias(filename);
 
+		u8 md5[16], sha1[20]; u32 crc = 0;
+		char md5_str[33], sha1_str[41], rom_name[128];
+
+		if(dat_file && isDir(filename))
+		{
+			int fd; CellFsDirectoryEntry entry; u32 read_f;
+			char *entry_name = entry.entry_name.d_name, *path = buffer;
+			u16 count = 0, verified = 0;
+
+			save_file(HASH_VERIFY_FILE, "", SAVE_ALL);
+
+			if(cellFsOpendir(filename, &fd) == CELL_FS_SUCCEEDED)
+			{
+				while(working && (!cellFsGetDirectoryEntries(fd, &entry, sizeof(entry), &read_f) && read_f))
+				{
+					if(entry.attribute.st_mode & S_IFDIR) continue;
+
+					snprintf(path, HTML_RECV_LAST, "%s/%s", filename, entry_name);
+					if(!calc_hashes(path, md5, NULL, NULL, true)) continue;
+
+					hash_to_str(md5_str, md5, 16); count++;
+
+					bool found = find_hash_in_dat(dat_file, md5_str, rom_name, sizeof(rom_name));
+					if(found) verified++;
+
+					snprintf(path, HTML_RECV_LAST, "%s %s %s%s", md5_str, found ? "OK " : "BAD", entry_name, found ? " -> " : "");
+					save_file(HASH_VERIFY_FILE, path, -(s64)strlen(path));
+					save_file(HASH_VERIFY_FILE, rom_name, APPEND_TEXT);
+				}
+				cellFsClosedir(fd);
+			}
+
+			sprintf(buffer, "File: ");
+			add_breadcrumb_trail(buffer, filename);
+			sprintf(param, "%s<p>Verified: %i / %i<p>Report: <a href=\"%s\">%s</a><p>", buffer, verified, count, HASH_VERIFY_FILE, HASH_VERIFY_FILE);
+
+			keep_alive = http_response(conn_s, header, "/md5.ps3", CODE_HTTP_OK, param);
+
+			goto exit_handleclient_www;
+		}
+
 		sprintf(buffer, "File: ");
 		add_breadcrumb_trail(buffer, filename);
 
 		struct CellFsStat buf; cellFsStat(filename, &buf);
 		unsigned long long sz = (unsigned long long)buf.st_size;
 
-		char md5[33];
-		calc_md5(filename, md5);
+		if(calc_hashes(filename, md5, sha1, &crc, true))
+		{
+			hash_to_str(md5_str, md5, 16);
+			hash_to_str(sha1_str, sha1, 20);
 
-		sprintf(param, "%s<p>Size: %llu bytes<p>MD5: %s<p>", buffer, sz, md5);
+			int len = sprintf(param, "%s<p>Size: %llu bytes<p>MD5: %s<p>SHA-1: %s<p>CRC32: %08x<p>", buffer, sz, md5_str, sha1_str, crc);
+
+			if(dat_file)
+			{
+				if(find_hash_in_dat(dat_file, md5_str, rom_name, sizeof(rom_name)))
+					sprintf(param + len, "DAT: OK (%s)<p>", rom_name);
+				else
+					sprintf(param + len, "DAT: not found<p>");
+			}
+		}
+		else
+			sprintf(param, "%s<p>Size: %llu bytes<p>MD5: %s<p>", buffer, sz, STR_ERROR);
 
 		keep_alive = http_response(conn_s, header, "/md5.ps3", CODE_HTTP_OK, param);
 
+		#undef HASH_VERIFY_FILE
+
 		goto exit_handleclient_www;
 	}
 #endif
@@ -55,6 +55,7 @@
 		// /mount.ps3/unmount<dev_path>
 		// /copy.ps3/<path>[&to=<destination>]
 		// /copy.ps3/<path>[&to=<destination>]?restart.ps3
+		// /copy.ps3$resume
 
 		char *params = param + 10;
 
@@ -79,7 +80,17 @@
 				goto html_response;
 			}
 		}
-		else if(islike(param, "/copy.ps3")) ;
+		else if(islike(param, "/copy.ps3"))
+		{
+			#ifdef COPY_PS3
+			// /copy.ps3$resume  continue the last interrupted copy job (files already copied are skipped)
+			if(islike(param + 9, "$resume") && !read_file(COPY_JOB_FILE, param + 9, STD_PATH_LEN * 2 + 1, 0))
+			{
+				keep_alive = http_response(conn_s, header, param, CODE_PATH_NOT_FOUND, "404 Path not found"); is_busy = false;
+				goto exit_handleclient_www;
+			}
+			#endif
+		}
 
 		else if(!islike(params, "/net") && !islike(params, WMTMP))
 		{
@@ -30,7 +30,7 @@
 
 					// save new PARAM.SFO
 					if(patch)
-						save_file(filename, param_sfo, sfo_size);
+						{save_file(filename, param_sfo, sfo_size); sfo_cache_drop(filename);}
 
 					// add footer
 					sprintf(tmp, "<hr>" HTML_BUTTON_FMT "%s",
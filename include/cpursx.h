@@ -576,6 +576,15 @@ static void cpu_rsx_stats(char *buffer, char *templn, char *param, u8 is_ps3_htt
 
 	strcat(buffer, "<hr>");
 
+	#ifdef USE_INTERNAL_NTFS_PLUGIN
+	////// sector cache of mounted raw ISO //////
+	if(rawseciso_loaded && (sect_cache.hits + sect_cache.misses))
+	{
+		sprintf(templn, "<label title=\"Sector cache\">&#9636;</label> %i%% (%i / %i, +%i) %iKB<br>",
+						(int)(((u64)sect_cache.hits * 100) / (sect_cache.hits + sect_cache.misses)), sect_cache.hits, sect_cache.misses, sect_cache.prefetched, sect_cache_mem>>10); buffer += concat(buffer, templn);
+	}
+	#endif
+
 	CellRtcTick pTick; cellRtcGetCurrentTick(&pTick);
 
 	// detect aprox. time when a game is launched
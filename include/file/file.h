@@ -15,6 +15,7 @@
 #include "file_size.h"
 #include "file_copy.h"
 #include "file_delete.h"
+#include "iso9660.h"
 
 #include "togglers.h"
 
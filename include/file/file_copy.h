@@ -71,8 +71,137 @@ static void get_copy_stats(char *msg, const char *label)
 }
 #endif
 
-int64_t file_copy(const char *file1, char *file2);
-int64_t file_copy(const char *file1, char *file2)
+#define COPY_RING_SLOTS			4				// read-ahead buffers shared by copy_reader_thread & the writer
+#define COPY_PART_SIZE			0xFFFF0000ULL	// 4GB - 64KB (split size of large files copied to FAT32)
+#define COPY_JOURNAL_FILE		WMTMP "/copy_file.bin"
+#define COPY_JOURNAL_MIN		0x10000000ULL	// files >= 256MB resume after an interruption
+#define COPY_JOURNAL_INTERVAL	0x10000000ULL	// save progress of resumable copies every 256MB
+
+static bool copy_interrupted = false; // a copy stopped on unload or I/O error (not on /copy.ps3$abort); reset by the caller of the job
+
+typedef struct
+{
+	char src[STD_PATH_LEN + 1];
+	char dst[STD_PATH_LEN + 1];
+	u64 size;
+	u64 mtime;
+	u64 offset; // bytes of src already written to dst
+} t_copy_journal;
+
+// ring of buffers: copy_reader_thread reads ahead while the caller writes the previous chunks
+typedef struct
+{
+	int fd;
+	bool is_ntfs;
+	u64 pos;  // next read offset
+	u64 size; // bytes left to read
+	char *buf[COPY_RING_SLOTS];
+	u32 len[COPY_RING_SLOTS];
+	vu8 full[COPY_RING_SLOTS];
+	vu8 abort;
+	u32 chunk_size;
+} t_copy_reader;
+
+static u32 copy_read_chunk(t_copy_reader *rd, u8 slot)
+{
+	u64 nread = 0; u32 len = (u32)MIN(rd->chunk_size, rd->size);
+
+	if(len)
+	{
+		#ifdef USE_NTFS
+		if(rd->is_ntfs)
+		{
+			ps3ntfs_seek64(rd->fd, rd->pos, SEEK_SET);
+			int ret = ps3ntfs_read(rd->fd, (void *)rd->buf[slot], len);
+			if(ret > 0) nread = ret;
+		}
+		else
+		#endif
+		if(cellFsReadWithOffset(rd->fd, rd->pos, rd->buf[slot], len, &nread) != CELL_FS_SUCCEEDED) nread = 0;
+	}
+
+	rd->pos += nread, rd->size -= nread;
+	return rd->len[slot] = (u32)nread;
+}
+
+static void copy_reader_thread(u64 arg)
+{
+	t_copy_reader *rd = (t_copy_reader*)(u32)arg;
+
+	for(u8 i = 0; ; i = (i + 1) % COPY_RING_SLOTS)
+	{
+		while(rd->full[i] && !rd->abort) sys_ppu_thread_usleep(500);
+		if(rd->abort) break;
+
+		u32 nread = copy_read_chunk(rd, i);
+		__sync_synchronize(); // publish buffer before flag
+		rd->full[i] = 1;
+
+		if(!nread) break; // EOF or error
+	}
+
+	sys_ppu_thread_exit(0);
+}
+
+// files that fit in one chunk (or a single buffer) are read inline by the writer
+static sys_ppu_thread_t copy_reader_start(t_copy_reader *rd, int fd, bool is_ntfs, u64 pos, u64 size)
+{
+	rd->fd = fd, rd->is_ntfs = is_ntfs, rd->pos = pos, rd->size = size, rd->abort = 0;
+	for(u8 i = 0; i < COPY_RING_SLOTS; i++) rd->full[i] = rd->len[i] = 0;
+
+	sys_ppu_thread_t t_id = SYS_PPU_THREAD_NONE;
+	if(rd->buf[1] && (size > rd->chunk_size))
+	{
+		if(sys_ppu_thread_create(&t_id, copy_reader_thread, (u64)(u32)rd, THREAD_PRIO, THREAD_STACK_SIZE_16KB, SYS_PPU_THREAD_CREATE_JOINABLE, THREAD_NAME_COPY) != CELL_OK)
+			t_id = SYS_PPU_THREAD_NONE;
+	}
+	return t_id;
+}
+
+static void copy_reader_stop(t_copy_reader *rd, sys_ppu_thread_t *t_id)
+{
+	if(*t_id == SYS_PPU_THREAD_NONE) return;
+	rd->abort = 1;
+	thread_join(*t_id); *t_id = SYS_PPU_THREAD_NONE;
+}
+
+// split a sys_memory block into the ring (1 slot if the block is too small to be shared)
+static void copy_reader_init(t_copy_reader *rd, sys_addr_t sysmem, u32 mem_size)
+{
+	_memset(rd, sizeof(t_copy_reader));
+
+	u8 slots = (mem_size >= (COPY_RING_SLOTS * _64KB_)) ? COPY_RING_SLOTS : 1;
+	rd->chunk_size = mem_size / slots;
+	for(u8 i = 0; i < slots; i++) rd->buf[i] = (char*)sysmem + (i * rd->chunk_size);
+}
+
+static void set_part_name(char *file2, u16 flen, u8 part)
+{
+	if(file2[flen - 2] == '.')
+		sprintf(file2 + flen - 2, ".%i", part);
+	else
+		sprintf(file2 + flen - 2, "%02i", part);
+}
+
+// offset where an interrupted copy of the same file can continue (0 = copy from the start)
+static u64 copy_journal_offset(const t_copy_journal *job)
+{
+	t_copy_journal last;
+	if(read_file(COPY_JOURNAL_FILE, (char*)&last, sizeof(t_copy_journal), 0) != sizeof(t_copy_journal)) return 0;
+
+	if(!IS(last.src, job->src) || !IS(last.dst, job->dst) || (last.size != job->size) || (last.mtime != job->mtime) || (last.offset >= last.size)) return 0;
+
+	return last.offset;
+}
+
+static void copy_journal_save(t_copy_journal *job, u64 offset)
+{
+	job->offset = offset;
+	save_file(COPY_JOURNAL_FILE, (char*)job, sizeof(t_copy_journal));
+}
+
+// src_stat = stat of file1 already read with its directory entry (NULL = stat file1)
+static int64_t file_copy_stat(const char *file1, char *file2, const struct CellFsStat *src_stat)
 {
 	struct CellFsStat buf;
 	int fd1, fd2;
@@ -97,10 +226,12 @@ int64_t file_copy(const char *file1, char *file2)
 	if((is_ntfs1 = is_ntfs_path(file1)))
 	{
 		struct stat bufn;
-		if(ps3ntfs_stat(ntfs_path(file1), &bufn) >= 0) buf.st_size = bufn.st_size; else return FAILED;
+		if(ps3ntfs_stat(ntfs_path(file1), &bufn) >= 0) {buf.st_size = bufn.st_size, buf.st_mtime = bufn.st_mtime;} else return FAILED;
 	}
 	else
 	#endif
+	if(src_stat) buf = *src_stat; // stat from directory entry
+	else
 	if(cellFsStat(file1, &buf) != CELL_FS_SUCCEEDED)
 	{
 		#ifdef COBRA_NON_LITE
@@ -186,93 +317,154 @@ int64_t file_copy(const char *file1, char *file2)
 		}
 	}
 
-	u64 pos;
+	// large single files keep a journal to resume after unload, power loss or a removed device
+	t_copy_journal job; u64 resume_at = 0;
+	bool use_journal = (current_size >= COPY_JOURNAL_MIN) && !check_666 && (strlen(file2) <= STD_PATH_LEN);
+	if(use_journal)
+	{
+		_memset(&job, sizeof(t_copy_journal));
+		strncpy(job.src, file1, STD_PATH_LEN);
+		strcpy(job.dst, file2);
+		job.size = current_size, job.mtime = buf.st_mtime;
+
+		resume_at = copy_journal_offset(&job);
+	}
+
 	u8 merge_part = 0;
-	u32 chunk_size; sys_addr_t sysmem = NULL;
+	u32 mem_size; sys_addr_t sysmem = NULL;
 
-	if(g_free) {chunk_size = g_chunk_size, sysmem = g_sysmem, g_free = false;} else
+	if(g_free) {mem_size = g_chunk_size, sysmem = g_sysmem, g_free = false;} else
 	{
-		chunk_size = is_ntfs1 || (current_size <= _64KB_) ? _64KB_ : _128KB_;
-		sysmem = sys_mem_allocate(chunk_size);
-		if(!sysmem) {chunk_size = _64KB_; sys_mem_allocate(chunk_size);}
+		// small files: 1 buffer, no reader thread
+		mem_size = (current_size <= _64KB_) ? _64KB_ : (current_size <= _128KB_) ? _128KB_ : COPY_RING_SLOTS * (is_ntfs1 ? _64KB_ : _128KB_);
+		sysmem = sys_mem_allocate(mem_size);
+		if(!sysmem && (mem_size > COPY_RING_SLOTS * _64KB_)) {mem_size = COPY_RING_SLOTS * _64KB_; sysmem = sys_mem_allocate(mem_size);}
+		if(!sysmem && (mem_size > _64KB_)) {mem_size = _64KB_; sysmem = sys_mem_allocate(mem_size);}
 	}
 
 	if(sysmem)
 	{
+		t_copy_reader rd; sys_ppu_thread_t t_id = SYS_PPU_THREAD_NONE;
+		copy_reader_init(&rd, sysmem, mem_size);
+
 		++copy_in_progress;
 merge_next:
 		if(is_ntfs1 || (cellFsOpen(file1, CELL_FS_O_RDONLY, &fd1, NULL, 0) == CELL_FS_SUCCEEDED))
 		{
-			u64 size = current_size, part_size = current_size; u8 part = 0;
+			u64 size = current_size, part_size = current_size, written = 0, done = 0; u8 part = 0;
+			bool is_open, stopped = false;
+			u16 flen = strlen(file2);
 
-			if((part_size > 0xFFFFFFFFULL) && islike(file2, "/dev_usb"))
+			bool split = (part_size > 0xFFFFFFFFULL) && islike(file2, "/dev_usb");
+			if(split)
 			{
 				if(is_ext(file2, ".iso")) strcat(file2, ".0"); else strcat(file2, ".66600");
-				part++; part_size = 0xFFFF0000ULL; //4Gb - 64kb
+				flen = strlen(file2);
+				part++; part_size = COPY_PART_SIZE;
 			}
 
-			u64 read = 0, written = 0;
-			char *chunk = (char*)sysmem;
-			u16 flen = strlen(file2);
+			// continue an interrupted copy if the written part is still there
+			if(resume_at)
+			{
+				u8 cur_part = split ? (u8)(resume_at / COPY_PART_SIZE) : 0;
+				if(cur_part) set_part_name(file2, flen, cur_part);
+
+				u64 part_offset = split ? (resume_at % COPY_PART_SIZE) : resume_at;
+				if(!part_offset || (file_ssize(file2) >= (s64)part_offset))
+				{
+					done = resume_at, size -= resume_at, resume_at = part_offset;
+					if(split) {part = cur_part + 1; part_size = COPY_PART_SIZE - part_offset;} else part_size = size;
+				}
+				else
+				{
+					if(cur_part) set_part_name(file2, flen, 0);
+					resume_at = 0;
+				}
+			}
+
+			u64 saved = done;
+			t_id = copy_reader_start(&rd, fd1, is_ntfs1, done, size);
+
+			u8 slot = 0; u32 slot_pos = 0;
 next_part:
+			is_open = (merge_part > 0); // merged .666xx parts are appended to the open file
 			#ifdef USE_NTFS
 			if((is_ntfs2 = is_ntfs_path(file2)))
 			{
-				fd2 = ps3ntfs_open(ntfs_path(file2), O_CREAT | O_WRONLY | O_TRUNC, MODE);
+				fd2 = ps3ntfs_open(ntfs_path(file2), resume_at ? O_WRONLY : (O_CREAT | O_WRONLY | O_TRUNC), MODE);
 				if(fd2 < 0) is_ntfs2 = false;
+				else {is_open = true; if(resume_at) ps3ntfs_seek64(fd2, resume_at, SEEK_SET);}
 			}
+			else
 			#endif
+			if(resume_at && (cellFsOpen(file2, CELL_FS_O_WRONLY, &fd2, 0, 0) == CELL_FS_SUCCEEDED))
+			{
+				u64 pos; cellFsLseek(fd2, resume_at, CELL_FS_SEEK_SET, &pos); is_open = true;
+			}
+			resume_at = 0;
+
 			// copy_file
-			if(is_ntfs2 || merge_part || (cellFsOpen(file2, CELL_FS_O_CREAT | CELL_FS_O_WRONLY | CELL_FS_O_TRUNC, &fd2, 0, 0) == CELL_FS_SUCCEEDED))
+			if(is_open || (cellFsOpen(file2, CELL_FS_O_CREAT | CELL_FS_O_WRONLY | CELL_FS_O_TRUNC, &fd2, 0, 0) == CELL_FS_SUCCEEDED))
 			{
-				pos = 0;
 				while(size > 0)
 				{
 					if(copy_aborted) break;
+					if(!working) {stopped = true; break;}
 
-					#ifdef USE_NTFS
-					if(is_ntfs1)
-					{
-						ps3ntfs_seek64(fd1, pos, SEEK_SET);
-						read = ps3ntfs_read(fd1, (void *)chunk, chunk_size);
-					}
-					else
-					#endif
+					// next chunk: wait for the reader thread or read it inline
+					if(!slot_pos)
 					{
-						cellFsReadWithOffset(fd1, pos, chunk, chunk_size, &read);
+						if(t_id == SYS_PPU_THREAD_NONE)
+							copy_read_chunk(&rd, slot);
+						else
+						{
+							while(!rd.full[slot] && working && !copy_aborted) sys_ppu_thread_usleep(500);
+							if(!rd.full[slot]) continue;
+							__sync_synchronize();
+						}
+
+						if(!rd.len[slot]) {stopped = true; break;} // read error
 					}
 
-					if(!read) break;
+					u32 len = (u32)MIN(rd.len[slot] - slot_pos, part_size);
 
 					#ifdef USE_NTFS
 					if(is_ntfs2)
 					{
-						written = ps3ntfs_write(fd2, chunk, read);
+						int nwritten = ps3ntfs_write(fd2, rd.buf[slot] + slot_pos, len);
+						written = (nwritten > 0) ? nwritten : 0;
 					}
 					else
 					#endif
-					cellFsWrite(fd2, chunk, read, &written);
+					if(cellFsWrite(fd2, rd.buf[slot] + slot_pos, len, &written) != CELL_FS_SUCCEEDED) written = 0;
 
-					if(!written) break;
+					if(!written) {stopped = true; break;} // write error (device removed / disk full)
 
-					pos  += written;
-					size -= written;
+					size -= written, done += written;
+					part_size -= written;
 
-					if(chunk_size > size) chunk_size = (int) size;
+					// give the buffer back to the reader when fully written
+					slot_pos += written;
+					if(slot_pos >= rd.len[slot])
+					{
+						slot_pos = 0;
+						if(t_id != SYS_PPU_THREAD_NONE) {rd.full[slot] = 0; slot = (slot + 1) % COPY_RING_SLOTS;}
+						else sys_ppu_thread_usleep(1000);
+					}
 
-					part_size -= written;
-					if(part_size == 0) break;
+					if(use_journal && (done - saved >= COPY_JOURNAL_INTERVAL)) {copy_journal_save(&job, done); saved = done;}
 
-					sys_ppu_thread_usleep(1000);
+					if(part_size == 0) break;
 				}
 
-				if(check_666 && !copy_aborted && (merge_part < 99))
+				if(check_666 && !copy_aborted && !stopped && (merge_part < 99))
 				{
 					sprintf(file1_666, ".666%02i", ++merge_part);
 
 					current_size = file_size(file1);
 					if(current_size)
 					{
+						copy_reader_stop(&rd, &t_id);
 						cellFsClose(fd1);
 						goto merge_next;
 					}
@@ -284,7 +476,13 @@ next_part:
 				#endif
 				cellFsClose(fd2);
 
-				if(copy_aborted)
+				if(stopped) copy_interrupted = true;
+
+				if(stopped && use_journal)
+				{
+					copy_journal_save(&job, done); // keep the incomplete file to resume later
+				}
+				else if(copy_aborted || stopped)
 				{
 					#ifdef USE_NTFS
 					if(is_ntfs2) ps3ntfs_unlink(ntfs_path(file2));
@@ -294,20 +492,21 @@ next_part:
 				}
 				else if((part > 0) && (size > 0))
 				{
-					if(file2[flen - 2] == '.')
-						sprintf(file2 + flen - 2, ".%i", part);
-					else
-						sprintf(file2 + flen - 2, "%02i", part);
+					set_part_name(file2, flen, part);
 
-					part++; part_size = 0xFFFF0000ULL;
+					part++; part_size = COPY_PART_SIZE;
 					goto next_part;
 				}
 				else
 					{cellFsChmod(file2, MODE); copied_count++;}
 
-				ret = size;
+				if(use_journal && !stopped) cellFsUnlink(COPY_JOURNAL_FILE);
+
+				ret = stopped ? FAILED : (int64_t)size;
 			}
 
+			copy_reader_stop(&rd, &t_id);
+
 			#ifdef USE_NTFS
 			if(is_ntfs1) ps3ntfs_close(fd1);
 			else
@@ -317,7 +516,7 @@ next_part:
 		--copy_in_progress;
 	}
 
-	if(g_sysmem && !g_free)
+	if(sysmem && (sysmem == g_sysmem))
 		g_free = true;
 	else if(sysmem)
 		sys_memory_free(sysmem);
@@ -325,6 +524,12 @@ next_part:
 	return ret;
 }
 
+int64_t file_copy(const char *file1, char *file2);
+int64_t file_copy(const char *file1, char *file2)
+{
+	return file_copy_stat(file1, file2, NULL);
+}
+
 static void force_copy(const char *file1, char *file2)
 {
 	if(!file1 || !file2 || not_exists(file1)) return;
@@ -335,6 +540,8 @@ static void force_copy(const char *file1, char *file2)
 }
 
 #ifdef COPY_PS3
+#define COPY_JOB_FILE	WMTMP "/copy_job.txt"	// <source>|<target> of the running /copy.ps3 job (continued by /copy.ps3$resume)
+
 static void mkdir_tree(const char *full_path);
 static void normalize_path(char *path, bool slash);
 
@@ -401,13 +608,23 @@ static int recursive_folder_copy(const char *path1, char *path2)
 			sprintf(source + plen1, "/%s", entry_name);
 			sprintf(target + plen2, "/%s", entry_name);
 
-			if(isDir(source))
+			// use the metadata returned with the directory entry instead of a stat per file
+			bool is_dir;
+			#ifdef USE_NTFS
+			if(is_ntfs) is_dir = (bufn.st_mode & S_IFDIR);
+			else
+			#endif
+			is_dir = is_root ? isDir(source) : (entry.attribute.st_mode & S_IFDIR);
+
+			if(is_dir)
 			{
 				if(IS(source, "/dev_bdvd/PS3_UPDATE")) {cellFsMkdir(target, DMODE); continue;} // just create /PS3_UPDATE without its content
 				recursive_folder_copy(source, target);
 			}
 			else
-				file_copy(source, target);
+			{
+				file_copy_stat(source, target, (is_ntfs || is_root) ? NULL : &entry.attribute);
+			}
 		}
 
 		#ifdef USE_NTFS
@@ -423,8 +640,10 @@ static int recursive_folder_copy(const char *path1, char *path2)
 
 static int folder_copy(const char *path1, char *path2)
 {
-	if(!g_sysmem) {g_chunk_size = _256KB_; g_sysmem = sys_mem_allocate(g_chunk_size);}
-	if(!g_sysmem) {g_chunk_size = _128KB_; g_sysmem = sys_mem_allocate(g_chunk_size);}
+	// g_chunk_size is the size of the whole buffer ring shared by the files of the folder
+	if(!g_sysmem) {g_chunk_size = COPY_RING_SLOTS * _256KB_; g_sysmem = sys_mem_allocate(g_chunk_size);}
+	if(!g_sysmem) {g_chunk_size = COPY_RING_SLOTS * _128KB_; g_sysmem = sys_mem_allocate(g_chunk_size);}
+	if(!g_sysmem) {g_chunk_size = COPY_RING_SLOTS *  _64KB_; g_sysmem = sys_mem_allocate(g_chunk_size);}
 	if(!g_sysmem) {g_chunk_size =  _64KB_; g_sysmem = sys_mem_allocate(g_chunk_size);}
 	if( g_sysmem) g_free = true;
 
@@ -0,0 +1,262 @@
+#ifndef __ISO9660_H__
+#define __ISO9660_H__
+
+// ISO9660 + Joliet metadata reader shared by the ISO consumers (plugin, prepISO, ps3netsrv)
+// Portable C without allocations: the caller owns the reader, the directory block cache & the entries
+// Sectors are read through a callback; directory blocks are kept in a small LRU
+
+#include <stdint.h>
+#include <string.h>
+
+#define ISO9660_SECTOR		2048
+#define ISO9660_MAX_BLOCKS	8		// LRU slots (cache size / ISO9660_SECTOR)
+#define ISO9660_NAME_LEN	256
+
+// returns the bytes read at offset of the image
+typedef int (*iso9660_read_cb)(void *handle, uint64_t offset, void *buf, uint32_t size);
+
+typedef struct
+{
+	uint32_t lba;		// first sector of the extent
+	uint64_t size;		// bytes (all the extents of a multi-extent file)
+	uint8_t is_dir;
+	char name[ISO9660_NAME_LEN];	// without the ";1" version, UTF-8 for Joliet
+} iso9660_entry;
+
+typedef struct
+{
+	uint32_t lba, size;	// directory extent
+	uint32_t pos;		// offset of the next record
+} iso9660_dir;
+
+typedef struct
+{
+	iso9660_read_cb read;
+	void *handle;
+
+	iso9660_entry root;
+	uint32_t volume_sectors;
+	uint8_t joliet;
+
+	uint8_t *cache;		// blocks * ISO9660_SECTOR bytes
+	uint8_t blocks;
+	uint32_t block_lba[ISO9660_MAX_BLOCKS];
+	uint32_t block_stamp[ISO9660_MAX_BLOCKS];	// 0 = empty
+	uint32_t stamp;
+
+	uint32_t hits, misses;
+} iso9660_reader;
+
+// both-endian fields are read from the little endian half
+static uint32_t iso9660_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint8_t *iso9660_block(iso9660_reader *iso, uint32_t lba)
+{
+	uint8_t victim = 0;
+
+	if(iso->volume_sectors && (lba >= iso->volume_sectors)) return NULL;
+
+	for(uint8_t i = 0; i < iso->blocks; i++)
+	{
+		if(iso->block_stamp[i] && (iso->block_lba[i] == lba))
+		{
+			iso->block_stamp[i] = ++iso->stamp; iso->hits++;
+			return iso->cache + (i * ISO9660_SECTOR);
+		}
+		if(iso->block_stamp[i] < iso->block_stamp[victim]) victim = i;
+	}
+
+	iso->misses++;
+
+	uint8_t *block = iso->cache + (victim * ISO9660_SECTOR);
+
+	iso->block_stamp[victim] = 0;
+	if(iso->read(iso->handle, (uint64_t)lba * ISO9660_SECTOR, block, ISO9660_SECTOR) != ISO9660_SECTOR) return NULL;
+
+	iso->block_lba[victim] = lba;
+	iso->block_stamp[victim] = ++iso->stamp;
+
+	return block;
+}
+
+static void iso9660_record(iso9660_reader *iso, const uint8_t *record, iso9660_entry *entry)
+{
+	const uint8_t *name = record + 33; uint8_t len = record[32];
+	char *out = entry->name, *end = entry->name + ISO9660_NAME_LEN - 4;
+
+	entry->lba = iso9660_le32(record + 2);
+	entry->size = iso9660_le32(record + 10);
+	entry->is_dir = (record[25] & 2) ? 1 : 0;
+
+	if(iso->joliet)
+	{
+		// UCS-2 big endian
+		for(uint8_t i = 0; (i + 1 < len) && (out < end); i += 2)
+		{
+			uint16_t c = (name[i] << 8) | name[i + 1];
+			if(c < 0x80)  {*out++ = (char)c;} else
+			if(c < 0x800) {*out++ = (char)(0xC0 | (c >> 6)); *out++ = (char)(0x80 | (c & 0x3F));}
+			else		  {*out++ = (char)(0xE0 | (c >> 12)); *out++ = (char)(0x80 | ((c >> 6) & 0x3F)); *out++ = (char)(0x80 | (c & 0x3F));}
+		}
+	}
+	else
+	{
+		for(uint8_t i = 0; (i < len) && (out < end); i++) *out++ = (char)name[i];
+	}
+	*out = '\0';
+
+	// strip the ";1" version & the dot of the files without extension
+	if(!entry->is_dir)
+	{
+		char *ver = strrchr(entry->name, ';'); if(ver) *ver = '\0';
+		size_t n = strlen(entry->name); if((n > 1) && (entry->name[n - 1] == '.')) entry->name[n - 1] = '\0';
+	}
+}
+
+// next directory record (valid until the next block is read), NULL at the end of the directory
+static const uint8_t *iso9660_next_record(iso9660_reader *iso, iso9660_dir *dir)
+{
+	while(dir->pos < dir->size)
+	{
+		uint32_t offset = dir->pos % ISO9660_SECTOR;
+
+		const uint8_t *block = iso9660_block(iso, dir->lba + (dir->pos / ISO9660_SECTOR));
+		if(!block) return NULL;
+
+		const uint8_t *record = block + offset; uint8_t len = record[0];
+
+		if((len < 34) || (offset + len > ISO9660_SECTOR) || (33 + record[32] > len))
+		{
+			dir->pos += ISO9660_SECTOR - offset; // the rest of the sector is padding
+			continue;
+		}
+
+		dir->pos += len;
+		return record;
+	}
+
+	return NULL;
+}
+
+static int iso9660_opendir(const iso9660_entry *entry, iso9660_dir *dir)
+{
+	if(!entry->is_dir) return -1;
+
+	dir->lba = entry->lba, dir->size = (uint32_t)entry->size, dir->pos = 0;
+	return 0;
+}
+
+// 1 = entry read, 0 = end of directory (or read error)
+static int iso9660_readdir(iso9660_reader *iso, iso9660_dir *dir, iso9660_entry *entry)
+{
+	const uint8_t *record;
+
+	while((record = iso9660_next_record(iso, dir)))
+	{
+		if((record[32] == 1) && (record[33] <= 1)) continue; // "." & ".."
+
+		iso9660_record(iso, record, entry);
+
+		// the following records of a multi-extent file only add their size
+		while((record[25] & 0x80) && (record = iso9660_next_record(iso, dir))) entry->size += iso9660_le32(record + 10);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static int iso9660_namecmp(const char *name, const char *path, size_t len)
+{
+	for(size_t i = 0; i < len; i++)
+	{
+		char a = name[i], b = path[i];
+		if((a >= 'a') && (a <= 'z')) a -= 0x20;
+		if((b >= 'a') && (b <= 'z')) b -= 0x20;
+		if(a != b) return 1;
+	}
+
+	return name[len] != '\0';
+}
+
+// look up a path (e.g. "/PS3_GAME/PARAM.SFO") ignoring case & versions; 1 = found
+static int iso9660_find(iso9660_reader *iso, const char *path, iso9660_entry *entry)
+{
+	iso9660_dir dir;
+
+	*entry = iso->root;
+
+	while(*path)
+	{
+		while(*path == '/') path++;
+		if(!*path) break;
+
+		const char *sep = strchr(path, '/');
+		size_t len = sep ? (size_t)(sep - path) : strlen(path);
+
+		if(iso9660_opendir(entry, &dir)) return 0;
+
+		int found = 0;
+		while(iso9660_readdir(iso, &dir, entry))
+		{
+			if(!iso9660_namecmp(entry->name, path, len)) {found = 1; break;}
+		}
+		if(!found) return 0;
+
+		path += len;
+	}
+
+	return 1;
+}
+
+// reads from a file extent, returns the bytes read
+static int iso9660_read_file(iso9660_reader *iso, const iso9660_entry *entry, uint64_t offset, void *buf, uint32_t size)
+{
+	if(offset >= entry->size) return 0;
+	if(size > entry->size - offset) size = (uint32_t)(entry->size - offset);
+
+	return iso->read(iso->handle, ((uint64_t)entry->lba * ISO9660_SECTOR) + offset, buf, size);
+}
+
+// parse the volume descriptors: Joliet is preferred to the primary directory tree
+// cache holds the LRU directory blocks (at least one sector); returns 0 or -1 if not an ISO9660 image
+static int iso9660_open(iso9660_reader *iso, iso9660_read_cb read, void *handle, void *cache, uint32_t cache_size)
+{
+	memset(iso, 0, sizeof(iso9660_reader));
+
+	iso->read = read, iso->handle = handle;
+	iso->cache = (uint8_t *)cache;
+	iso->blocks = (cache_size / ISO9660_SECTOR) > ISO9660_MAX_BLOCKS ? ISO9660_MAX_BLOCKS : (uint8_t)(cache_size / ISO9660_SECTOR);
+
+	if(!iso->blocks) return -1;
+
+	int found = 0;
+
+	for(uint32_t lba = 16; lba < 32; lba++)
+	{
+		const uint8_t *vd = iso9660_block(iso, lba);
+		if(!vd || memcmp(vd + 1, "CD001", 5) || (vd[0] == 0xFF)) break;
+
+		uint8_t is_joliet = (vd[0] == 2) && (vd[88] == '%') && (vd[89] == '/') && ((vd[90] == '@') || (vd[90] == 'C') || (vd[90] == 'E'));
+
+		if((vd[0] == 1) || (is_joliet && !iso->joliet))
+		{
+			if(vd[0] == 1) iso->volume_sectors = iso9660_le32(vd + 80);
+
+			if(!found || is_joliet)
+			{
+				iso->joliet = is_joliet;
+				iso9660_record(iso, vd + 156, &iso->root);
+				iso->root.name[0] = '\0';
+			}
+			found = 1;
+		}
+	}
+
+	return (found && iso->root.is_dir) ? 0 : -1;
+}
+
+#endif // __ISO9660_H__
@@ -1,42 +1,228 @@
+#if defined(CALC_MD5) || defined(GZIP_HTML)
+static u32 crc32_table[256];
+
+static u32 crc32_update(u32 crc, const u8 *data, u32 len)
+{
+	if(!crc32_table[1])
+	{
+		for(u32 n = 0; n < 256; n++)
+		{
+			u32 c = n;
+			for(u8 k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+			crc32_table[n] = c;
+		}
+	}
+
+	crc = ~crc;
+	while(len--) crc = crc32_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+#endif
+
 #ifdef CALC_MD5
 
 #include <cell/hash/libmd5.h>
+#include <cell/hash/libsha1.h>
 
-static void calc_md5(const char *filename, char *md5)
+#define HASH_STATE_FILE		WMTMP "/hash_state.bin"
+#define HASH_SAVE_INTERVAL	0x40000000ULL	// save progress of resumable hashes every 1GB
+
+#define HASH_SHA1			1
+#define HASH_CRC32			2
+
+typedef struct
+{
+	char path[STD_PATH_LEN + 1];
+	u64 size;
+	u64 mtime; // a file rewritten with the same size is hashed again
+	u64 offset; // bytes already hashed
+	u8  digests; // HASH_SHA1 | HASH_CRC32 being computed (MD5 is always computed)
+	u32 crc;
+	CellMd5WorkArea  md5;
+	CellSha1WorkArea sha1;
+} t_hash_state;
+
+// double buffer: hash_reader_thread fills one buffer while the caller hashes the other
+typedef struct
+{
+	int fd;
+	u8 *buf[2];
+	u64 len[2];
+	vu8 full[2];
+	vu8 abort;
+	size_t buffer_size;
+} t_hash_reader;
+
+static void hash_reader_thread(u64 arg)
 {
-	u64 _md5[2] = {0, 0};
+	t_hash_reader *rd = (t_hash_reader*)(u32)arg;
 
-	size_t buffer_size = _256KB_; sys_addr_t sysmem = sys_mem_allocate(buffer_size);
-	if(!sysmem) {buffer_size = _128KB_; sysmem = sys_mem_allocate(buffer_size);}
-	if(!sysmem) {buffer_size =  _64KB_; sysmem = sys_mem_allocate(buffer_size);}
-	if( sysmem)
+	for(u8 i = 0; ; i ^= 1)
 	{
-		int fd;
+		while(rd->full[i] && !rd->abort) sys_ppu_thread_usleep(500);
+		if(rd->abort) break;
 
-		if(cellFsOpen(filename, CELL_FS_O_RDONLY, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+		u64 nread = 0;
+		if(cellFsRead(rd->fd, rd->buf[i], rd->buffer_size, &nread) != CELL_FS_SUCCEEDED) nread = 0;
+
+		rd->len[i] = nread;
+		__sync_synchronize(); // publish buffer before flag
+		rd->full[i] = 1;
+
+		if(!nread) break; // EOF or error
+	}
+
+	sys_ppu_thread_exit(0);
+}
+
+// MD5, SHA-1 & CRC32 in one pass; sha1/crc are optional
+// resume: continue from HASH_STATE_FILE if it belongs to the same file & save progress there
+static bool calc_hashes(const char *filename, u8 *md5, u8 *sha1, u32 *crc, bool resume)
+{
+	bool ret = false;
+
+	size_t buffer_size = _256KB_; sys_addr_t sysmem = sys_mem_allocate(buffer_size * 2);
+	if(!sysmem) {buffer_size = _128KB_; sysmem = sys_mem_allocate(buffer_size * 2);}
+	if(!sysmem) {buffer_size =  _64KB_; sysmem = sys_mem_allocate(buffer_size * 2);}
+	if(!sysmem) return ret;
+
+	t_hash_state state; t_hash_reader rd;
+	_memset(&rd, sizeof(t_hash_reader));
+
+	u8 digests = (sha1 ? HASH_SHA1 : 0) | (crc ? HASH_CRC32 : 0);
+
+	struct CellFsStat buf;
+	if((cellFsStat(filename, &buf) == CELL_FS_SUCCEEDED) && (cellFsOpen(filename, CELL_FS_O_RDONLY, &rd.fd, NULL, 0) == CELL_FS_SUCCEEDED))
+	{
+		if(!resume || (read_file(HASH_STATE_FILE, (char*)&state, sizeof(t_hash_state), 0) != sizeof(t_hash_state)) ||
+			!IS(state.path, filename) || (state.size != (u64)buf.st_size) || (state.mtime != (u64)buf.st_mtime) || (state.offset > state.size) ||
+			(state.digests != digests)) // a state without the SHA-1/CRC32 progress can't resume a full hash
 		{
-			CellMd5WorkArea workarea;
+			_memset(&state, sizeof(t_hash_state));
+			strncpy(state.path, filename, STD_PATH_LEN);
+			state.size = buf.st_size;
+			state.mtime = buf.st_mtime;
+			state.digests = digests;
+			cellMd5BlockInit(&state.md5);
+			cellSha1BlockInit(&state.sha1);
+		}
 
-			cellMd5BlockInit(&workarea);
+		u64 pos, saved = state.offset;
+		cellFsLseek(rd.fd, state.offset, CELL_FS_SEEK_SET, &pos);
 
-			u8 *buf = (u8 *)sysmem;
+		rd.buf[0] = (u8*)sysmem;
+		rd.buf[1] = (u8*)sysmem + buffer_size;
+		rd.buffer_size = buffer_size;
 
-			for(u64 nread = buffer_size; nread > 0; )
+		sys_ppu_thread_t t_id;
+		if(sys_ppu_thread_create(&t_id, hash_reader_thread, (u64)(u32)&rd, THREAD_PRIO, THREAD_STACK_SIZE_8KB, SYS_PPU_THREAD_CREATE_JOINABLE, THREAD_NAME_HASH) == CELL_OK)
+		{
+			for(u8 i = 0; working; i ^= 1)
 			{
-				cellFsRead(fd, buf, buffer_size, &nread);
+				while(!rd.full[i] && working) sys_ppu_thread_usleep(500);
+				if(!rd.full[i]) break;
+
+				__sync_synchronize();
+				u64 nread = rd.len[i];
+				if(!nread) {ret = (state.offset == state.size); break;}
+
+				cellMd5BlockUpdate(&state.md5, rd.buf[i], nread);
+				if(sha1) cellSha1BlockUpdate(&state.sha1, rd.buf[i], nread);
+				if(crc)  state.crc = crc32_update(state.crc, rd.buf[i], nread);
+				state.offset += nread;
 
-				cellMd5BlockUpdate(&workarea, buf, nread);
+				rd.full[i] = 0; // give buffer back to the reader
+
+				if(resume && (state.offset - saved >= HASH_SAVE_INTERVAL))
+				{
+					save_file(HASH_STATE_FILE, (char*)&state, sizeof(t_hash_state)); saved = state.offset;
+				}
 			}
 
-			cellFsClose(fd);
-			cellMd5BlockResult(&workarea, (u8*)_md5);
+			rd.abort = 1;
+			thread_join(t_id);
 		}
 
-		sys_memory_free(sysmem);
+		cellFsClose(rd.fd);
+
+		if(ret)
+		{
+			cellMd5BlockResult(&state.md5, md5);
+			if(sha1) cellSha1BlockResult(&state.sha1, sha1);
+			if(crc) *crc = state.crc;
+			if(resume) cellFsUnlink(HASH_STATE_FILE);
+		}
+		else if(resume && state.offset)
+			save_file(HASH_STATE_FILE, (char*)&state, sizeof(t_hash_state)); // interrupted: resume next time
 	}
 
+	sys_memory_free(sysmem);
+	return ret;
+}
+
+static void hash_to_str(char *str, const u8 *hash, u8 len)
+{
+	for(u8 n = 0; n < len; n++) str += sprintf(str, "%02x", hash[n]);
+	*str = NULL;
+}
+
+static void calc_md5(const char *filename, char *md5)
+{
+	u8 _md5[16]; _memset(_md5, sizeof(_md5));
+
+	calc_hashes(filename, _md5, NULL, NULL, false);
+
 	// return md5 hash as a string
-	sprintf(md5, "%016llx%016llx", _md5[0], _md5[1]);
+	hash_to_str(md5, _md5, 16);
+}
+
+// find md5 in a Redump / No-Intro DAT (xml) and copy the rom name of the matching entry
+static bool find_hash_in_dat(const char *dat_file, const char *md5, char *rom_name, u16 max_len)
+{
+	bool found = false; *rom_name = NULL;
+
+	#define DAT_OVERLAP	_2KB_ // keep the tail of the previous window to catch entries split between reads
+
+	sys_addr_t sysmem = sys_mem_allocate(_64KB_);
+	if(!sysmem) return found;
+
+	char *buffer = (char*)sysmem; int fd;
+
+	if(cellFsOpen(dat_file, CELL_FS_O_RDONLY, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+	{
+		u64 nread, keep = 0;
+
+		while(working && (cellFsRead(fd, buffer + keep, _64KB_ - keep - 1, &nread) == CELL_FS_SUCCEEDED) && nread)
+		{
+			u64 len = keep + nread; buffer[len] = NULL;
+
+			char *pos = strcasestr(buffer, md5);
+			if(pos)
+			{
+				// walk back to the start of the <rom ... /> element
+				*pos = NULL; char *rom = buffer, *p;
+				for(p = buffer; (p = strstr(p, "<rom ")); p++) rom = p;
+
+				char *name = strstr(rom, "name=\"");
+				if(name)
+				{
+					name += 6; u16 n = 0;
+					while(name[n] && (name[n] != '"') && (n < max_len - 1)) {rom_name[n] = name[n]; n++;}
+					rom_name[n] = NULL;
+				}
+				found = true; break;
+			}
+
+			keep = MIN(len, DAT_OVERLAP);
+			memmove(buffer, buffer + len - keep, keep);
+		}
+		cellFsClose(fd);
+	}
+
+	#undef DAT_OVERLAP
+
+	sys_memory_free(sysmem);
+	return found;
 }
 
 #endif
@@ -1352,7 +1352,7 @@ static void handleclient_ftp(u64 conn_s_ftp_p)
 
 								#ifdef COBRA_ONLY
 								if(strcasestr(filename, ".iso"))
-									fix_iso(param, 0x100000UL, false);
+									fix_iso(param, false);
 								else
 								#endif
 									fix_game(param, filename, FIX_GAME_FORCED);
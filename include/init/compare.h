@@ -29,29 +29,45 @@ static bool islike(const char *param, const char *text)
 }
 
 #if defined(PS3MAPI) || defined(DEBUG_MEM)
-static u64 faster_find(const char *find, int len, char *mask)
+static bool bcompare(const char *a, const char *b, u8 len, const char *mask)
+{
+	while(len && ((*a++ == *b++) || (*mask == '?'))) {mask++,len--;}
+	return len;
+}
+
+// first offset in [pos, last] (every step bytes) where mem matches find ('?' in mask = any byte), -1 if not found
+// mem must hold last + len bytes. The first byte of find that is not masked is searched 8 bytes at a time
+static s32 find_masked(const char *mem, u32 pos, u32 last, u8 step, const char *find, u8 len, const char *mask)
 {
-	if(!mask || !find) return 0;
+	u8 k = 0; while((k < len) && (mask[k] == '?')) k++;
+	if(k >= len) return (pos <= last) ? (s32)pos : NONE; // only wildcards
 
-	u64 faster = *(u64*)find; // first 64bits
+	const u8 c = (u8)find[k];
+	const u8 *anchor = (const u8*)mem + k;
+
+	if(step == 1)
+	{
+		const u64 ones = 0x0101010101010101ULL, pattern = c * ones;
 
-	replace_char(mask, '*', '?'); // use single type of wildcard
+		while(pos <= last)
+		{
+			// skip 8 positions if none of them has the byte
+			if(((last - pos) >= 8) && !((u32)(anchor + pos) & 7))
+			{
+				u64 x = *(u64*)(anchor + pos) ^ pattern;
+				if(!((x - ones) & ~x & (ones << 7))) {pos += 8; continue;}
+			}
 
-	if(len < 8)
-		faster = 0; // do not fast find if len < 8
+			if((anchor[pos] == c) && !bcompare(mem + pos, find, len, mask)) return (s32)pos;
+			pos++;
+		}
+	}
 	else
 	{
-		char s = mask[8]; mask[8] = '\0'; // truncate to search only first 8 characters
-		if(strchr(mask, '?')) faster = 0; // do not fast find if using mask
-		mask[8] = s; // restore mask
+		for(; pos <= last; pos += step)
+			if((anchor[pos] == c) && !bcompare(mem + pos, find, len, mask)) return (s32)pos;
 	}
 
-	return faster;
-}
-
-static bool bcompare(const char *a, const char *b, u8 len, const char *mask)
-{
-	while(len && ((*a++ == *b++) || (*mask == '?'))) {mask++,len--;}
-	return len;
+	return NONE;
 }
 #endif
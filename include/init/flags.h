@@ -25,6 +25,7 @@
   #undef NET_SUPPORT
   #undef DEBUG_XREGISTRY
   #undef VIEW_PARAM_SFO
+  #undef GZIP_HTML
  #endif
 #else
  #undef WM_PROXY_SPRX
@@ -493,3 +493,45 @@ static size_t prepare_header(char *buffer, const char *param, u8 is_binary)
 
 	return header.size;
 }
+
+#include "../www/http_range.h"
+
+#define HTTP_BOUNDARY		"WMBYTERANGES"
+
+// copy the value of a request header field (field = "\nName:") or empty string if not found
+static void get_header_value(const char *header, const char *field, char *value, u8 max_len)
+{
+	*value = NULL;
+
+	const char *pos = strcasestr(header, field); if(!pos) return;
+
+	for(pos += strlen(field); *pos == ' '; pos++);
+
+	u8 n = 0; max_len--;
+	while(pos[n] && (pos[n] != '\r') && (pos[n] != '\n') && (n < max_len)) {value[n] = pos[n]; n++;}
+	value[n] = NULL;
+}
+
+// RFC 7231 date (e.g. "Sun, 06 Nov 1994 08:49:37 GMT") used by Last-Modified / If-Modified-Since
+static void http_date(char *date, u64 mtime)
+{
+	const char *wday[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+	CellRtcDateTime rDate;
+	cellRtcSetTime_t(&rDate, mtime);
+	int dow = cellRtcGetDayOfWeek(rDate.year, rDate.month, rDate.day);
+
+	sprintf(date, "%s, %02i %s %04i %02i:%02i:%02i GMT", wday[dow % 7], rDate.day, smonth[(rDate.month - 1) % 12], rDate.year, rDate.hour, rDate.minute, rDate.second);
+}
+
+// replace the status of the response line "HTTP/1.1 200 OK\r\n" built by prepare_header
+static size_t set_http_status(char *header, size_t header_len, const char *status)
+{
+	char *eol = strstr(header, "\r\n"); if(!eol) return header_len;
+
+	char *code = header + 9; size_t len = strlen(status);
+	memmove(code + len, eol, header_len - (eol - header) + 1);
+	memcpy(code, status, len);
+
+	return header_len + len - (eol - code);
+}
@@ -79,6 +79,7 @@
 #define FILE_LIST_HTM		WMTMP "/filelist.htm"
 
 #define SLAUNCH_FILE		WMTMP "/slist.bin"
+#define SLAUNCH_IDX			WMTMP "/slist.idx"				// sort orders & search filter of slist.bin
 #define DEL_CACHED_ISO		WMTMP "/deliso.txt"
 
 #define LAST_GAME_TXT		WMTMP "/last_game.txt"
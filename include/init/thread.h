@@ -3,6 +3,7 @@
 #define SYS_EVENT_QUEUE_NONE       (sys_event_queue_t)NONE
 #define SYS_DEVICE_HANDLE_NONE     (sys_device_handle_t)NONE
 #define SYS_MEMORY_CONTAINER_NONE  (sys_memory_container_t)NONE
+#define SYS_MUTEX_NONE             (sys_mutex_t)NONE
 
 //////////////////////////////////////
 
@@ -19,6 +20,8 @@
 #define THREAD_NAME_INSTALLPKG	"install_pkg"
 #define THREAD_NAME_NETSVR		"netsvr"
 #define THREAD_NAME_NETSVRD		"netsvrd"
+#define THREAD_NAME_HASH		"hash_reader"
+#define THREAD_NAME_COPY		"copy_reader"
 
 #define STOP_THREAD_NAME 		"wwwds"
 
@@ -78,6 +81,7 @@ static sys_ppu_thread_t thread_id_art = SYS_PPU_THREAD_NONE;
 #endif
 
 #define MAX_WWW_THREADS		(8)
+#define WWW_WORKERS			(2)	// persistent web workers fed by the accept queue (extra clients get their own thread)
 #define MAX_FTP_THREADS		(10)
 
 static void thread_join(sys_ppu_thread_t thread_id)
@@ -85,4 +89,58 @@ static void thread_join(sys_ppu_thread_t thread_id)
 	u64 exit_code;
 	if(thread_id != SYS_PPU_THREAD_NONE)
 		sys_ppu_thread_join(thread_id, &exit_code);
+}
+
+//////////////////////////////////////
+// mutexes of the data shared by the web clients (created by wwwd_thread)
+// the data is used without lock if the mutex could not be created
+
+static sys_mutex_t www_mutex = SYS_MUTEX_NONE; // idle workers of the web worker pool
+static sys_mutex_t covers_mutex = SYS_MUTEX_NONE; // published cover index (games_covers.h)
+static sys_mutex_t sfo_mutex = SYS_MUTEX_NONE; // PARAM.SFO info cache (param_sfo.h)
+static sys_mutex_t memscan_mutex = SYS_MUTEX_NONE; // memory search session (mem_search.h)
+
+static void create_mutex(sys_mutex_t *mutex)
+{
+	sys_mutex_attribute_t attr;
+	sys_mutex_attribute_initialize(attr);
+	if(sys_mutex_create(mutex, &attr) != CELL_OK) *mutex = SYS_MUTEX_NONE;
+}
+
+static void destroy_mutex(sys_mutex_t *mutex)
+{
+	sys_mutex_t id = *mutex; *mutex = SYS_MUTEX_NONE;
+	if(id != SYS_MUTEX_NONE) sys_mutex_destroy(id);
+}
+
+static void mutex_lock(sys_mutex_t mutex)
+{
+	if(mutex != SYS_MUTEX_NONE) sys_mutex_lock(mutex, 0);
+}
+
+// returns false if the mutex is locked by other thread
+static bool mutex_trylock(sys_mutex_t mutex)
+{
+	return (mutex == SYS_MUTEX_NONE) || (sys_mutex_trylock(mutex) == CELL_OK);
+}
+
+static void mutex_unlock(sys_mutex_t mutex)
+{
+	if(mutex != SYS_MUTEX_NONE) sys_mutex_unlock(mutex);
+}
+
+static void create_mutexes(void)
+{
+	create_mutex(&www_mutex);
+	create_mutex(&covers_mutex);
+	create_mutex(&sfo_mutex);
+	create_mutex(&memscan_mutex);
+}
+
+static void destroy_mutexes(void)
+{
+	destroy_mutex(&www_mutex);
+	destroy_mutex(&covers_mutex);
+	destroy_mutex(&sfo_mutex);
+	destroy_mutex(&memscan_mutex);
 }
\ No newline at end of file
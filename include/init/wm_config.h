@@ -121,7 +121,9 @@ typedef struct
 	char neth[5][16]; //ip 255.255.255.255
 
 	u8 nsd;
-	u8 padding8[32];
+	u8 netiso_window; // 0=default (8 reads in flight), 1=protocol v1, 2-16=tagged reads in flight (protocol v2)
+	u8 netiso_compress; // 0=raw transfers, 1=compressed transfer mode (protocol v2)
+	u8 padding8[30];
 
 	// mount settings
 
@@ -1,101 +1,55 @@
 //#define MAX_TRACKS	98 <- defined in cobra.h
 
 #ifdef COBRA_ONLY
-static int parse_lba(const char *templn, int ret_value)
-{
-	char *time = strrchr(templn, ' '); if(!time) return ret_value;
-	char tcode[10]; // mm:ss:ff
-
-	int tcode_len = snprintf(tcode, 8, "%s", time + 1); tcode[8] = '\0';
-	if((tcode_len != 8) || tcode[2]!=':' || tcode[5]!=':') return ret_value;
-
-	unsigned int tmin, tsec, tfrm;
-	tmin = val(tcode);     // (tcode[0] & 0x0F)*10 + (tcode[1] & 0x0F); // 0-98
-	tsec = val(tcode + 3); // (tcode[3] & 0x0F)*10 + (tcode[4] & 0x0F); // 0-59
-	tfrm = val(tcode + 6); // (tcode[6] & 0x0F)*10 + (tcode[7] & 0x0F); // 0-74
-
-	return ((((tmin * 60) + tsec) * 75) + tfrm); // msf_to_lba
-}
-
-static int get_line(char *templn, const char *cue_buf, const int buf_size, const int start)
-{
-	int l = 0;
-	int len = MIN(buf_size, MAX_LINE_LEN);
-
-	int lp = start;
-	bool eol = false;
-
-	for(; lp < buf_size; lp++)
-	{
-		if(!cue_buf[lp]) break;
-
-		if(cue_buf[lp] != '\n' && cue_buf[lp] != '\r')
-		{
-			if(eol) break;
-			if(l < len) templn[l++] = cue_buf[lp];
-		}
-		else
-			eol = true;
-	}
-
-	templn[l] = '\0';
-
-	if(l) return lp;
-
-	return NONE;
-}
+#include "cue_sheet.h"
 
-static unsigned int parse_cue(char *templn, const char *cue_buf, const int cue_size, TrackDef *tracks)
+// tracks of a .cue / .ccd (1 data track if the sheet has no tracks)
+// file_sectors = sectors of each FILE of a multi-bin sheet joined by the mount (NULL = only the 1st FILE is mounted)
+static unsigned int parse_cue(const char *cue_buf, int cue_size, TrackDef *tracks, const u32 *file_sectors, u8 num_files)
 {
-	if(!cue_buf || !templn || !tracks) return 1; // default 1 track
+	if(!tracks) return 1; // default 1 track
 
+	cue_track sheet[MAX_TRACKS];
 	unsigned int num_tracks = 0;
+	u8 files = 0;
 
 	tracks[0].lba = 0;
 	tracks[0].is_audio = 0;
 
-	if(cue_size > 16)
-	{
-		int lba, lp = 0, off = 0, len;
-
-		int pregap = 0;
-
-		while(lp < cue_size)
-		{
-			lp = get_line(templn, cue_buf, cue_size, lp);
+	if(cue_buf && (cue_size > 16))
+		num_tracks = cue_parse(cue_buf, cue_size, sheet, MAX_TRACKS, &files);
 
-			if(lp < 1) break;
-			if(*templn == NULL) continue;
-
-			lba = NONE;
-
-			if(strstr(templn, "INDEX 1=")) lba = get_valuen32(templn, "INDEX 1="); else // ccd frames
-			if(strstr(templn, "INDEX 01") || strstr(templn, "INDEX 1 "))
-			{
-				len = lba = parse_lba(templn, FAILED); // cue msf
-				if((lba < off) || !num_tracks)
-					lba = off + pregap; // INDEX 01 is a track length, instead of lba in msf
-				else
-					len = 0;			// INDEX 01 is absolute LBA in MSF
-				off = lba + len;
-			}
-
-			if(lba < 0) continue;
+	if(files > 1)
+	{
+		if(!file_sectors || (num_files < files)) num_files = 1;
 
-			if(num_tracks)
-			{
-				tracks[num_tracks].lba = lba;
-				tracks[num_tracks].is_audio = 1;
-			}
+		// tracks of the files that are not mounted are dropped
+		unsigned int t = 0;
+		while((t < num_tracks) && (sheet[t].file < num_files)) t++;
+		num_tracks = t;
 
-			pregap = 150; // (2 * 75) -> 2 secs * 75 frames/sec
+		if(num_files > 1) cue_resolve(sheet, num_tracks, file_sectors);
+	}
 
-			num_tracks++; if(num_tracks >= MAX_TRACKS) break;
-		}
+	for(unsigned int t = 0; t < num_tracks; t++)
+	{
+		tracks[t].lba = sheet[t].lba;
+		tracks[t].is_audio = sheet[t].audio;
 	}
 
 	if(!num_tracks) num_tracks++;
 
 	return num_tracks;
 }
+
+// table of contents of the disc for rawseciso / netiso
+static void set_scsi_tracks(ScsiTrackDescriptor *scsi_tracks, const TrackDef *tracks, unsigned int num_tracks)
+{
+	for(unsigned int t = 0; t < num_tracks; t++)
+	{
+		scsi_tracks[t].adr_control = (t && tracks[t].is_audio) ? 0x10 : 0x14;
+		scsi_tracks[t].track_number = t + 1;
+		scsi_tracks[t].track_start_addr = t ? tracks[t].lba : 0;
+	}
+}
 #endif
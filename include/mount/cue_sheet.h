@@ -0,0 +1,184 @@
+#ifndef __CUE_SHEET_H__
+#define __CUE_SHEET_H__
+
+// Track table of a cue sheet (used by cue_file.h for the PSX/PS2 mounts)
+// Portable C: the text of a .cue or .ccd is parsed in a single pass, without copying its lines
+//   .cue   FILE "name" BINARY | TRACK nn MODE2/2352 | AUDIO | INDEX 01 mm:ss:ff
+//   .ccd   [TRACK n] | MODE=0 (audio) | INDEX 1=<lba>
+// The INDEX 01 of a multi-bin sheet is relative to the start of its FILE:
+// cue_resolve() adds the sectors of the previous files, as the files are joined by the mount
+
+#include <stdint.h>
+#include <string.h>
+
+#define CUE_PREGAP	150		// 2 secs * 75 frames/sec
+
+typedef struct
+{
+	uint32_t lba;			// first sector of the track (INDEX 01)
+	uint8_t  file;			// FILE of the track (0 in .ccd)
+	uint8_t  audio;
+} cue_track;
+
+static inline const char *cue_skip_spaces(const char *p, const char *end)
+{
+	while((p < end) && ((*p == ' ') || (*p == '\t'))) p++;
+	return p;
+}
+
+static inline int cue_is(const char *p, const char *end, const char *keyword, uint8_t len)
+{
+	if((end - p) < len) return 0;
+	for(uint8_t i = 0; i < len; i++)
+	{
+		char c = ((p[i] >= 'a') && (p[i] <= 'z')) ? (p[i] - 0x20) : p[i];
+		if(c != keyword[i]) return 0; // upper case keyword, case insensitive
+	}
+	return 1;
+}
+
+static inline uint32_t cue_number(const char **p, const char *end)
+{
+	uint32_t n = 0;
+	for(; (*p < end) && (**p >= '0') && (**p <= '9'); (*p)++) n = (n * 10) + (**p - '0');
+	return n;
+}
+
+// mm:ss:ff -> sectors (-1 if it isn't a time code)
+static int32_t cue_msf(const char *p, const char *end)
+{
+	uint32_t msf[3];
+
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		const char *start = p;
+		msf[i] = cue_number(&p, end);
+		if(p == start) return -1;
+		if(i < 2) {if((p >= end) || (*p != ':')) return -1; p++;}
+	}
+
+	return (int32_t)((((msf[0] * 60) + msf[1]) * 75) + msf[2]);
+}
+
+/***********************************************************************
+* parse a .cue / .ccd
+* tracks = table of max_tracks entries
+* files  = number of FILE entries of the sheet (0 in .ccd)
+* returns the number of tracks (0 if none was found)
+***********************************************************************/
+static uint8_t cue_parse(const char *buf, uint32_t size, cue_track *tracks, uint8_t max_tracks, uint8_t *files)
+{
+	const char *p = buf, *end = buf + size;
+	uint8_t num_tracks = 0, num_files = 0;
+	int8_t audio = -1; // type of the next track (-1 = not given)
+
+	for(const char *eol; p < end; p = eol + 1)
+	{
+		for(eol = p; (eol < end) && *eol && (*eol != '\n') && (*eol != '\r'); eol++) ;
+		if((eol < end) && !*eol) end = eol; // text ends at NUL
+
+		p = cue_skip_spaces(p, eol);
+
+		if(cue_is(p, eol, "FILE ", 5))
+		{
+			if(num_files < 0xFF) num_files++;
+		}
+		else if(cue_is(p, eol, "TRACK ", 6))
+		{
+			p = cue_skip_spaces(p + 6, eol); cue_number(&p, eol); p = cue_skip_spaces(p, eol);
+			audio = cue_is(p, eol, "AUDIO", 5);
+		}
+		else if(cue_is(p, eol, "[TRACK ", 7))
+			audio = -1;
+		else if(cue_is(p, eol, "MODE=", 5))
+			audio = ((p + 5 < eol) && (p[5] == '0'));
+		else if(cue_is(p, eol, "INDEX", 5))
+		{
+			p = cue_skip_spaces(p + 5, eol);
+			if(cue_number(&p, eol) != 1) continue; // INDEX 00 (pregap), INDEX 02+
+
+			int32_t lba;
+			if((p < eol) && (*p == '='))
+				{p++; lba = (int32_t)cue_number(&p, eol);} // ccd frames
+			else
+				lba = cue_msf(cue_skip_spaces(p, eol), eol);  // cue msf
+
+			if(lba < 0) continue;
+
+			tracks[num_tracks].lba = (uint32_t)lba;
+			tracks[num_tracks].file = num_files ? (num_files - 1) : 0;
+			tracks[num_tracks].audio = (audio < 0) ? (num_tracks > 0) : audio;
+			audio = -1;
+
+			if(++num_tracks >= max_tracks) break;
+		}
+	}
+
+	// single file: INDEX 01 lower than the end of the previous track is a track length, not a LBA
+	if(num_files <= 1)
+	{
+		uint32_t off = 0, pregap = 0;
+
+		for(uint8_t t = 0; t < num_tracks; t++)
+		{
+			uint32_t lba = tracks[t].lba;
+
+			if(!t || (lba < off))
+				{tracks[t].lba = off + pregap; off = tracks[t].lba + lba;}
+			else
+				off = lba;
+
+			pregap = CUE_PREGAP;
+		}
+	}
+
+	if(files) *files = num_files;
+	return num_tracks;
+}
+
+/***********************************************************************
+* name of the FILE n of a .cue without its path (not terminated)
+* returns NULL if the sheet has less files
+***********************************************************************/
+static const char *cue_file_name(const char *buf, uint32_t size, uint8_t n, uint32_t *len)
+{
+	const char *p = buf, *end = buf + size;
+
+	for(const char *eol; p < end; p = eol + 1)
+	{
+		for(eol = p; (eol < end) && *eol && (*eol != '\n') && (*eol != '\r'); eol++) ;
+
+		p = cue_skip_spaces(p, eol);
+
+		if(!cue_is(p, eol, "FILE ", 5) || n--) continue;
+
+		const char *name = cue_skip_spaces(p + 5, eol), *name_end;
+
+		if((name < eol) && (*name == '"'))
+			for(name_end = ++name; (name_end < eol) && (*name_end != '"'); name_end++) ;
+		else
+			for(name_end = name; (name_end < eol) && (*name_end != ' ') && (*name_end != '\t'); name_end++) ;
+
+		for(const char *c = name; c < name_end; c++)
+			if((*c == '/') || (*c == '\\')) name = c + 1;
+
+		*len = (uint32_t)(name_end - name);
+		return *len ? name : NULL;
+	}
+
+	return NULL;
+}
+
+// multi-bin: file_sectors[n] = sectors of FILE n, the LBAs become absolute on the joined files
+static void cue_resolve(cue_track *tracks, uint8_t num_tracks, const uint32_t *file_sectors)
+{
+	uint32_t start = 0;
+
+	for(uint8_t t = 0, file = 0; t < num_tracks; t++)
+	{
+		for(; file < tracks[t].file; file++) start += file_sectors[file];
+		tracks[t].lba += start;
+	}
+}
+
+#endif // __CUE_SHEET_H__
@@ -0,0 +1,43 @@
+#ifndef __EXTENT_MAP_H__
+#define __EXTENT_MAP_H__
+
+// Extent map of the sections of a raw ISO (rawseciso.h)
+// Portable C: start[i] is the disc offset of section i (prefix sums of the section sizes, start[count] = end of the disc)
+// extent_find() tries the section of the last hit and the next one (sequential reads) before a binary search
+// Empty sections start where the next one starts and are never returned
+
+#include <stdint.h>
+
+typedef struct
+{
+	uint64_t *start;	// count + 1 entries
+	uint32_t count;		// sections
+	uint32_t last;		// section of the last hit
+} t_extent_map;
+
+// returns the section that holds offset or count if offset is past the end of the disc
+static uint32_t extent_find(t_extent_map *map, uint64_t offset)
+{
+	const uint64_t *start = map->start;
+
+	if(offset >= start[map->count]) return map->count;
+
+	uint32_t i = map->last;
+
+	if((offset >= start[i]) && (offset < start[i + 1])) return i;
+
+	// find the last section that starts at or before offset
+	uint32_t lo = 0, hi = map->count;
+
+	if((offset >= start[i + 1]) && (offset < start[i + 2])) lo = i + 1, hi = i + 2; // next section (i + 1 < count: offset is before the end)
+
+	while(hi - lo > 1)
+	{
+		uint32_t mid = (lo + hi) / 2;
+		if(start[mid] <= offset) lo = mid; else hi = mid;
+	}
+
+	return map->last = lo;
+}
+
+#endif // __EXTENT_MAP_H__
@@ -19,45 +19,17 @@ enum FIX_GAME_MODES
 
 #include "param_sfo.h"
 
-#ifdef COBRA_ONLY
- #if defined(USE_NTFS) || defined(FIX_GAME)
-static u32 getLBA(const char *chunk, u16 chunk_size, const char *filename, u16 flen, u16 *start, u32 *size)
-{
-	if(!chunk) return 0; // chunk is NULL
-
-	chunk_size -= (flen + 1);
-	for(u16 n = *start + 0x26; n < chunk_size; n++)
-	{
-		if((chunk[n] == flen) && (memcmp(&chunk[n + 1], filename, flen) == 0))
-		{
-			u32 lba = INT32(chunk + n - 0x1A);
-			*size   = INT32(chunk + n - 0x12);
-			*start  = n + (flen + 1); fixed_count++;
-			return lba;
-		}
-	}
-
-	return 0; // not found
-}
- #endif
-#endif
-
 #ifdef FIX_GAME
 static bool fix_sfo_attribute(unsigned char *mem, u16 sfo_size)
 {
-	READ_SFO_HEADER(false)
+	sfo_index sfo;
+	if(!index_param_sfo(mem, sfo_size, &sfo)) return false;
 
-	FOR_EACH_SFO_FIELD()
-	{
-		if(!memcmp((char *) &mem[str], "ATTRIBUTE", 9))
-		{
-			if(webman_config->fixgame == FIX_GAME_FORCED) {mem[pos+2]|=0x2; mem[pos+4]|=0xA5; return true;} // PS3_EXTRA + BGM + RemotePlay
-			if(!(mem[pos+2] & 2)) {mem[pos+2]|=0x2; return true;}                                           // PS3_EXTRA
-			break;
-		}
+	u16 pos = sfo.pos[SFO_ATTRIBUTE];
+	if(!pos || (sfo.siz[SFO_ATTRIBUTE] < 4)) return false;
 
-		READ_NEXT_SFO_FIELD()
-	}
+	if(webman_config->fixgame == FIX_GAME_FORCED) {mem[pos+2]|=0x2; mem[pos+4]|=0xA5; return true;} // PS3_EXTRA + BGM + RemotePlay
+	if(!(mem[pos+2] & 2)) {mem[pos+2]|=0x2; return true;}                                           // PS3_EXTRA
 
 	return false;
 }
@@ -136,137 +108,117 @@ static void fix_game_folder(char *path)
 }
 
 #ifdef COBRA_ONLY
-static void fix_iso(char *iso_file, u64 maxbytes, bool patch_update)
-{
-	struct CellFsStat buf;
+// ISO9660 directory walk: only the directory extents and the headers of the target files are read
 
-	if(islike(iso_file, "/net") || strstr(iso_file, ".ntfs[")) ; else
-	if(fix_aborted || (cellFsStat(iso_file, &buf) != CELL_FS_SUCCEEDED) || (c_firmware >= LATEST_CFW)) return;
+#define ISO_MAX_DEPTH	8		// ISO9660 limits the directory tree to 8 levels
 
-	int fd; char title_id[10], update_path[STD_PATH_LEN];
+static int read_iso_fd(void *fd, uint64_t offset, void *buf, uint32_t size)
+{
+	u64 bytes_read = 0;
+	if(cellFsReadWithOffset(*(int *)fd, offset, buf, size, &bytes_read) != CELL_FS_SUCCEEDED) return 0;
+	return (int)bytes_read;
+}
 
-	#ifdef COPY_PS3
-	sprintf(current_file, "%s", iso_file);
-	#endif
+// lower the required firmware of a SELF/SPRX header to 4.20
+static void fix_iso_self(iso9660_reader *iso, const iso9660_entry *entry, bool is_sprx, char *header)
+{
+	u64 ps3_sys_version = 0;
+	u32 ver_offset;
 
-	show_progress(iso_file, OV_FIX);
+	if(iso9660_read_file(iso, entry, 0, header, ISO9660_SECTOR) != ISO9660_SECTOR) return;
 
-	cellFsChmod(iso_file, MODE); //fix file read-write permission
+	ver_offset = INT32(header + 0xC) - 0x78;
 
-	if(cellFsOpen(iso_file, CELL_FS_O_RDWR, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+	for(u8 retry = 0; retry < 3; retry++)
 	{
-		u64 chunk_size=_4KB_; char chunk[chunk_size]; u64 ps3_sys_version;
-		u64 bytes_read = 0, lba = 0, pos = 0xA000ULL;
-
-		bool fix_sfo = true, fix_eboot = true, fix_ver = false;
-
-		u64 size = buf.st_size;
-		if(maxbytes > 0 && size > maxbytes) size = maxbytes;
-		if(size > pos) size -= pos; else size = 0;
-
-		u16 start, offset; u32 siz;
-
-		while(size)
-		{
-			if(fix_aborted) break;
-
-			if(fix_sfo)
-			{
-				cellFsReadWithOffset(fd, pos, chunk, chunk_size, &bytes_read); if(!bytes_read) break;
-
-				start = 0, lba = getLBA(chunk, chunk_size, "PARAM.SFO;1", 11, &start, &siz);
-
-				if(lba)
-				{
-					lba *= 0x800ULL, fix_sfo = false;
+		if(retry == 1) {if(is_sprx) ver_offset = 0x258; else ver_offset = 0x428;}
+		if(retry == 2) {if(is_sprx) ver_offset = 0x278; else break;}
 
-					cellFsReadWithOffset(fd, lba, (void *)&chunk, chunk_size, &bytes_read); if(!bytes_read) break;
+		if(ver_offset > ISO9660_SECTOR - 8) continue;
 
-					fix_ver = fix_param_sfo((unsigned char *)chunk, title_id, FIX_SFO, (u16)bytes_read);
+		memcpy(&ps3_sys_version, header + ver_offset, 8); if(ps3_sys_version >= MIN_CFW && ps3_sys_version < MAX_CFW) break;
+	}
 
-					if(patch_update)
-					{
-						if(is_app_dir(HDD0_GAME_DIR, title_id)) fix_ver = false;
-					}
+	if(ps3_sys_version > CFW_420 && ps3_sys_version < MAX_CFW && ver_offset <= ISO9660_SECTOR - 8)
+	{
+		ps3_sys_version = CFW_420; fixed_count++;
+		cellFsWriteWithOffset(*(int *)iso->handle, ((u64)entry->lba * ISO9660_SECTOR) + ver_offset, (void *)(&ps3_sys_version), 8, NULL);
+	}
+}
 
-					if(fix_ver)
-					{
-						cellFsWriteWithOffset(fd, lba, chunk, chunk_size, &bytes_read);
-					}
-					else goto exit_fix; //do not fix if sfo version is ok
+// patch EBOOT.BIN, *.SELF & *.SPRX in a folder of the ISO and its subfolders
+// entries: ISO_MAX_DEPTH + 1 entries allocated by the caller, the entry of each level is entries[depth]
+static void fix_iso_folder_tree(iso9660_reader *iso, const iso9660_entry *folder, u8 depth, char *header, iso9660_entry *entries)
+{
+	iso9660_entry *entry = entries + depth; iso9660_dir dir;
 
-					if(size > lba) size = lba;
+	if(iso9660_opendir(folder, &dir)) return;
 
-					sprintf(chunk, "%s %s", STR_FIXING, iso_file);
-					show_msg(chunk);
+	while(iso9660_readdir(iso, &dir, entry))
+	{
+		if(fix_aborted || !working) return;
 
-					start = 0, lba = getLBA(chunk, chunk_size, "PS3_DISC.SFB;1", 14, &start, &siz), lba *= 0x800ULL, chunk_size = 0x800; //1 sector
-					if(lba > 0 && size > lba) size = lba;
-				}
-			}
+		if(entry->is_dir)
+		{
+			if(depth < ISO_MAX_DEPTH) fix_iso_folder_tree(iso, entry, depth + 1, header, entries);
+		}
+		else if(IS(entry->name, "EBOOT.BIN") || !extcasecmp(entry->name, ".self", 5))
+			fix_iso_self(iso, entry, false, header);
+		else if(!extcasecmp(entry->name, ".sprx", 5))
+			fix_iso_self(iso, entry, true, header);
+	}
+}
 
-			for(u8 t = (fix_eboot ? 0 : 1); t < 5; t++)
-			{
-				cellFsReadWithOffset(fd, pos, chunk, chunk_size, &bytes_read); if(!bytes_read) break;
+static void fix_iso(char *iso_file, bool patch_update)
+{
+	struct CellFsStat buf;
 
-				lba = start = 0;
+	if(islike(iso_file, "/net") || strstr(iso_file, ".ntfs[")) ; else
+	if(fix_aborted || (cellFsStat(iso_file, &buf) != CELL_FS_SUCCEEDED) || (c_firmware >= LATEST_CFW)) return;
 
-				while(true)
-				{
-					sys_ppu_thread_usleep(1000);
-					if(fix_aborted) goto exit_fix;
+	int fd; char title_id[10] = "", update_path[STD_PATH_LEN];
 
-					if(t == 0) lba = getLBA(chunk, chunk_size, "EBOOT.BIN;1", 11, &start, &siz); else
-					if(t == 1) lba = getLBA(chunk, chunk_size, ".SELF;1", 7, &start, &siz);      else
-					if(t == 2) lba = getLBA(chunk, chunk_size, ".self;1", 7, &start, &siz);      else
-					if(t == 3) lba = getLBA(chunk, chunk_size, ".SPRX;1", 7, &start, &siz);      else
-					if(t == 4) lba = getLBA(chunk, chunk_size, ".sprx;1", 7, &start, &siz);
+	#ifdef COPY_PS3
+	sprintf(current_file, "%s", iso_file);
+	#endif
 
-					if(lba)
-					{
-						#define IS_EBOOT	(t == 0)
-						#define IS_SPRX		(t >= 3)
+	show_progress(iso_file, OV_FIX);
 
-						if(IS_EBOOT) fix_eboot = false;
+	cellFsChmod(iso_file, MODE); //fix file read-write permission
 
-						lba *= 0x800ULL;
+	// directory blocks, PARAM.SFO / file header & the entries of the tree walk are kept off the stack (fix_iso runs on the FTP client thread)
+	sys_addr_t sysmem = sys_mem_allocate(_64KB_);
 
-						cellFsReadWithOffset(fd, lba, (void *)&chunk, chunk_size, &bytes_read); if(!bytes_read) break;
+	if(sysmem && (cellFsOpen(iso_file, CELL_FS_O_RDWR, &fd, NULL, 0) == CELL_FS_SUCCEEDED))
+	{
+		char *chunk = (char*)sysmem; // ISO9660_MAX_BLOCKS directory blocks
+		char *header = chunk + (ISO9660_MAX_BLOCKS * ISO9660_SECTOR);
+		iso9660_entry *entries = (iso9660_entry *)(header + _4KB_), *entry = entries;
+		iso9660_reader iso;
+		u64 bytes_read = 0;
 
-						memcpy(&offset, chunk + 0xC, 4); offset -= 0x78;
+		if(iso9660_open(&iso, read_iso_fd, &fd, chunk, ISO9660_MAX_BLOCKS * ISO9660_SECTOR)) goto exit_fix;
 
-						for(u8 retry = 0; retry < 3; retry++)
-						{
-							if(retry == 1) {if(IS_SPRX) offset = 0x258; else offset = 0x428;}
-							if(retry == 2) {if(IS_SPRX) offset = 0x278; else break;}
+		if(!iso9660_find(&iso, "/PS3_GAME/PARAM.SFO", entry) || entry->is_dir) goto exit_fix;
 
-							memcpy(&ps3_sys_version, chunk + offset, 8); if(ps3_sys_version >= MIN_CFW && ps3_sys_version < MAX_CFW) break;
-						}
+		bytes_read = iso9660_read_file(&iso, entry, 0, header, _4KB_); if(!bytes_read) goto exit_fix;
 
-						if(ps3_sys_version > CFW_420 && ps3_sys_version < MAX_CFW)
-						{
-							ps3_sys_version = CFW_420;
-							cellFsWriteWithOffset(fd, lba + offset, (void *)(&ps3_sys_version), 8, NULL);
-						}
-						else goto exit_fix;
+		bool fix_ver = fix_param_sfo((unsigned char *)header, title_id, FIX_SFO, (u16)bytes_read);
 
-						if(IS_EBOOT) break;
+		if(patch_update)
+		{
+			if(is_app_dir(HDD0_GAME_DIR, title_id)) fix_ver = false;
+		}
 
-						#undef IS_EBOOT
-						#undef IS_SPRX
+		if(!fix_ver) goto exit_fix; //do not fix if sfo version is ok
 
-					} else break;
-				}
-			}
+		cellFsWriteWithOffset(fd, (u64)entry->lba * ISO9660_SECTOR, header, bytes_read, NULL);
 
-			if(!bytes_read) break;
+		sprintf(header, "%s %s", STR_FIXING, iso_file);
+		show_msg(header);
 
-			pos  += chunk_size;
-			size -= chunk_size;
-			if(chunk_size > size) chunk_size = (int) size;
+		fix_iso_folder_tree(&iso, &iso.root, 0, header, entries);
 
-			sys_ppu_thread_usleep(1000);
-		}
 exit_fix:
 		cellFsClose(fd);
 	}
@@ -276,6 +228,8 @@ exit_fix:
 		getTitleID(update_path, title_id, GET_TITLE_ID_ONLY);
 	}
 
+	if(sysmem) sys_memory_free(sysmem);
+
 	// fix update folder
 	sprintf(update_path, "%s%s/PARAM.SFO", HDD0_GAME_DIR, title_id);
 	if(getTitleID(update_path, title_id, FIX_SFO) || webman_config->fixgame==FIX_GAME_FORCED)
@@ -284,6 +238,32 @@ exit_fix:
 		fix_game_folder(update_path);
 	}
 }
+
+// fix every ISO of a folder (e.g. /dev_hdd0/PS3ISO)
+static void fix_iso_folder(char *path)
+{
+	int fd;
+
+	if(cellFsOpendir(path, &fd) != CELL_FS_SUCCEEDED) return;
+
+	CellFsDirectoryEntry dir; u32 read_e;
+	const char *entry_name = dir.entry_name.d_name;
+
+	u16 plen = strlen(path); path[plen] = '/';
+	char *filename = path + plen + 1;
+
+	while(working && !fix_aborted && (!cellFsGetDirectoryEntries(fd, &dir, sizeof(dir), &read_e) && read_e))
+	{
+		if(entry_name[0] == '.') continue;
+		if(!is_ext(entry_name, ".iso") && !is_iso_0(entry_name)) continue;
+
+		strcpy(filename, entry_name);
+		fix_iso(path, false);
+	}
+
+	path[plen] = '\0';
+	cellFsClosedir(fd);
+}
 #endif //#ifdef COBRA_ONLY
 
 static void fix_game(char *game_path, char *title_id, u8 fix_type)
@@ -298,7 +278,9 @@ static void fix_game(char *game_path, char *title_id, u8 fix_type)
 
 		#ifdef COBRA_ONLY
 		if(is_ext(game_path, ".iso") || is_iso_0(game_path))
-			fix_iso(game_path, 0x100000UL, false);
+			fix_iso(game_path, false);
+		else if(strstr(game_path, "/PS3ISO") && isDir(game_path))
+			fix_iso_folder(game_path);
 		else
 		#endif //#ifdef COBRA_ONLY
 
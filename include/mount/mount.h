@@ -859,6 +859,11 @@ static bool game_mount(char *buffer, char *templn, char *param, char *tempstr, b
 				bool fast_move = (cp_mode == CP_MODE_MOVE) && is_same_dev(source, target);
 				mkdir_tree(target);
 
+				// journal the job: /copy.ps3$resume continues it after an unload, power loss or removed device
+				bool use_job = !wildcard && !fast_move && !strstr(source, "/exdata");
+				if(use_job) {sprintf(templn, "%s|%s", source, target); save_file(COPY_JOB_FILE, templn, SAVE_ALL);}
+				copy_interrupted = false;
+
 				// copy folder to target
 				if(strstr(source,"/exdata"))
 				{
@@ -873,6 +878,8 @@ static bool game_mount(char *buffer, char *templn, char *param, char *tempstr, b
 				else
 					file_copy(source, target);
 
+				if(use_job && (copy_aborted || (working && !copy_interrupted))) cellFsUnlink(COPY_JOB_FILE);
+
 				// show msg end
 				if(copy_aborted)
 					show_msg_with_icon(ICON_EXCLAMATION, STR_CPYABORT);
@@ -886,7 +893,7 @@ static bool game_mount(char *buffer, char *templn, char *param, char *tempstr, b
 				setPluginInactive();
 			}
 
-			if(!copy_aborted && (cp_mode == CP_MODE_MOVE) && file_exists(target)) del(source, true);
+			if(!copy_aborted && !copy_interrupted && (cp_mode == CP_MODE_MOVE) && file_exists(target)) del(source, true);
 			if(cp_mode) {cp_mode = CP_MODE_NONE, *cp_path = NULL;}
 		}
 		#endif //#ifdef COPY_PS3
@@ -1277,7 +1284,7 @@ static bool mount_ps_disc_image(char *_path, char *cobra_iso_list[], u8 iso_part
 			if(cue_size > 16)
 			{
 				TrackDef tracks[MAX_TRACKS];
-				unsigned int num_tracks = parse_cue(_path, cue_buf, cue_size, tracks);
+				unsigned int num_tracks = parse_cue(cue_buf, cue_size, tracks, NULL, 1);
 
 				if(emu_type == EMU_PSX)
 					cobra_mount_psx_disc_image(cobra_iso_list[0], tracks, num_tracks);
@@ -138,7 +138,7 @@ mount_again:
 				if(webman_config->fixgame != FIX_GAME_DISABLED)
 				{
 					fix_in_progress=true; fix_aborted = false;
-					fix_iso(_path, 0x100000UL, true);
+					fix_iso(_path, true);
 					fix_in_progress=false;
 				}
 				#endif //#ifdef FIX_GAME
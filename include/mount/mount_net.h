@@ -78,57 +78,37 @@ if(BETWEEN('0', netid, '4'))
 		int ns = connect_to_remote_server(netiso_svrid);
 		if(ns >= 0)
 		{
-			// load cuesheet
-			cellFsUnlink(TEMP_NET_PSXCUE);
-			{
-				// change .cue / .ccd extension to .bin / .iso
-				if(is_ext(netpath, ".cue") || is_ext(netpath, ".ccd"))
-					for(u8 e = 0; e < 10; e++)
-					{
-						strcpy(netpath + len - 4, iso_ext[e]);
-						if(remote_file_exists(ns, netpath)) break;
-					}
-
-				// copy .cue / .ccd to local TEMP_NET_PSXCUE
-				for(u8 e = 0; e < 4; e++)
+			// change .cue / .ccd extension to .bin / .iso
+			if(is_ext(netpath, ".cue") || is_ext(netpath, ".ccd"))
+				for(u8 e = 0; e < 10; e++)
 				{
-					strcpy(netiso_args.path + len - 4, cue_ext[e]);
-					if(copy_net_file(TEMP_NET_PSXCUE, netiso_args.path, ns) == CELL_OK) break;
+					strcpy(netpath + len - 4, iso_ext[e]);
+					if(remote_file_exists(ns, netpath)) break;
 				}
-			}
-			sclose(&ns);
 
-			size_t cue_size = file_size(TEMP_NET_PSXCUE);
-			if(cue_size > 0x10)
+			// read .cue / .ccd in memory
+			char *cue_buf = malloc(_8KB_);
+			if(cue_buf)
 			{
-				char *cue_buf = malloc(cue_size);
-				if(cue_buf)
+				int cue_size = FAILED;
+				for(u8 e = 0; e < 4; e++)
 				{
-					u16 cue_size = read_sfo(TEMP_NET_PSXCUE, cue_buf);
-					cellFsUnlink(TEMP_NET_PSXCUE);
-
-					num_tracks = parse_cue(templn, cue_buf, cue_size, tracks);
-					free(cue_buf);
+					strcpy(netiso_args.path + len - 4, cue_ext[e]);
+					cue_size = read_net_file(ns, netiso_args.path, cue_buf, _8KB_);
+					if(cue_size > 0) break;
 				}
+
+				num_tracks = parse_cue(cue_buf, cue_size, tracks, NULL, 1);
+				free(cue_buf);
 			}
+			sclose(&ns);
 		}
 
 		mount_unk = netiso_args.emu_mode = EMU_PSX;
 		netiso_args.num_tracks = num_tracks;
 		strcpy(netiso_args.path, netpath);
 
-		ScsiTrackDescriptor *scsi_tracks = (ScsiTrackDescriptor *)netiso_args.tracks;
-
-		scsi_tracks[0].adr_control = 0x14;
-		scsi_tracks[0].track_number = 1;
-		scsi_tracks[0].track_start_addr = 0;
-
-		for(unsigned int t = 1; t < num_tracks; t++)
-		{
-			scsi_tracks[t].adr_control = 0x10;
-			scsi_tracks[t].track_number = t + 1;
-			scsi_tracks[t].track_start_addr = tracks[t].lba;
-		}
+		set_scsi_tracks((ScsiTrackDescriptor *)netiso_args.tracks, tracks, num_tracks);
 	}
 	else if((islike(netpath, "/GAMES") || islike(netpath, "/GAMEZ") || islike(netpath, "/PS3ISO")) && strchr(netpath + 5, '/'))
 	{
@@ -0,0 +1,153 @@
+#ifndef __NET_CACHE_H__
+#define __NET_CACHE_H__
+
+// Sector cache of the netiso client for CMD_READ_ISO (netiso.h)
+// Portable C: LRU segments filled on misses (request + readahead window) and by one async readahead
+// that is sent after a sequential read and received before the next command
+// The I/O goes through the callbacks of the client, so the readahead & the other commands share one connection
+
+#include <stdint.h>
+#include <string.h>
+
+#define NET_CACHE_SEGS		4
+#define NET_SEG_SIZE		(128 * 1024)
+#define NET_RA_MIN			(32 * 1024)	// first readahead window of a sequential stream (doubles up to NET_SEG_SIZE)
+
+typedef struct
+{
+	uint64_t offset;
+	uint32_t len;   // 0 = empty
+	uint32_t stamp; // last use (LRU)
+} t_net_segment;
+
+typedef struct
+{
+	uint8_t *mem;			// NET_CACHE_SEGS * NET_SEG_SIZE bytes (NULL = no cache)
+	uint64_t disc_size;
+
+	t_net_segment seg[NET_CACHE_SEGS];
+	uint32_t stamp;
+	uint64_t last_end;		// end of the previous read (sequential stream detector)
+	uint32_t ra_window;		// readahead window (0 = random access)
+	int8_t   ra_seg;		// segment waiting for the async readahead (-1 = none)
+	uint32_t ra_len;
+
+	// I/O of the client: 0 = done
+	void *handle;
+	int (*read)(void *handle, uint8_t *buf, uint64_t offset, uint32_t size);	// synchronous read (the end of the disc is zero filled)
+	int (*ra_send)(void *handle, uint64_t offset, uint32_t size);				// request of the readahead
+	int (*ra_recv)(void *handle, uint8_t *buf, uint32_t size);					// data of the readahead
+} t_net_cache;
+
+static void net_cache_reset(t_net_cache *c)
+{
+	memset(c->seg, 0, sizeof(c->seg));
+	c->stamp = c->ra_window = c->ra_len = 0;
+	c->last_end = 0;
+	c->ra_seg = -1;
+}
+
+static int net_cache_lookup(const t_net_cache *c, uint64_t offset)
+{
+	for(uint8_t i = 0; i < NET_CACHE_SEGS; i++)
+		if(c->seg[i].len && (offset >= c->seg[i].offset) && (offset < c->seg[i].offset + c->seg[i].len)) return i;
+
+	return -1;
+}
+
+// least recently used segment, keeping the ones that start in [keep_from, keep_to)
+static uint8_t net_cache_victim(const t_net_cache *c, uint64_t keep_from, uint64_t keep_to)
+{
+	uint8_t victim = 0; uint32_t oldest = 0xFFFFFFFF;
+
+	for(uint8_t i = 0; i < NET_CACHE_SEGS; i++)
+	{
+		if(i == c->ra_seg) continue;
+		if(!c->seg[i].len) return i;
+		if((c->seg[i].offset >= keep_from) && (c->seg[i].offset < keep_to)) continue;
+		if(c->seg[i].stamp < oldest) {oldest = c->seg[i].stamp; victim = i;}
+	}
+
+	return victim;
+}
+
+static void net_readahead_start(t_net_cache *c, uint8_t i, uint64_t offset, uint32_t size)
+{
+	c->seg[i].len = 0, c->seg[i].offset = offset;
+
+	if(c->ra_send(c->handle, offset, size) == 0) {c->ra_seg = i, c->ra_len = size;}
+}
+
+// receive the pending readahead: must be called before any other command is sent to the server
+static int net_readahead_finish(t_net_cache *c)
+{
+	if(c->ra_seg < 0) return 0;
+
+	uint8_t i = (uint8_t)c->ra_seg; c->ra_seg = -1;
+
+	if(c->ra_recv(c->handle, c->mem + (i * NET_SEG_SIZE), c->ra_len)) return -1;
+
+	c->seg[i].len = c->ra_len, c->seg[i].stamp = ++c->stamp;
+	return 0;
+}
+
+static int net_cache_read(t_net_cache *c, uint8_t *buf, uint64_t offset, uint32_t size)
+{
+	// sequential stream: grow the readahead window; random access: no readahead
+	if(offset == c->last_end)
+		c->ra_window = c->ra_window ? ((c->ra_window * 2 < NET_SEG_SIZE) ? c->ra_window * 2 : NET_SEG_SIZE) : NET_RA_MIN;
+	else
+		c->ra_window = 0;
+
+	c->last_end = offset + size;
+
+	while(size)
+	{
+		int i = net_cache_lookup(c, offset);
+
+		if((i < 0) && (c->ra_seg >= 0) && (offset >= c->seg[(uint8_t)c->ra_seg].offset) && (offset < c->seg[(uint8_t)c->ra_seg].offset + c->ra_len))
+		{
+			if(net_readahead_finish(c)) return -1;
+			continue;
+		}
+
+		if(i < 0)
+		{
+			if(net_readahead_finish(c)) return -1;
+
+			// large reads and the reads of the end of the disc bypass the cache
+			if((size > NET_SEG_SIZE) || (offset + size > c->disc_size)) return c->read(c->handle, buf, offset, size);
+
+			// miss: fill a segment with the request and the readahead window (not beyond the end of the disc)
+			i = net_cache_victim(c, 0, 0);
+			uint64_t len = (size > c->ra_window) ? size : c->ra_window;
+			if(len > NET_SEG_SIZE) len = NET_SEG_SIZE;
+			if(len > c->disc_size - offset) len = c->disc_size - offset;
+
+			c->seg[i].len = 0;
+			if(c->read(c->handle, c->mem + (i * NET_SEG_SIZE), offset, (uint32_t)len)) return -1;
+			c->seg[i].offset = offset, c->seg[i].len = (uint32_t)len;
+		}
+
+		t_net_segment *seg = &c->seg[i]; seg->stamp = ++c->stamp;
+
+		uint32_t pos = (uint32_t)(offset - seg->offset), n = seg->len - pos; if(n > size) n = size;
+		memcpy(buf, c->mem + (i * NET_SEG_SIZE) + pos, n);
+
+		buf += n, offset += n, size -= n;
+	}
+
+	// keep the next window of a sequential stream on its way while the data is consumed
+	if(c->ra_window && (c->ra_seg < 0))
+	{
+		uint64_t ahead = c->last_end; int i;
+		while((i = net_cache_lookup(c, ahead)) >= 0) ahead = c->seg[i].offset + c->seg[i].len;
+
+		if((ahead < c->disc_size) && (ahead - c->last_end < c->ra_window))
+			net_readahead_start(c, net_cache_victim(c, c->last_end, ahead), ahead, (uint32_t)((c->disc_size - ahead < c->ra_window) ? c->disc_size - ahead : c->ra_window));
+	}
+
+	return 0;
+}
+
+#endif // __NET_CACHE_H__
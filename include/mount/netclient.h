@@ -28,8 +28,6 @@ _netiso_args netiso_args;
 
 #define MAX_RETRIES    3
 
-#define TEMP_NET_PSXCUE  WMTMP "/~netpsx.cue"
-
 static int8_t netiso_svrid = NONE;
 
 static int read_remote_file(int s, void *buf, u64 offset, u32 size, int *abort_connection)
@@ -72,6 +70,151 @@ static int read_remote_file(int s, void *buf, u64 offset, u32 size, int *abort_c
 	return bytes_read;
 }
 
+#ifdef USE_INTERNAL_NET_PLUGIN
+#define NETISO_V2_WINDOW	8		// default tagged reads in flight (webman_config->netiso_window: 0=default, 1=protocol v1)
+#define NETISO_V2_CHUNK		_64KB_	// size of each tagged read
+
+static u8 netiso_window = 0; // tagged reads in flight negotiated with the server (0 = protocol v1)
+static u8 *netiso_zbuf = NULL; // LZ4 input of the compressed transfer mode (NULL = raw transfers)
+
+// protocol v2: returns the tagged reads in flight accepted by the server (0 = the server only speaks v1)
+// servers without v2 close the connection on the unknown command, so the caller must reconnect if 0 is returned
+static u8 negotiate_remote_v2(int s, u8 window, u8 *flags)
+{
+	netiso_negotiate_v2_cmd cmd;
+	netiso_negotiate_v2_result res;
+
+	_memset(&cmd, sizeof(cmd));
+	cmd.opcode = NETISO_CMD_NEGOTIATE_V2;
+	cmd.version = NETISO_PROTOCOL_V2;
+	cmd.window = window;
+	cmd.flags = *flags;
+
+	if(send(s, &cmd, sizeof(cmd), 0) != sizeof(cmd)) return 0;
+
+	if(recv(s, &res, sizeof(res), MSG_WAITALL) != sizeof(res)) return 0;
+
+	if((res.version < NETISO_PROTOCOL_V2) || (res.max_read < NETISO_V2_CHUNK)) return 0;
+
+	*flags &= res.flags;
+
+	return (u8)MIN(res.window, window);
+}
+
+// LZ4 block format decoder: the block must expand to exactly dst_size bytes
+static int lz4_decompress_block(const u8 *src, u32 src_size, u8 *dst, u32 dst_size)
+{
+	const u8 *ip = src, *ip_end = src + src_size;
+	u8 *op = dst, *op_end = dst + dst_size;
+
+	while(ip < ip_end)
+	{
+		u8 token = *ip++, b;
+		u32 len = token >> 4;
+
+		if(len == 15) do {if(ip >= ip_end) return FAILED; b = *ip++; len += b;} while(b == 255);
+
+		if((len > (u32)(ip_end - ip)) || (len > (u32)(op_end - op))) return FAILED;
+
+		memcpy(op, ip, len); op += len, ip += len;
+
+		if(ip >= ip_end) break; // the last sequence has only literals
+
+		if(ip_end - ip < 2) return FAILED;
+
+		u32 offset = ip[0] | (ip[1] << 8); ip += 2;
+		if(!offset || (offset > (u32)(op - dst))) return FAILED;
+
+		len = (token & 15) + 4;
+		if((token & 15) == 15) do {if(ip >= ip_end) return FAILED; b = *ip++; len += b;} while(b == 255);
+
+		if(len > (u32)(op_end - op)) return FAILED;
+
+		// byte copy: the match can overlap the output (runs)
+		for(const u8 *match = op - offset; len; len--) *op++ = *match++;
+	}
+
+	return (op == op_end) ? CELL_OK : FAILED;
+}
+
+// receive file data: raw, or in blocks of NETISO_BLOCK_SIZE in the compressed transfer mode
+static int recv_remote_data(int s, u8 *buf, u32 size)
+{
+	if(!netiso_zbuf)
+		return (recv(s, buf, size, MSG_WAITALL) == (int)size) ? CELL_OK : FAILED;
+
+	netiso_block_header header;
+
+	for(u32 pos = 0, len; pos < size; pos += len)
+	{
+		len = MIN(NETISO_BLOCK_SIZE, size - pos);
+
+		if(recv(s, &header, sizeof(header), MSG_WAITALL) != sizeof(header)) return FAILED;
+
+		if(header.type == NETISO_BLOCK_ZERO)
+		{
+			_memset(buf + pos, len);
+		}
+		else if(header.type == NETISO_BLOCK_LZ4)
+		{
+			if((header.size >= len) || (recv(s, netiso_zbuf, header.size, MSG_WAITALL) != (int)header.size)) return FAILED;
+			if(lz4_decompress_block(netiso_zbuf, header.size, buf + pos, len)) return FAILED;
+		}
+		else
+		{
+			if((header.size != len) || (recv(s, buf + pos, len, MSG_WAITALL) != (int)len)) return FAILED;
+		}
+	}
+
+	return CELL_OK;
+}
+
+// protocol v2: split a read in tagged requests, keep up to netiso_window of them in flight
+// and place each result by its tag (the server can complete them in any order)
+static int read_remote_file_tagged(int s, u8 *buf, u64 offset, u32 size)
+{
+	netiso_read_file_tagged_cmd cmd;
+	netiso_read_file_tagged_result res;
+
+	u32 nreads = (size + NETISO_V2_CHUNK - 1) / NETISO_V2_CHUNK, sent = 0, done = 0;
+
+	if(nreads > 0xFFFF) return FAILED;
+
+	_memset(&cmd, sizeof(cmd));
+	cmd.opcode = NETISO_CMD_READ_FILE_TAGGED;
+
+	while(done < nreads)
+	{
+		// fill the window
+		for(; (sent < nreads) && (sent - done < netiso_window); sent++)
+		{
+			u32 pos = sent * NETISO_V2_CHUNK;
+
+			cmd.tag = (u16)sent;
+			cmd.num_bytes = MIN(NETISO_V2_CHUNK, size - pos);
+			cmd.offset = offset + pos;
+
+			if(send(s, &cmd, sizeof(cmd), 0) != sizeof(cmd)) return FAILED;
+		}
+
+		// each result completes one request
+		if(recv(s, &res, sizeof(res), MSG_WAITALL) != sizeof(res)) return FAILED;
+
+		if(res.tag >= nreads) return FAILED;
+
+		u32 pos = res.tag * NETISO_V2_CHUNK, len = MIN(NETISO_V2_CHUNK, size - pos);
+
+		if(res.bytes_read != (s32)len) return FAILED; // critical read: short reads are errors
+
+		if(recv_remote_data(s, buf + pos, len)) return FAILED;
+
+		done++;
+	}
+
+	return CELL_OK;
+}
+#endif
+
 static s64 open_remote_file(int s, const char *path, int *abort_connection)
 {
 	*abort_connection = 1;
@@ -267,6 +410,19 @@ static int copy_net_file(const char *local_file, const char *remote_file, int ns
 	return ret;
 }
 
+// read a small remote file (e.g. .cue) in memory, returns the bytes read
+static int read_net_file(int ns, const char *remote_file, char *buf, u32 size)
+{
+	int abort_connection = 0;
+
+	s64 file_size = open_remote_file(ns, remote_file, &abort_connection);
+	if(file_size <= 0) return FAILED;
+
+	if(file_size < size) size = (u32)file_size;
+
+	return read_remote_file(ns, buf, 0, size, &abort_connection);
+}
+
 static bool is_netsrv_enabled(u8 server_id)
 {
 	server_id &= 0x0F; // change '0'-'4' to  0..4
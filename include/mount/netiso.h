@@ -1,6 +1,33 @@
 #ifdef USE_INTERNAL_NET_PLUGIN
+
+#include "net_cache.h"
+
+static t_net_cache net_cache; // sector cache & readahead of CMD_READ_ISO (net_cache.mem = NULL: no cache)
+
+static int net_ra_send(__attribute__((unused)) void *handle, u64 offset, u32 size)
+{
+	netiso_read_file_critical_cmd cmd;
+
+	_memset(&cmd, sizeof(cmd));
+	cmd.opcode = NETISO_CMD_READ_FILE_CRITICAL;
+	cmd.num_bytes = size;
+	cmd.offset = offset;
+
+	return (send(g_socket, &cmd, sizeof(cmd), 0) == sizeof(cmd)) ? CELL_OK : FAILED;
+}
+
+static int net_ra_recv(__attribute__((unused)) void *handle, u8 *buf, u32 size)
+{
+	return recv_remote_data(g_socket, buf, size);
+}
+
 static int read_remote_file_critical(u64 offset, void *buf, u32 size)
 {
+	if(net_readahead_finish(&net_cache)) return FAILED;
+
+	if(netiso_window && (size > NETISO_V2_CHUNK))
+		return read_remote_file_tagged(g_socket, (u8*)buf, offset, size);
+
 	netiso_read_file_critical_cmd cmd;
 
 	_memset(&cmd, sizeof(cmd));
@@ -14,7 +41,7 @@ static int read_remote_file_critical(u64 offset, void *buf, u32 size)
 		return FAILED;
 	}
 
-	if(recv(g_socket, buf, size, MSG_WAITALL) != (int)size)
+	if(recv_remote_data(g_socket, buf, size))
 	{
 		//DPRINTF("recv failed (recv file)  (errno=%d)!\n", sys_net_errno);
 		return FAILED;
@@ -25,6 +52,8 @@ static int read_remote_file_critical(u64 offset, void *buf, u32 size)
 
 static int process_read_cd_2048_cmd(u8 *buf, u32 start_sector, u32 sector_count)
 {
+	if(net_readahead_finish(&net_cache)) return FAILED;
+
 	netiso_read_cd_2048_critical_cmd cmd;
 
 	_memset(&cmd, sizeof(cmd));
@@ -71,6 +100,11 @@ static int process_read_iso_cmd(u8 *buf, u64 offset, u32 size)
 	return read_remote_file_critical(offset, buf, size);
 }
 
+static int net_cache_miss(__attribute__((unused)) void *handle, u8 *buf, u64 offset, u32 size)
+{
+	return process_read_iso_cmd(buf, offset, size);
+}
+
 static int process_read_cd_2352_cmd(u8 *buf, u32 sector, u32 remaining)
 {
 	int cache = 0;
@@ -153,6 +187,70 @@ static u8 netiso_loaded = 0;
 static sys_event_queue_t command_queue_net = NONE;
 static sys_ppu_thread_t thread_id_net = SYS_PPU_THREAD_NONE;
 
+static int netiso_connect(void)
+{
+	int s = connect_to_server(netiso_args.server, netiso_args.port);
+	if(s < 0 && !IS(webman_config->allow_ip, netiso_args.server))
+	{
+		// retry using ip of the remote connection
+		s = connect_to_server(webman_config->allow_ip, netiso_args.port);
+	}
+	return s;
+}
+
+// connect to the server & negotiate the protocol: v2 (tagged reads in flight & compressed transfer mode) or v1
+static int netiso_session(void)
+{
+	g_socket = netiso_connect();
+
+	if(g_socket < 0) return FAILED;
+
+	netiso_window = 0;
+	if(webman_config->netiso_window != 1)
+	{
+		u8 flags = 0;
+		if(webman_config->netiso_compress)
+		{
+			if(!netiso_zbuf) netiso_zbuf = (u8*)sys_mem_allocate(NETISO_BLOCK_SIZE);
+			if(netiso_zbuf) flags = NETISO_FLAG_COMPRESS;
+		}
+
+		netiso_window = negotiate_remote_v2(g_socket, webman_config->netiso_window ? webman_config->netiso_window : NETISO_V2_WINDOW, &flags);
+
+		if(netiso_zbuf && !(netiso_window && (flags & NETISO_FLAG_COMPRESS)))
+		{
+			sys_memory_free((sys_addr_t)netiso_zbuf); netiso_zbuf = NULL; // raw transfers
+		}
+
+		if(!netiso_window)
+		{
+			// older ps3netsrv closes the connection on unknown commands: reconnect with protocol v1
+			sclose(&g_socket);
+			g_socket = netiso_connect();
+			if(g_socket < 0) return FAILED;
+		}
+	}
+
+	return CELL_OK;
+}
+
+// a failed read can leave tagged results or file data on the way: the next command is sent on a new connection
+static int netiso_reconnect(void)
+{
+	int abort_connection = 0; // the CD sector size is already detected
+
+	sclose(&g_socket);
+	net_cache.ra_seg = NONE; // the pending readahead was on the closed connection
+
+	if(netiso_session() || (open_remote_file(g_socket, netiso_args.path, &abort_connection) < 0))
+	{
+		sclose(&g_socket);
+		return FAILED;
+	}
+
+	return CELL_OK;
+}
+
 static void netiso_thread(__attribute__((unused)) u64 arg)
 {
 	unsigned int real_disctype;
@@ -162,17 +260,11 @@ static void netiso_thread(__attribute__((unused)) u64 arg)
 
 	emu_mode = netiso_args.emu_mode & 0xF;
 	CD_SECTOR_SIZE_2352 = 2352;
+	net_cache_reset(&net_cache);
 
 	//DPRINTF("Hello VSH\n");
 
-	g_socket = connect_to_server(netiso_args.server, netiso_args.port);
-	if(g_socket < 0 && !IS(webman_config->allow_ip, netiso_args.server))
-	{
-		// retry using ip of the remote connection
-		g_socket = connect_to_server(webman_config->allow_ip, netiso_args.port);
-	}
-
-	if(g_socket < 0)
+	if(netiso_session())
 	{
 		goto exit_netiso;
 	}
@@ -225,6 +317,10 @@ static void netiso_thread(__attribute__((unused)) u64 arg)
 		num_tracks = 0;
 		tracks = NULL;
 		is_cd2352 = 0;
+
+		net_cache.disc_size = discsize;
+		net_cache.read = net_cache_miss, net_cache.ra_send = net_ra_send, net_cache.ra_recv = net_ra_recv;
+		net_cache.mem = (u8*)sys_mem_allocate(NET_CACHE_SEGS * NET_SEG_SIZE); // no cache if there is no memory
 	}
 
 	sys_storage_ext_get_disc_type(&real_disctype, NULL, NULL);
@@ -264,6 +360,9 @@ static void netiso_thread(__attribute__((unused)) u64 arg)
 		u64 offset = event.data2;
 		u32 size = event.data3&0xFFFFFFFF;
 
+		ret = (g_socket < 0) ? netiso_reconnect() : CELL_OK;
+
+		if(ret == CELL_OK)
 		switch(event.data1)
 		{
 			case CMD_READ_ISO:
@@ -272,6 +371,10 @@ static void netiso_thread(__attribute__((unused)) u64 arg)
 				{
 					ret = process_read_cd_2048_cmd(buf, offset / CD_SECTOR_SIZE_2048, size / CD_SECTOR_SIZE_2048);
 				}
+				else if(net_cache.mem)
+				{
+					ret = net_cache_read(&net_cache, buf, offset, size);
+				}
 				else
 				{
 					ret = process_read_iso_cmd(buf, offset, size);
@@ -286,6 +389,8 @@ static void netiso_thread(__attribute__((unused)) u64 arg)
 			break;
 		}
 
+		if(ret && netiso_loaded) sclose(&g_socket); // reconnect before the next command
+
 		while(netiso_loaded)
 		{
 			ret = sys_event_port_send(result_port, ret, 0, 0);
@@ -327,6 +432,17 @@ exit_netiso:
 		sys_memory_free((sys_addr_t)cd_cache);
 	}
 
+	if(net_cache.mem)
+	{
+		sys_memory_free((sys_addr_t)net_cache.mem); net_cache.mem = NULL;
+	}
+	net_cache.ra_seg = NONE;
+
+	if(netiso_zbuf)
+	{
+		sys_memory_free((sys_addr_t)netiso_zbuf); netiso_zbuf = NULL;
+	}
+
 	if(g_socket >= 0)
 	{
 		sclose(&g_socket);
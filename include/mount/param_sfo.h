@@ -35,43 +35,200 @@ static bool is_sfo(unsigned char *mem)
 		pos+=siz, indx+=0x10; if(indx>=fld) break; \
 	}
 
-static void parse_param_sfo(unsigned char *mem, char *title_id, char *title, u16 sfo_size)
+// keys of PARAM.SFO indexed in a single pass of its key table
+enum SFO_Keys
 {
-	READ_SFO_HEADER()
+	SFO_TITLE,
+	SFO_TITLE_XX,
+	SFO_TITLE_ID,
+	SFO_APP_VER,
+	SFO_CATEGORY,
+	SFO_PS3_SYSTEM_VER,
+	SFO_ATTRIBUTE,
+	SFO_KEYS
+};
 
-	_memset(title_id, 10);
-	_memset(title, 128);
+typedef struct
+{
+	u16 pos[SFO_KEYS]; // offset of the value in PARAM.SFO (0 = key not found)
+	u16 siz[SFO_KEYS]; // max length of the value
+} sfo_index;
 
-	FOR_EACH_SFO_FIELD()
+static bool is_sfo_key(const char *key, const char *name, u16 max_len)
+{
+	u16 len = strlen(name) + 1; // including the NULL
+	return (len <= max_len) && !memcmp(key, name, len);
+}
+
+static bool index_param_sfo(unsigned char *mem, u16 sfo_size, sfo_index *sfo)
+{
+	_memset(sfo, sizeof(sfo_index));
+
+	if((sfo_size < 0x14) || !is_sfo(mem)) return false;
+
+	u16 key_table  = mem[0x08] + (mem[0x09]<<8);
+	u16 data_table = mem[0x0c] + (mem[0x0d]<<8);
+	u16 entries    = mem[0x10] + (mem[0x11]<<8);
+
+	for(u16 n = 0, indx = 0x14; (n < entries) && (indx + 0x10 <= sfo_size); n++, indx += 0x10)
 	{
-		if(!memcmp(FIELD_NAME, "TITLE_ID", 8))
-		{
-			strncpy(title_id, (char *)mem + pos, TITLE_ID_LEN);
-			#ifndef ENGLISH_ONLY
-			if(*TITLE_XX == NULL)
-			#endif
-				if(*title) break;
-		}
-		else
-		if(!memcmp(FIELD_NAME, "TITLE", 6))
+		u32 str = key_table  + mem[indx + 0x0] + (mem[indx + 0x1]<<8);
+		u32 pos = data_table + mem[indx + 0xc] + (mem[indx + 0xd]<<8);
+		u32 siz = mem[indx + 0x8] + (mem[indx + 0x9]<<8);
+
+		if((str >= sfo_size) || (pos >= sfo_size)) continue;
+		if(pos + siz > sfo_size) siz = sfo_size - pos;
+
+		const char *key = FIELD_NAME; u16 max_len = sfo_size - str; u8 k = SFO_KEYS;
+
+		switch(*key)
 		{
-			memcpy64(title, (char *)mem + pos, 128);
-			#ifndef ENGLISH_ONLY
-			if(*TITLE_XX == NULL)
-			#endif
-				if(*title_id) break;
+			case 'T':
+				if(is_sfo_key(key, "TITLE", max_len))    k = SFO_TITLE;    else
+				if(is_sfo_key(key, "TITLE_ID", max_len)) k = SFO_TITLE_ID;
+				#ifndef ENGLISH_ONLY
+				else
+				if(*TITLE_XX && is_sfo_key(key, TITLE_XX, max_len)) k = SFO_TITLE_XX;
+				#endif
+				break;
+			case 'A':
+				if(is_sfo_key(key, "APP_VER", max_len))   k = SFO_APP_VER;  else
+				if(is_sfo_key(key, "ATTRIBUTE", max_len)) k = SFO_ATTRIBUTE;
+				break;
+			case 'C':
+				if(is_sfo_key(key, "CATEGORY", max_len))  k = SFO_CATEGORY;
+				break;
+			case 'P':
+				if(is_sfo_key(key, "PS3_SYSTEM_VER", max_len)) k = SFO_PS3_SYSTEM_VER;
+				break;
 		}
-		#ifndef ENGLISH_ONLY
-		else
-		if(!memcmp(FIELD_NAME, TITLE_XX, TITLE_ID_LEN))
+
+		if(k < SFO_KEYS) {sfo->pos[k] = (u16)pos, sfo->siz[k] = (u16)siz;}
+	}
+
+	return true;
+}
+
+// copy the value of an indexed key (size = size of value including the NULL)
+static void get_sfo_value(unsigned char *mem, const sfo_index *sfo, u8 key, char *value, u16 size)
+{
+	_memset(value, size);
+
+	if(!sfo->pos[key]) return;
+
+	strncpy(value, (char *)mem + sfo->pos[key], MIN(sfo->siz[key], size - 1));
+}
+
+/***********************************************************************
+* PARAM.SFO cache
+* The fields read by the scanners (games_xml, games_html), fix_game and
+* mount are parsed once per path & mtime, e.g. the version and the title
+* of a game are no longer read from the same PARAM.SFO twice.
+***********************************************************************/
+#define SFO_CACHE_SIZE	8
+
+typedef struct
+{
+	u32 hash;		// path (0 = empty entry)
+	u32 size;
+	u64 mtime;
+	u8  lang;		// TITLE_XX of the title
+	char title_id[10];
+	char app_ver[8];
+	char category[4];
+	char title[128];
+} sfo_info;
+
+static sfo_info sfo_cache[SFO_CACHE_SIZE];
+static u8 sfo_cache_next = 0;
+
+static u32 sfo_path_hash(const char *path)
+{
+	u32 hash = 0x811C9DC5; // FNV-1a
+	while(*path) hash = (hash ^ (u8)*path++) * 0x01000193;
+	return hash | 1;
+}
+
+// data = work buffer of 4KB
+static bool read_sfo_info(const char *param_sfo, sfo_info *info, char *data)
+{
+	struct CellFsStat s;
+	u32 hash = 0;
+	u16 sfo_size;
+
+	#ifdef USE_NTFS
+	if(is_ntfs_path(param_sfo))
+		sfo_size = read_sfo(param_sfo, data); // not cached
+	else
+	#endif
+	if(cellFsStat(param_sfo, &s) == CELL_FS_SUCCEEDED)
+	{
+		hash = sfo_path_hash(param_sfo);
+
+		mutex_lock(sfo_mutex);
+		for(u8 n = 0; n < SFO_CACHE_SIZE; n++)
 		{
-			memcpy64(title, (char *)mem + pos, 128);
-			if(*title_id) break;
+			sfo_info *entry = &sfo_cache[n];
+			if((entry->hash == hash) && (entry->size == (u32)s.st_size) && (entry->mtime == (u64)s.st_mtime) && (entry->lang == webman_config->lang))
+			{
+				memcpy(info, entry, sizeof(sfo_info));
+				mutex_unlock(sfo_mutex);
+				return true;
+			}
 		}
-		#endif
-		READ_NEXT_SFO_FIELD()
+		mutex_unlock(sfo_mutex);
+
+		sfo_size = (u16)read_file(param_sfo, data, MIN(s.st_size, _4KB_), 0);
+	}
+	else
+		return false;
+
+	sfo_index sfo;
+	if(!index_param_sfo((unsigned char *)data, sfo_size, &sfo)) return false;
+
+	unsigned char *mem = (u8*)data;
+
+	_memset(info, sizeof(sfo_info));
+
+	get_sfo_value(mem, &sfo, SFO_TITLE_ID, info->title_id, sizeof(info->title_id));
+	get_sfo_value(mem, &sfo, SFO_APP_VER,  info->app_ver,  sizeof(info->app_ver));
+	get_sfo_value(mem, &sfo, SFO_CATEGORY, info->category, sizeof(info->category));
+	get_sfo_value(mem, &sfo, sfo.pos[SFO_TITLE_XX] ? SFO_TITLE_XX : SFO_TITLE, info->title, sizeof(info->title));
+
+	info->lang = webman_config->lang;
+
+	if(hash)
+	{
+		info->size  = (u32)s.st_size;
+		info->mtime = (u64)s.st_mtime;
+
+		info->hash  = hash;
+
+		mutex_lock(sfo_mutex);
+		memcpy(&sfo_cache[sfo_cache_next], info, sizeof(sfo_info));
+		if(++sfo_cache_next >= SFO_CACHE_SIZE) sfo_cache_next = 0;
+		mutex_unlock(sfo_mutex);
 	}
 
+	return true;
+}
+
+// drop a PARAM.SFO from the cache when it is modified
+static void sfo_cache_drop(const char *param_sfo)
+{
+	u32 hash = sfo_path_hash(param_sfo);
+
+	mutex_lock(sfo_mutex);
+	for(u8 n = 0; n < SFO_CACHE_SIZE; n++)
+		if(sfo_cache[n].hash == hash) sfo_cache[n].hash = 0;
+	mutex_unlock(sfo_mutex);
+}
+
+static void get_sfo_title(const sfo_info *info, char *title_id, char *title)
+{
+	strcpy(title_id, info->title_id);
+	strcpy(title, info->title);
+
 	if(webman_config->tid && ISDIGIT(title_id[8]) && (*title_id == 'B' || *title_id == 'N' || *title_id == 'S'))
 	{
 		strcat(title, " ["); strcat(title, title_id); strcat(title, "]");
@@ -129,47 +286,28 @@ static u8 unlock_param_sfo(const char *param_sfo, unsigned char *mem, u16 sfo_si
 #ifdef FIX_GAME
 static bool fix_param_sfo(unsigned char *mem, char *title_id, u8 opcode, u16 sfo_size)
 {
-	READ_SFO_HEADER(false)
+	sfo_index sfo;
 
 	_memset(title_id, 10);
 
-	#ifdef FIX_GAME
-	u8 fcount = 0;
-	#endif
+	if(!index_param_sfo(mem, sfo_size, &sfo)) return false;
 
-	bool ret = false;
+	get_sfo_value(mem, &sfo, SFO_TITLE_ID, title_id, 10);
 
-	FOR_EACH_SFO_FIELD()
-	{
-		if(!memcmp(FIELD_NAME, "TITLE_ID", 8))
-		{
-			strncpy(title_id, FIELD_VALUE, TITLE_ID_LEN);
-			#ifdef FIX_GAME
-			if(opcode == GET_TITLE_ID_ONLY) break;
-			fcount++; if(fcount >= 2) break;
-			#else
-			break;
-			#endif
-		}
-		else
-		if(!memcmp(FIELD_NAME, "PS3_SYSTEM_VER", 14))
-		{
-			char version[8];
-			strncpy(version, FIELD_VALUE, 7);
-			int fw_ver = 10000 * ((version[1] & 0x0F)) + 1000 * ((version[3] & 0x0F)) + 100 * ((version[4] & 0x0F));
-			if((c_firmware >= 4.20f && c_firmware < LATEST_CFW) && (fw_ver > (int)(c_firmware * 10000.0f)))
-			{
-				if(opcode == SHOW_WARNING) {char text[64]; sprintf(text, "WARNING: Game requires firmware version %i.%i", (fw_ver / 10000), (fw_ver - 10000*(fw_ver / 10000)) / 100); show_msg(text); break;}
+	u16 pos = sfo.pos[SFO_PS3_SYSTEM_VER];
+	if((opcode == GET_TITLE_ID_ONLY) || !pos) return false;
 
-				mem[pos + 1] = '4', mem[pos + 3] = '2', mem[pos + 4] = '0'; ret = true;
-			}
-			fcount++; if(fcount >= 2) break;
-		}
+	char version[8];
+	get_sfo_value(mem, &sfo, SFO_PS3_SYSTEM_VER, version, 8);
+	int fw_ver = 10000 * ((version[1] & 0x0F)) + 1000 * ((version[3] & 0x0F)) + 100 * ((version[4] & 0x0F));
+	if((c_firmware >= 4.20f && c_firmware < LATEST_CFW) && (fw_ver > (int)(c_firmware * 10000.0f)))
+	{
+		if(opcode == SHOW_WARNING) {char text[64]; sprintf(text, "WARNING: Game requires firmware version %i.%i", (fw_ver / 10000), (fw_ver - 10000*(fw_ver / 10000)) / 100); show_msg(text); return false;}
 
-		READ_NEXT_SFO_FIELD()
+		mem[pos + 1] = '4', mem[pos + 3] = '2', mem[pos + 4] = '0'; return true;
 	}
 
-	return ret;
+	return false;
 }
 #endif
 
@@ -283,38 +421,44 @@ static bool getTitleID(char *filename, char *title_id, u8 opcode)
 	_memset(title_id, 10);
 
 	char param_sfo[_4KB_];
-	unsigned char *mem = (u8*)param_sfo;
 
 	check_ps3_game(filename);
 
-	u16 sfo_size = read_sfo(filename, param_sfo);
+	#ifdef FIX_GAME
+	if((opcode == FIX_SFO) || (opcode == SHOW_WARNING))
+	{
+		u16 sfo_size = read_sfo(filename, param_sfo);
+
+		if(sfo_size)
+		{
+			ret = fix_param_sfo((unsigned char *)param_sfo, title_id, opcode, sfo_size);  // get titleid & show warning if game needs to fix PS3_SYSTEM_VER
+
+			if(ret && opcode == FIX_SFO) {save_file(filename, param_sfo, sfo_size); sfo_cache_drop(filename);}
+		}
+		return ret;
+	}
+	#endif
+
+	sfo_info info;
 
-	if(sfo_size)
+	if(read_sfo_info(filename, &info, param_sfo))
 	{
 		// get titleid
 		if(opcode == GET_TITLE_ID_ONLY)
-			get_param_sfo(mem, "TITLE_ID", title_id, sfo_size);
+			strcpy(title_id, info.title_id);
 		else if(opcode == GET_VERSION)
 		{
 			char *app_ver = title_id;
-			get_param_sfo(mem, "APP_VER", app_ver, sfo_size);   // get game version (app_ver)
+			strcpy(app_ver, info.app_ver);              // get game version (app_ver)
 		}
 		else if(opcode == IS_GAME_DATA)
 		{
 			char *category = title_id;
-			get_param_sfo(mem, "CATEGORY", category, sfo_size); // get category & return if it is GD
+			strcpy(category, info.category);            // get category & return if it is GD
 			return islike(category, "GD");
 		}
 		else if(opcode == GET_TITLE_AND_ID)
-			parse_param_sfo(mem, title_id, filename, sfo_size);    // get titleid & return title in the file name (used to backup games in _mount.h)
-		#ifdef FIX_GAME
-		else
-		{
-			ret = fix_param_sfo(mem, title_id, opcode, sfo_size);  // get titleid & show warning if game needs to fix PS3_SYSTEM_VER
-
-			if(ret && opcode == FIX_SFO) save_file(filename, param_sfo, sfo_size);
-		}
-		#endif
+			get_sfo_title(&info, title_id, filename);   // get titleid & return title in the file name (used to backup games in _mount.h)
 	}
 
 	return ret;
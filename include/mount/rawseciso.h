@@ -1,6 +1,5 @@
 #define CD_CACHE_SIZE           (48) // sectors 48*2448 = 115KB (up to 52 sectors fit in 128KB)
 
-#define LAST_SECTOR             1
 #define READ_SECTOR             0xFFFFFFFF
 
 #ifdef RAWISO_PSX_MULTI
@@ -158,61 +157,206 @@ static int sys_storage_ext_mount_discfile_proxy(sys_event_port_t result_port, sy
 	return (int)p1;
 }
 
+// extent map: disc offset where each section starts (prefix sums), built on the first read of a set of sections
+// and searched with the last hit (sequential reads) or a binary search instead of walking all the sections
+#include "extent_map.h"
+
+#define EXTENT_MAP_MIN		16	// fewer sections are walked
+
+static t_extent_map extent_map;		// num_sections + 1 entries
+static u32 extent_max = 0;			// entries allocated
+static u32 *extent_sections = NULL;	// sections of the map
+static u64 extent_sec_size = 0;
+
+static u64 section_bytes(u32 i, u64 sec_size)
+{
+	if((i == 0) && (IS_FAKE_ISO))
+		return (((u64)sections_size[i]) * CD_SECTOR_SIZE_2048);
+	else
+		return (((u64)sections_size[i]) * sec_size);
+}
+
+static bool build_extent_map(u64 sec_size)
+{
+	extent_sections = NULL;
+
+	if(num_sections < EXTENT_MAP_MIN) return false;
+
+	if(num_sections >= extent_max)
+	{
+		if(extent_map.start) sys_memory_free((sys_addr_t)extent_map.start);
+		extent_map.start = NULL; extent_max = 0;
+
+		u32 size = ((num_sections + 1) * sizeof(u64) + _64KB_ - 1) & ~(_64KB_ - 1);
+		extent_map.start = (u64*)sys_mem_allocate(size);
+		if(!extent_map.start) return false;
+
+		extent_max = size / sizeof(u64);
+	}
+
+	u64 base = 0;
+	for(u32 i = 0; i < num_sections; i++)
+	{
+		extent_map.start[i] = base; base += section_bytes(i, sec_size);
+	}
+	extent_map.start[num_sections] = base;
+	extent_map.count = num_sections, extent_map.last = 0;
+
+	extent_sections = sections, extent_sec_size = sec_size;
+	return true;
+}
+
 static void get_next_read(u64 discoffset, u64 bufsize, u64 *offset, u64 *readsize, int *idx, u64 sec_size)
 {
-	u64 last, sz, base = 0;
+	u64 base = 0, last = 0;
 	*idx = NONE;
 	*readsize = bufsize;
 	*offset = 0;
 
-	for(u32 i = 0; i < num_sections; i++)
+	if(((extent_sections == sections) && (extent_sec_size == sec_size)) || build_extent_map(sec_size))
 	{
-		if(i == 0 && IS_FAKE_ISO)
-			sz = (((u64)sections_size[i]) * CD_SECTOR_SIZE_2048);
-		else
-			sz = (((u64)sections_size[i]) * sec_size);
+		u32 i = extent_find(&extent_map, discoffset);
+		if(i >= num_sections) goto out_of_range;
 
-		last = base + sz;
-
-		if(discoffset >= base && discoffset < last)
+		base = extent_map.start[i], last = extent_map.start[i + 1];
+		*idx = i;
+	}
+	else
+	{
+		for(u32 i = 0; i < num_sections; i++)
 		{
-			u64 maxfileread = last-discoffset;
+			last = base + section_bytes(i, sec_size);
 
-			if(bufsize > maxfileread)
-				*readsize = maxfileread;
-			else
-				*readsize = bufsize;
+			if(discoffset >= base && discoffset < last)
+			{
+				*idx = i;
+				break;
+			}
 
-			*idx = i;
-			*offset = discoffset-base;
-			return;
+			base = last;
 		}
+	}
+
+	if(*idx != NONE)
+	{
+		u64 maxfileread = last-discoffset;
+
+		if(bufsize > maxfileread)
+			*readsize = maxfileread;
+		else
+			*readsize = bufsize;
 
-		base += sz;
+		*offset = discoffset-base;
+		return;
 	}
 
+out_of_range:
 	// We can be here on video blu-ray
 	//DPRINTF("Offset or size out of range  %lx%08lx   %lx!!!!!!!!\n", discoffset>>32, discoffset, bufsize);
+	return;
+}
+
+// set-associative cache of device sectors for partial sectors & short reads (ISO, PSX & multi PSX paths)
+#include "sect_cache.h"
+
+static u8 sect_cache_buf[_4KB_] __attribute__((aligned(16))); // single line if nothing can be allocated
+static t_sect_cache sect_cache;		// sect_cache.mem = NULL: not initialized
+static u32 sect_cache_mem = 0;		// bytes allocated (0 = sect_cache_buf)
+
+static int read_device_sectors(u32 sector, u32 n, u8 *buf);
+
+static int sect_cache_read(__attribute__((unused)) void *handle, u32 sector, u32 n, u8 *buf)
+{
+	return read_device_sectors(sector, n, buf);
+}
+
+// sized by the free memory: 256KB, 128KB, 64KB or the static line
+static void sect_cache_init(void)
+{
+	get_meminfo();
+
+	u32 size = (meminfo.avail >= _3MB_) ? _256KB_ : (meminfo.avail >= _2MB_) ? _128KB_ : (meminfo.avail >= _1MB_) ? _64KB_ : 0;
+	u32 line = SECT_CACHE_LINE;
+
+	sect_cache_mem = 0;
+	if(size)
+	{
+		sys_addr_t addr = sys_mem_allocate(size);
+		if(addr) {sect_cache.mem = (u8 *)addr; sect_cache_mem = size;}
+	}
+	if(!sect_cache_mem) {sect_cache.mem = sect_cache_buf; size = line = sizeof(sect_cache_buf);}
+
+	sect_cache_setup(&sect_cache, sect_cache.mem, size, line, (u32)sec_size);
+	sect_cache.read = sect_cache_read;
+}
+
+static void sect_cache_free(void)
+{
+	if(sect_cache_mem) sys_memory_free((sys_addr_t)sect_cache.mem);
+	sect_cache.mem = NULL, sect_cache_mem = 0;
 }
 
-static u8 last_sect_buf[_4KB_] __attribute__((aligned(16)));
-static u32 last_sect = READ_SECTOR;
+static int read_device_sectors(u32 sector, u32 n, u8 *buf)
+{
+	int ret;
+	u32 r;
+
+	for(int retry = 0; retry < 16; retry++)
+	{
+		r = 0;
+		ret = sys_storage_read(handle, 0, sector, n, buf, &r, 0);
+
+		if(ret == CELL_OK && r == n) return CELL_OK;
+
+#ifdef RAWISO_PSX_MULTI
+		if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
+#endif
+		if(ret == (int) 0x80010002 || ret == (int) 0x8001002D)
+		{
+			if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
+
+			while(ntfs_running)
+			{
+				if(sys_storage_get_device_info(usb_device, &disc_info) == 0)
+				{
+					ret = sys_storage_open(usb_device, 0, &handle, 0);
+					if(ret == CELL_OK) break;
+
+					handle = SYS_DEVICE_HANDLE_NONE; sys_ppu_thread_usleep(500000);
+				}
+				else sys_ppu_thread_usleep(7000000);
+			}
+
+			sect_cache_reset(&sect_cache); // the device was reconnected
+			retry = -1; continue;
+		}
+
+		if(retry == 15 || !ntfs_running)
+		{
+			//DPRINTF("sys_storage_read failed: %x %x -> %x\n", sector, n, ret);
+			return FAILED;
+		}
+		else sys_ppu_thread_usleep(100000);
+	}
+
+	return FAILED;
+}
 
 static int process_read_iso_cmd_iso(u8 *buf, u64 offset, u64 size)
 {
 	u64 remaining;
-	int retry;
+	int ret;
 
 	//DPRINTF("read iso: %p %lx %lx\n", buf, offset, size);
 	remaining = size;
 
+	if(!sect_cache.mem) sect_cache_init();
+	sect_cache.sector_count = disc_info.sector_count; // disc_info is updated by the reconnects & the eject polling
+
 	while(remaining)
 	{
 		u64 pos, readsize;
 		int idx;
-		int ret;
-		u32 sector;
-		u32 r;
 
 		if(!ntfs_running) return FAILED;
 
@@ -227,186 +371,44 @@ static int process_read_iso_cmd_iso(u8 *buf, u64 offset, u64 size)
 			continue;
 		}
 
-		if(pos % sec_size)
+		// fragments that are contiguous on the device are read with one request
+		for(u32 i = idx; (readsize < remaining) && (i + 1 < num_sections) && !((i == 0) && (IS_FAKE_ISO)) && (sections[i] + sections_size[i] == sections[i + 1]); i++)
 		{
-			sector = sections[idx] + (pos / sec_size);
-			for(retry = 0; retry < 16; retry++)
-			{
-				r = 0;
-				if(last_sect == sector)
-				{
-					ret = CELL_OK; r = LAST_SECTOR;
-				}
-				else
-					ret = sys_storage_read(handle, 0, sector, 1, last_sect_buf, &r, 0);
-
-				if(ret == CELL_OK && r == LAST_SECTOR)
-					last_sect = sector;
-				else
-					last_sect = READ_SECTOR;
-
-				if(last_sect == READ_SECTOR)
-				{
-#ifdef RAWISO_PSX_MULTI
-					if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
-#endif
-					if(ret == (int) 0x80010002 || ret == (int) 0x8001002D)
-					{
-						if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
+			readsize = MIN(remaining, readsize + ((u64)sections_size[i + 1] * sec_size));
+		}
 
-						while(ntfs_running)
-						{
-							if(sys_storage_get_device_info(usb_device, &disc_info) == 0)
-							{
-								ret = sys_storage_open(usb_device, 0, &handle, 0);
-								if(ret == CELL_OK) break;
+		while(readsize)
+		{
+			u32 sector = sections[idx] + (pos / sec_size);
+			u64 csize;
 
-								handle = SYS_DEVICE_HANDLE_NONE; sys_ppu_thread_usleep(500000);
-							}
-							else sys_ppu_thread_usleep(3000000);
-						}
-						retry = -1; continue;
-					}
+			if((pos % sec_size) || (readsize < sect_cache.line_bytes))
+			{
+				// partial sectors & short reads are served by the sector cache
+				u8 *line = sect_cache_line(&sect_cache, sector, &ret);
+				if(!line) return ret;
 
+				u32 line_pos = ((sector % sect_cache.line_sectors) * (u32)sec_size) + (u32)(pos % sec_size);
 
-					if(retry == 15 || !ntfs_running)
-					{
-						//DPRINTF("sys_storage_read failed: %x 1 -> %x\n", sector, ret);
-						return FAILED;
-					}
-					else sys_ppu_thread_usleep(100000);
-				}
-				else break;
+				csize = MIN(readsize, sect_cache.line_bytes - line_pos);
+				memcpy64(buf, line + line_pos, csize);
 			}
+			else
+			{
+				u32 n = readsize / sec_size;
 
-			u64 csize = sec_size - (pos % sec_size);
+				ret = read_device_sectors(sector, n, buf);
+				if(ret) return ret;
 
-			if(csize > readsize) csize = readsize;
+				csize = n * sec_size;
+			}
 
-			memcpy64(buf, last_sect_buf + (pos % sec_size), csize);
 			buf += csize;
 			offset += csize;
 			pos += csize;
 			remaining -= csize;
 			readsize -= csize;
 		}
-
-		if(readsize)
-		{
-			u32 n = readsize / sec_size;
-
-			if(n)
-			{
-				sector = sections[idx] + (pos / sec_size);
-				for(retry = 0; retry < 16; retry++)
-				{
-					r = 0;
-					ret = sys_storage_read(handle, 0, sector, n, buf, &r, 0);
-
-					if(ret == CELL_OK && r == n)
-						last_sect = sector + n - 1;
-					else
-						last_sect = READ_SECTOR;
-
-					if(last_sect == READ_SECTOR)
-					{
-#ifdef RAWISO_PSX_MULTI
-						if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
-#endif
-						if(ret == (int) 0x80010002 || ret == (int) 0x8001002D)
-						{
-							if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
-
-							while(ntfs_running)
-							{
-								if(sys_storage_get_device_info(usb_device, &disc_info) == 0)
-								{
-									ret = sys_storage_open(usb_device, 0, &handle, 0);
-									if(ret == CELL_OK) break;
-
-									handle = SYS_DEVICE_HANDLE_NONE; sys_ppu_thread_usleep(500000);
-								}
-								else sys_ppu_thread_usleep(7000000);
-							}
-							retry = -1; continue;
-						}
-
-						if(retry == 15 || !ntfs_running)
-						{
-							//DPRINTF("sys_storage_read failed: %x %x -> %x\n", sector, n, ret);
-							return FAILED;
-						}
-						else sys_ppu_thread_usleep(100000);
-					}
-					else break;
-				}
-
-				u64 s = n * sec_size;
-
-				buf += s;
-				offset += s;
-				pos += s;
-				remaining -= s;
-				readsize -= s;
-			}
-
-			if(readsize)
-			{
-				sector = sections[idx] + pos / sec_size;
-				for(retry = 0; retry < 16; retry++)
-				{
-					r = 0;
-					if(last_sect == sector)
-					{
-						ret = CELL_OK; r = LAST_SECTOR;
-					}
-					else
-						ret = sys_storage_read(handle, 0, sector, 1, last_sect_buf, &r, 0);
-
-					if(ret == CELL_OK && r == LAST_SECTOR)
-						last_sect = sector;
-					else
-						last_sect = READ_SECTOR;
-
-					if(last_sect == READ_SECTOR)
-					{
-#ifdef RAWISO_PSX_MULTI
-						if(emu_mode == EMU_PSX_MULTI) return (int) 0x8001000A; // EBUSY
-#endif
-						if(ret == (int) 0x80010002 || ret == (int) 0x8001002D)
-						{
-							if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle); handle = SYS_DEVICE_HANDLE_NONE;
-
-							while(ntfs_running)
-							{
-								if(sys_storage_get_device_info(usb_device, &disc_info) == 0)
-								{
-									ret = sys_storage_open(usb_device, 0, &handle, 0);
-									if(ret == CELL_OK) break;
-
-									handle = SYS_DEVICE_HANDLE_NONE; sys_ppu_thread_usleep(500000);
-								}
-								else sys_ppu_thread_usleep(7000000);
-							}
-							retry = -1; continue;
-						}
-
-						if(retry == 15 || !ntfs_running)
-						{
-							//DPRINTF("sys_storage_read failed: %x 1 -> %x\n", sector, ret);
-							return FAILED;
-						}
-						else sys_ppu_thread_usleep(100000);
-					}
-					else break;
-				}
-
-				memcpy64(buf, last_sect_buf, readsize);
-				buf += readsize;
-				offset += readsize;
-				remaining -= readsize;
-			}
-		}
 	}
 
 	return CELL_OK;
@@ -631,6 +633,13 @@ static int process_read_cd_2048_cmd_iso(u8 *buf, u32 start_sector, u32 sector_co
 
 static int process_read_cd_2352_cmd_iso(u8 *buf, u32 sector, u32 remaining)
 {
+	// short reads go to the sector cache (keeps interleaved streams apart),
+	// longer reads keep the 48-sector readahead window
+	if(sect_cache_mem && (remaining * CD_SECTOR_SIZE_2352 < SECT_CACHE_LINE))
+	{
+		return process_read_iso_cmd_iso(buf, sector * CD_SECTOR_SIZE_2352, remaining * CD_SECTOR_SIZE_2352);
+	}
+
 	if(remaining <= CD_CACHE_SIZE)
 	{
 		int dif = (int)cached_cd_sector - sector;
@@ -1262,6 +1271,14 @@ exit_rawseciso:
 		sys_memory_free((sys_addr_t)cd_cache);
 	}
 
+	sect_cache_free();
+
+	if(extent_map.start)
+	{
+		sys_memory_free((sys_addr_t)extent_map.start);
+	}
+	extent_map.start = NULL, extent_sections = NULL, extent_max = 0;
+
 	if(handle != SYS_DEVICE_HANDLE_NONE) sys_storage_close(handle);
 
 #ifdef RAWISO_PSX_MULTI
@@ -0,0 +1,105 @@
+#ifndef __SECT_CACHE_H__
+#define __SECT_CACHE_H__
+
+// Set-associative cache of device sectors for the partial sectors & short reads of a raw ISO (rawseciso.h)
+// Portable C: lines of whole device sectors are stored [way][set], so the following lines of a way are contiguous
+// and a sequential miss prefetches them with a single read of the device (callback of the plugin)
+
+#include <stdint.h>
+#include <string.h>
+
+#define SECT_CACHE_WAYS		4
+#define SECT_CACHE_LINE		(8 * 1024)
+#define SECT_CACHE_PREFETCH	8			// lines loaded by a sequential miss
+#define SECT_CACHE_LINES	32			// 256KB / SECT_CACHE_LINE
+#define SECT_NO_LINE		0xFFFFFFFF
+
+typedef struct
+{
+	uint8_t *mem;							// lines [way][set]
+	uint32_t tag[SECT_CACHE_LINES];			// line number + 1 (0 = empty)
+	uint32_t stamp[SECT_CACHE_LINES];
+	uint32_t clock, ways, sets, line_sectors, line_bytes;
+	uint32_t next_line;						// line after the last miss
+	uint64_t sector_count;					// sectors of the device (0 = unknown)
+	uint32_t hits, misses, prefetched;
+
+	// device read: 0 = done, else error code returned by sect_cache_line()
+	void *handle;
+	int (*read)(void *handle, uint32_t sector, uint32_t n, uint8_t *buf);
+} t_sect_cache;
+
+static void sect_cache_reset(t_sect_cache *c)
+{
+	memset(c->tag, 0, sizeof(c->tag));
+	memset(c->stamp, 0, sizeof(c->stamp));
+	c->clock = 0, c->next_line = SECT_NO_LINE;
+}
+
+// lines of line_size bytes (rounded to whole sectors) in size bytes of mem
+static void sect_cache_setup(t_sect_cache *c, uint8_t *mem, uint32_t size, uint32_t line_size, uint32_t sec_size)
+{
+	c->mem = mem;
+	c->line_sectors = (line_size > sec_size) ? line_size / sec_size : 1;
+	c->line_bytes = c->line_sectors * sec_size;
+
+	uint32_t lines = size / c->line_bytes; if(lines > SECT_CACHE_LINES) lines = SECT_CACHE_LINES;
+	c->ways = (lines < SECT_CACHE_WAYS) ? (lines ? lines : 1) : SECT_CACHE_WAYS;
+	c->sets = (lines / c->ways) ? lines / c->ways : 1;
+
+	c->hits = c->misses = c->prefetched = 0;
+	sect_cache_reset(c);
+}
+
+// returns the cached line that holds the sector, NULL on read error (*err = error code)
+static uint8_t *sect_cache_line(t_sect_cache *c, uint32_t sector, int *err)
+{
+	uint32_t line = sector / c->line_sectors, set = line % c->sets, victim = 0, i;
+
+	for(uint32_t way = 0; way < c->ways; way++)
+	{
+		i = (way * c->sets) + set;
+		if(c->tag[i] == line + 1)
+		{
+			c->stamp[i] = ++c->clock; c->hits++;
+			return c->mem + (i * c->line_bytes);
+		}
+		if(c->stamp[i] < c->stamp[(victim * c->sets) + set]) victim = way;
+	}
+
+	c->misses++;
+
+	// a sequential miss also loads the next lines of the victim way (up to the last set)
+	uint32_t count = (line == c->next_line) ? ((c->sets - set < SECT_CACHE_PREFETCH) ? c->sets - set : SECT_CACHE_PREFETCH) : 1;
+	uint32_t first = line * c->line_sectors, n = count * c->line_sectors;
+
+	if(c->sector_count)
+	{
+		// a line past the last sector of the device can't be read
+		if(first >= c->sector_count) {*err = -1; c->next_line = SECT_NO_LINE; return NULL;}
+		if((uint64_t)first + n > c->sector_count) n = (uint32_t)(c->sector_count - first);
+	}
+	count = (n + c->line_sectors - 1) / c->line_sectors;
+
+	// drop copies of the loaded lines held by other ways & the lines being replaced
+	for(uint32_t l = 0; l < count; l++)
+		for(uint32_t way = 0; way < c->ways; way++)
+		{
+			i = (way * c->sets) + set + l;
+			if((way == victim) || (c->tag[i] == line + l + 1)) c->tag[i] = 0;
+		}
+
+	i = (victim * c->sets) + set;
+
+	*err = c->read(c->handle, first, n, c->mem + (i * c->line_bytes));
+	if(*err) {c->next_line = SECT_NO_LINE; return NULL;}
+
+	for(uint32_t l = 0; l < count; l++) {c->tag[i + l] = line + l + 1; c->stamp[i + l] = ++c->clock;}
+
+	c->prefetched += count - 1;
+	c->next_line = line + count;
+
+	return c->mem + (i * c->line_bytes);
+}
+
+#endif // __SECT_CACHE_H__
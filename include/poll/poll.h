@@ -218,8 +218,7 @@ static void poll_thread(__attribute__((unused)) u64 arg)
 		if(file_exists(WM_REQUEST_FILE))
 		{
 			loading_html++;
-			sys_ppu_thread_t t_id;
-			if(working) sys_ppu_thread_create(&t_id, handleclient_www, WM_FILE_REQUEST, THREAD_PRIO, THREAD_STACK_SIZE_WEB_CLIENT, SYS_PPU_THREAD_CREATE_NORMAL, THREAD_NAME_WEB);
+			if(working) spawn_client_www(WM_FILE_REQUEST);
 		}
 		#endif
 	}
@@ -35,7 +35,6 @@ static sys_addr_t typeA_Copy = NULL;
 #define	PAD_SQUARE		(1<<15)
 
 static u8 doForceWrite = 0;
-static u8 isConstantWrite = 0;
 static process_id_t attachedPID = 0;
 static int userCodesLen = 0;
 
@@ -122,6 +121,8 @@ static char *ReadHexPartial(char *read, int start, int len, char *buf, int bufSi
 		unsigned char c = h2b(read[i]);
 
 		int bufOff = ((bufSize < 4) ? 4 : bufSize) - (cnt/2) - 1;
+		if (bufOff < 0)
+			break; // odd count of digits: the value is truncated to the buffer
 
 		if (cnt & 1)
 			buf[bufOff] |= (unsigned char)c;
@@ -160,29 +161,43 @@ static int WriteMem(process_id_t pid, u64 addr, char *buf, int size)
 // Compares the bytes at addr to buf (equal to)
 static int CompareMemory(process_id_t pid, u64 addr, char *buf, int bufLen)
 {
-	char cmp[1];
+	char cmp[256];
 
-	for (int i = 0; i < bufLen; i++)
+	for (int i = 0, len; i < bufLen; i += len)
 	{
-		if (get_process_mem(pid, addr + i, cmp, 1) < 0)
+		len = MIN(bufLen - i, (int)sizeof(cmp));
+
+		if (get_process_mem(pid, addr + i, cmp, len) < 0)
 			return 0;
-		if (buf[i] != cmp[0])
+		if (memcmp(buf + i, cmp, len))
 			return 0;
 	}
 
 	return 1;
 }
 
-// Compares the bytes at source to buf (equal to)
-static int CompareMemoryBuffered(char *source, int sourceOff, char *buf, int bufLen)
+// Bad character table of the pattern for FindPattern (shifts are capped to 255)
+static void PatternShifts(const u8 *pat, u32 len, u8 *shift)
 {
-	for (int i = 0; i < bufLen; i++)
+	memset(shift, MIN(len, 255), 256);
+
+	for (u32 i = 0; i + 1 < len; i++)
+		shift[pat[i]] = MIN(len - 1 - i, 255);
+}
+
+// Horspool search: returns the first offset in [pos, last] where buf matches pat, or -1
+static int FindPattern(const u8 *buf, u32 pos, u32 last, const u8 *pat, u32 len, const u8 *shift)
+{
+	const u8 end = pat[len - 1];
+
+	for (u8 c; pos <= last; pos += shift[c])
 	{
-		if (buf[i] != source[sourceOff + i])
-			return 0;
+		c = buf[pos + len - 1];
+		if ((c == end) && !memcmp(buf + pos, pat, len))
+			return pos;
 	}
 
-	return 1;
+	return -1;
 }
 
 // Compares the bytes at addr to buf (and equal to)
@@ -254,13 +269,54 @@ static bool isCodeLineValid(char *line)
 }
 
 // Artemis PS3 Engine
+// The codelist is compiled once when it is loaded: CompileLine() decodes each code line into an art_op
+// (addresses, values & search patterns are pre-decoded), RunCodes() executes the ops on every pass
+
+#define OP_CODE		0xFF	// start of a code: resets the lines to skip, jumps to the next code if not constant
+
+typedef struct
+{
+	u8   type;			// code type ('0'-'F') or OP_CODE
+	u8   constant;		// OP_CODE: constant write
+	u16  unused;
+	u32  size;			// bytes of the op + data (4-byte aligned)
+	u32  line, lineLen;	// source line in userCodes (log)
+	u32  addr;
+	int  arg0;			// sub-type (0, A), bytes to copy (F), lines to skip (D, E), max replacements (B)
+	uint value;			// count (4, A), offset (6), end address (B), destination (F); OP_CODE: offset of the next code
+	uint inc, valueInc;	// type 4: address & value increment
+	u32  writeLen;		// bytes written (0, 1, 2, 4, B) or compared (D, E)
+	u32  len0, len1;	// bytes of data0 & data1 (after the op)
+} art_op;
+
+static sys_addr_t sysmem_prog = NULL;
+static int userProgLen = 0;
+
 static u64 ptrAddr = 0;
 static uint typeA_Size = 0;
-static int ParseLine(process_id_t pid, char *lines, int start, int *skip, int doForceWrite)
+
+// Appends an op with room for its data; only computes the size of the program if prog is NULL
+static art_op *EmitOp(u8 *prog, int *progLen, u8 type, u32 len0, u32 len1)
 {
-	if (pid == NULL)
-		return userCodesLen;
+	const u32 size = (sizeof(art_op) + len0 + len1 + 3) & ~3;
 
+	art_op *op = prog ? (art_op *)(prog + *progLen) : NULL;
+	if (op)
+	{
+		_memset(op, sizeof(art_op));
+		op->type = type;
+		op->size = size;
+		op->len0 = len0;
+		op->len1 = len1;
+	}
+
+	*progLen += size;
+	return op;
+}
+
+// Decodes a code line (and the second line used by the types 4 & B), returns the end of the line
+static int CompileLine(char *lines, int start, u8 *prog, int *progLen)
+{
 	int lineLen;
 	for (lineLen = start; lineLen < userCodesLen; lineLen++)
 	{
@@ -271,167 +327,325 @@ static int ParseLine(process_id_t pid, char *lines, int start, int *skip, int do
 
 	const int lineEnd = (start + lineLen);
 
-	if (skip[0] <= 0)
+	int arg2Len = 0, arg1Off = 0, arg0, arg0_2 = 0;
+	int arg3Off = lineEnd, arg4Off = arg3Off + 1, arg4Len = arg4Off;
+
+	//Parse first line
+	while ((lineEnd - arg2Len) > 0 && lines[lineEnd - arg2Len] != ' ')
+		arg2Len++;
+	while ((start + arg1Off) < userCodesLen && lines[start + arg1Off] != ' ')
+		arg1Off++;
+
+	//Check if theres a second line
+	if ((lineEnd + 1) < userCodesLen)
 	{
-		skip[0] = 0;
+		//Parse second line vars (for codes that need the second line
+		//Get next code arguments
+		while (arg3Off < userCodesLen && lines[arg3Off] != ' ')
+			arg3Off++;
+		arg4Off = arg3Off + 1;
+		while (arg4Off < userCodesLen && lines[arg4Off] != ' ')
+			arg4Off++;
+		arg4Len = arg4Off + 1;
+		while (arg4Len < userCodesLen && lines[arg4Len] != '\r' && lines[arg4Len] != '\n')
+			arg4Len++;
+		arg4Len -= arg4Off;
+	}
+	else
+		arg4Len = 0;
 
-		int arg2Len = 0, arg1Off = 0, arg0, arg0_2 = 0;
-		int arg3Off = lineEnd, arg4Off = arg3Off + 1, arg4Len = arg4Off;
+	const int buf0size = arg2Len - 1;
+	const int buf0Len  = arg2Len / 2;
+	const int startPos = lineEnd - arg2Len + 1;
 
-		//Parse first line
-		while (lines[lineEnd - arg2Len] != ' ')
-			arg2Len++;
-		while (lines[start + arg1Off] != ' ')
-			arg1Off++;
+	const uint binc = arg4Len/2;					// new (COP) length
+	const uint cmpSize = (arg4Off - arg3Off)/2;		// original (OGP) length
 
-		if (arg2Len < 0)
-			return userCodesLen;
+	const char cType = lines[start];
 
-		char addrBuf[4]; _memset(addrBuf, 4);
+	u32 len0 = 0, len1 = 0;
+	switch (cType)
+	{
+		case '0': case 'D': case 'E': len0 = buf0Len; break;
+		case '1': len0 = buf0size; break;
+		case '2': len0 = 4; break;
+		case '4': len0 = MAX(buf0Len, 4); break;
+		case 'B': len0 = cmpSize; len1 = binc; break;
+	}
 
-		ReadHexPartial(lines, start + 1, (arg1Off - 1), addrBuf, (arg1Off - 1)/2);
-		arg0 = (int)(INT32(addrBuf));
+	art_op *op = EmitOp(prog, progLen, cType, len0, len1);
+	if (!op) return lineEnd;
 
-		ReadHex(lines, start + arg1Off + 1, 8, addrBuf, 4);
-		u64 addr = (u64)(INT32(addrBuf));
-		if (ptrAddr)
+	op->line = start;
+	op->lineLen = lineLen;
+
+	// the buffers are large enough for the values read past the line & the 4 bytes of INT32()
+	const int addrSize = MAX(MAX(arg1Off, arg3Off - lineEnd), arg2Len) + 8; // the address is read as 8 bytes
+	const int buf0Size = MAX(arg2Len, 4);
+	const int buf2Size = MAX(arg4Len, arg4Off - arg3Off) + 4;
+
+	char addrBuf[addrSize]; _memset(addrBuf, addrSize);
+	char buf0[buf0Size]; _memset(buf0, buf0Size);
+	char buf0_2[buf2Size]; _memset(buf0_2, buf2Size);
+	char buf1_2[buf2Size]; _memset(buf1_2, buf2Size);
+
+	ReadHexPartial(lines, start + 1, (arg1Off - 1), addrBuf, (arg1Off - 1)/2);
+	arg0 = (int)(INT32(addrBuf));
+	if (arg0 < 0)
+		arg0 = 0;
+
+	ReadHex(lines, start + arg1Off + 1, 8, addrBuf, 4);
+	op->addr = INT32(addrBuf);
+	op->arg0 = arg0;
+
+	if (arg4Len)
+	{
+		//Get args for second line
+		ReadHexPartial(lines, lineEnd + 2, (arg3Off) - (lineEnd + 2), addrBuf, ((arg3Off) - (lineEnd + 2))/2);
+		arg0_2 = (uint)(INT32(addrBuf));
+
+		//Get address for second line
+		ReadHexPartial(lines, arg3Off + 1, arg4Off - arg3Off - 1, buf0_2, (arg4Off - arg3Off - 1)/2);
+
+		//Get value for second line
+		ReadHexPartial(lines, arg4Off + 1, arg4Len - 1, buf1_2, (arg4Len - 1)/2);
+	}
+
+	char *data0 = (char *)(op + 1), *data1 = data0 + len0;
+
+	switch (cType)
+	{
+		case '0': //Write bytes (1=OR,2=AND,3=XOR,rest=write)
+		case 'D': //Write conditional
+		case 'E': //Write conditional (bitwise)
+			ReadHex(lines, startPos, buf0size, buf0, 4);
+			memcpy(data0, buf0, len0);
+			op->writeLen = buf0Len;
+			break;
+		case '1': //Write text
+			memcpy(data0, lines + startPos, len0);
+			op->writeLen = buf0size;
+			break;
+		case '2': //Write float
+			strncpy(buf0, lines + startPos, buf0size);
+			float buf2Flt = (float)tofloat(buf0);
+			memcpy(data0, &buf2Flt, 4);
+			op->writeLen = MIN(buf0size, 4);
+			break;
+		case '4': //Write condensed
+			ReadHex(lines, startPos, buf0size, buf0, buf0Len);
+			memcpy(data0, buf0, len0);
+			op->writeLen = buf0Len;
+			op->value = (uint)(INT32(buf1_2)); // count
+			op->inc = (uint)(INT32(buf0_2));
+			op->valueInc = (uint)arg0_2;
+			break;
+		case '6': //Write pointer
+		case 'A': //Copy paste (count)
+			ReadHexPartial(lines, startPos, buf0size, buf0, buf0Len);
+			op->value = (uint)(INT32(buf0));
+			break;
+		case 'B': //Find Replace
+			ReadHex(lines, startPos, buf0size, addrBuf, 4);
+			op->value = (uint)(INT32(addrBuf)); // end addr
+			memcpy(data0, buf0_2, len0);
+			memcpy(data1, buf1_2, len1);
+			op->writeLen = binc;
+			break;
+		case 'F': //Copy bytes
+			ReadHex(lines, startPos, buf0size, buf0, 4);
+			op->value = (uint)(INT32(buf0)); // destination
+			break;
+	}
+
+	return lineEnd;
+}
+
+// Loops through each line of the code list & compiles the codes, returns the size of the program
+// Every code starts with an OP_CODE; the codes that are not constant are compiled too (force write)
+static int CompileCodes(char *userCodes, u8 *prog)
+{
+	char lineBuf[101];
+
+	int lineNum = 0, lineCharInd = 0, progLen = 0;
+
+	art_op *code = EmitOp(prog, &progLen, OP_CODE, 0, 0);
+
+	for (int i = 0; i < userCodesLen; i++)
+	{
+		if (userCodes[i] != '#')
 		{
-			addr = ptrAddr;
-			ptrAddr = 0;
-		}
+			if (userCodes[i] == '\n')
+			{
+				lineNum++;
+				lineCharInd = -1;
+			}
+			else
+			{
+				if (lineCharInd == 0)
+				{
+					int n;
+					for (n = i; n < userCodesLen; n++)
+					{
+						if (userCodes[n] == '\n' || userCodes[n] == '\r')
+							break;
+					}
+					n -= i; // line length
+					if(n > 100) n = 100;
+					memcpy64(lineBuf, userCodes + i, n);
+					lineBuf[n] = 0;
+				}
 
-		char buf0[arg2Len]; _memset(buf0, arg2Len);
-		const int buf0size = arg2Len - 1;
-		const int buf0Len  = arg2Len / 2;
+				switch (lineNum)
+				{
+					case 1: //cWrite
+						if (*lineBuf == 0)
+							lineNum--;
+						else if (lineCharInd == 0)
+						{
+							if(code) code->constant = (userCodes[i] == '1' || userCodes[i] == 'T');
+						}
+						break;
+					case 0: //Name
+						break;
 
-		if (arg0 < 0)
-			arg0 = 0;
-		char buf1[arg0]; _memset(buf1, arg0);
+					default: //codes
 
-		//Check if theres a second line
-		if ((lineEnd + 1) < userCodesLen)
+						if (lineNum > 1 && isCodeLineValid(lineBuf))
+						{
+							i = CompileLine(userCodes, i, prog, &progLen);
+						}
+						break;
+				}
+			}
+			lineCharInd++;
+		}
+		else // skip # line
 		{
-			//Parse second line vars (for codes that need the second line
-			//Get next code arguments
-			while (arg3Off < userCodesLen && lines[arg3Off] != ' ')
-				arg3Off++;
-			arg4Off = arg3Off + 1;
-			while (arg4Off < userCodesLen && lines[arg4Off] != ' ')
-				arg4Off++;
-			arg4Len = arg4Off + 1;
-			while (arg4Len < userCodesLen && lines[arg4Len] != '\r' && lines[arg4Len] != '\n')
-				arg4Len++;
-			arg4Len -= arg4Off;
+			lineNum = -1;
+			lineCharInd = 0;
+
+			if(code) code->value = progLen; // next code
+			code = EmitOp(prog, &progLen, OP_CODE, 0, 0);
+
+			while ((i < userCodesLen) && (userCodes[i] == '\n'))
+				i++;
 		}
-		else
-			arg4Len = 0;
+	}
 
-		char buf0_2[arg4Len/2];
-		char buf1_2[(arg4Off - arg3Off)/2];
+	if(code) code->value = progLen;
+
+	return progLen;
+}
 
-		if (arg4Len)
+// Executes the compiled codes & writes to process id
+static void RunCodes(process_id_t pid, u8 *prog)
+{
+	int skip = 0;
+
+	if(file_size(ARTEMIS_CODES_LOG) >= _2MB_)
+		create_file(ARTEMIS_CODES_LOG); // truncate log file larger than 2MB
+
+	for (int pc = 0; pc < userProgLen; )
+	{
+		art_op *op = (art_op *)(prog + pc); pc += op->size;
+
+		if (op->type == OP_CODE)
 		{
-			//Get args for second line
-			ReadHexPartial(lines, lineEnd + 2, (arg3Off) - (lineEnd + 2), addrBuf, ((arg3Off) - (lineEnd + 2))/2);
-			arg0_2 = (uint)(INT32(addrBuf));
+			skip = 0;
+			if (!op->constant && !doForceWrite) //skip this code if not constant or force write
+				pc = op->value;
+			continue;
+		}
 
-			//Get address for second line
-			ReadHexPartial(lines, arg3Off + 1, arg4Off - arg3Off - 1, buf0_2, (arg4Off - arg3Off - 1)/2);
+		if (skip > 0)
+		{
+			skip--;
+			continue;
+		}
 
-			//Get value for second line
-			ReadHexPartial(lines, arg4Off + 1, arg4Len - 1, buf1_2, (arg4Len - 1)/2);
+		u64 addr = (u64)op->addr;
+		if (ptrAddr)
+		{
+			addr = ptrAddr;
+			ptrAddr = 0;
 		}
 
-		int startPos = lineEnd - arg2Len + 1;
+		char *line = userCodes + op->line, c = line[op->lineLen];
+		line[op->lineLen] = '\0';
+		add_log(line); // write line to log file
+		line[op->lineLen] = c;
 
-		lines[lineEnd] = '\0';
-		add_log(lines + start); // write line to log file
-		lines[lineEnd] = '\n';
+		char *data0 = (char *)(op + 1), *data1 = data0 + op->len0;
 
-		char cType = lines[start];
-		switch (cType)
+		switch (op->type)
 		{
-			case '0': ; //Write bytes (1=OR,2=AND,3=XOR,rest=write)
-				ReadHex(lines, startPos, buf0size, buf0, 4);
+			case '0': //Write bytes (1=OR,2=AND,3=XOR,rest=write)
+				if (op->arg0)
+				{
+					const int len = op->writeLen;
+					char buf0[MAX(len, 4)], buf1[len]; // WriteMem() logs 4 bytes
+					memcpy(buf0, data0, len);
 
-				//Get source bytes
-				if(arg0) get_process_mem(pid, addr, buf1, buf0Len);
+					//Get source bytes
+					get_process_mem(pid, addr, buf1, len);
 
-				switch (arg0)
-				{
-					case 1: //OR
-						for (int cnt0 = 0; cnt0 < buf0Len; cnt0++)
-							buf0[cnt0] |= buf1[cnt0];
-						break;
-					case 2: //AND
-						for (int cnt0 = 0; cnt0 < buf0Len; cnt0++)
-							buf0[cnt0] &= buf1[cnt0];
-						break;
-					case 3: //XOR
-						for (int cnt0 = 0; cnt0 < buf0Len; cnt0++)
-							buf0[cnt0] ^= buf1[cnt0];
-						break;
-				}
+					switch (op->arg0)
+					{
+						case 1: //OR
+							for (int cnt0 = 0; cnt0 < len; cnt0++)
+								buf0[cnt0] |= buf1[cnt0];
+							break;
+						case 2: //AND
+							for (int cnt0 = 0; cnt0 < len; cnt0++)
+								buf0[cnt0] &= buf1[cnt0];
+							break;
+						case 3: //XOR
+							for (int cnt0 = 0; cnt0 < len; cnt0++)
+								buf0[cnt0] ^= buf1[cnt0];
+							break;
+					}
 
-				//Write bytes to dest
-				WriteMem(pid, addr, buf0, buf0Len);
+					WriteMem(pid, addr, buf0, len);
+				}
+				else
+					WriteMem(pid, addr, data0, op->writeLen);
 				break;
 			case '1': //Write text
-				//Get total text write size
-				arg1Off++;
-				while (lines[start + arg1Off] != ' ')
-					arg1Off++;
-
-				arg2Len = lineLen - arg1Off;
-				memcpy64(buf0, lines + startPos, buf0size);
-				buf0[buf0size] = '\0';
-				WriteMem(pid, addr, buf0, buf0size);
-				break;
 			case '2': //Write float
-				strncpy(buf0, lines + startPos, buf0size);
-				float buf2Flt = (float)tofloat(buf0);
-				WriteMem(pid, addr, (char*)&buf2Flt, buf0size);
+				WriteMem(pid, addr, data0, op->writeLen);
 				break;
-			case '4': ; //Write condensed
-				//Get count
-				uint count = (uint)(INT32(buf1_2));
-
-				//Get increment
-				u64 inc = (u64)(INT32(buf0_2));
-
-				//Get write
-				ReadHex(lines, startPos, buf0size, buf0, buf0Len);
+			case '4': //Write condensed
+			{
+				char buf4[op->len0];
+				memcpy(buf4, data0, op->len0);
 
-				for (uint cnt4 = 0; cnt4 < count; cnt4++)
+				for (uint cnt4 = 0; cnt4 < op->value; cnt4++)
 				{
-					WriteMem(pid, addr + (u64)(cnt4 * inc), buf0, buf0Len);
-					if (arg0_2)
-						*(uint*)buf0 += (arg0_2 << ((buf0Len % 4) * 8));
+					WriteMem(pid, addr + ((u64)cnt4 * op->inc), buf4, op->writeLen);
+					if (op->valueInc)
+						*(uint*)buf4 += (op->valueInc << ((op->writeLen % 4) * 8));
 				}
 
-				skip[0]++;
+				skip++;
 				break;
-			case '6': //Write pointer
-
-				//Get offset
-				ReadHexPartial(lines, startPos, buf0size, buf0, buf0Len);
-				u64 offset = (u64)(INT32(buf0));
-
+			}
+			case '6': ; //Write pointer
 				//Get address at pointer
-				get_process_mem(pid, addr, buf0, 4);
-				ptrAddr = (u64)(INT32(buf0));
+				char ptr[4]; _memset(ptr, 4);
+				get_process_mem(pid, addr, ptr, 4);
+				ptrAddr = (u64)(INT32(ptr));
 
-				ptrAddr += offset;
+				ptrAddr += (u64)op->value; // offset
 
 				break;
 			case 'A': //Copy paste
 
-				switch (arg0)
+				switch (op->arg0)
 				{
-					case 1:
+					case 1: ;
 						//Get count
-						ReadHexPartial(lines, startPos, buf0size, buf0, buf0Len);
-						uint count = (uint)(INT32(buf0));
+						uint count = op->value;
 
 						if(count > _64KB_) {typeA_Size = 0; break;} // disable paste if copy is too large
 
@@ -465,178 +679,89 @@ static int ParseLine(process_id_t pid, char *lines, int start, int *skip, int do
 				if (!doForceWrite)
 					break;
 
-				//Get end addr
-				ReadHex(lines, startPos, buf0size, addrBuf, 4);
-				u64 endAddr = (u64)(INT32(addrBuf));
+				u64 endAddr = (u64)op->value;
 
 				//new (COP) length
-				uint binc = arg4Len/2;
+				uint binc = op->len1;
 
 				//original (OGP) length
-				uint cmpSize = (arg4Off - arg3Off)/2;
+				uint cmpSize = op->len0;
 
 				//Flip addresses
-				u64 temp = 0;
-				if (endAddr < addr) { temp = addr; addr = endAddr; endAddr = temp; }
+				if (endAddr < addr) { u64 temp = addr; addr = endAddr; endAddr = temp; }
 
 				const size_t scanInc = _64KB_;
+				if (!cmpSize || (cmpSize >= scanInc)) { skip++; break; }
+
 				sys_addr_t sysmem = sys_mem_allocate(scanInc);
 
 				if(sysmem)
 				{
+					u8 shift[256]; PatternShifts((u8 *)data0, cmpSize, shift);
+					u64 found = 0;
+
+					//The windows overlap by cmpSize bytes, so a match at the end of a window is found in the next one
 					for (u64 curAddr = addr; curAddr < endAddr; curAddr += (scanInc - cmpSize))
 					{
+						//Stop if count reached
+						if (op->arg0 > 0 && found >= (u64)op->arg0)
+							break;
+
 						if (get_process_mem(pid, curAddr, (char *)sysmem, scanInc) >= 0)
 						{
-							//So we stop it each loop before (scanInc - cmpSize) in the instance that
-							//the result is the last 2 bytes, for instance, and the compare is actually 4 bytes (so it won't result even though it should)
-							//This fixes that
-							for (u64 boff = 0; boff < (scanInc - cmpSize); boff++)
+							const u32 last = MIN(scanInc - cmpSize, endAddr - curAddr) - 1;
+
+							for (int boff = 0; (boff = FindPattern((u8 *)sysmem, boff, last, (u8 *)data0, cmpSize, shift)) >= 0; )
 							{
 								//Break if count reached
-								if (arg0 > 0 && temp >= (u64)arg0)
-									break;
-								if ((curAddr + boff) >= endAddr)
+								if (op->arg0 > 0 && found >= (u64)op->arg0)
 									break;
 
-								if (CompareMemoryBuffered((char *)sysmem, boff, buf0_2, cmpSize))
-								{
-									//printf ("Instance found at 0x%08x, writing 0x%i (%d)\n", curAddr + boff, *(uint*)buf1_2, binc);
-									WriteMem(pid, curAddr + boff, buf1_2, binc);
-									//Just skip in case the replacement has, within itself, the ogp
-									//We subtract one because it gets added back at the top of the loop
-									boff += binc - 1;
-									temp++;
-								}
+								WriteMem(pid, curAddr + boff, data1, binc);
+								found++;
+
+								//Just skip in case the replacement has, within itself, the ogp
+								if (!binc) break;
+								boff += binc;
 							}
 						}
 					}
 					sys_memory_free(sysmem);
 				}
 
-				skip[0]++;
+				skip++;
 				break;
 			case 'D': //Write conditional
-				ReadHex(lines, startPos, buf0size, buf0, 4);
-				int DisCond = CompareMemory(pid, addr, buf0, buf0Len);
-
-				if (!DisCond)
+				if (!CompareMemory(pid, addr, data0, op->writeLen))
 				{
-					skip[0] += arg0;
+					skip += op->arg0;
 				}
 
 				break;
 			case 'E': //Write conditional (bitwise)
-				ReadHex(lines, startPos, buf0size, buf0, 4);
-				int EisCond = CompareMemoryAnd(pid, addr, buf0, buf0Len);
-
-				if (!EisCond)
+				if (!CompareMemoryAnd(pid, addr, data0, op->writeLen))
 				{
-					skip[0] += arg0;
+					skip += op->arg0;
 				}
 
 				break;
 			case 'F': //Copy bytes
+				if (op->arg0 > _64KB_)
+					break; // ignore copy if too large (like type A)
 
-				//Get destination
-				ReadHex(lines, startPos, buf0size, buf0, 4);
-				u64 dest = (u64)(INT32(buf0));
-
-				//Get source bytes
-				get_process_mem(pid, addr, buf1, arg0);
-				//Write bytes to dest
-				WriteMem(pid, dest, buf1, arg0);
-
-				break;
-
-		}
-	}
-	else
-		skip[0]--;
-
-	return lineEnd;
-}
-
-// Loops through each line of the code list, interprets the codes & writes to process id
-static void ConvertCodes(process_id_t pid, char *userCodes)
-{
-	char lineBuf[100];
-
-	int lineNum = 0, codeNum = 0, lineCharInd = 0;
-	int skip[1]; skip[0] = 0;
+				char buf1[_4KB_];
 
-	if(file_size(ARTEMIS_CODES_LOG) >= _2MB_)
-		create_file(ARTEMIS_CODES_LOG); // truncate log file larger than 2MB
-
-	for (int i = 0; i < userCodesLen; i++)
-	{
-		if (userCodes[i] != '#')
-		{
-			if (userCodes[i] == '\n')
-			{
-				lineNum++;
-				lineCharInd = -1;
-			}
-			else
-			{
-				if (lineCharInd == 0)
-				{
-					int n;
-					for (n = i; n < userCodesLen; n++)
-					{
-						if (userCodes[n] == '\n' || userCodes[n] == '\r')
-							break;
-					}
-					n -= i; // line length
-					if(n > 100) n = sizeof(lineBuf);
-					memcpy64(lineBuf, userCodes + i, n);
-					lineBuf[n] = 0;
-				}
-
-				switch (lineNum)
+				for (int n = 0, len; n < op->arg0; n += len)
 				{
-					case 1: //cWrite
-						if (*lineBuf == 0)
-							lineNum--;
-						else
-						{
-							if (lineCharInd == 0)
-								isConstantWrite = (userCodes[i] == '1' || userCodes[i] == 'T');
-
-							if (!isConstantWrite && !doForceWrite) //skip this code if not constant or force write
-							{
-								while ((i < userCodesLen) && (userCodes[i] != '#'))
-									i++;
-								i--;
-							}
-						}
-						break;
-					case 0: //Name
-						break;
-
-					default: //codes
+					len = MIN(op->arg0 - n, _4KB_);
 
-						if (lineNum > 1 && isCodeLineValid(lineBuf))
-						{
-							if(!(isConstantWrite || doForceWrite))
-								skip[0]++;
-							i = ParseLine(pid, userCodes, i, skip, doForceWrite);
-						}
-						break;
+					//Get source bytes
+					get_process_mem(pid, addr + n, buf1, len);
+					//Write bytes to dest
+					WriteMem(pid, (u64)op->value + n, buf1, len);
 				}
-			}
-			lineCharInd++;
-		}
-		else // skip # line
-		{
-			lineNum = -1;
-			isConstantWrite = 0;
-			skip[0] = 0;
-			codeNum++;
-			lineCharInd = 0;
 
-			while ((i < userCodesLen) && (userCodes[i] == '\n'))
-				i++;
+				break;
 		}
 	}
 }
@@ -648,6 +773,9 @@ static void release_art(bool init)
 		userCodesLen = attachedPID = 0;
 	if(sysmem_art)
 		{sys_memory_free(sysmem_art); sysmem_art = NULL;}
+	if(sysmem_prog)
+		{sys_memory_free(sysmem_prog); sysmem_prog = NULL;}
+	userProgLen = 0;
 	if(typeA_Copy)
 		{sys_memory_free(typeA_Copy); typeA_Copy = NULL;}
 	userCodes = NULL;
@@ -695,6 +823,15 @@ static void art_process(int forceWrite)
 				{
 					userCodes[userCodesLen] = '\n'; // append line break
 					userCodes[++userCodesLen] = '\0';
+
+					// compile the codelist once (1st pass computes the size of the program)
+					userProgLen = CompileCodes(userCodes, NULL);
+					sysmem_prog = sys_mem_allocate(_64KB_ + (userProgLen / _64KB_) * _64KB_);
+
+					if(sysmem_prog)
+						CompileCodes(userCodes, (u8 *)sysmem_prog);
+					else
+						release_art(1);
 				}
 				else
 					release_art(1);
@@ -707,9 +844,9 @@ static void art_process(int forceWrite)
 			}
 		}
 
-		if (userCodes && (attachedPID == GetGameProcessID()))
+		if (userCodes && sysmem_prog && (attachedPID == GetGameProcessID()))
 		{
-			ConvertCodes(attachedPID, userCodes);
+			RunCodes(attachedPID, (u8 *)sysmem_prog);
 			sys_timer_usleep(100000);
 		}
 	}
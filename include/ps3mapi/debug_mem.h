@@ -81,7 +81,7 @@ static void peek_chunk_flash(u64 start_sector, u32 size, u64 *buffer) // read fr
 		peek_chunk_device(FLASH_DEVICE_NAND, start_sector, size, buffer);
 }
 
-static int ps3mapi_get_memory(u32 pid, u32 address, char *mem, u32 size)
+static int ps3mapi_get_memory(u32 pid, u64 address, char *mem, u32 size)
 {
 	if(pid == LV1)
 	{
@@ -113,6 +113,37 @@ static int ps3mapi_get_memory(u32 pid, u32 address, char *mem, u32 size)
 	return 0;
 }
 
+// Memory search engine (/find.lv1, /find.lv2, ps3mapi_find_offset)
+// Reads the memory in chunks into mem & scans them with find_masked(). Every step bytes from *address to stop (excluded)
+// Returns true with the address of the hit in *address, false if not found (or the memory could not be read)
+static bool find_memory(u32 pid, u64 *address, u64 stop, u8 step, const char *sfind, u8 len, const char *mask, char *mem, u32 chunk_size)
+{
+	char label[20];
+	u64 pos = *address;
+
+	if(!len || !step || (chunk_size < (u32)len + 8)) return false;
+
+	while(pos < stop)
+	{
+		u64 base = pos & ~7ULL; // read 8-byte aligned chunks
+		u64 end  = MIN(stop - 1, base + chunk_size - len); // last position in this chunk
+
+		u32 first = (u32)(pos - base), last = (u32)(end - base);
+		u32 size  = (last + len + 7) & ~7;
+
+		if(ps3mapi_get_memory(pid, base, mem, size) < 0) break;
+
+		s32 offset = find_masked(mem, first, last, step, sfind, len, mask);
+		if(offset >= 0) {*address = base + offset; return true;}
+
+		pos += ((last - first) / step + 1) * step;
+
+		sprintf(label, "0x%llx", pos); show_progress(label, OV_FIND);
+	}
+
+	return false;
+}
+
 static void ps3mapi_dump_process(const char *dump_file, u32 pid, u32 address, u32 size)
 {
 	sys_addr_t sysmem = sys_mem_allocate(_64KB_);
@@ -189,12 +220,13 @@ static void ps3mapi_mem_dump(char *buffer, char *templn, char *param)
 }
 
 #define HEXVIEW_SIZE	0x200
+#define FIND_PAGE_HITS	32
 
 static void ps3mapi_find_peek_poke_hexview(char *buffer, char *templn, char *param)
 {
 	u64 address = 0, addr, byte_addr, upper_memory = LV1_UPPER_MEMORY, found_address = 0, step = 1;
 	u8 byte = 0, p = 0, lv1 = 0, rep = 1, oper = 0; // replace value
-	bool found = false, not_found = false;
+	bool found = false, not_found = false, find_all = false;
 	int flen = 0, hilite;
 	char *v;
 
@@ -226,16 +258,16 @@ static void ps3mapi_find_peek_poke_hexview(char *buffer, char *templn, char *par
 			{
 				char *mem = (char*)sysmem, *mask = sfind;
 				s32 i, n; u64 addr = address;
-				u64 faster = faster_find(sfind, flen, mask);
+				replace_char(mask, '*', '?'); // use single type of wildcard
 				while((n = read_file(fname, mem, _64KB_, addr)))
 				{
 					n -= flen; if(n <= 0) break;
-					for(i = 0; i < n; i++)
+					for(i = 0; (i = find_masked(mem, i, n - 1, 1, sfind, flen, mask)) >= 0; i++)
 					{
-						if(faster && (*(u64*)(mem + i) != faster)) continue;
-						if(!bcompare(mem + i, sfind, flen, mask) && !(--rep)) break;
+						if(!(--rep)) break;
 					}
-					addr += i; if(i < n) {address = found_address = addr; found = true; break;}
+					if(i >= 0) {address = found_address = addr + i; found = true; break;}
+					addr += n;
 				}
 				sys_memory_free(sysmem);
 				if(rep) not_found = true;
@@ -287,7 +319,9 @@ static void ps3mapi_find_peek_poke_hexview(char *buffer, char *templn, char *par
 
 	if(islike(param, "/find.lv"))
 	{
-		char *pos = strstr(param, "&rep="); if(pos) {rep = (u8)val(pos + 5); *pos = NULL;}
+		char *pos = strstr(param, "&all"); if(pos) {find_all = true; *pos = NULL;} // list the next hits
+
+		pos = strstr(param, "&rep="); if(pos) {rep = (u8)val(pos + 5); *pos = NULL;}
 
 		pos = strchr(param, '#'); if(!pos) pos = strstr(param, "&align");
 		if(pos) {*pos = NULL, step = 4, address &= 0x80000000FFFFFFFCULL;} // find using aligned memory address (4X faster) e.g. /find.lv2?3000=3940ffff#
@@ -309,27 +343,23 @@ static void ps3mapi_find_peek_poke_hexview(char *buffer, char *templn, char *par
 	else
 	if(islike(param, "/find.lv"))
 	{
-		char tfind[33], label[20];
 		if(isHEX(v + 1))
 			flen = Hex2Bin(v + 1, sfind);
 		else
 			flen = sprintf(sfind, "%s", v + 1);
 
-		u64 (*peek_mem)(u64) = lv1 ? peek_lv1 : peekq;
+		replace_char(sfind, '*', '?'); // use single type of wildcard
 
 		u64 _upper_memory = (upper_memory - flen + 8) & 0x8FFFFFFFFFFFFFF0ULL;
-		u64 faster = faster_find(sfind, flen, sfind);
-		for(addr = address; addr < _upper_memory; addr += step)
-		{
-			if(faster && (peek_mem(addr) != faster)) continue;
-
-			for(u8 n = 0; n < flen; n += 8)
-				*(u64*)(tfind + n) = peek_mem(addr +  n);
 
-			if(!bcompare(tfind, sfind, flen, sfind) && !(--rep)) {address = found_address = addr; found = true; break;}
+		// staging buffer for the chunks of memory
+		sys_addr_t sysmem = sys_mem_allocate(_64KB_);
+		char *mem = sysmem ? (char*)sysmem : (char*)data;
+		u32 chunk_size = sysmem ? _64KB_ : HEXVIEW_SIZE;
+		u32 pid = lv1 ? LV1 : LV2;
 
-			if((addr & 0xF00) == 0) {sprintf(label, "0x%llx", address + addr); show_progress(label, OV_FIND);}
-		}
+		for(addr = address; (found = find_memory(pid, &addr, _upper_memory, step, sfind, flen, sfind, mem, chunk_size)); addr += step)
+			if(!(--rep)) break;
 
 		if(!found)
 		{
@@ -339,7 +369,27 @@ static void ps3mapi_find_peek_poke_hexview(char *buffer, char *templn, char *par
 		{
 			found_address = address = addr;
 			sprintf(templn, "Offset: 0x%08X<br><br>", (u32)address); buffer += concat(buffer, templn);
+
+			if(find_all)
+			{
+				// next hits of the page & link to the next page
+				u8 hits = 1;
+				for(addr += step; (hits < FIND_PAGE_HITS) && find_memory(pid, &addr, _upper_memory, step, sfind, flen, sfind, mem, chunk_size); addr += step, hits++)
+				{
+					sprintf(templn, "<a href=\"/peek.lv%i?%llx\">0x%08X</a> ", lv1 ? 1 : 2, addr, (u32)addr); buffer += concat(buffer, templn);
+				}
+				// link to the next page only if there is a next hit (the page starts at that hit)
+				if((hits >= FIND_PAGE_HITS) && (strlen(v + 1) < 256) && find_memory(pid, &addr, _upper_memory, step, sfind, flen, sfind, mem, chunk_size))
+				{
+					u16 n = sprintf(templn, "<a href=\"/find.lv%i?%llx=", lv1 ? 1 : 2, addr);
+					urlenc(templn + n, v + 1); n = strlen(templn); // the value is URL encoded (up to 3 x 255 chars)
+					sprintf(templn + n, "&stop=%llx%s&all\">%s</a>", upper_memory, (step == 4) ? "&align" : "", "Next>"); buffer += concat(buffer, templn);
+				}
+				buffer += concat(buffer, "<br><br>");
+			}
 		}
+
+		if(sysmem) sys_memory_free(sysmem);
 		disable_progress();
 	}
 	else
@@ -0,0 +1,220 @@
+#ifndef __MEM_SCAN_H__
+#define __MEM_SCAN_H__
+
+// Scan core of the memory search sessions (/getmem.ps3mapi?scan=)
+// Portable C: a page of memory is compared with a value and/or its previous snapshot
+// The positions (offset / align) that still match are kept in a bitmap, 1 bit per position
+// Values are read big endian, like the memory of the PS3 processes
+// The signed types compare as two's complement (>, <, increased, decreased)
+
+#include <stdint.h>
+#include <string.h>
+
+#define MEMSCAN_PAGE	0x10000					// bytes per page
+#define MEMSCAN_BITMAP	(MEMSCAN_PAGE / 8)		// bitmap bytes of a page (align 1)
+
+enum memscan_types
+{
+	MEMSCAN_U8,
+	MEMSCAN_U16,
+	MEMSCAN_U32,
+	MEMSCAN_U64,
+	MEMSCAN_FLOAT,
+	MEMSCAN_S8,
+	MEMSCAN_S16,
+	MEMSCAN_S32,
+	MEMSCAN_S64,
+};
+
+enum memscan_ops
+{
+	MEMSCAN_ANY,		// unknown value (first scan)
+	MEMSCAN_EQ,			// == value
+	MEMSCAN_NE,			// != value
+	MEMSCAN_GT,			// >  value
+	MEMSCAN_LT,			// <  value
+	MEMSCAN_CHANGED,	// != previous  (the next ops need a previous snapshot)
+	MEMSCAN_UNCHANGED,	// == previous
+	MEMSCAN_INC,		// >  previous
+	MEMSCAN_DEC,		// <  previous
+	MEMSCAN_INC_BY,		// == previous + value
+	MEMSCAN_DEC_BY,		// == previous - value
+};
+
+static const uint8_t memscan_size[] = {1, 2, 4, 8, 4, 1, 2, 4, 8};
+
+static inline uint64_t memscan_load(const uint8_t *p, uint8_t size)
+{
+	uint64_t v = 0;
+	for(uint8_t i = 0; i < size; i++) v = (v << 8) | p[i];
+	return v;
+}
+
+static inline float memscan_float(uint64_t bits)
+{
+	union {uint32_t u; float f;} v; v.u = (uint32_t)bits;
+	return v.f;
+}
+
+// sign extends a value of size bytes
+static inline int64_t memscan_signed(uint64_t v, uint8_t size)
+{
+	uint8_t shift = 64 - (size * 8);
+	return (int64_t)(v << shift) >> shift;
+}
+
+static inline uint8_t memscan_popcount(uint8_t b)
+{
+	b = b - ((b >> 1) & 0x55);
+	b = (b & 0x33) + ((b >> 2) & 0x33);
+	return (b + (b >> 4)) & 0x0F;
+}
+
+// number of positions of a page for a value type & alignment
+static inline uint32_t memscan_positions(uint32_t size, uint8_t type, uint8_t align)
+{
+	uint8_t vsize = memscan_size[type];
+	return (size < vsize) ? 0 : ((size - vsize) / align) + 1;
+}
+
+static inline int memscan_match(uint8_t type, uint8_t op, uint64_t cur, uint64_t prev, uint64_t value, uint64_t mask)
+{
+	if(type == MEMSCAN_FLOAT)
+	{
+		float c = memscan_float(cur), p = memscan_float(prev), v = memscan_float(value);
+
+		switch(op)
+		{
+			case MEMSCAN_EQ:		return c == v;
+			case MEMSCAN_NE:		return c != v;
+			case MEMSCAN_GT:		return c >  v;
+			case MEMSCAN_LT:		return c <  v;
+			case MEMSCAN_CHANGED:	return cur != prev;
+			case MEMSCAN_UNCHANGED:	return cur == prev;
+			case MEMSCAN_INC:		return c >  p;
+			case MEMSCAN_DEC:		return c <  p;
+			case MEMSCAN_INC_BY:	return c == p + v;
+			case MEMSCAN_DEC_BY:	return c == p - v;
+		}
+		return 1;
+	}
+
+	if(type >= MEMSCAN_S8)
+	{
+		uint8_t vsize = memscan_size[type];
+		int64_t c = memscan_signed(cur, vsize), p = memscan_signed(prev, vsize), v = memscan_signed(value, vsize);
+
+		switch(op)
+		{
+			case MEMSCAN_GT:		return c >  v;
+			case MEMSCAN_LT:		return c <  v;
+			case MEMSCAN_INC:		return c >  p;
+			case MEMSCAN_DEC:		return c <  p;
+		}
+		// ==, !=, changed and +N / -N are the same as unsigned
+	}
+
+	switch(op)
+	{
+		case MEMSCAN_EQ:		return cur == value;
+		case MEMSCAN_NE:		return cur != value;
+		case MEMSCAN_GT:		return cur >  value;
+		case MEMSCAN_LT:		return cur <  value;
+		case MEMSCAN_CHANGED:	return cur != prev;
+		case MEMSCAN_UNCHANGED:	return cur == prev;
+		case MEMSCAN_INC:		return cur >  prev;
+		case MEMSCAN_DEC:		return cur <  prev;
+		case MEMSCAN_INC_BY:	return cur == ((prev + value) & mask);
+		case MEMSCAN_DEC_BY:	return cur == ((prev - value) & mask);
+	}
+	return 1;
+}
+
+// narrows the candidates of a page
+// cur  = current memory of the page
+// prev = snapshot of the previous scan or NULL for the first scan (all the positions are candidates)
+// bits = candidates bitmap (written by the first scan)
+// returns the candidates left in the page
+static uint32_t memscan_page(const uint8_t *cur, const uint8_t *prev, uint8_t *bits, uint32_t size, uint8_t type, uint8_t align, uint8_t op, uint64_t value)
+{
+	uint8_t vsize = memscan_size[type];
+	uint32_t positions = memscan_positions(size, type, align), count = 0;
+	uint64_t mask = (vsize == 8) ? ~0ULL : ((1ULL << (vsize * 8)) - 1);
+
+	if(!positions) return 0;
+
+	value &= mask;
+
+	if(!prev)
+	{
+		if(op >= MEMSCAN_CHANGED) op = MEMSCAN_ANY; // nothing to compare yet
+
+		memset(bits, 0, (positions + 7) / 8);
+
+		if(op == MEMSCAN_ANY)
+		{
+			memset(bits, 0xFF, positions / 8);
+			if(positions & 7) bits[positions / 8] = (1 << (positions & 7)) - 1;
+			return positions;
+		}
+
+		for(uint32_t n = 0, offset = 0; n < positions; n++, offset += align)
+		{
+			if(memscan_match(type, op, memscan_load(cur + offset, vsize), 0, value, mask))
+				{bits[n >> 3] |= 1 << (n & 7); count++;}
+		}
+		return count;
+	}
+
+	int keep = (op == MEMSCAN_ANY); // nothing to narrow
+
+	// unchanged page: only "unchanged" (or +0 / -0) keeps its candidates
+	if((op >= MEMSCAN_CHANGED) && !memcmp(cur, prev, size))
+	{
+		if((op == MEMSCAN_UNCHANGED) || (((op == MEMSCAN_INC_BY) || (op == MEMSCAN_DEC_BY)) && !value)) keep = 1;
+		else
+		{
+			memset(bits, 0, (positions + 7) / 8);
+			return 0;
+		}
+	}
+
+	for(uint32_t n = 0; n < positions; n += 8)
+	{
+		uint8_t b = bits[n >> 3];
+		if(!b) continue;
+
+		if(!keep)
+		{
+			for(uint8_t i = 0; i < 8; i++)
+			{
+				if(!(b & (1 << i))) continue;
+
+				uint32_t offset = (n + i) * align;
+				uint64_t c = memscan_load(cur + offset, vsize);
+				uint64_t p = (op >= MEMSCAN_CHANGED) ? memscan_load(prev + offset, vsize) : 0;
+
+				if(!memscan_match(type, op, c, p, value, mask)) b &= ~(1 << i);
+			}
+			bits[n >> 3] = b;
+		}
+
+		count += memscan_popcount(b);
+	}
+
+	return count;
+}
+
+// index of the next candidate from position n or -1
+static int32_t memscan_next(const uint8_t *bits, uint32_t positions, uint32_t n)
+{
+	for(; n < positions; n++)
+	{
+		uint8_t b = bits[n >> 3] >> (n & 7);
+		if(!b) {n |= 7; continue;}
+		if(b & 1) return (int32_t)n;
+	}
+	return -1;
+}
+
+#endif // __MEM_SCAN_H__
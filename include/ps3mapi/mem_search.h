@@ -0,0 +1,294 @@
+#ifdef PS3MAPI
+
+// Memory search sessions (unknown value / changed / increased ... like a cheat searcher)
+// /getmem.ps3mapi?proc=<pid>&addr=<start>&stop=<end>&scan=new[&type=u8|u16|u32|u64|float|s8|s16|s32|s64][&align=<n>][&num=<value>]
+// /getmem.ps3mapi?scan=<eq|ne|gt|lt|changed|unchanged|inc|dec|incby|decby>[&num=<value>]
+// /getmem.ps3mapi?scan=list[&from=<n>]
+// /getmem.ps3mapi?scan=end
+//
+// The session keeps one record per page of the region in MEMSCAN_FILE: [candidates bitmap][snapshot of the page]
+// The pages without candidates are dropped (not read nor written again)
+// A record is written back only if its bitmap or the memory of the page changed
+// There is one session: a request that finds it in use by another client gets "busy"
+
+#include "mem_scan.h"
+
+#define MEMSCAN_FILE		WMTMP "/memscan.bin"
+#define MEMSCAN_RECORD		(MEMSCAN_BITMAP + MEMSCAN_PAGE)
+#define MEMSCAN_MAX_PAGES	1024	// 64MB per session
+#define MEMSCAN_LIST		32		// candidates listed per page
+
+static const char *memscan_types[] = {"u8", "u16", "u32", "u64", "float", "s8", "s16", "s32", "s64", NULL};
+static const char *memscan_ops[] = {"any", "eq", "ne", "gt", "lt", "changed", "unchanged", "inc", "dec", "incby", "decby", NULL};
+
+static struct
+{
+	u32 pid;
+	u32 start;
+	u16 pages;		// 0 = no session
+	u16 scans;
+	u8  type, align;
+	u32 candidates;
+	u32 count[MEMSCAN_MAX_PAGES];	// candidates per page (0 = dropped)
+} memscan;
+
+static s8 memscan_index(const char **list, const char *name)
+{
+	for(u8 i = 0; list[i]; i++)
+		if(IS(list[i], name)) return i;
+	return NONE;
+}
+
+static u64 memscan_value(const char *num, u8 type)
+{
+	if((type != MEMSCAN_FLOAT) || islike(num, "0x")) return (u64)val(num);
+
+	// decimal float: [-]123.456
+	union {u32 u; float f;} v;
+
+	bool neg = (*num == '-'); if(neg) num++;
+	const char *dot = strchr(num, '.');
+
+	v.f = (float)val(num);
+	if(dot) for(float d = 0.1f; ISDIGIT(*++dot); d /= 10) v.f += (*dot - '0') * d;
+	if(neg) v.f = -v.f;
+
+	return v.u;
+}
+
+static void memscan_value_str(char *str, u64 value, u8 type)
+{
+	if(type == MEMSCAN_FLOAT)
+	{
+		float f = memscan_float(value); bool neg = (f < 0); if(neg) f = -f;
+		u32 n = (u32)f;
+		sprintf(str, "%s%u.%03u", neg ? "-" : "", n, (u32)((f - n) * 1000));
+	}
+	else if(type >= MEMSCAN_S8)
+		sprintf(str, "%lld (0x%llX)", memscan_signed(value, memscan_size[type]), value);
+	else
+		sprintf(str, "%llu (0x%llX)", value, value);
+}
+
+// runs a scan over the pages of the session, returns the candidates left
+static u32 memscan_run(u8 op, u64 value, bool is_new)
+{
+	sys_addr_t sysmem = sys_mem_allocate(_192KB_);
+	if(!sysmem) {if(is_new) memscan.pages = 0; return memscan.candidates;}
+
+	int fd;
+	u8 *cur  = (u8*)sysmem;
+	u8 *bits = cur + MEMSCAN_PAGE;		// record: [bitmap][previous snapshot]
+	u8 *prev = bits + MEMSCAN_BITMAP;
+
+	u32 bits_size = (memscan_positions(MEMSCAN_PAGE, memscan.type, memscan.align) + 7) / 8;
+
+	int flags = is_new ? (CELL_FS_O_CREAT | CELL_FS_O_TRUNC | CELL_FS_O_RDWR) : CELL_FS_O_RDWR;
+
+	if(cellFsOpen(MEMSCAN_FILE, flags, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+	{
+		{ PS3MAPI_ENABLE_ACCESS_SYSCALL8 }
+
+		char label[20]; u64 pos, bytes;
+
+		memscan.candidates = 0;
+
+		for(u16 page = 0; page < memscan.pages; page++)
+		{
+			if(!is_new && !memscan.count[page]) continue; // dropped
+
+			u32 address = memscan.start + (page * MEMSCAN_PAGE);
+			u64 offset = (u64)page * MEMSCAN_RECORD;
+			u32 count = 0;
+
+			if(ps3mapi_get_memory(memscan.pid, address, (char*)cur, MEMSCAN_PAGE) < 0) goto drop_page;
+
+			if(!is_new)
+			{
+				if(cellFsReadWithOffset(fd, offset, bits, MEMSCAN_RECORD, &bytes) != CELL_FS_SUCCEEDED || (bytes != MEMSCAN_RECORD)) goto drop_page;
+			}
+
+			count = memscan_page(cur, is_new ? NULL : prev, bits, MEMSCAN_PAGE, memscan.type, memscan.align, op, value);
+
+			if(count)
+			{
+				// the scans only clear bits: the same count is the same bitmap
+				if(is_new || (count != memscan.count[page]))
+				{
+					cellFsLseek(fd, offset, CELL_FS_SEEK_SET, &pos);
+					cellFsWrite(fd, bits, bits_size, NULL);
+				}
+				if(is_new || memcmp(cur, prev, MEMSCAN_PAGE))
+				{
+					cellFsLseek(fd, offset + MEMSCAN_BITMAP, CELL_FS_SEEK_SET, &pos);
+					cellFsWrite(fd, cur, MEMSCAN_PAGE, NULL);
+				}
+			}
+
+		drop_page:
+			memscan.count[page] = count;
+			memscan.candidates += count;
+
+			if(!(page & 0xF)) {sprintf(label, "0x%x", address); show_progress(label, OV_FIND);}
+		}
+
+		{ PS3MAPI_DISABLE_ACCESS_SYSCALL8 }
+
+		cellFsClose(fd);
+
+		memscan.scans++;
+
+		disable_progress();
+	}
+	else if(is_new)
+		memscan.pages = 0;
+
+	sys_memory_free(sysmem);
+
+	return memscan.candidates;
+}
+
+static void memscan_list(char *buffer, char *templn, u32 from)
+{
+	int fd;
+	if(cellFsOpen(MEMSCAN_FILE, CELL_FS_O_RDONLY, &fd, NULL, 0) != CELL_FS_SUCCEEDED) return;
+
+	sys_addr_t sysmem = sys_mem_allocate(_64KB_);
+	if(sysmem)
+	{
+		u8 *bits = (u8*)sysmem, mem[8]; char value[40]; u64 bytes;
+
+		u8  vsize = memscan_size[memscan.type];
+		u32 positions = memscan_positions(MEMSCAN_PAGE, memscan.type, memscan.align);
+		u32 index = 0, shown = 0;
+
+		for(u16 page = 0; (page < memscan.pages) && (shown < MEMSCAN_LIST); page++)
+		{
+			u32 count = memscan.count[page];
+			if(!count) continue;
+			if(index + count <= from) {index += count; continue;}
+
+			if(cellFsReadWithOffset(fd, (u64)page * MEMSCAN_RECORD, bits, (positions + 7) / 8, &bytes) != CELL_FS_SUCCEEDED) break;
+
+			for(s32 n = memscan_next(bits, positions, 0); (n >= 0) && (shown < MEMSCAN_LIST); n = memscan_next(bits, positions, n + 1), index++)
+			{
+				if(index < from) continue;
+
+				u32 address = memscan.start + (page * MEMSCAN_PAGE) + (n * memscan.align);
+
+				if(ps3mapi_get_memory(memscan.pid, address, (char*)mem, 8) < 0) _memset(mem, 8);
+				memscan_value_str(value, memscan_load(mem, vsize), memscan.type);
+
+				sprintf(templn, "<a href=\"/getmem.ps3mapi?proc=0x%x&addr=%x\">%08X</a> %s<br>", memscan.pid, address, address, value);
+				buffer += concat(buffer, templn); shown++;
+			}
+		}
+
+		if(from + shown < memscan.candidates)
+		{
+			sprintf(templn, "<a href=\"/getmem.ps3mapi?proc=0x%x&scan=list&from=%u\">Next></a><br>", memscan.pid, from + shown);
+			concat(buffer, templn);
+		}
+
+		sys_memory_free(sysmem);
+	}
+
+	cellFsClose(fd);
+}
+
+static void ps3mapi_memscan(char *buffer, char *templn, const char *param, u32 pid, u32 address)
+{
+	char scan[12], num[24];
+
+	bool has_num = get_param("num=", num, param, 23);
+
+	if(!mutex_trylock(memscan_mutex))
+	{
+		sprintf(templn, "<b><u>%s:</u></b> %s<br><br>", "Search", "busy"); concat(buffer, templn);
+		return;
+	}
+
+	if(get_param("scan=", scan, param, 11))
+	{
+		if(IS(scan, "end"))
+		{
+			memscan.pages = 0;
+			cellFsUnlink(MEMSCAN_FILE);
+		}
+		else if(IS(scan, "new") && (pid >= PID))
+		{
+			char type[8]; s8 n = get_param("type=", type, param, 7) ? memscan_index(memscan_types, type) : NONE;
+			memscan.type = (n < 0) ? MEMSCAN_U32 : n;
+
+			u8 vsize = memscan_size[memscan.type];
+			u8 align = get_valuen(param, "align=", 0, 8);
+			memscan.align = (align == 1 || align == 2 || align == 4 || align == 8) ? align : MIN(vsize, 4);
+
+			u32 stop = 0; const char *pos = strstr(param, "&stop=");
+			if(pos) stop = convertH(pos + 6); if(stop <= address) stop = address + 0x1000000;
+
+			memscan.pid = pid;
+			memscan.start = address & ~(memscan.align - 1);
+			memscan.pages = MIN((stop - memscan.start + MEMSCAN_PAGE - 1) / MEMSCAN_PAGE, MEMSCAN_MAX_PAGES);
+			memscan.scans = 0;
+
+			memscan_run(has_num ? MEMSCAN_EQ : MEMSCAN_ANY, has_num ? memscan_value(num, memscan.type) : 0, true);
+		}
+		else if(memscan.pages)
+		{
+			s8 op = memscan_index(memscan_ops, scan);
+			if(op >= 0) memscan_run(op, memscan_value(num, memscan.type), false);
+		}
+	}
+
+	sprintf(templn, "<b><u>%s:</u></b> ", "Search"); concat(buffer, templn);
+
+	if(memscan.pages)
+	{
+		sprintf(templn, "%u candidates (%s) at 0x%x-0x%x, scan #%u",
+						memscan.candidates, memscan_types[memscan.type],
+						memscan.start, memscan.start + (memscan.pages * MEMSCAN_PAGE), memscan.scans); concat(buffer, templn);
+
+		const char *labels[] = {"Changed", "Unchanged", "Increased", "Decreased"};
+		for(u8 op = MEMSCAN_CHANGED; op <= MEMSCAN_DEC; op++)
+		{
+			sprintf(templn, " [<a href=\"/getmem.ps3mapi?proc=0x%x&scan=%s\">%s</a>]", memscan.pid, memscan_ops[op], labels[op - MEMSCAN_CHANGED]);
+			concat(buffer, templn);
+		}
+
+		// default value of the prompts: only the characters of a number (num is written into a javascript: URL)
+		if(has_num) for(const char *c = num; *c; c++) if(!ISHEX(*c) && !strchr("+-.xX", *c)) {has_num = false; break;}
+
+		const char *prompts[] = {"=", "&ne;", "&gt;", "&lt;"};
+		for(u8 op = MEMSCAN_EQ; op <= MEMSCAN_LT; op++)
+		{
+			sprintf(templn, " [<a href=\"javascript:void(location.href='/getmem.ps3mapi?proc=0x%x&scan=%s&num='+prompt('%s','%s').toString());\">%s</a>]",
+							memscan.pid, memscan_ops[op], "Value", has_num ? num : "", prompts[op - MEMSCAN_EQ]);
+			concat(buffer, templn);
+		}
+
+		sprintf(templn, " [<a href=\"javascript:void(location.href='/getmem.ps3mapi?proc=0x%x&scan=incby&num='+prompt('%s','1').toString());\">+N</a>]"
+						" [<a href=\"javascript:void(location.href='/getmem.ps3mapi?proc=0x%x&scan=decby&num='+prompt('%s','1').toString());\">-N</a>]"
+						" [<a href=\"/getmem.ps3mapi?proc=0x%x&scan=end\">%s</a>]<br>",
+						memscan.pid, "Value", memscan.pid, "Value", memscan.pid, "End"); concat(buffer, templn);
+
+		if(memscan.candidates) memscan_list(buffer, templn, get_valuen32(param, "from="));
+	}
+	else if(pid >= PID)
+	{
+		sprintf(templn, HTML_FORM_METHOD_FMT("/getmem")
+						"<input type=\"hidden\" name=\"proc\" value=\"0x%x\">"
+						"<input type=\"hidden\" name=\"scan\" value=\"new\">"
+						"%s: " HTML_INPUT("addr", "%X", "8", "10") " - " HTML_INPUT("stop", "%X", "8", "10")
+						" <select name=\"type\"><option>u8<option>u16<option selected>u32<option>u64<option>float<option>s8<option>s16<option>s32<option>s64</select>"
+						" %s: " HTML_INPUT("num", "", "20", "12")
+						" <input class=\"bs\" type=\"submit\" value=\" %s \"/></form>",
+						HTML_FORM_METHOD, pid, "Range", address, address + 0x1000000, "Value", "New Search"); concat(buffer, templn);
+	}
+
+	concat(buffer, "<br>");
+
+	mutex_unlock(memscan_mutex);
+}
+
+#endif // #ifdef PS3MAPI
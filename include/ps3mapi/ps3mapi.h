@@ -694,9 +694,8 @@ static u8 add_proc_list(char *buffer, char *templn, u32 *proc_id, u8 src)
 
 static u32 ps3mapi_find_offset(u32 pid, u32 address, u32 stop, u8 step, const char *sfind, u8 len, char *mask, u32 fallback)
 {
-	char label[20], buffer[0x200], *mem;
+	char buffer[0x200], *mem;
 
-	int retval = NONE;
 	found_offset = fallback;
 
 	u32 chunk_size = _64KB_; sys_addr_t sysmem = sys_mem_allocate(chunk_size);
@@ -709,28 +708,13 @@ static u32 ps3mapi_find_offset(u32 pid, u32 address, u32 stop, u8 step, const ch
 		mem = buffer, chunk_size = sizeof(buffer);
 	}
 
-	u64 faster = faster_find(sfind, len, mask);
-	const u32 m = chunk_size - len, gap = (len + 0x10) - (len % 0x10);
-	for(; address < stop; address += chunk_size - gap)
-	{
-		retval = ps3mapi_get_memory(pid, address, mem, chunk_size);
-		if(retval < 0) break;
-
-		sprintf(label, "0x%x", address); show_progress(label, OV_FIND);
+	replace_char(mask, '*', '?'); // use single type of wildcard
 
-		for(u32 offset = 0; offset < m; offset += step)
-		{
-			if(faster && (*(u64*)(mem + offset) != faster)) continue;
+	u64 addr = address;
+	if(find_memory(pid, &addr, stop, step, sfind, len, mask, mem, chunk_size))
+		found_offset = (u32)addr;
 
-			if( !bcompare(mem + offset, sfind, len, mask) )
-			{
-				found_offset = (address + offset);
-				address = stop;
-				break;
-			}
-		}
-	}
-	if(chunk_size == _64KB_)
+	if(sysmem)
 		sys_memory_free(sysmem);
 	disable_progress();
 	return found_offset;
@@ -1003,6 +987,8 @@ static void ps3mapi_getmem(char *buffer, char *templn, const char *param)
 
 	concat(buffer, "<br>");
 
+	if(!is_ps3mapi_home && !is_read_only) ps3mapi_memscan(buffer, templn, param, pid, address);
+
 #ifdef DEBUG_MEM
 	concat(buffer, "Dump: [<a href=\"/dump.ps3?mem\">Full Memory</a>] [<a href=\"/dump.ps3?flash\">Flash</a>] [<a href=\"/dump.ps3?rsx\">RSX</a>] [<a href=\"/dump.ps3?vsh\">VSH</a>] [<a href=\"/dump.ps3?lv1\">LV1</a>] [<a href=\"/dump.ps3?lv2\">LV2</a>]");
 	sprintf(templn, " [<a href=\"/dump.ps3?%x\">LV1 Dump 0x%x</a>] [<a href=\"/peek.lv1?%x\">LV1 Peek</a>] [<a href=\"/peek.lv2?%x\">LV2 Peek</a>]", address, address, address, address); concat(buffer, templn + (address ? 0 : 41));
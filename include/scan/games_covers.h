@@ -65,23 +65,220 @@ static bool HAS(char *icon)
 	return ((*icon == 'h') || ((*icon == '/') && file_exists(icon) && LCASE(icon[strlen(icon) - 1]) == 'g' ));
 }
 
+// cover index: the images of the cover folders in /dev_hdd0 are listed once and again only if the mtime of a folder changes
+// get_image_file() resolves the misses in those folders without stat & confirms the hits with file_exists()
+// a new index is built apart and published by swapping covers_idx under covers_mutex; the readers use it only under the lock
+#define MAX_COVER_DIRS		12
+#define COVER_DIR_LEN		80
+#define COVERS_IDX_SIZE		_64KB_
+#define COVERS_IDX_MAX		_1MB_
+
+typedef struct
+{
+	u8  dirs;
+	char dir[MAX_COVER_DIRS][COVER_DIR_LEN];
+	time_t mtime[MAX_COVER_DIRS];
+} t_cover_dirs;
+
+typedef struct
+{
+	u32 size;		// bytes allocated
+	u32 slots, count;
+	t_cover_dirs folders;
+	u32 slot[];		// hash of folder + name without extension (bits 4-31) | extensions found (bits 0-3), 0 = free
+} t_covers_idx;
+
+static t_covers_idx *covers_idx = NULL; // published index (NULL = no index)
+
+static u32 cover_key(u8 d, const char *name, int len)
+{
+	u32 h = 0x811C9DC5 ^ d;
+	while(len-- > 0) h = (h ^ (u8)*name++) * 0x01000193;
+	h &= ~0xF; return h ? h : 0x10;
+}
+
+static u32 *cover_slot(t_covers_idx *idx, u32 key)
+{
+	u32 i = (key >> 4) % idx->slots;
+	while(idx->slot[i] && ((idx->slot[i] & ~0xF) != key)) if(++i >= idx->slots) i = 0;
+	return &idx->slot[i];
+}
+
+static t_covers_idx *alloc_covers_index(u32 size, const t_cover_dirs *folders)
+{
+	t_covers_idx *idx = (t_covers_idx *)sys_mem_allocate(size);
+	if(!idx) return NULL;
+
+	_memset(idx, size);
+	idx->size = size;
+	idx->slots = (size - sizeof(t_covers_idx)) / sizeof(u32);
+	memcpy(&idx->folders, folders, sizeof(t_cover_dirs));
+	return idx;
+}
+
+// private index of the builder: moved to a table of double size when it is half full
+static t_covers_idx *grow_covers_index(t_covers_idx *idx)
+{
+	if(idx->size * 2 > COVERS_IDX_MAX) return NULL;
+
+	t_covers_idx *new_idx = alloc_covers_index(idx->size * 2, &idx->folders);
+	if(!new_idx) return NULL;
+
+	for(u32 i = 0; i < idx->slots; i++)
+		if(idx->slot[i]) *cover_slot(new_idx, idx->slot[i] & ~0xF) = idx->slot[i];
+
+	new_idx->count = idx->count;
+	return new_idx;
+}
+
+// returns false if the index is full
+static bool add_cover(t_covers_idx *idx, u8 d, const char *name, int len)
+{
+	if(len < 5) return true;
+
+	for(u8 e = 0; e < 4; e++)
+	{
+		if(strcmp(name + len - 4, ext[e])) continue;
+
+		u32 key = cover_key(d, name, len - 4), *slot = cover_slot(idx, key);
+		if(!*slot)
+		{
+			if((idx->count + 1) * 2 > idx->slots) return false;
+			idx->count++;
+		}
+		*slot |= key | (1 << e);
+		break;
+	}
+	return true;
+}
+
+static void publish_covers_index(t_covers_idx *idx)
+{
+	mutex_lock(covers_mutex);
+	t_covers_idx *old = covers_idx; covers_idx = idx;
+	mutex_unlock(covers_mutex);
+
+	if(old) sys_memory_free((sys_addr_t)old); // no reader holds it after the lock was released
+}
+
+static void build_covers_index(const t_cover_dirs *folders)
+{
+	t_covers_idx *idx = folders->dirs ? alloc_covers_index(COVERS_IDX_SIZE, folders) : NULL;
+
+	int fd; CellFsDirent entry; u64 read_e;
+
+	for(u8 d = 0; idx && (d < folders->dirs); d++)
+	{
+		if(cellFsOpendir(folders->dir[d], &fd) != CELL_FS_SUCCEEDED) continue;
+
+		while(idx && (cellFsReaddir(fd, &entry, &read_e) == CELL_FS_SUCCEEDED) && read_e)
+		{
+			if(add_cover(idx, d, entry.d_name, entry.d_namlen)) continue;
+
+			t_covers_idx *new_idx = grow_covers_index(idx);
+			sys_memory_free((sys_addr_t)idx); idx = new_idx; // too many files: no index (use stat)
+
+			if(idx) add_cover(idx, d, entry.d_name, entry.d_namlen);
+		}
+
+		cellFsClosedir(fd);
+	}
+
+	publish_covers_index(idx);
+}
+
+static void add_cover_dir(t_cover_dirs *folders, const char *path)
+{
+	if(!islike(path, "/dev_hdd0/") || (strlen(path) >= COVER_DIR_LEN) || (folders->dirs >= MAX_COVER_DIRS)) return;
+
+	struct CellFsStat s;
+	if(cellFsStat(path, &s) != CELL_FS_SUCCEEDED) s.st_mtime = 0;
+
+	strcpy(folders->dir[folders->dirs], path); folders->mtime[folders->dirs++] = s.st_mtime;
+}
+
+static bool same_cover_dirs(const t_cover_dirs *a, const t_cover_dirs *b)
+{
+	if(a->dirs != b->dirs) return false;
+
+	for(u8 d = 0; d < a->dirs; d++)
+		if((a->mtime[d] != b->mtime[d]) || !IS(a->dir[d], b->dir[d])) return false;
+
+	return true;
+}
+
+// index of the folder of icon (path up to flen) or NONE; name = file name in the folder
+static s8 get_cover_dir(const t_cover_dirs *folders, const char *icon, int flen, const char **name)
+{
+	const char *pos = icon + flen; while((pos > icon) && (*pos != '/')) pos--;
+	int len = pos - icon; *name = pos + 1;
+
+	for(u8 d = 0; d < folders->dirs; d++)
+		if(!strncmp(folders->dir[d], icon, len) && !folders->dir[d][len]) return d;
+
+	return NONE;
+}
+
+// add an image written to an indexed folder (e.g. covers copied to WMTMP by prepNTFS)
+static void index_cover_file(const char *path)
+{
+	if(!covers_idx || !path) return;
+
+	struct CellFsStat s;
+	const char *name = get_filename(path); if(!name) return;
+
+	int plen = name - path;
+	char dir[COVER_DIR_LEN]; if(plen >= COVER_DIR_LEN) return;
+	strncpy(dir, path, plen); dir[plen] = '\0';
+	if(cellFsStat(dir, &s) != CELL_FS_SUCCEEDED) return;
+
+	mutex_lock(covers_mutex);
+	if(covers_idx)
+	{
+		s8 d = get_cover_dir(&covers_idx->folders, path, plen, &name);
+		if(d >= 0)
+		{
+			if(add_cover(covers_idx, d, name, strlen(name)))
+				covers_idx->folders.mtime[d] = s.st_mtime; // the index is up to date with the folder
+			else
+				covers_idx->folders.mtime[d] = 0;          // full: the misses of the folder are checked with stat
+		}
+	}
+	mutex_unlock(covers_mutex);
+}
+
 static void check_cover_folders(char *buffer)
 {
 	if(!buffer) return; // sanity check
 
+	// folders of the cover index
+	t_cover_dirs folders; folders.dirs = 0;
+	#define INDEX_COVER_DIR(path)	add_cover_dir(&folders, path)
+
 	#ifndef ENGLISH_ONLY
 												covers_exist[0] = isDir(COVERS_PATH); // online url or custom path
+	if(covers_exist[0]) {INDEX_COVER_DIR(COVERS_PATH);}
 	#endif
 	for(u8 p = 0; p < 3; p++)
 	{
 		sprintf(buffer, "%s/covers_retro/psx", cpath[p]); covers_retro_exist[p] = isDir(buffer);  // MM_ROOT_STD, MM_ROOT_STL, MM_ROOT_SSTL
+		if(covers_retro_exist[p]) {INDEX_COVER_DIR(buffer);}
 	}
 	for(u8 p = 0; p < 6; p++)
 	{
 		sprintf(buffer, "%s/covers", cpath[p]); covers_exist[p + 1] = isDir(buffer);  // MM_ROOT_STD, MM_ROOT_STL, MM_ROOT_SSTL, "/dev_hdd0/GAMES", "/dev_hdd0/GAMEZ"
+		if(covers_exist[p + 1]) {INDEX_COVER_DIR(buffer);}
 	}
 												covers_exist[6] = isDir(WMTMP_COVERS);
 												covers_exist[8] = isDir(WMTMP) && SHOW_COVERS_OR_ICON0; // WMTMP
+	if(covers_exist[6]) {INDEX_COVER_DIR(WMTMP_COVERS);}
+	if(covers_exist[8]) {INDEX_COVER_DIR(WMTMP);}
+
+	mutex_lock(covers_mutex);
+	bool changed = covers_idx ? !same_cover_dirs(&covers_idx->folders, &folders) : (folders.dirs > 0);
+	mutex_unlock(covers_mutex);
+
+	if(changed) build_covers_index(&folders);
 
 	#ifndef ENGLISH_ONLY
 	if(!covers_exist[0]) {use_custom_icon_path = strstr(COVERS_PATH, "%s"); use_icon_region = strstr(COVERS_PATH, "%s/%s");} else {use_icon_region = use_custom_icon_path = false;}
@@ -121,6 +318,47 @@ static bool get_image_file(char *icon, int flen)
 {
 	if(!icon || (flen <= 0) || (*icon != '/')) return false; // sanity check
 
+	// folder in the cover index: stat only the extensions listed (a miss stats only the folder)
+	const char *name; s8 d = NONE; u32 found = 0; time_t mtime = 0; char dir[COVER_DIR_LEN];
+
+	mutex_lock(covers_mutex);
+	if(covers_idx)
+	{
+		d = get_cover_dir(&covers_idx->folders, icon, flen, &name);
+		if(d >= 0)
+		{
+			found = *cover_slot(covers_idx, cover_key(d, name, flen - (name - icon)));
+			mtime = covers_idx->folders.mtime[d];
+			strcpy(dir, covers_idx->folders.dir[d]);
+		}
+	}
+	mutex_unlock(covers_mutex);
+
+	// folder changed after the index was built (e.g. files copied by FTP): check all the extensions
+	if((d >= 0) && !found)
+	{
+		struct CellFsStat s;
+		if((cellFsStat(dir, &s) != CELL_FS_SUCCEEDED) || (s.st_mtime != mtime)) d = NONE;
+	}
+
+	if(d >= 0)
+	{
+		for(u8 e = 0; e < 4; e++)
+		{
+			if(!(found & (1 << ex[e]))) continue;
+
+			strcpy(icon + flen, ext[ex[e]]);
+			if(file_exists(icon)) {swap_ex(e); return true;}
+		}
+
+		// no listed extension is left (e.g. a .jpg replaced by a .png over FTP): check all the extensions
+		if(!found)
+		{
+			strcpy(icon + flen, ext[ex[3]]);
+			return false;
+		}
+	}
+
 	for(u8 e = 0; e < 4; e++)
 	{
 		strcpy(icon + flen, ext[ex[e]]);
@@ -594,16 +832,15 @@ static int get_title_and_id_from_sfo(char *param_sfo, char *title_id, const char
 	bool use_filename = webman_config->use_filename;
 
 	// read param.sfo
-	unsigned char *mem = (u8*)data;
-	u16 sfo_size = read_sfo(param_sfo, data);
+	sfo_info info;
 	char *title = param_sfo;
 
 	// get title_id & title from PARAM.SFO
-	if(sfo_size && is_sfo(mem))
+	if(read_sfo_info(param_sfo, &info, data))
 	{
 		if((IS_HDD0 && islike(param_sfo + 9, "/game/")) || islike(param_sfo + 11, "/GAMEI/") || strstr(param_sfo, "_00-")) use_filename = false;
 
-		parse_param_sfo(mem, title_id, title, sfo_size);
+		get_sfo_title(&info, title_id, title);
 
 		if(SHOW_COVERS) get_cover_by_titleid(icon, title_id);
 
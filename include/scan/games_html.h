@@ -1092,6 +1092,9 @@ next_html_entry:
 		{
 			_concat(&sout, "];");
 			save_file(GAMELIST_JS, sout.str, sout.size);
+			#ifdef GZIP_HTML
+			save_file_gz(GAMELIST_JS, sout.str, sout.size);
+			#endif
 		}
 		else
 		{
@@ -1,10 +1,12 @@
 #ifdef SLAUNCH_FILE
 
-#define MAX_SLAUNCH_ITEMS	2000
+#include "../../slaunch_idx.h"
+
+#define MAX_SLAUNCH_ITEMS	10000
 
 static bool custom_icon = false; // override default cover mode using index.ps3?cover=<cover type> (icon0, mm, disc, online)
 
-typedef struct // 1MB for 2000+1 titles
+typedef struct // 524 bytes per title
 {
 	u8  type;
 	char id[10];
@@ -74,28 +76,151 @@ static void add_slaunch_entry(int fd, const char *neth, const char *path, const
 	cellFsWrite(fd, (void *)&slaunch, sizeof(_slaunch), NULL);
 }
 
+// rank of the title in last_games.bin (1 = last played, 0 = not played)
+static u8 get_slaunch_recent(const char *path, const char *lastgames, u8 last, u8 count)
+{
+	for(u8 n = 0, i = last; n < count; n++)
+	{
+		const char *game = lastgames + (i * MAX_PATH_LEN);
+		if(*game && IS(path + 10, game)) return n + 1; // skip /mount_ps3
+		i = i ? (i - 1) : (count - 1);
+	}
+	return 0;
+}
+
+static void build_slaunch_index(void)
+{
+	cellFsUnlink(SLAUNCH_IDX);
+
+	u32 count = file_size(SLAUNCH_FILE) / sizeof(_slaunch);
+	if(!count || (count > MAX_SLAUNCH_ITEMS)) return;
+
+	#define SLAUNCH_CHUNK	(_64KB_ / sizeof(_slaunch))
+	#define MAX_PLAYED		8
+
+	u32 keys_size = count * sizeof(slidx_key), orders_size = SLIDX_ORDERS * count * sizeof(u16), sigs_size = count * sizeof(slidx_sig);
+	u32 mem_size = (keys_size + orders_size + sigs_size + _64KB_ + (MAX_PLAYED * MAX_PATH_LEN) + _64KB_ - 1) & ~(_64KB_ - 1);
+
+	sys_addr_t sysmem = sys_mem_allocate(mem_size);
+	if(!sysmem) return;
+
+	slidx_key *keys = (slidx_key*)sysmem;
+	slidx_sig *sigs = (slidx_sig*)((char*)keys + keys_size);
+	u16 *orders = (u16*)((char*)sigs + sigs_size);
+	_slaunch *chunk = (_slaunch*)((char*)orders + orders_size);
+	char *lastgames = (char*)chunk + _64KB_;
+
+	_memset(keys, keys_size);
+	_memset(sigs, sigs_size);
+
+	// last_games.bin: u8 last + paths (urlencoded like the paths of the titles)
+	char *path = (char*)chunk;
+	u32 size = read_file(LAST_GAMES_BIN, path, _64KB_, 0);
+	u8 last = *path, played = (size > 1) ? MIN((size - 1) / MAX_PATH_LEN, MAX_PLAYED) : 0;
+	if(last >= played) played = 0;
+
+	for(u8 n = 0; n < played; n++) urlenc_ex(lastgames + (n * MAX_PATH_LEN), path + 1 + (n * MAX_PATH_LEN), false);
+
+	int fd; u64 read_e;
+	if(cellFsOpen(SLAUNCH_FILE, CELL_FS_O_RDONLY, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+	{
+		for(u32 n = 0; n < count; )
+		{
+			if(cellFsRead(fd, chunk, SLAUNCH_CHUNK * sizeof(_slaunch), &read_e) != CELL_FS_SUCCEEDED || (read_e < sizeof(_slaunch))) {count = n; break;}
+
+			for(u32 i = 0; (i < (read_e / sizeof(_slaunch))) && (n < count); i++, n++)
+			{
+				_slaunch *slaunch = &chunk[i];
+				char *title = slaunch->name; path = slaunch->name + slaunch->path_pos;
+
+				for(u8 c = 0; (c < SLIDX_KEY_LEN) && title[c]; c++) keys[n].title[c] = slidx_upper(title[c]);
+				memcpy(keys[n].id, slaunch->id, sizeof(keys[n].id));
+				keys[n].type = slaunch->type;
+				keys[n].recent = get_slaunch_recent(path, lastgames, last, played);
+
+				slidx_signature(&sigs[n], title);
+				slidx_signature(&sigs[n], path);
+			}
+		}
+		cellFsClose(fd);
+
+		_slaunch_idx idx;
+		slidx_build(&idx, keys, orders, count, sizeof(_slaunch));
+
+		if(count && cellFsOpen(SLAUNCH_IDX, CELL_FS_O_CREAT | CELL_FS_O_TRUNC | CELL_FS_O_WRONLY, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+		{
+			u64 padding = 0;
+			cellFsWrite(fd, (void *)&idx, sizeof(_slaunch_idx), NULL);
+			cellFsWrite(fd, (void *)orders, SLIDX_ORDERS * count * sizeof(u16), NULL);
+			cellFsWrite(fd, (void *)&padding, slidx_sig_offset(count) - slidx_order_offset(count, SLIDX_ORDERS), NULL);
+			cellFsWrite(fd, (void *)sigs, count * sizeof(slidx_sig), NULL);
+			cellFsClose(fd);
+			cellFsChmod(SLAUNCH_IDX, MODE);
+		}
+	}
+
+	sys_memory_free(sysmem);
+}
+
 static void close_slaunch_file(int fd)
 {
 	if(!fd) return;
 
 	cellFsClose(fd);
 	cellFsChmod(SLAUNCH_FILE, MODE);
+
+	build_slaunch_index();
+}
+
+// returns the records of slist.bin if slist.idx is up to date
+static u32 open_slaunch_index(int *fdi)
+{
+	_slaunch_idx idx; *fdi = 0;
+
+	if((read_file(SLAUNCH_IDX, (char*)&idx, sizeof(_slaunch_idx), 0) != sizeof(_slaunch_idx)) ||
+		(idx.magic != SLIDX_MAGIC) || (idx.version != SLIDX_VERSION) || (idx.record_size != sizeof(_slaunch)) ||
+		(idx.count != (file_size(SLAUNCH_FILE) / sizeof(_slaunch)))) return 0;
+
+	if(cellFsOpen(SLAUNCH_IDX, CELL_FS_O_RDONLY, fdi, NULL, 0) != CELL_FS_SUCCEEDED) {*fdi = 0; return 0;}
+
+	return idx.count;
 }
 
 static int find_slaunch_game(char *filename, u8 offset)
 {
-	int fsl = 0, ret = 0;
+	int fsl = 0, fdi = 0, ret = 0;
 	if(cellFsOpen(SLAUNCH_FILE, CELL_FS_O_RDONLY, &fsl, NULL, 0) == CELL_FS_SUCCEEDED)
 	{
 		_slaunch slaunch; u64 read_e;
 		char *name = slaunch.name;
 		char filename2[MAX_PATH_LEN]; urlenc_ex(filename2, filename, false);
-		while(cellFsRead(fsl, &slaunch, sizeof(_slaunch), &read_e) == CELL_FS_SUCCEEDED && read_e > 0)
+
+		// with slist.idx only the titles that can contain the filename are read
+		slidx_sig sigs[64], query1, query2; _memset(&query1, sizeof(slidx_sig)); _memset(&query2, sizeof(slidx_sig));
+		slidx_signature(&query1, filename2);
+		slidx_signature(&query2, filename);
+
+		u32 count = open_slaunch_index(&fdi), sig_offset = slidx_sig_offset(count);
+
+		for(u32 n = 0; ; n++)
 		{
+			if(fdi)
+			{
+				if(n >= count) break;
+
+				slidx_sig *sig = &sigs[n & 63];
+				if(!(n & 63) && (cellFsReadWithOffset(fdi, sig_offset + (n * sizeof(slidx_sig)), sigs, sizeof(sigs), &read_e) != CELL_FS_SUCCEEDED)) break;
+				if(!slidx_match(sig, &query1) && !slidx_match(sig, &query2)) continue;
+
+				if(cellFsReadWithOffset(fsl, (u64)n * sizeof(_slaunch), &slaunch, sizeof(_slaunch), &read_e) != CELL_FS_SUCCEEDED || (read_e < sizeof(_slaunch))) break;
+			}
+			else if(cellFsRead(fsl, &slaunch, sizeof(_slaunch), &read_e) != CELL_FS_SUCCEEDED || (read_e == 0)) break;
+
 			char *path = slaunch.name + slaunch.path_pos;
 			if((strcasestr(path, filename2) == NULL) && (strcasestr(name, filename) == NULL)) continue;
 			ret = sprintf(filename, "%s", path + offset); break;
 		}
+		if(fdi) cellFsClose(fdi);
 		cellFsClose(fsl);
 	}
 	return ret;
@@ -15,24 +15,30 @@ static u32 *sections_sizeP = NULL;
 
 static sys_addr_t sysmem_p = NULL;
 
+static int read_iso_ntfs(void *fd, uint64_t offset, void *buf, uint32_t size)
+{
+	if(ps3ntfs_seek64(*(int *)fd, offset, SEEK_SET) < 0) return 0;
+	return ps3ntfs_read(*(int *)fd, buf, size);
+}
+
 // extract ICON0.PNG & PARAM.SFO from ISO
-static u64 extract_iso_file(const char *iso_path, const char *file, u8 len, const char *out_path, const char *sector)
+static bool extract_iso_file(iso9660_reader *iso, const char *file, const char *out_path, char *buffer)
 {
-	if(!sector) return 0;
-	u16 start = 0x40; u32 size; fixed_count = 0;
-	u64 lba = getLBA(sector, 0x800, file, len, &start, &size);
-	if(!lba && (len == 11)) lba = getLBA(sector, 0x800, file, len - 2, &start, &size); // search without ;1
-	if(lba)
-	{
-		if(!size || (size > _62KB_)) return 0; // is file larger than buffer size?
-		lba *= 0x800ULL; if(lba > (file_size(iso_path) - size)) return 0; // is offset larger than iso?
-		if(!out_path) return lba; // return offset
+	iso9660_entry entry;
 
-		char *buffer = (char*)(sector + 0x800); // (0-62KB)
-		read_file(iso_path, buffer, size, lba);
-		save_file(out_path, buffer, size);
-	}
-	return lba; // return offset
+	if(!iso9660_find(iso, file, &entry) || entry.is_dir) return false;
+	if(!entry.size || (entry.size > _62KB_)) return false; // is file larger than buffer size?
+
+	if(iso9660_read_file(iso, &entry, 0, buffer, (u32)entry.size) != (int)entry.size) return false;
+
+	save_file(out_path, buffer, entry.size);
+	return true;
+}
+
+// append the sectors of a file to the sections (multi-part iso / multi-bin cue)
+static int add_ntfs_sections(const char *path, int parts, int max_sections)
+{
+	return ps3ntfs_file_to_sectors(path, sectionsP + parts, sections_sizeP + parts, max_sections - parts, 1);
 }
 
 static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
@@ -41,7 +47,23 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 
 	const int max_sections = MAX_SECTIONS;
 
-	int parts = ps3ntfs_file_to_sectors(iso_path, sectionsP, sections_sizeP, max_sections, 1);
+	char tmp_path[MAX_PATH_LEN];
+
+	// redump multi-bin: "Game (Track 01).bin" + "Game.cue", only the 1st track is listed
+	char *track_pos = NULL;
+	if(ntfs_m == id_PSXISO)
+	{
+		track_pos = strstr(iso_path + plen - strlen(filename), " (Track ");
+		if(track_pos)
+		{
+			strcpy(tmp_path, iso_path);
+			strcpy(tmp_path + (track_pos - iso_path), ".cue");
+			if(!change_ext(tmp_path, 4, cue_ext)) track_pos = NULL; else
+			if(val(track_pos + 8) > 1) return;
+		}
+	}
+
+	int parts = add_ntfs_sections(iso_path, 0, max_sections);
 
 	if(parts <= 0) return;
 
@@ -51,7 +73,6 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 	ScsiTrackDescriptor *scsi_tracks;
 
 	u8 extlen = 4, sfo_found = 0;
-	char tmp_path[MAX_PATH_LEN];
 
 	rawseciso_args *p_args;
 
@@ -68,7 +89,7 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 			sprintf(tmp_path + nlen, "%i", o);
 			if(not_exists(tmp_path)) break;
 
-			nparts = ps3ntfs_file_to_sectors(tmp_path, sectionsP + (parts * sizeof(u32)), sections_sizeP + (parts * sizeof(u32)), max_sections - parts, 1);
+			nparts = add_ntfs_sections(tmp_path, parts, max_sections);
 			if(nparts <= 0) return;
 
 			parts += nparts;
@@ -104,13 +125,45 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 			else if(cd_sector_size != 2352) cd_sector_size_param = cd_sector_size<<4;
 
 			// read LBA for tracks from cue file
-			if(change_ext(iso_path, 4, cue_ext))
+			char *cue_file = tmp_path;
+			strcpy(cue_file, iso_path);
+			if(track_pos) strcpy(cue_file + (track_pos - iso_path), ".cue");
+
+			if(change_ext(cue_file, 4, cue_ext))
 			{
-				char *cue_file = iso_path;
 				char *cue_buf = (char*)sysmem_p;
 				int cue_size = read_file(cue_file, cue_buf, _8KB_, 0);
 
-				num_tracks = parse_cue(cue_file, cue_buf, cue_size, tracks);
+				u32 file_sectors[MAX_TRACKS];
+				u8 num_files = 1; u32 len;
+
+				file_sectors[0] = bufn.st_size / cd_sector_size;
+
+				// multi-bin: the other files of the sheet are joined after the 1st file (if the 1st file is this one)
+				const char *name = (cue_size > 0) ? cue_file_name(cue_buf, cue_size, 0, &len) : NULL;
+				if(name && (len == strlen(filename)) && !strncasecmp(name, filename, len))
+				{
+					char *bin_path = cue_buf + _8KB_;
+					char *bin_name = strrchr(strcpy(bin_path, cue_file), '/') + 1;
+
+					for(; num_files < MAX_TRACKS; num_files++)
+					{
+						name = cue_file_name(cue_buf, cue_size, num_files, &len);
+						if(!name || (len >= (u32)(STD_PATH_LEN - (bin_name - bin_path)))) break;
+
+						memcpy(bin_name, name, len); bin_name[len] = '\0';
+
+						if(ps3ntfs_stat(bin_path, &bufn) < 0) break;
+
+						int nparts = add_ntfs_sections(bin_path, parts, max_sections);
+						if(nparts <= 0) break;
+
+						parts += nparts;
+						file_sectors[num_files] = bufn.st_size / cd_sector_size;
+					}
+				}
+
+				num_tracks = parse_cue(cue_buf, cue_size, tracks, file_sectors, num_files);
 			}
 		}
 
@@ -134,16 +187,7 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 
 		scsi_tracks = (ScsiTrackDescriptor *)(plugin_args + sizeof(rawseciso_args) + (2 * array_len));
 
-		scsi_tracks[0].adr_control = 0x14;
-		scsi_tracks[0].track_number = 1;
-		scsi_tracks[0].track_start_addr = 0;
-
-		for(unsigned int t = 1; t < num_tracks; t++)
-		{
-			scsi_tracks[t].adr_control = 0x10;
-			scsi_tracks[t].track_number = t + 1;
-			scsi_tracks[t].track_start_addr = tracks[t].lba;
-		}
+		set_scsi_tracks(scsi_tracks, tracks, num_tracks);
 
 		int slen = strlen(filename) - extlen;
 		filename[slen] = '\0'; // truncate file extension
@@ -169,23 +213,27 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 			snprintf(tmp_path, sizeof(tmp_path), "%s/%s%s.SFO", WMTMP, filename, SUFIX2(profile));
 			if(not_exists(tmp_path) && (file_size(iso_path) > _128KB_))
 			{
-				char *sector = (char*)sysmem_p;
+				char *sector = (char*)sysmem_p; // directory block (2KB) + file buffer (0-62KB)
+				iso9660_reader iso; bool found = false;
 
-				// Read root directory of ISO
-				read_file(iso_path, sector, 0x800, 0x10000); // get root sector 20
-				u64 offset = extract_iso_file(iso_path, "PS3_GAME", 8, NULL, sector); // find offset
-				if(offset)
+				int fd = ps3ntfs_open(iso_path, O_RDONLY, 0);
+				if(fd >= 0)
 				{
-					// extract PARAM.SFO from ISO
-					read_file(iso_path, sector, 0x800, offset); // get PS3_GAME sector
-					extract_iso_file(iso_path, "PARAM.SFO;1", 11, tmp_path, sector);
-
-					// extract ICON0.PNG from ISO
-					snprintf(tmp_path, sizeof(tmp_path), "%s/%s%s.PNG", WMTMP, filename, SUFIX2(profile));
-					extract_iso_file(iso_path, "ICON0.PNG;1", 11, tmp_path, sector);
-
-					if(file_exists(tmp_path)) return;
+					if(!iso9660_open(&iso, read_iso_ntfs, &fd, sector, 0x800))
+					{
+						// extract PARAM.SFO from ISO
+						extract_iso_file(&iso, "/PS3_GAME/PARAM.SFO", tmp_path, sector + 0x800);
+
+						// extract ICON0.PNG from ISO
+						snprintf(tmp_path, sizeof(tmp_path), "%s/%s%s.PNG", WMTMP, filename, SUFIX2(profile));
+						extract_iso_file(&iso, "/PS3_GAME/ICON0.PNG", tmp_path, sector + 0x800);
+
+						found = file_exists(tmp_path); if(found) index_cover_file(tmp_path);
+					}
+					ps3ntfs_close(fd);
 				}
+
+				if(found) return;
 			}
 		}
 
@@ -211,6 +259,7 @@ static void create_ntfs_file(char *iso_path, char *filename, size_t plen)
 
 		// copy external image to WMTMP
 		force_copy(img_path, tmp_path);
+		index_cover_file(tmp_path);
 	}
 }
 
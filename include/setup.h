@@ -374,6 +374,8 @@ static void setup_parse_settings(char *param)
 
 	get_param("aip=", webman_config->allow_ip, param, 16);
 	webman_config->nsd = IS_UNMARKED("nsd=1");
+	webman_config->netiso_window = get_valuen(param, "&nw=", 0, 16);
+	webman_config->netiso_compress = IS_MARKED("ncz=1");
  #endif
 #endif
 
@@ -621,6 +623,8 @@ static void setup_form(char *buffer, char *templn)
 		++PS3NETSRV[21], ++PS3NETSRV[75];
 	}
 	add_checkbox_line("nsd", "Scan remote sub-directories", !(webman_config->nsd), buffer);
+	sprintf(templn, " &nbsp; Reads in flight: " HTML_NUMBER("nw", "%i", "0", "16") " (0=auto, 1=v1) ", webman_config->netiso_window); concat(buffer, templn);
+	add_checkbox_line("ncz", "Compress (slow links)", webman_config->netiso_compress, buffer);
  #endif
 #endif
 
@@ -0,0 +1,103 @@
+#ifndef __HTTP_RANGE_H__
+#define __HTTP_RANGE_H__
+
+// Request fields of the conditional & partial GET of files (www_binary.h)
+// Portable C: If-Modified-Since dates & Range byte-range sets are parsed without the plugin helpers
+//   parse_http_date()    RFC 7231, RFC 850 & asctime dates -> seconds since 1970
+//   parse_http_range()   "bytes=a-b,c-,-n" -> inclusive ranges clipped to the file size (RFC 7233)
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_HTTP_RANGES		(4)
+
+static const char *http_months[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+#define HTTP_ISDIGIT(a)		( ('0' <= (a)) && ((a) <= '9') )
+
+// returns the time in seconds since 1970 or 0 if the date is not valid
+// "Sun, 06 Nov 1994 08:49:37 GMT", "Sunday, 06-Nov-94 08:49:37 GMT" or "Sun Nov  6 08:49:37 1994"
+static uint64_t parse_http_date(const char *date)
+{
+	int day = 0, month = 0, year = -1, hour = -1, minute = 0, second = 0;
+
+	for(const char *pos = date; *pos; )
+	{
+		if(HTTP_ISDIGIT(*pos))
+		{
+			int n = 0; uint8_t digits = 0;
+			for(; HTTP_ISDIGIT(*pos); pos++, digits++) n = (n < 100000) ? (n * 10) + (*pos - '0') : n;
+
+			if(*pos == ':')
+			{
+				hour = n; minute = second = 0;
+				for(++pos; HTTP_ISDIGIT(*pos); pos++) minute = (minute < 100) ? (minute * 10) + (*pos - '0') : minute;
+				if(*pos == ':') for(++pos; HTTP_ISDIGIT(*pos); pos++) second = (second < 100) ? (second * 10) + (*pos - '0') : second;
+			}
+			else if(!day && (digits <= 2) && (year < 0)) day = n;
+			else year = (digits <= 2) ? n + ((n < 70) ? 2000 : 1900) : n;
+		}
+		else if(!month && (strlen(pos) >= 3))
+		{
+			for(uint8_t m = 0; m < 12; m++)
+				if(!strncasecmp(pos, http_months[m], 3)) {month = m + 1; break;}
+			if(month) pos += 3; else pos++;
+		}
+		else
+			pos++;
+	}
+
+	if(!month || (day < 1) || (day > 31) || (year < 1970) || (year > 9999) || (hour < 0) || (hour > 23) || (minute > 59) || (second > 60)) return 0;
+
+	// days since 1970-01-01 of the civil date
+	int y = year - (month <= 2), era = y / 400, yoe = y - (era * 400);
+	int doy = ((153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5) + day - 1;
+	int doe = (yoe * 365) + (yoe / 4) - (yoe / 100) + doy;
+	int64_t days = ((int64_t)era * 146097) + doe - 719468;
+
+	return (uint64_t)((days * 86400) + (hour * 3600) + (minute * 60) + second);
+}
+
+// returns number of ranges, 0 if Range should be ignored (invalid), -1 if not satisfiable (all start past the end)
+static int parse_http_range(const char *range, uint64_t file_size, uint64_t *from, uint64_t *to)
+{
+	if(strncmp(range, "bytes=", 6) || !file_size) return 0;
+
+	int count = 0, specs = 0;
+
+	for(const char *pos = range + 6; *pos; specs++)
+	{
+		while(*pos == ' ' || *pos == ',') pos++;
+		if(!*pos) break;
+
+		if(count >= MAX_HTTP_RANGES) return 0; // too many ranges: send the whole file
+
+		uint64_t a = 0, b = file_size - 1; uint8_t suffix = (*pos == '-'), digits;
+
+		if(!suffix)
+		{
+			if(!HTTP_ISDIGIT(*pos)) return 0;
+			for(digits = 0; HTTP_ISDIGIT(*pos); pos++) if(++digits > 19) return 0; else a = (a * 10) + (*pos - '0');
+		}
+		if(*pos++ != '-') return 0;
+		if(HTTP_ISDIGIT(*pos))
+		{
+			for(digits = 0, b = 0; HTTP_ISDIGIT(*pos); pos++) if(++digits > 19) return 0; else b = (b * 10) + (*pos - '0');
+			if(!suffix && (b < a)) return 0; // "a-b" with b < a is an invalid range set: the Range header is ignored
+		}
+		else if(suffix) return 0;
+
+		if(suffix) {a = (b >= file_size) ? 0 : (file_size - b); b = file_size - 1;}
+		if(b >= file_size) b = file_size - 1;
+
+		if(a <= b) {from[count] = a, to[count] = b, count++;}
+
+		while(*pos == ' ') pos++;
+		if(*pos && *pos != ',') return 0;
+	}
+
+	return count ? count : specs ? -1 : 0; // no range: invalid
+}
+
+#endif // __HTTP_RANGE_H__
@@ -1,20 +1,115 @@
 	if(is_binary == BINARY_FILE) // binary file
 	{
+		#ifdef GZIP_HTML
+		// serve the precompressed <file>.gz sibling of text files if it is up to date
+		bool is_gzip = false;
+		if(accept_gzip && !is_ntfs && (strstr(header, "Content-Type: text/") || strstr(header, "svg+xml")) && (strlen(param) < STD_PATH_LEN))
+		{
+			struct CellFsStat gz_stat; strcat(param, ".gz");
+			if((cellFsStat(param, &gz_stat) == CELL_FS_SUCCEEDED) && (gz_stat.st_mtime >= (time_t)c_mtime))
+			{
+				c_len = gz_stat.st_size, c_mtime = gz_stat.st_mtime, *range = NULL;
+				header_len += sprintf(header + header_len, "Content-Encoding: gzip\r\n");
+				is_gzip = true;
+			}
+			else
+				param[strlen(param) - 3] = NULL;
+		}
+		if(accept_gzip || is_gzip) header_len += sprintf(header + header_len, "Vary: Accept-Encoding\r\n");
+		#endif
+
+		// cache validators from file mtime & size
+		char etag[40], last_modified[32];
+		sprintf(etag, "\"%llx-%llx\"", (unsigned long long)c_mtime, (unsigned long long)c_len);
+		http_date(last_modified, c_mtime);
+
+		// If-None-Match takes precedence; If-Modified-Since matches if the file is not newer than the date
+		u64 since = *if_modified_since ? parse_http_date(if_modified_since) : 0;
+
+		if(*if_none_match ? ((*if_none_match == '*') || strstr(if_none_match, etag)) : (since && (c_mtime <= since)))
+		{
+			header_len = sprintf(header, "HTTP/1.1 304 Not Modified\r\n"
+										 "ETag: %s\r\n"
+										 "Last-Modified: %s\r\n"
+										 "Cache-Control: no-cache\r\n", etag, last_modified);
+			if(keep_alive)
+			{
+				header_len += sprintf(header + header_len,  "Keep-Alive: timeout=3,max=250\r\n"
+															"Connection: keep-alive\r\n");
+			}
+			header_len += sprintf(header + header_len, "\r\n");
+			send(conn_s, header, header_len, 0);
+
+			goto exit_handleclient_www;
+		}
+
+		// byte ranges (ignored if If-Range does not match the current file)
+		u64 range_from[MAX_HTTP_RANGES], range_to[MAX_HTTP_RANGES];
+		int nranges = 0;
+		if(*range && (!*if_range || IS(if_range, etag) || IS(if_range, last_modified)))
+			nranges = parse_http_range(range, c_len, range_from, range_to);
+
+		if(nranges < 0)
+		{
+			header_len = sprintf(header, "HTTP/1.1 416 Range Not Satisfiable\r\n"
+										 "Content-Range: bytes */%llu\r\n"
+										 "Content-Length: 0\r\n"
+										 "\r\n", (unsigned long long)c_len);
+			send(conn_s, header, header_len, 0);
+
+			goto exit_handleclient_www;
+		}
+
+		// part header: "\r\n--" boundary "\r\nContent-Type: " type "\r\nContent-Range: bytes " 3 x 20 digits "-/" "\r\n\r\n" (109 bytes + boundary + type)
+		char part_type[64], part_header[sizeof(part_type) + sizeof(HTTP_BOUNDARY) + 128]; u64 send_len = c_len;
+
+		if(nranges)
+		{
+			header_len = set_http_status(header, header_len, "206 Partial Content");
+
+			if(nranges == 1)
+			{
+				send_len = range_to[0] - range_from[0] + 1;
+				header_len += sprintf(header + header_len, "Content-Range: bytes %llu-%llu/%llu\r\n", (unsigned long long)range_from[0], (unsigned long long)range_to[0], (unsigned long long)c_len);
+			}
+			else
+			{
+				// the file type moves to each part of the multipart/byteranges body
+				get_header_value(header, "\nContent-Type:", part_type, sizeof(part_type));
+				char *ctype = strstr(header, "Content-Type:"); if(ctype) header_len = ctype - header;
+				header_len += sprintf(header + header_len, "Content-Type: multipart/byteranges; boundary=" HTTP_BOUNDARY "\r\n");
+
+				send_len = strlen("\r\n--" HTTP_BOUNDARY "--\r\n");
+				for(int n = 0; n < nranges; n++)
+					send_len += sprintf(part_header, "\r\n--" HTTP_BOUNDARY "\r\nContent-Type: %s\r\nContent-Range: bytes %llu-%llu/%llu\r\n\r\n", part_type, (unsigned long long)range_from[n], (unsigned long long)range_to[n], (unsigned long long)c_len)
+							  + (range_to[n] - range_from[n] + 1);
+			}
+		}
+
+		header_len += sprintf(header + header_len,  "ETag: %s\r\n"
+													"Last-Modified: %s\r\n"
+													"Cache-Control: no-cache\r\n"
+													"Accept-Ranges: bytes\r\n", etag, last_modified);
+
 		if(keep_alive)
 		{
 			header_len += sprintf(header + header_len,  "Keep-Alive: timeout=3,max=250\r\n"
 														"Connection: keep-alive\r\n");
 		}
 
-		header_len += sprintf(header + header_len, "Content-Length: %llu\r\n\r\n", (unsigned long long)c_len);
-		send(conn_s, header, header_len, 0);
+		u8 npages = send_len ? (u8)MIN(MAX_PAGES, 1 + ((send_len - 1) / _64KB_)) : 1;
+
+		size_t buffer_size = sysmem_size; // reuse the buffer of the previous request on keep-alive connections
 
-		size_t buffer_size = 0; if(sysmem) sys_memory_free(sysmem); sysmem = NULL;
+		if(!sysmem || (buffer_size < (size_t)(npages * _64KB_)))
+		{
+			if(sysmem) sys_memory_free(sysmem); sysmem = NULL; buffer_size = 0;
 
-		u8 npages = c_len ? (u8)MIN(MAX_PAGES, 1 + ((c_len - 1) / _64KB_)) : 1;
+			for(u8 n = npages; n > 0; n--)
+				if(sys_memory_allocate(n * _64KB_, SYS_MEMORY_PAGE_SIZE_64K, &sysmem) == CELL_OK) {buffer_size = n * _64KB_; sys_ppu_thread_usleep(5000); break;}
 
-		for(u8 n = npages; n > 0; n--)
-			if(sys_memory_allocate(n * _64KB_, SYS_MEMORY_PAGE_SIZE_64K, &sysmem) == CELL_OK) {buffer_size = n * _64KB_; sys_ppu_thread_usleep(5000); break;}
+			sysmem_size = buffer_size;
+		}
 
 		if(!sysmem)
 		{
@@ -34,44 +129,38 @@
 			if(fd <= 0) is_ntfs = false;
 		}
 		#endif
-		if(is_ntfs || cellFsOpen(param, CELL_FS_O_RDONLY, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+		if(!is_ntfs && cellFsOpen(param, CELL_FS_O_RDONLY, &fd, NULL, 0) != CELL_FS_SUCCEEDED)
 		{
-			u64 read_e = 0, pos;
+			keep_alive = http_response(conn_s, header, param, CODE_PATH_NOT_FOUND, "404 Path not found");
+			goto exit_handleclient_www;
+		}
 
-			#ifdef USE_NTFS
-			if(is_ntfs) ps3ntfs_seek64(fd, 0, SEEK_SET);
-			else
-			#endif
-			cellFsLseek(fd, 0, CELL_FS_SEEK_SET, &pos);
+		header_len += sprintf(header + header_len, "Content-Length: %llu\r\n\r\n", (unsigned long long)send_len);
+		send(conn_s, header, header_len, 0);
+
+		// the buffer & the file are ready before the header: a body shorter than its Content-Length
+		// ends the connection, or the client would read the rest of the file as the next response
+		bool sent = true;
 
-			while(working)
+		if(nranges > 1)
+		{
+			for(int n = 0; sent && (n < nranges); n++)
 			{
-				#ifdef USE_NTFS
-				if(is_ntfs) read_e = ps3ntfs_read(fd, (void *)buffer, buffer_size);
-				#endif
-				if(is_ntfs || cellFsRead(fd, (void *)buffer, buffer_size, &read_e) == CELL_FS_SUCCEEDED)
-				{
-					if(read_e > 0)
-					{
-						#ifdef UNLOCK_SAVEDATA
-						if(webman_config->unlock_savedata) unlock_param_sfo(param, (unsigned char*)buffer, (u16)read_e);
-						#endif
-						if(send(conn_s, buffer, (size_t)read_e, 0) < 0) break;
-					}
-					else
-						break;
-				}
-				else
-					break;
-
-				//sys_ppu_thread_usleep(1668);
+				u16 plen = sprintf(part_header, "\r\n--" HTTP_BOUNDARY "\r\nContent-Type: %s\r\nContent-Range: bytes %llu-%llu/%llu\r\n\r\n", part_type, (unsigned long long)range_from[n], (unsigned long long)range_to[n], (unsigned long long)c_len);
+				sent = (send(conn_s, part_header, plen, 0) >= 0) && send_file_data(conn_s, fd, is_ntfs, buffer, buffer_size, range_from[n], range_to[n] - range_from[n] + 1, param);
 			}
-			#ifdef USE_NTFS
-			if(is_ntfs) ps3ntfs_close(fd);
-			else
-			#endif
-			cellFsClose(fd);
+			if(sent) ssend(conn_s, "\r\n--" HTTP_BOUNDARY "--\r\n");
 		}
+		else
+			sent = send_file_data(conn_s, fd, is_ntfs, buffer, buffer_size, nranges ? range_from[0] : 0, send_len, param);
+
+		if(!sent) keep_alive = 0;
+
+		#ifdef USE_NTFS
+		if(is_ntfs) ps3ntfs_close(fd);
+		else
+		#endif
+		cellFsClose(fd);
 
 		goto exit_handleclient_www;
 	}
@@ -282,6 +282,44 @@ static size_t prepare_html(char *buffer, char *templn, char *param, u8 is_ps3_ht
 	return sbuffer.size;
 }
 
+// send size bytes of an open file starting at offset
+static bool send_file_data(int conn_s, int fd, bool is_ntfs, char *buffer, size_t buffer_size, u64 offset, u64 size, const char *param)
+{
+	u64 read_e = 0, pos;
+
+	#ifdef USE_NTFS
+	if(is_ntfs) ps3ntfs_seek64(fd, offset, SEEK_SET);
+	else
+	#endif
+	cellFsLseek(fd, offset, CELL_FS_SEEK_SET, &pos);
+
+	while(working && size)
+	{
+		u64 len = MIN(size, (u64)buffer_size);
+
+		#ifdef USE_NTFS
+		if(is_ntfs) {int ret = ps3ntfs_read(fd, (void *)buffer, len); read_e = (ret > 0) ? ret : 0;}
+		#endif
+		if(is_ntfs || cellFsRead(fd, (void *)buffer, len, &read_e) == CELL_FS_SUCCEEDED)
+		{
+			if(read_e > 0)
+			{
+				#ifdef UNLOCK_SAVEDATA
+				if(!offset && webman_config->unlock_savedata) unlock_param_sfo(param, (unsigned char*)buffer, (u16)read_e);
+				#endif
+				if(send(conn_s, buffer, (size_t)read_e, 0) < 0) return false;
+				size -= MIN(size, read_e); offset += read_e;
+			}
+			else
+				break;
+		}
+		else
+			break;
+	}
+
+	return !size;
+}
+
 static void do_web_command(u64 conn_s_p, const char *wm_url)
 {
 	int conn_s = (int)conn_s_p;
@@ -290,7 +328,7 @@ static void do_web_command(u64 conn_s_p, const char *wm_url)
 	bool is_local = true;
 	size_t header_len;
 	sys_net_sockinfo_t conn_info;
-	sys_addr_t sysmem = NULL;
+	sys_addr_t sysmem = NULL; size_t sysmem_size = 0; // sysmem_size > 0: file buffer reused by the next keep-alive request
 
 	u8 max_cc = 0; // count client connections per persistent connection
 	u8 keep_alive = 0, use_keep_alive = 0;
@@ -300,6 +338,7 @@ static void do_web_command(u64 conn_s_p, const char *wm_url)
 
 	char cmd[16], header[HTML_RECV_SIZE];
 	char *mc = NULL, *mc_param = NULL;
+	char *next_request = NULL; // pipelined request received along with the current one
 
 	char param[HTML_RECV_SIZE];
 	char *file_query = param + HTML_RECV_LAST; *file_query = NULL;
@@ -378,18 +417,20 @@ parse_request:
   {
 	u8 retry, served, is_binary;	// served http request?, is_binary: 0 = http command, 1 = file, 2 = folder listing
 	s8 sort_order, sort_by;
-	u64 c_len;
+	u64 c_len, c_mtime;
+	char if_none_match[40], if_modified_since[32], if_range[40], range[64]; // conditional GET & byte ranges
 
 	u8 is_cpursx;
 	u8 is_popup, auto_mount;
 	u8 is_ps3_http;
+	u8 accept_gzip;
 
 	#ifdef USE_NTFS
 	skip_prepntfs = false;
 	#endif
 
 	retry = served = 0; is_binary = WEB_COMMAND;
-	is_ps3_http  = auto_mount = is_popup = is_cpursx = 0; c_len = 0;
+	is_ps3_http  = auto_mount = is_popup = is_cpursx = accept_gzip = 0; c_len = c_mtime = 0;
 	sort_order = 1, sort_by = 0;
 
 //// process commands ////
@@ -400,14 +441,29 @@ parse_request:
 		_memset(header, HTML_RECV_SIZE);
 		keep_alive = 0;
 
+		int rlen = NONE;
+
 		if(!mc)
 		{
 			#ifdef USE_DEBUG
 			ssend(debug_s, "ACC - ");
 			#endif
 
+			if(next_request)
+			{
+				// serve pipelined request without waiting for recv, receive the rest of its headers if they were split
+				int len = strlen(strcpy(header, next_request));
+				free(next_request); next_request = NULL;
+
+				while((len < HTML_RECV_LAST) && !strstr(header, "\r\n\r\n"))
+				{
+					int n = recv(conn_s, header + len, HTML_RECV_LAST - len, 0);
+					if(n <= 0) break;
+					len += n;
+				}
+			}
 			#ifdef WM_REQUEST
-			if(wm_request)
+			else if(wm_request)
 			{
 				// Set the content of WM_REQUEST_FILE as header
 				if(wm_url || (buf.st_size > 5 && buf.st_size < HTML_RECV_SIZE && read_file(WM_REQUEST_FILE, header, buf.st_size, 0) > 4))
@@ -495,13 +551,43 @@ parse_request:
 
 		mc = NULL;
 
-		if((*header == 'G') || ((recv(conn_s, header, HTML_RECV_SIZE, 0) > 0) && (*header == 'G') && (header[4] == '/'))) // serve only GET /xxx requests
+		if((*header == 'G') || (((rlen = recv(conn_s, header, HTML_RECV_LAST, 0)) > 0) && (*header == 'G') && (header[4] == '/'))) // serve only GET /xxx requests
 		{
-			if(strstr(header, "Connection: keep-alive"))
+			// keep the next pipelined request for the following iteration (complete or only its first bytes)
+			char *next = strstr(header, "\r\n\r\n");
+			if(next && next[4])
 			{
-				use_keep_alive = keep_alive = 1;
+				next += 4;
+				if(!next_request)
+				{
+					next_request = malloc(strlen(next) + 1);
+					if(next_request) strcpy(next_request, next);
+				}
+				*next = NULL;
 			}
 
+			// HTTP/1.1 connections are persistent unless the client asks to close them
+			if(!strcasestr(header, "Connection: close"))
+			{
+				char *eol = strstr(header, "\r\n");
+				if(strcasestr(header, "Connection: keep-alive") || (eol && (eol - header > 8) && islike(eol - 8, "HTTP/1.1")))
+					use_keep_alive = keep_alive = 1;
+			}
+
+			get_header_value(header, "\nIf-None-Match:",     if_none_match,     sizeof(if_none_match));
+			get_header_value(header, "\nIf-Modified-Since:", if_modified_since, sizeof(if_modified_since));
+			get_header_value(header, "\nIf-Range:",          if_range,          sizeof(if_range));
+			get_header_value(header, "\nRange:",             range,             sizeof(range));
+
+			#ifdef GZIP_HTML
+			get_header_value(header, "\nAccept-Encoding:", param, 255); // param is overwritten by ssplit below
+			if(strstr(param, "gzip"))
+			{
+				char *eol = strstr(header, "\r\n");
+				accept_gzip = (eol && (eol - header > 8) && islike(eol - 8, "HTTP/1.0")) ? GZIP_CLOSE : GZIP_CHUNKED;
+			}
+			#endif
+
 			if(strstr(header, "x-ps3-browser")) is_ps3_http = 1; else
 			if(strstr(header, "Gecko/36"))  	is_ps3_http = 2; else
 												is_ps3_http = 0;
@@ -744,15 +830,26 @@ send_response:
 				{
 					c_len = sbuffer.size;
 
-					header_len += sprintf(header + header_len, "Content-Length: %llu\r\n\r\n", (unsigned long long)c_len);
-					send(conn_s, header, header_len, 0);
+					#ifdef GZIP_HTML
+					if(!accept_gzip || (c_len < GZIP_MIN_SIZE) || !send_gzip_response(conn_s, header, header_len, buffer, c_len, accept_gzip))
+					#endif
+					{
+						header_len += sprintf(header + header_len, "Content-Length: %llu\r\n\r\n", (unsigned long long)c_len);
+						send(conn_s, header, header_len, 0);
 
-					send(conn_s, buffer, c_len, 0);
+						send(conn_s, buffer, c_len, 0);
+					}
+					#ifdef GZIP_HTML
+					else if(accept_gzip == GZIP_CLOSE)
+						keep_alive = 0; // the end of the gzip body is the end of the connection
+					#endif
 				}
 
 				*buffer = NULL;
 			}
 		}
+		else if(max_cc || !rlen) // idle keep-alive connection timed out or closed by the client
+			break;
 		else if(++retry < 250) // if(loading_html && (*header == 0) && (++retry < 5))
 		{
 			served = 0; // data no received
@@ -778,34 +875,155 @@ exit_nocobra_error:
 
 exit_handleclient_www:
 
-	if(sysmem) {sys_memory_free(sysmem); sysmem = NULL;}
+	if(sysmem && !(keep_alive && sysmem_size)) {sys_memory_free(sysmem); sysmem = NULL; sysmem_size = 0;}
 
 	if(ap_param)
 		{auto_play(param, --ap_param); ap_param = 0;} // ap_param: 1=from /mount.ps3, 2=from /play.ps3
 
 	if(mc || (use_keep_alive && keep_alive && loading_html && (++max_cc < MAX_WWW_CC))) goto parse_request;
 
+	if(sysmem) sys_memory_free(sysmem);
 	if(mc_param) free(mc_param);
+	if(next_request) free(next_request);
 
 	#ifdef USE_DEBUG
 	ssend(debug_s, "Request served.\r\n");
 	#endif
 }
 
-static void handleclient_www(u64 conn_s_p)
+static void serve_client_www(int conn_s)
 {
-	int conn_s = (int)conn_s_p;
-
 	#ifdef USE_DEBUG
 	ssend(debug_s, "waiting...");
 	#endif
 
 	if(loading_html > 10) loading_html = 0;
 
-	do_web_command(conn_s_p, NULL);
+	do_web_command((u64)conn_s, NULL);
 
 	if(loading_html) loading_html--;
 
 	sclose(&conn_s);
+}
+
+static vu32 www_clients = 0; // handleclient_www threads created & not ended
+
+static void handleclient_www(u64 conn_s_p)
+{
+	serve_client_www((int)conn_s_p);
+
+	__sync_fetch_and_sub(&www_clients, 1);
+	sys_ppu_thread_exit(0);
+}
+
+// client with a thread of its own (no idle worker or request from a file)
+static void spawn_client_www(u64 conn_s_p)
+{
+	__sync_fetch_and_add(&www_clients, 1);
+
+	sys_ppu_thread_t t_id;
+	if(sys_ppu_thread_create(&t_id, handleclient_www, conn_s_p, THREAD_PRIO, THREAD_STACK_SIZE_WEB_CLIENT, SYS_PPU_THREAD_CREATE_NORMAL, THREAD_NAME_WEB) != CELL_OK)
+		__sync_fetch_and_sub(&www_clients, 1);
+}
+
+// wait up to 10 seconds for the client threads; returns false if some are still running
+static bool wait_clients_www(void)
+{
+	for(u8 timeout = 0; www_clients; timeout++)
+	{
+		if(timeout >= 200) return false;
+		sys_ppu_thread_usleep(50000);
+	}
+	return true;
+}
+
+////////////////////////////////
+// web worker pool: accepted sockets are posted to www_queue
+// and served by WWW_WORKERS threads that stay alive between clients
+
+static sys_event_queue_t www_queue = SYS_EVENT_QUEUE_NONE;
+static sys_event_port_t www_port = (sys_event_port_t)NONE;
+static u8 www_idle = 0; // workers waiting on www_queue (www_mutex)
+static sys_ppu_thread_t www_worker_id[WWW_WORKERS];
+
+static void www_worker_thread(__attribute__((unused)) u64 arg)
+{
+	sys_event_t event;
+
+	while(working)
+	{
+		mutex_lock(www_mutex); www_idle++; mutex_unlock(www_mutex);
+
+		if(sys_event_queue_receive(www_queue, &event, 0) != CELL_OK) break; // queue destroyed
+
+		serve_client_www((int)event.data1);
+	}
+
 	sys_ppu_thread_exit(0);
 }
+
+static void stop_www_workers(void)
+{
+	if(www_port != (sys_event_port_t)NONE)
+	{
+		sys_event_port_disconnect(www_port);
+		sys_event_port_destroy(www_port);
+		www_port = (sys_event_port_t)NONE;
+	}
+
+	if(www_queue != SYS_EVENT_QUEUE_NONE)
+	{
+		sys_event_queue_destroy(www_queue, SYS_EVENT_QUEUE_DESTROY_FORCE);
+		www_queue = SYS_EVENT_QUEUE_NONE;
+	}
+
+	// the workers leave their loop when the queue is destroyed (after the client being served)
+	for(u8 n = 0; n < WWW_WORKERS; n++)
+	{
+		thread_join(www_worker_id[n]); www_worker_id[n] = SYS_PPU_THREAD_NONE;
+	}
+
+	mutex_lock(www_mutex); www_idle = 0; mutex_unlock(www_mutex);
+}
+
+static void start_www_workers(void)
+{
+	if(www_queue != SYS_EVENT_QUEUE_NONE) return;
+
+	for(u8 n = 0; n < WWW_WORKERS; n++) www_worker_id[n] = SYS_PPU_THREAD_NONE;
+
+	sys_event_queue_attribute_t queue_attr;
+	sys_event_queue_attribute_initialize(queue_attr);
+	if(sys_event_queue_create(&www_queue, &queue_attr, 0, WWW_WORKERS) != CELL_OK)
+	{
+		www_queue = SYS_EVENT_QUEUE_NONE;
+		return;
+	}
+
+	if((sys_event_port_create(&www_port, 1, SYS_EVENT_PORT_NO_NAME) != CELL_OK) || (sys_event_port_connect_local(www_port, www_queue) != CELL_OK))
+	{
+		stop_www_workers();
+		return;
+	}
+
+	for(u8 n = 0; n < WWW_WORKERS; n++)
+		if(sys_ppu_thread_create(&www_worker_id[n], www_worker_thread, n, THREAD_PRIO, THREAD_STACK_SIZE_WEB_CLIENT, SYS_PPU_THREAD_CREATE_JOINABLE, THREAD_NAME_WEB) != CELL_OK)
+			www_worker_id[n] = SYS_PPU_THREAD_NONE;
+}
+
+// returns false if no worker is idle; caller must spawn handleclient_www
+static bool dispatch_client_www(int conn_s)
+{
+	if(www_port == (sys_event_port_t)NONE) return false;
+
+	mutex_lock(www_mutex);
+	bool idle = (www_idle > 0); if(idle) www_idle--;
+	mutex_unlock(www_mutex);
+
+	if(!idle) return false;
+
+	if(sys_event_port_send(www_port, (u64)conn_s, 0, 0) == CELL_OK) return true;
+
+	mutex_lock(www_mutex); www_idle++; mutex_unlock(www_mutex);
+	return false;
+}
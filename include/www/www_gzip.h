@@ -0,0 +1,206 @@
+#ifdef GZIP_HTML
+
+// gzip (RFC 1952) encoder for generated pages & static file siblings
+// single deflate block with fixed Huffman codes and a one-probe LZ77 hash over the input buffer
+
+#define GZIP_HASH_BITS		13
+#define GZIP_HASH_SIZE		(1 << GZIP_HASH_BITS)
+#define GZIP_WINDOW			32768
+#define GZIP_MIN_MATCH		3
+#define GZIP_MAX_MATCH		258
+#define GZIP_OUT_SIZE		(_64KB_ - (GZIP_HASH_SIZE * 4))
+#define GZIP_MIN_SIZE		_1KB_	// smaller pages are sent uncompressed
+
+#define GZIP_CHUNKED		1		// accept_gzip: HTTP/1.1 client, chunked reply
+#define GZIP_CLOSE			2		// accept_gzip: HTTP/1.0 client, the reply is ended by closing the connection
+
+typedef struct
+{
+	int conn_s;		// HTTP output if >= 0
+	bool chunked;	// HTTP output as chunks
+	int fd;			// file output if conn_s < 0
+	u8 *out;
+	u32 out_len;
+	u64 bits;
+	u8 nbits;
+	bool failed;
+} t_gzip;
+
+static const u16 gz_len_base[29]  = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const u8  gz_len_extra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const u16 gz_dist_base[30]  = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const u8  gz_dist_extra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+static void gzip_flush(t_gzip *gz)
+{
+	if(!gz->out_len || gz->failed) {gz->out_len = 0; return;}
+
+	if((gz->conn_s >= 0) && !gz->chunked)
+	{
+		if(send(gz->conn_s, gz->out, gz->out_len, 0) < 0) gz->failed = true;
+	}
+	else if(gz->conn_s >= 0)
+	{
+		char chunk[12]; u8 clen = sprintf(chunk, "%x\r\n", gz->out_len);
+		if( (send(gz->conn_s, chunk, clen, 0) < 0) ||
+			(send(gz->conn_s, gz->out, gz->out_len, 0) < 0) ||
+			(send(gz->conn_s, "\r\n", 2, 0) < 0) ) gz->failed = true;
+	}
+	else if(cellFsWrite(gz->fd, gz->out, gz->out_len, NULL) != CELL_FS_SUCCEEDED)
+		gz->failed = true;
+
+	gz->out_len = 0;
+}
+
+static void gzip_byte(t_gzip *gz, u8 value)
+{
+	gz->out[gz->out_len++] = value;
+	if(gz->out_len >= GZIP_OUT_SIZE) gzip_flush(gz);
+}
+
+static void gzip_bits(t_gzip *gz, u32 value, u8 count)
+{
+	gz->bits |= ((u64)value << gz->nbits); gz->nbits += count;
+	while(gz->nbits >= 8) {gzip_byte(gz, (u8)gz->bits); gz->bits >>= 8, gz->nbits -= 8;}
+}
+
+// Huffman codes are stored MSB first
+static void gzip_code(t_gzip *gz, u32 code, u8 count)
+{
+	u32 rev = 0;
+	for(u8 n = 0; n < count; n++) {rev = (rev << 1) | (code & 1); code >>= 1;}
+	gzip_bits(gz, rev, count);
+}
+
+static void gzip_symbol(t_gzip *gz, u16 sym)
+{
+	if(sym < 144) gzip_code(gz, 0x30  + sym, 8);			else
+	if(sym < 256) gzip_code(gz, 0x190 + sym - 144, 9);	else
+	if(sym < 280) gzip_code(gz, sym - 256, 7);			else
+				  gzip_code(gz, 0xC0  + sym - 280, 8);
+}
+
+static void gzip_match(t_gzip *gz, u16 len, u16 dist)
+{
+	u8 n = 28; while(gz_len_base[n] > len) n--;
+	gzip_symbol(gz, 257 + n);
+	if(gz_len_extra[n]) gzip_bits(gz, len - gz_len_base[n], gz_len_extra[n]);
+
+	n = 29; while(gz_dist_base[n] > dist) n--;
+	gzip_code(gz, n, 5);
+	if(gz_dist_extra[n]) gzip_bits(gz, dist - gz_dist_base[n], gz_dist_extra[n]);
+}
+
+// compress data to conn_s (as HTTP chunks if chunked) or to fd using a 64KB work buffer
+static bool gzip_data(int conn_s, bool chunked, int fd, const char *data, u32 len, sys_addr_t sysmem)
+{
+	u32 *head = (u32*)sysmem; _memset(head, GZIP_HASH_SIZE * 4); // last position + 1 of each 3-byte hash
+
+	t_gzip gz;
+	gz.conn_s = conn_s, gz.chunked = chunked, gz.fd = fd;
+	gz.out = (u8*)(sysmem + (GZIP_HASH_SIZE * 4)), gz.out_len = 0;
+	gz.bits = 0, gz.nbits = 0, gz.failed = false;
+
+	const u8 *in = (const u8*)data;
+
+	// gzip header: magic, deflate, no flags, no mtime, unknown OS
+	const u8 gz_header[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+	for(u8 n = 0; n < 10; n++) gzip_byte(&gz, gz_header[n]);
+
+	gzip_bits(&gz, 1, 1); // BFINAL
+	gzip_bits(&gz, 1, 2); // BTYPE = fixed Huffman
+
+	#define GZIP_HASH(p)	((((p)[0] << 10) ^ ((p)[1] << 5) ^ (p)[2]) & (GZIP_HASH_SIZE - 1))
+
+	for(u32 i = 0; (i < len) && !gz.failed && working; )
+	{
+		u16 best = 0; u32 dist = 0;
+
+		if(i + GZIP_MIN_MATCH <= len)
+		{
+			u32 h = GZIP_HASH(in + i), cand = head[h]; head[h] = i + 1;
+
+			if(cand && ((dist = i + 1 - cand) <= GZIP_WINDOW))
+			{
+				const u8 *a = in + cand - 1, *b = in + i;
+				u32 max = MIN(GZIP_MAX_MATCH, len - i);
+				while((best < max) && (a[best] == b[best])) best++;
+			}
+		}
+
+		if(best >= GZIP_MIN_MATCH)
+		{
+			gzip_match(&gz, best, (u16)dist);
+
+			// index the positions covered by the match
+			for(u32 end = i + best, p = i + 1; (p < end) && (p + GZIP_MIN_MATCH <= len); p++) head[GZIP_HASH(in + p)] = p + 1;
+			i += best;
+		}
+		else
+			gzip_symbol(&gz, in[i++]);
+	}
+
+	#undef GZIP_HASH
+
+	if(!working) gz.failed = true; // aborted on unload
+
+	gzip_symbol(&gz, 256); // end of block
+	if(gz.nbits) gzip_bits(&gz, 0, 8 - gz.nbits);
+
+	// trailer: CRC32 & ISIZE (little endian)
+	u32 crc = crc32_update(0, in, len);
+	for(u8 n = 0; n < 32; n += 8) gzip_byte(&gz, (u8)(crc >> n));
+	for(u8 n = 0; n < 32; n += 8) gzip_byte(&gz, (u8)(len >> n));
+
+	gzip_flush(&gz);
+
+	if((conn_s >= 0) && chunked && !gz.failed) send(conn_s, "0\r\n\r\n", 5, 0); // last chunk
+
+	return !gz.failed;
+}
+
+// send a generated page as gzip; header must end with "\r\n" before the blank line
+// mode: GZIP_CHUNKED or GZIP_CLOSE (HTTP/1.0 has no chunked encoding: the caller closes the connection after the body)
+// returns false (nothing sent) if the work buffer could not be allocated
+static bool send_gzip_response(int conn_s, char *header, size_t header_len, const char *data, u32 len, u8 mode)
+{
+	sys_addr_t sysmem = sys_mem_allocate(_64KB_);
+	if(!sysmem) return false;
+
+	bool chunked = (mode == GZIP_CHUNKED);
+
+	header_len += sprintf(header + header_len,  "Content-Encoding: gzip\r\n"
+												"Vary: Accept-Encoding\r\n"
+												"%s\r\n", chunked ? "Transfer-Encoding: chunked\r\n" : "Connection: close\r\n");
+	send(conn_s, header, header_len, 0);
+
+	gzip_data(conn_s, chunked, NONE, data, len, sysmem);
+
+	sys_memory_free(sysmem);
+	return true;
+}
+
+// write <file>.gz beside a static file so it can be served precompressed
+static void save_file_gz(const char *file, const char *data, u32 len)
+{
+	char gz_file[STD_PATH_LEN + 4]; int fd;
+	snprintf(gz_file, sizeof(gz_file), "%s.gz", file);
+
+	cellFsUnlink(gz_file); // never leave a stale sibling
+
+	if(len < GZIP_MIN_SIZE) return;
+
+	sys_addr_t sysmem = sys_mem_allocate(_64KB_);
+	if(!sysmem) return;
+
+	if(cellFsOpen(gz_file, CELL_FS_O_CREAT | CELL_FS_O_TRUNC | CELL_FS_O_WRONLY, &fd, NULL, 0) == CELL_FS_SUCCEEDED)
+	{
+		bool ok = gzip_data(NONE, false, fd, data, len, sysmem);
+		cellFsClose(fd);
+		if(!ok) cellFsUnlink(gz_file);
+	}
+
+	sys_memory_free(sysmem);
+}
+
+#endif // #ifdef GZIP_HTML
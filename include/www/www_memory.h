@@ -1,5 +1,7 @@
 			u32 BUFFER_SIZE_HTML = _64KB_;
 
+			if(sysmem) {sys_memory_free(sysmem); sysmem = NULL; sysmem_size = 0;} // release file buffer kept by keep-alive
+
 			if(show_info_popup || islike(param, "/cpursx.ps3")) is_cpursx = 1;
 			else
 			if((is_binary == FOLDER_LISTING) || islike(param, "/index.ps3") || islike(param, "/sman.ps3") || islike(param, "/gameplugin.ps3mapi"))
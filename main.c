@@ -10,6 +10,7 @@
 #include <sys/prx.h>
 #include <sys/ppu_thread.h>
 #include <sys/event.h>
+#include <sys/synchronization.h>
 #include <sys/syscall.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -384,6 +385,7 @@ static void installPKG_all(const char *path, bool delete_after_install);
 
 static void start_www(u64 conn_s_p);
 static void handleclient_www(u64 conn_s_p);
+static void spawn_client_www(u64 conn_s_p);
 static void do_web_command(u64 conn_s_p, const char *wm_url);
 
 static void do_umount(bool clean);
@@ -445,6 +447,7 @@ static u8 mount_unk = EMU_OFF;
 #include "include/ftp.h"
 
 #include "include/ps3mapi/debug_mem.h"
+#include "include/ps3mapi/mem_search.h"
 #include "include/ps3mapi/ps3mapi.h"
 #include "include/ps3mapi/ps3mapi_server.h"
 #include "include/ps3mapi/stealth.h"
@@ -467,6 +470,7 @@ static u8 mount_unk = EMU_OFF;
 #include "include/feat/pkg_handler.h"
 #include "include/poll/poll.h"
 
+#include "include/www/www_gzip.h"
 #include "include/www/www_client.h"
 #include "include/www/www_start.h"
 
@@ -580,6 +584,9 @@ again_debug:
 
 	int list_s = NONE;
 
+	create_mutexes();
+	start_www_workers();
+
 relisten:
 	#ifdef USE_DEBUG
 	ssend(debug_s, "Listening on port 80...");
@@ -636,8 +643,9 @@ relisten:
 
 				loading_html++;
 
-				sys_ppu_thread_t t_id;
-				sys_ppu_thread_create(&t_id, handleclient_www, (u64)conn_s, THREAD_PRIO, THREAD_STACK_SIZE_WEB_CLIENT, SYS_PPU_THREAD_CREATE_NORMAL, THREAD_NAME_WEB);
+				if(dispatch_client_www(conn_s)) continue;
+
+				spawn_client_www((u64)conn_s);
 			}
 			else if((sys_net_errno == SYS_NET_EBADF) || (sys_net_errno == SYS_NET_ENETDOWN))
 			{
@@ -650,6 +658,10 @@ relisten:
 end:
 	sclose(&list_s);
 
+	// no client may hold or be about to take the mutexes when they are destroyed (else they are left to the system)
+	stop_www_workers();
+	if(wait_clients_www()) destroy_mutexes();
+
 	//thread_id_wwwd = SYS_PPU_THREAD_NONE;
 	sys_ppu_thread_exit(0);
 }
@@ -0,0 +1,161 @@
+#ifndef __SLAUNCH_IDX_H__
+#define __SLAUNCH_IDX_H__
+
+// sLaunch game list index (slist.idx) shared by webMAN MOD (games_slaunch.h) & sLaunch (slaunch.c)
+// slist.bin remains an array of _slaunch records. The index written next to it adds:
+//   _slaunch_idx header
+//   uint16_t order[SLIDX_ORDERS][count]	record numbers sorted by title, title ID, type + title, last played + title
+//   slidx_sig sig[count]					trigram signatures of title + path (in record order)
+// The index is valid only while its count & record size match slist.bin
+
+#include <stdint.h>
+#include <string.h>
+
+#define SLIDX_MAGIC		0x534C4958	// SLIX
+#define SLIDX_VERSION	1
+#define SLIDX_TYPES		8			// TYPE_ALL ... TYPE_FAV
+#define SLIDX_KEY_LEN	24			// chars of the title used to sort
+
+enum slidx_orders
+{
+	SLIDX_TITLE,
+	SLIDX_ID,
+	SLIDX_TYPE,
+	SLIDX_RECENT,
+	SLIDX_ORDERS
+};
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;						// sizeof(_slaunch)
+	uint32_t count;								// records in slist.bin
+	uint32_t type_first[SLIDX_TYPES + 1];		// first position of each type in the type order
+} __attribute__((packed)) _slaunch_idx;
+
+typedef struct {uint64_t bits[2];} slidx_sig;	// 1 bit per trigram (bloom filter)
+
+typedef struct
+{
+	char title[SLIDX_KEY_LEN];	// upper case
+	char id[10];
+	uint8_t type;
+	uint8_t recent;				// 1 = last played ... 0 = not played
+} slidx_key;
+
+static inline uint32_t slidx_order_offset(uint32_t count, uint8_t order)
+{
+	return sizeof(_slaunch_idx) + (order * count * sizeof(uint16_t));
+}
+
+static inline uint32_t slidx_sig_offset(uint32_t count)
+{
+	return (slidx_order_offset(count, SLIDX_ORDERS) + 7) & ~7;
+}
+
+static inline uint32_t slidx_size(uint32_t count)
+{
+	return slidx_sig_offset(count) + (count * sizeof(slidx_sig));
+}
+
+static inline char slidx_upper(char c)
+{
+	return ((c >= 'a') && (c <= 'z')) ? (c - 0x20) : c;
+}
+
+/***********************************************************************
+* search filter: every trigram of the text sets 1 bit of the signature
+* a text can contain the query only if its signature has all the bits
+* of the query (queries shorter than 3 chars have no bits: all match)
+***********************************************************************/
+static void slidx_signature(slidx_sig *sig, const char *text)
+{
+	uint32_t h = 0;
+
+	for(uint8_t n = 0; *text; text++)
+	{
+		h = ((h << 8) | (uint8_t)slidx_upper(*text)) & 0xFFFFFF;
+		if(++n < 3) continue;
+
+		uint8_t bit = (uint8_t)((h * 0x9E3779B1U) >> 25); // 0-127
+		sig->bits[bit >> 6] |= 1ULL << (bit & 63);
+	}
+}
+
+static inline int slidx_match(const slidx_sig *sig, const slidx_sig *query)
+{
+	return ((sig->bits[0] & query->bits[0]) == query->bits[0]) &&
+		   ((sig->bits[1] & query->bits[1]) == query->bits[1]);
+}
+
+/***********************************************************************
+* sort orders
+***********************************************************************/
+static int slidx_cmp(const slidx_key *keys, uint8_t order, uint16_t a, uint16_t b)
+{
+	const slidx_key *ka = &keys[a], *kb = &keys[b];
+	int ret = 0;
+
+	if(order == SLIDX_ID)
+		ret = strncmp(ka->id, kb->id, sizeof(ka->id));
+	else if(order == SLIDX_TYPE)
+		ret = (int)ka->type - (int)kb->type;
+	else if(order == SLIDX_RECENT)
+		ret = (int)(uint8_t)(ka->recent - 1) - (int)(uint8_t)(kb->recent - 1); // 0 (not played) goes last
+
+	if(!ret) ret = strncmp(ka->title, kb->title, SLIDX_KEY_LEN);
+
+	return ret ? ret : ((int)a - (int)b); // keep the order of the list
+}
+
+// shell sort of the record numbers (no recursion, no extra memory)
+static void slidx_sort(const slidx_key *keys, uint8_t order, uint16_t *list, uint32_t count)
+{
+	static const uint32_t gaps[] = {8929, 3905, 1750, 701, 301, 132, 57, 23, 10, 4, 1};
+
+	for(uint8_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++)
+	{
+		uint32_t gap = gaps[g];
+
+		for(uint32_t i = gap; i < count; i++)
+		{
+			uint16_t rec = list[i]; uint32_t j = i;
+
+			for(; (j >= gap) && (slidx_cmp(keys, order, list[j - gap], rec) > 0); j -= gap) list[j] = list[j - gap];
+
+			list[j] = rec;
+		}
+	}
+}
+
+// orders = SLIDX_ORDERS * count record numbers; fills the header
+static void slidx_build(_slaunch_idx *idx, const slidx_key *keys, uint16_t *orders, uint32_t count, uint16_t record_size)
+{
+	memset(idx, 0, sizeof(_slaunch_idx));
+
+	idx->magic = SLIDX_MAGIC;
+	idx->version = SLIDX_VERSION;
+	idx->record_size = record_size;
+	idx->count = count;
+
+	for(uint8_t order = 0; order < SLIDX_ORDERS; order++)
+	{
+		uint16_t *list = orders + (order * count);
+
+		for(uint32_t n = 0; n < count; n++) list[n] = n;
+
+		slidx_sort(keys, order, list, count);
+	}
+
+	// ranges of each type in the type order
+	const uint16_t *list = orders + (SLIDX_TYPE * count);
+
+	for(uint32_t n = 0, type = 0; type <= SLIDX_TYPES; type++)
+	{
+		while((n < count) && (keys[list[n]].type < type)) n++;
+		idx->type_first[type] = n;
+	}
+}
+
+#endif // __SLAUNCH_IDX_H__